@@ -53,7 +53,7 @@
 
 #include "src/ble_device_type.h"
 #include "src/lcd.h"
-#include "src/circular_buffer.h"
+#include "src/dashboard.h"
 
 
 
@@ -111,7 +111,7 @@
 //           to call one of the LOG_***() functions from.
 
 // Include logging specifically for this .c file
-//#define INCLUDE_LOG_DEBUG 1
+//#define LOG_LEVEL LOG_LEVEL_INFO
 #include "src/log.h"
 
 #include "src/timers.h"
@@ -120,6 +120,10 @@
 #include "src/i2c.h"
 #include "src/ble.h"
 #include "src/adc.h"
+#include "src/trace.h"
+#include "src/profiler.h"
+#include "src/energy.h"
+#include "src/periodic.h"
 
 /*****************************************************************************
  * Application Power Manager callbacks
@@ -130,7 +134,8 @@
 
 bool app_is_ok_to_sleep(void)
 {
-  return APP_IS_OK_TO_SLEEP;
+  // stay awake until the binary log records have been sent
+  return APP_IS_OK_TO_SLEEP && !logPending();
 
 } // app_is_ok_to_sleep()
 
@@ -161,6 +166,8 @@ SL_WEAK void app_init(void)
 
   //initialize letimer0
   initLETIMER0(LETIMER_PERIOD_MS, LETIMER_ON_TIME_MS, LOWEST_ENERGY_MODE);
+  //start the measurement, EXTCOMIN and sleep hours ticks
+  periodic_init();
   //initialize GPIO pins
   gpioInit();
   //power up the temperature sensor
@@ -173,16 +180,17 @@ SL_WEAK void app_init(void)
   reset_ISL29125();
   //configure the sensor
   configure_ISL29125();
-  //reset I2C0
-  I2C_Reset(I2C0);
-  //clear the circular buffer
-  clear_queue();
+  //start the event-loop profiler, a no-op unless PROFILER_ENABLE is set
+  profiler_init();
+
+  //account the time spent in every energy mode
+  energy_init();
 
    //Add power requirement to run if the energy mode is EM1 or EM2
 #if defined(LOWEST_ENERGY_MODE)
   if((LOWEST_ENERGY_MODE == SL_POWER_MANAGER_EM1) || \
       (LOWEST_ENERGY_MODE == SL_POWER_MANAGER_EM2))
-    sl_power_manager_add_em_requirement(LOWEST_ENERGY_MODE);
+    ENERGY_ADD_EM_REQUIREMENT(LOWEST_ENERGY_MODE, ENERGY_NO_HOLD_LIMIT);
 #endif
 
 }
@@ -210,26 +218,23 @@ SL_WEAK void app_process_action(void)
   //         We will create/use a scheme that is far more energy efficient in
   //         later assignments.
 
+  // send the log records stored while handling the last events
+  logDrain();
+
 }
 
-/**************************************************************************//**
- * Bluetooth stack event handler.
- * This overrides the dummy weak implementation.
- *
- * @param[in] evt Event coming from the Bluetooth stack.
- *
- * The code here will process events from the Bluetooth stack. This is the only
- * opportunity we will get to act on an event.
- *****************************************************************************/
-void sl_bt_on_event(sl_bt_msg_t *evt)
+/**
+ * Dispatch one event from the Bluetooth stack to the BLE handler and
+ * the state machines.
+ * @param evt: Event coming from the Bluetooth stack.
+ */
+static void app_handle_event(sl_bt_msg_t *evt)
 {
-  
-  // Just a trick to hide a compiler warning about unused input parameter evt.
-  (void) evt;
-
   // Some events require responses from our application code,
   // and don’t necessarily advance our state machines.
+   uint32_t start = profiler_cycles();
    handle_ble_event(evt); // put this code in ble.c/.h
+   profiler_record(PROF_KIND_BLE_HANDLER, SL_BT_MSG_ID(evt->header), start);
 
 #if DEVICE_IS_BLE_SERVER
 
@@ -242,36 +247,34 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
    //BLE private data
    conn_properties_t *bleDataPtr = getBleDataPtr();
 
-   if((event == evtLETIMER0_UF) && bleDataPtr->connOn && \
-       bleDataPtr->bonded){
+   if(bleDataPtr->connOn && bleDataPtr->bonded){
 
-       if(!sleep_hours){
+       if((event & evtMEASURE_TICK) && !sleep_hours){
            //turn off LED0
            gpioLed0SetOff();
            //initiate all sensors to read data
            activate_services();
        }
-       else{
+
+       if((event & evtSLEEP_HOUR_TICK) && sleep_hours){
            LCD_display_optimal_values();
            sleep_hours--;
            //turn on LED0
            gpioLed0SetOn();
-           return;
        }
    }
-   else if(!bleDataPtr->connOn || !bleDataPtr->bonded){
+   else{
        //display the required user action
        displayPrintf(DISPLAY_ROW_ACTION, "Pairing Required");
        //clear all displays
-       displayPrintf(DISPLAY_ROW_TEMPVALUE, "");
-       displayPrintf(DISPLAY_ROW_8, "");
-       displayPrintf(DISPLAY_ROW_9, "");
-       return;
+       dashboardClear();
    }
 
-   temperature_state_machine(evt);
-   light_state_machine(evt);
-   sound_state_machine(evt);
+   // overlap the sound, light and temperature measurements. The I2C, ADC
+   // and timer bits merged into this wakeup are handled whatever else it
+   // carried, so a job left on I2C0 by an aborted cycle also completes and
+   // the queue releases EM1
+   sensor_pipeline_state_machine(evt);
 
 
 #else
@@ -280,6 +283,46 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
    discovery_state_machine(evt);
 
 #endif
-   
+
+} // app_handle_event()
+
+/**************************************************************************//**
+ * Bluetooth stack event handler.
+ * This overrides the dummy weak implementation.
+ *
+ * @param[in] evt Event coming from the Bluetooth stack.
+ *
+ * The code here will process events from the Bluetooth stack. This is the only
+ * opportunity we will get to act on an event.
+ *****************************************************************************/
+void sl_bt_on_event(sl_bt_msg_t *evt)
+{
+  
+  // Just a trick to hide a compiler warning about unused input parameter evt.
+  (void) evt;
+
+  // profile the dispatch latency, a no-op unless PROFILER_ENABLE is set
+  uint32_t start = profiler_cycles();
+  profiler_record_wakeup();
+
+  // capture the event for offline replay, a no-op unless TRACE_ENABLE is set
+  trace_record_bt_event(evt);
+
+  // close the energy accounting period at every measurement tick
+  if((SL_BT_MSG_ID(evt->header) == sl_bt_evt_system_external_signal_id) && \
+      (evt->data.evt_system_external_signal.extsignals & evtMEASURE_TICK))
+    energy_cycle_report();
+
+  app_handle_event(evt);
+
+  // send all rows drawn while handling the event in one LCD update
+  displayFlush();
+
+  profiler_record(PROF_KIND_BT_EVENT, SL_BT_MSG_ID(evt->header), start);
+
+  // dump the profile of every connection over VCOM
+  if(SL_BT_MSG_ID(evt->header) == sl_bt_evt_connection_closed_id)
+    profiler_dump();
+
 } // sl_bt_on_event()
 
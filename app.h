@@ -50,10 +50,18 @@
 
 #define LOWEST_ENERGY_MODE                  SL_POWER_MANAGER_EM2
 #define LETIMER_ON_TIME_MS                  0
-#define LETIMER_PERIOD_MS                   (3000)
+// LETIMER0 is only the time base of the timestamps and the software
+// timers, a long period keeps its UF wakeups rare
+#define LETIMER_PERIOD_MS                   (7000)
 #define MS_TO_US                            (1000)
 #define MAX_RH_CONV_TIME_MS                 (12)
 #define MAX_TEMP_CONV_TIME_MS               (11) //11
+// periodic tasks run on the sleeptimer, see src/periodic.h
+#define MEASUREMENT_PERIOD_MS               (3000)
+#define EXTCOMIN_PERIOD_MS                  (1000)
+#define SLEEP_HOUR_PERIOD_MS                (3000)
+// tasks due this close to a wakeup run in it, below half of any period
+#define PERIODIC_SLACK_MS                   (50)
 
 
 /**************************************************************************//**
@@ -36,12 +36,28 @@ GATT_DATA(const uint8_t gattdb_uuidtable_128_map[]) =
   0x42, 0x78, 0x83, 0xb4, 0xf7, 0xf6, 0x85, 0x86, 0x0b, 0x49, 0xd0, 0xc1, 0x2a, 0xed, 0x4b, 0x1e, 
   0x82, 0x9a, 0x16, 0x45, 0x50, 0xd4, 0xef, 0xbc, 0x2a, 0x4b, 0x8a, 0xf0, 0x4e, 0xa9, 0x99, 0xb9, 
   0xfa, 0x20, 0x4f, 0x93, 0xb8, 0x9d, 0x36, 0xbf, 0x64, 0x42, 0x64, 0x77, 0x1d, 0xc8, 0x02, 0x73, 
+  0x84, 0x5d, 0xf0, 0xc1, 0x93, 0x7a, 0xe2, 0xb6, 0x39, 0x4c, 0x1a, 0x5f, 0x27, 0x8b, 0x4e, 0x0d, 
+  0x25, 0x7b, 0x4d, 0xc0, 0xf6, 0x91, 0xe8, 0xa3, 0x96, 0x4d, 0x71, 0x2c, 0x0a, 0x3f, 0x8e, 0x5b, 
   0x63, 0x60, 0x32, 0xe0, 0x37, 0x5e, 0xa4, 0x88, 0x53, 0x4e, 0x6d, 0xfb, 0x64, 0x35, 0xbf, 0xf7, 
 };
-GATT_DATA(const sli_bt_gattdb_value_t gattdb_attribute_field_47) = {
+GATT_DATA(const sli_bt_gattdb_value_t gattdb_attribute_field_53) = {
   .len = 16,
   .data = { 0xf0, 0x19, 0x21, 0xb4, 0x47, 0x8f, 0xa4, 0xbf, 0xa1, 0x4f, 0x63, 0xfd, 0xee, 0xd6, 0x14, 0x1d, }
 };
+GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_52) = {
+  .properties = 0x0a,
+  .max_len = 12,
+  .data = { 0xc8, 0x00, 0x05, 0x14, 0x0a, 0x00, 0x05, 0x14, 0x1e, 0x00, 0x05, 0x0a, },
+};
+GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_49) = {
+  .properties = 0x30,
+  .max_len = 243,
+  .data = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, },
+};
+GATT_DATA(const sli_bt_gattdb_value_t gattdb_attribute_field_47) = {
+  .len = 16,
+  .data = { 0x36, 0x7e, 0x9d, 0x4b, 0xf0, 0xc2, 0x51, 0x8a, 0x7e, 0x4d, 0xb4, 0x93, 0x1e, 0x2c, 0x0f, 0x6a, }
+};
 GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_46) = {
   .properties = 0x0a,
   .max_len = 1,
@@ -71,7 +87,7 @@ GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_38) = {
   .data = { 0x00, },
 };
 GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_36) = {
-  .properties = 0x2a,
+  .properties = 0x3a,
   .max_len = 4,
   .data = { 0x00, 0x00, 0x00, 0x00, },
 };
@@ -85,7 +101,7 @@ GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_33) = {
   .data = { 0x00, },
 };
 GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_31) = {
-  .properties = 0x2a,
+  .properties = 0x3a,
   .max_len = 4,
   .data = { 0x00, 0x00, 0x00, 0x00, },
 };
@@ -199,14 +215,14 @@ GATT_DATA(const sli_bt_gattdb_attribute_t gattdb_attributes_map[]) = {
   { .handle = 0x1c, .uuid = 0x000a, .permissions = 0x803, .caps = 0xffff, .state = 0x00, .datatype = 0x03, .configdata = { .flags = 0x01, .clientconfig_index = 0x02 } },
   { .handle = 0x1d, .uuid = 0x000b, .permissions = 0x803, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_28 },
   { .handle = 0x1e, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_29 },
-  { .handle = 0x1f, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x2a, .char_uuid = 0x8001 } },
+  { .handle = 0x1f, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x3a, .char_uuid = 0x8001 } },
   { .handle = 0x20, .uuid = 0x8001, .permissions = 0x4843, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_31 },
-  { .handle = 0x21, .uuid = 0x000a, .permissions = 0xc03, .caps = 0xffff, .state = 0x00, .datatype = 0x03, .configdata = { .flags = 0x02, .clientconfig_index = 0x03 } },
+  { .handle = 0x21, .uuid = 0x000a, .permissions = 0xc03, .caps = 0xffff, .state = 0x00, .datatype = 0x03, .configdata = { .flags = 0x03, .clientconfig_index = 0x03 } },
   { .handle = 0x22, .uuid = 0x8002, .permissions = 0x803, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_33 },
   { .handle = 0x23, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_34 },
-  { .handle = 0x24, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x2a, .char_uuid = 0x8003 } },
+  { .handle = 0x24, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x3a, .char_uuid = 0x8003 } },
   { .handle = 0x25, .uuid = 0x8003, .permissions = 0x4843, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_36 },
-  { .handle = 0x26, .uuid = 0x000a, .permissions = 0xc03, .caps = 0xffff, .state = 0x00, .datatype = 0x03, .configdata = { .flags = 0x02, .clientconfig_index = 0x04 } },
+  { .handle = 0x26, .uuid = 0x000a, .permissions = 0xc03, .caps = 0xffff, .state = 0x00, .datatype = 0x03, .configdata = { .flags = 0x03, .clientconfig_index = 0x04 } },
   { .handle = 0x27, .uuid = 0x8004, .permissions = 0x803, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_38 },
   { .handle = 0x28, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_39 },
   { .handle = 0x29, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x0a, .char_uuid = 0x8005 } },
@@ -217,21 +233,27 @@ GATT_DATA(const sli_bt_gattdb_attribute_t gattdb_attributes_map[]) = {
   { .handle = 0x2e, .uuid = 0x000a, .permissions = 0xc03, .caps = 0xffff, .state = 0x00, .datatype = 0x03, .configdata = { .flags = 0x02, .clientconfig_index = 0x05 } },
   { .handle = 0x2f, .uuid = 0x8007, .permissions = 0x803, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_46 },
   { .handle = 0x30, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_47 },
-  { .handle = 0x31, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x08, .char_uuid = 0x8008 } },
-  { .handle = 0x32, .uuid = 0x8008, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
+  { .handle = 0x31, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x30, .char_uuid = 0x8008 } },
+  { .handle = 0x32, .uuid = 0x8008, .permissions = 0x4800, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_49 },
+  { .handle = 0x33, .uuid = 0x000a, .permissions = 0xc03, .caps = 0xffff, .state = 0x00, .datatype = 0x03, .configdata = { .flags = 0x03, .clientconfig_index = 0x06 } },
+  { .handle = 0x34, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x0a, .char_uuid = 0x8009 } },
+  { .handle = 0x35, .uuid = 0x8009, .permissions = 0x843, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_52 },
+  { .handle = 0x36, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_53 },
+  { .handle = 0x37, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x08, .char_uuid = 0x800a } },
+  { .handle = 0x38, .uuid = 0x800a, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
 };
 
 GATT_HEADER(const sli_bt_gattdb_t gattdb) = {
   .attributes = gattdb_attributes_map,
-  .attribute_table_size = 50,
-  .attribute_num = 50,
+  .attribute_table_size = 56,
+  .attribute_num = 56,
   .uuid16 = gattdb_uuidtable_16_map,
   .uuid16_table_size = 15,
   .uuid16_num = 15,
   .uuid128 = gattdb_uuidtable_128_map,
-  .uuid128_table_size = 9,
-  .uuid128_num = 9,
-  .num_ccfg = 6,
+  .uuid128_table_size = 11,
+  .uuid128_num = 11,
+  .num_ccfg = 7,
   .caps_mask = 0xffff,
   .enabled_caps = 0xffff,
 };
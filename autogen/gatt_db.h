@@ -27,7 +27,9 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_sleep_time                     42
 #define gattdb_sleep_hours                    45
 #define gattdb_sleep_hours_descriptor         47
-#define gattdb_ota_control                    50
+#define gattdb_sensor_batch                   50
+#define gattdb_sampling_policy                53
+#define gattdb_ota_control                    56
 
 
 #endif // __GATT_DB_H
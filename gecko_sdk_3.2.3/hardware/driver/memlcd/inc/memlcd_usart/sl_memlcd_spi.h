@@ -29,6 +29,11 @@ extern "C" {
 
 #define SL_MEMLCD_SPI_VALUE_NONE 0xFF
 
+#if defined(LDMA_PRESENT)
+/* The asynchronous transfers run on the LDMA. */
+#define SL_MEMLCD_SPI_ASYNC_PRESENT 1
+#endif
+
 /***************************************************************************//**
  * @addtogroup memlcd
  * @{
@@ -49,8 +54,26 @@ typedef struct {
   uint8_t miso_loc;
   uint8_t clk_loc;
 #endif
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT) || defined(DOXYGEN)
+  uint32_t dma_signal;    ///< LDMA request of the USART TX buffer
+  uint8_t dma_channel;    ///< LDMA channel used by the asynchronous transfers
+#endif
 } sli_memlcd_spi_handle_t;
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT) || defined(DOXYGEN)
+/***************************************************************************//**
+ * @brief
+ *   Callback of an asynchronous transfer, called from the LDMA interrupt.
+ *
+ * @param[in] status
+ *   SL_STATUS_OK if all the data has been clocked out, otherwise the error.
+ *
+ * @param[in] ctx
+ *   The context passed to @ref sli_memlcd_spi_tx_async().
+ *****************************************************************************/
+typedef void (*sli_memlcd_spi_callback_t)(sl_status_t status, void *ctx);
+#endif
+
 /***************************************************************************//**
  * @brief
  *   Initialize the SPI interface.
@@ -117,6 +140,51 @@ sl_status_t sli_memlcd_spi_tx(sli_memlcd_spi_handle_t *handle, const void *data,
  *****************************************************************************/
 void sli_memlcd_spi_wait(sli_memlcd_spi_handle_t *handle);
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT) || defined(DOXYGEN)
+/***************************************************************************//**
+ * @brief
+ *   Transmit data on the SPI interface without blocking the CPU.
+ *
+ * @detail
+ *   The data is moved to the USART by the LDMA. The callback is called from
+ *   the LDMA interrupt once the last byte has been clocked out. The data must
+ *   stay valid until then. Only one asynchronous transfer can run at a time.
+ *
+ * @param[in] handle
+ *   Handle to the SPI interface.
+ *
+ * @param[in] data
+ *   Pointer to the data to be transmitted.
+ *
+ * @param[in] len
+ *   Length of data to transmit.
+ *
+ * @param[in] callback
+ *   Function called when the transfer has completed.
+ *
+ * @param[in] ctx
+ *   Context passed to the callback.
+ *
+ * @return
+ *   SL_STATUS_OK if the transfer has been started, SL_STATUS_BUSY if another
+ *   asynchronous transfer is running.
+ *****************************************************************************/
+sl_status_t sli_memlcd_spi_tx_async(sli_memlcd_spi_handle_t *handle,
+                                    const void *data,
+                                    unsigned len,
+                                    sli_memlcd_spi_callback_t callback,
+                                    void *ctx);
+
+/***************************************************************************//**
+ * @brief
+ *   Check whether an asynchronous transfer is running.
+ *
+ * @return
+ *   true if an asynchronous transfer has not completed yet.
+ *****************************************************************************/
+bool sli_memlcd_spi_is_busy(void);
+#endif
+
 /** @} */
 #ifdef __cplusplus
 }
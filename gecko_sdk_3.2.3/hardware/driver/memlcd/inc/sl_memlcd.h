@@ -62,6 +62,13 @@ typedef struct sl_memlcd_t {
   uint8_t hold_us;            ///< SPI CS hold time
 } sl_memlcd_t;
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT) || defined(DOXYGEN)
+/**
+ * Callback of an asynchronous draw, called from interrupt context.
+ */
+typedef void (*sl_memlcd_callback_t)(sl_status_t status, void *ctx);
+#endif
+
 /**************************************************************************//**
  * @brief
  *   Configure the memory LCD device.
@@ -137,6 +144,37 @@ sl_status_t sl_memlcd_draw(const struct sl_memlcd_t *device,
                            unsigned int row_start,
                            unsigned int row_count);
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT) || defined(DOXYGEN)
+/**************************************************************************//**
+ * @brief
+ *   Draw the marked rows to the memory LCD display without blocking.
+ * @details
+ *   The marked rows are copied from the pixel matrix buffer into one
+ *   multi-line update, which the LDMA then sends over SPI. The buffer can be
+ *   modified again as soon as this function returns. EM1 is kept as the
+ *   lowest energy mode until the transfer has completed.
+ * @param[in] device
+ *   Memory LCD display device.
+ * @param[in] data
+ *   Pointer to the pixel matrix buffer of the whole display.
+ * @param[in] rows
+ *   Bitmap of the rows to draw, bit n of word n / 32 is row n.
+ * @param[in] callback
+ *   Function called from interrupt context when the transfer has completed.
+ * @param[in] ctx
+ *   Context passed to the callback.
+ * @return
+ *   SL_STATUS_OK if the transfer has been started and the callback will be
+ *   called, SL_STATUS_EMPTY if no row is marked, SL_STATUS_BUSY if a
+ *   transfer is still running.
+ *****************************************************************************/
+sl_status_t sl_memlcd_draw_async(const struct sl_memlcd_t *device,
+                                 const void *data,
+                                 const uint32_t *rows,
+                                 sl_memlcd_callback_t callback,
+                                 void *ctx);
+#endif
+
 /**************************************************************************//**
  * @brief
  *   Refresh the display device.
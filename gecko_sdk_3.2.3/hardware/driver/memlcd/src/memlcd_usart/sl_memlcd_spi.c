@@ -18,6 +18,30 @@
 #include "em_cmu.h"
 #include "sl_memlcd_spi.h"
 
+#include <stddef.h>
+
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+/* Largest number of bytes moved by one LDMA descriptor. */
+#define DMA_MAX_XFER_COUNT    ((_LDMA_CH_CTRL_XFERCNT_MASK >> _LDMA_CH_CTRL_XFERCNT_SHIFT) + 1)
+/* Number of linked descriptors, enough for a full frame of the display. */
+#define DMA_DESCRIPTOR_COUNT  2
+
+/* LDMA transfer descriptor as read by the hardware. */
+typedef struct {
+  uint32_t ctrl;
+  uint32_t src;
+  uint32_t dst;
+  uint32_t link;
+} dma_descriptor_t;
+
+static dma_descriptor_t dma_descriptors[DMA_DESCRIPTOR_COUNT];
+
+/* State of the running asynchronous transfer, dma_handle is NULL when idle. */
+static sli_memlcd_spi_handle_t * volatile dma_handle = NULL;
+static sli_memlcd_spi_callback_t dma_callback;
+static void *dma_ctx;
+#endif
+
 sl_status_t sli_memlcd_spi_init(sli_memlcd_spi_handle_t *handle, int baudrate, USART_ClockMode_TypeDef mode)
 {
   USART_InitSync_TypeDef init = USART_INITSYNC_DEFAULT;
@@ -86,3 +110,111 @@ void sli_memlcd_spi_wait(sli_memlcd_spi_handle_t *handle)
   while (!(usart->STATUS & USART_STATUS_TXC))
     ;
 }
+
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+sl_status_t sli_memlcd_spi_tx_async(sli_memlcd_spi_handle_t *handle,
+                                    const void *data,
+                                    unsigned len,
+                                    sli_memlcd_spi_callback_t callback,
+                                    void *ctx)
+{
+  const uint8_t *src = data;
+  uint32_t ch_mask = 1UL << handle->dma_channel;
+  unsigned count;
+  unsigned i;
+
+  if (dma_handle != NULL) {
+    return SL_STATUS_BUSY;
+  }
+  if ((len == 0) || (len > DMA_MAX_XFER_COUNT * DMA_DESCRIPTOR_COUNT)) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+
+  /* Build a chain of byte transfers into the TX buffer, paced by TXBL. */
+  for (i = 0; len > 0; i++) {
+    count = (len > DMA_MAX_XFER_COUNT) ? DMA_MAX_XFER_COUNT : len;
+
+    dma_descriptors[i].ctrl = LDMA_CH_CTRL_STRUCTTYPE_TRANSFER
+                              | ((count - 1) << _LDMA_CH_CTRL_XFERCNT_SHIFT)
+                              | LDMA_CH_CTRL_BLOCKSIZE_UNIT1
+                              | LDMA_CH_CTRL_REQMODE_BLOCK
+                              | LDMA_CH_CTRL_SRCINC_ONE
+                              | LDMA_CH_CTRL_SIZE_BYTE
+                              | LDMA_CH_CTRL_DSTINC_NONE;
+    dma_descriptors[i].src  = (uint32_t) src;
+    dma_descriptors[i].dst  = (uint32_t) &handle->usart->TXDATA;
+    dma_descriptors[i].link = 0;
+    if (i > 0) {
+      dma_descriptors[i - 1].link = ((uint32_t) &dma_descriptors[i] & _LDMA_CH_LINK_LINKADDR_MASK)
+                                    | LDMA_CH_LINK_LINK;
+    }
+
+    src += count;
+    len -= count;
+  }
+  /* Only the last descriptor raises the done interrupt. */
+  dma_descriptors[i - 1].ctrl |= LDMA_CH_CTRL_DONEIFSEN;
+
+  dma_callback = callback;
+  dma_ctx      = ctx;
+  dma_handle   = handle;
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  LDMA->IFC = ch_mask | LDMA_IF_ERROR;
+  LDMA->IEN |= ch_mask | LDMA_IEN_ERROR;
+  NVIC_ClearPendingIRQ(LDMA_IRQn);
+  NVIC_EnableIRQ(LDMA_IRQn);
+
+  /* Load the first descriptor and enable the channel. */
+  LDMA->CH[handle->dma_channel].REQSEL = handle->dma_signal;
+  LDMA->CH[handle->dma_channel].CFG    = 0;
+  LDMA->CH[handle->dma_channel].LOOP   = 0;
+  LDMA->CH[handle->dma_channel].LINK   = (uint32_t) &dma_descriptors[0] & _LDMA_CH_LINK_LINKADDR_MASK;
+  LDMA->CHDONE &= ~ch_mask;
+  LDMA->LINKLOAD = ch_mask;
+
+  return SL_STATUS_OK;
+}
+
+bool sli_memlcd_spi_is_busy(void)
+{
+  return dma_handle != NULL;
+}
+
+/***************************************************************************//**
+ * LDMA interrupt handler, completes the running asynchronous transfer.
+ ******************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  sli_memlcd_spi_handle_t *handle = dma_handle;
+  uint32_t pending = LDMA->IF & LDMA->IEN;
+  uint32_t ch_mask;
+  sl_status_t status = SL_STATUS_OK;
+
+  LDMA->IFC = pending;
+
+  if (handle == NULL) {
+    return;
+  }
+
+  ch_mask = 1UL << handle->dma_channel;
+  if (!(pending & (ch_mask | LDMA_IF_ERROR))) {
+    return;
+  }
+
+  if (pending & LDMA_IF_ERROR) {
+    LDMA->CHEN &= ~ch_mask;
+    status = SL_STATUS_FAIL;
+  } else {
+    /* The LDMA is done once the last byte is in the TX buffer,
+       wait until it has been shifted out. */
+    sli_memlcd_spi_wait(handle);
+  }
+
+  dma_handle = NULL;
+  if (dma_callback != NULL) {
+    dma_callback(status, dma_ctx);
+  }
+}
+#endif
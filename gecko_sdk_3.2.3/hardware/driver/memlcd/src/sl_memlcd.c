@@ -14,11 +14,15 @@
  * sections of the MSLA applicable to Source Code.
  *
  ******************************************************************************/
+#if defined(SL_COMPONENT_CATALOG_PRESENT)
+#include "sl_component_catalog.h"
+#endif
 #include "sl_memlcd.h"
 #include "sl_memlcd_display.h"
 #include "sl_sleeptimer.h"
 #include "sl_udelay.h"
-#if defined(SL_CATALOG_POWER_MANAGER_PRESENT) && defined(SL_MEMLCD_USE_EUSART)
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT) \
+  && (defined(SL_MEMLCD_USE_EUSART) || defined(SL_MEMLCD_SPI_ASYNC_PRESENT))
 #include "sl_power_manager.h"
 #endif
 
@@ -39,6 +43,34 @@
 #define SL_MEMLCD_SPI_CLOCK(N) SL_CONCAT(cmuClock_EUSART, N)
 #endif
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+/* Concatenate preprocessor tokens A, B and C. */
+#define SL_CONCAT3(A, B, C) A ## B ## C
+
+/* Generate the LDMA request of the TX buffer based on instance. */
+#define SL_MEMLCD_SPI_TX_DMA_SIGNAL(N) (SL_CONCAT(LDMA_CH_REQSEL_SOURCESEL_USART, N) \
+                                        | SL_CONCAT3(LDMA_CH_REQSEL_SIGSEL_USART, N, TXBL))
+
+/* LDMA channel used for the asynchronous draws. */
+#ifndef SL_MEMLCD_DMA_CHANNEL
+#define SL_MEMLCD_DMA_CHANNEL       0
+#endif
+
+/* Bytes in a multi-line update of every row: the command, an address,
+   the pixels and a dummy byte per row, and the trailing dummy byte. */
+#define ASYNC_ROW_LEN     ((SL_MEMLCD_DISPLAY_WIDTH * SL_MEMLCD_DISPLAY_BPP) / 8)
+#define ASYNC_BUFFER_LEN  (2 + SL_MEMLCD_DISPLAY_HEIGHT * (ASYNC_ROW_LEN + 2))
+
+/** Multi-line update sent by the running asynchronous draw. */
+static uint8_t async_buffer[ASYNC_BUFFER_LEN];
+
+/** Completion callback of the running asynchronous draw. */
+static sl_memlcd_callback_t async_callback;
+static void *async_ctx;
+
+static void async_draw_done(sl_status_t status, void *ctx);
+#endif
+
 #if defined(SL_MEMLCD_EXTCOMIN_PORT)
 /** Timer used for periodic maintenance of the display. */
 static sl_sleeptimer_timer_handle_t extcomin_timer;
@@ -88,6 +120,10 @@ static sli_memlcd_spi_handle_t spi_handle = {
   .miso_loc  = SL_MEMLCD_SPI_VALUE_NONE,
   .clk_loc   = SL_MEMLCD_SPI_CLK_LOC,
 #endif
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+  .dma_signal  = SL_MEMLCD_SPI_TX_DMA_SIGNAL(SL_MEMLCD_SPI_PERIPHERAL_NO),
+  .dma_channel = SL_MEMLCD_DMA_CHANNEL,
+#endif
 };
 #endif
 
@@ -173,6 +209,12 @@ sl_status_t sl_memlcd_clear(const struct sl_memlcd_t *device)
 {
   uint16_t cmd;
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+  if (sli_memlcd_spi_is_busy()) {
+    return SL_STATUS_BUSY;
+  }
+#endif
+
   /* Set SCS */
   GPIO_PinOutSet(SL_MEMLCD_SPI_CS_PORT, SL_MEMLCD_SPI_CS_PIN);
 
@@ -203,6 +245,12 @@ sl_status_t sl_memlcd_draw(const struct sl_memlcd_t *device, const void *data, u
   uint8_t reversed_row;
 #endif
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+  if (sli_memlcd_spi_is_busy()) {
+    return SL_STATUS_BUSY;
+  }
+#endif
+
   row_len = (device->width * device->bpp) / 8;
   row_start++;
 
@@ -262,6 +310,103 @@ sl_status_t sl_memlcd_draw(const struct sl_memlcd_t *device, const void *data, u
   return SL_STATUS_OK;
 }
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+sl_status_t sl_memlcd_draw_async(const struct sl_memlcd_t *device,
+                                 const void *data,
+                                 const uint32_t *rows,
+                                 sl_memlcd_callback_t callback,
+                                 void *ctx)
+{
+#if defined(SL_MEMLCD_LPM013M126A)
+  (void) device;
+  (void) data;
+  (void) rows;
+  (void) callback;
+  (void) ctx;
+  (void) async_draw_done;
+
+  /* The LPM013M126A uses a different command layout */
+  return SL_STATUS_NOT_SUPPORTED;
+#else
+  const uint8_t *src = data;
+  uint8_t *p = async_buffer;
+  unsigned int row;
+  int row_len;
+  sl_status_t status;
+
+  if (sli_memlcd_spi_is_busy()) {
+    return SL_STATUS_BUSY;
+  }
+
+  row_len = (device->width * device->bpp) / 8;
+
+  /* Every line of a multi-line update carries its own address, so the rows
+     do not have to be consecutive and go out in a single transfer. */
+  *p++ = CMD_UPDATE;
+  for (row = 0; row < device->height; row++) {
+    if (!(rows[row / 32] & (1UL << (row % 32)))) {
+      continue;
+    }
+    *p++ = (uint8_t) (row + 1);
+    memcpy(p, src + row * row_len, row_len);
+    p += row_len;
+    *p++ = 0xff;
+  }
+  if (p == &async_buffer[1]) {
+    return SL_STATUS_EMPTY;
+  }
+  *p++ = 0xff;
+
+  async_callback = callback;
+  async_ctx = ctx;
+
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+  /* The USART and the LDMA do not run in EM2 */
+  sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+#endif
+
+  /* Assert SCS */
+  GPIO_PinOutSet(SL_MEMLCD_SPI_CS_PORT, SL_MEMLCD_SPI_CS_PIN);
+
+  /* SCS setup time */
+  sl_udelay_wait(device->setup_us);
+
+  status = sli_memlcd_spi_tx_async(&spi_handle, async_buffer, p - async_buffer,
+                                   async_draw_done, (void *) device);
+  if (status != SL_STATUS_OK) {
+    GPIO_PinOutClear(SL_MEMLCD_SPI_CS_PORT, SL_MEMLCD_SPI_CS_PIN);
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+    sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+#endif
+  }
+
+  return status;
+#endif
+}
+
+/***************************************************************************//**
+ * Completion of an asynchronous draw, called from the LDMA interrupt.
+ ******************************************************************************/
+static void async_draw_done(sl_status_t status, void *ctx)
+{
+  const sl_memlcd_t *device = ctx;
+
+  /* SCS hold time */
+  sl_udelay_wait(device->hold_us);
+
+  /* De-assert SCS */
+  GPIO_PinOutClear(SL_MEMLCD_SPI_CS_PORT, SL_MEMLCD_SPI_CS_PIN);
+
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+  sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+#endif
+
+  if (async_callback != NULL) {
+    async_callback(status, async_ctx);
+  }
+}
+#endif
+
 const sl_memlcd_t *sl_memlcd_get(void)
 {
   if (initialized) {
@@ -18,6 +18,7 @@
 #include "dmd.h"
 #include "sl_memlcd.h"
 #include "sl_memlcd_display.h"
+#include "em_core.h"
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -47,7 +48,17 @@ static uint32_t dirtyRows[(SL_MEMLCD_DISPLAY_HEIGHT  + (sizeof(uint32_t) * 8 - 1
 /* This framebuffer is large enough to store one full frame. */
 static uint8_t framebuffer[(SL_MEMLCD_DISPLAY_WIDTH * SL_MEMLCD_DISPLAY_HEIGHT * SL_MEMLCD_DISPLAY_BPP) / 8];
 
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+/* Completion callback of the running asynchronous update. */
+static DMD_UpdateCallback updateCallback;
+static void *updateCtx;
+
+/* Rows sent by the running asynchronous update, dirty again if it fails. */
+static uint32_t updateRows[sizeof(dirtyRows) / sizeof(dirtyRows[0])];
+#endif
+
 static void setLineDirty(int line);
+static void restoreDirtyRows(const uint32_t *rows);
 
 EMSTATUS DMD_init(DMD_InitConfig *initConfig)
 {
@@ -515,59 +526,137 @@ EMSTATUS DMD_selectFramebuffer(void *framebuffer)
 EMSTATUS DMD_updateDisplay(void)
 {
   sl_status_t   status;
+  uint32_t      pendingRows[sizeof(dirtyRows) / sizeof(dirtyRows[0])];
+  unsigned int  dirtyWordCnt = sizeof(dirtyRows) / sizeof(dirtyRows[0]);
+  unsigned int  word;
   unsigned int  startRow;
-  unsigned int  consecutiveDirtyRows;
+  unsigned int  row;
+  uint32_t      flags;
   uint8_t      *pStartRow;
   int           bytesPerRow  = (SL_MEMLCD_DISPLAY_WIDTH * SL_MEMLCD_DISPLAY_BPP) / 8;
-  uint32_t      dirtyFlags   = dirtyRows[0];
-  int           dirtyWordCnt = 1;
-
-  startRow             = 0;
-  consecutiveDirtyRows = 0;
-
-  while (startRow + consecutiveDirtyRows < memlcd->height) {
-    if (dirtyFlags & 0x1) {
-      consecutiveDirtyRows++;
-    } else {
-      if (consecutiveDirtyRows) {
-        /* We have reached the end of a series of consecutive dirty rows,
-           update display now. */
-        pStartRow = (uint8_t*) framebuffer + startRow * bytesPerRow;
-        status = sl_memlcd_draw(memlcd, pStartRow, startRow, consecutiveDirtyRows);
-        if (status != SL_STATUS_OK) {
-          return DMD_ERROR_MEMORY_ERROR;
-        }
+  CORE_DECLARE_IRQ_STATE;
 
-        startRow += consecutiveDirtyRows + 1;
-        consecutiveDirtyRows = 0;
-      } else {
-        startRow++;
+  /* Take the dirty rows and clear the flags in one step, so that rows marked
+     dirty while the transfer is running are kept for the next update. */
+  CORE_ENTER_ATOMIC();
+  memcpy(pendingRows, dirtyRows, sizeof(dirtyRows));
+  memset(dirtyRows, 0x0, sizeof(dirtyRows));
+  CORE_EXIT_ATOMIC();
+
+  row = 0;
+  while (row < memlcd->height) {
+    /* Find the first dirty row, skipping a whole word of clean rows at once. */
+    word  = row >> DIRTY_WORD_BITS_LOG2;
+    flags = pendingRows[word] & (0xFFFFFFFFUL << (row & DIRTY_WORD_BITS_LOG2_MASK));
+    while (flags == 0) {
+      if (++word >= dirtyWordCnt) {
+        return DMD_OK;
       }
+      flags = pendingRows[word];
+    }
+    startRow = (word << DIRTY_WORD_BITS_LOG2) + __builtin_ctz(flags);
+    if (startRow >= memlcd->height) {
+      break;
     }
 
-    /* Shift down dirtyFlags until
-       all dirtyFlags in the current dirty word have been checked,
-       then set to next dirty word.  */
-    if ( (startRow + consecutiveDirtyRows) & DIRTY_WORD_BITS_LOG2_MASK ) {
-      dirtyFlags >>= 1;
+    /* Find the first clean row after it, the run may span several words. */
+    flags = ~pendingRows[word] & (0xFFFFFFFFUL << (startRow & DIRTY_WORD_BITS_LOG2_MASK));
+    while (flags == 0) {
+      if (++word >= dirtyWordCnt) {
+        break;
+      }
+      flags = ~pendingRows[word];
+    }
+    if (flags) {
+      row = (word << DIRTY_WORD_BITS_LOG2) + __builtin_ctz(flags);
     } else {
-      dirtyFlags = dirtyRows[dirtyWordCnt++];
+      row = dirtyWordCnt << DIRTY_WORD_BITS_LOG2;
+    }
+    if (row > memlcd->height) {
+      row = memlcd->height;
     }
-  }
 
-  /* Check if there dirty rows at end that have not been written yet. */
-  if (consecutiveDirtyRows) {
+    /* Send the whole run of consecutive dirty rows in one multi-line write. */
     pStartRow = (uint8_t*) framebuffer + startRow * bytesPerRow;
-    status = sl_memlcd_draw(memlcd, pStartRow, startRow, consecutiveDirtyRows);
+    status = sl_memlcd_draw(memlcd, pStartRow, startRow, row - startRow);
     if (status != SL_STATUS_OK) {
+      /* Mark the rows dirty again so that the next update retries them. */
+      restoreDirtyRows(pendingRows);
       return DMD_ERROR_MEMORY_ERROR;
     }
   }
 
-  /* Clear dirty rows flags. */
+  return DMD_OK;
+}
+
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+/***************************************************************************//**
+ * @brief
+ *   Completion of an asynchronous update, called from interrupt context.
+ ******************************************************************************/
+static void updateDisplayDone(sl_status_t status, void *ctx)
+{
+  (void) ctx;
+
+  if (status != SL_STATUS_OK) {
+    /* Mark the rows dirty again so that the next update retries them. */
+    restoreDirtyRows(updateRows);
+  }
+
+  if (updateCallback != NULL) {
+    updateCallback((status == SL_STATUS_OK) ? DMD_OK : DMD_ERROR_MEMORY_ERROR, updateCtx);
+  }
+}
+#endif
+
+EMSTATUS DMD_updateDisplayAsync(DMD_UpdateCallback callback, void *ctx)
+{
+#if defined(SL_MEMLCD_SPI_ASYNC_PRESENT)
+  sl_status_t   status;
+  uint32_t      pendingRows[sizeof(dirtyRows) / sizeof(dirtyRows[0])];
+  CORE_DECLARE_IRQ_STATE;
+
+  /* The callback and the rows of the running update must be kept. */
+  if (sli_memlcd_spi_is_busy()) {
+    return DMD_ERROR_DRIVER_BUSY;
+  }
+
+  /* Take the dirty rows and clear the flags in one step, as in
+     DMD_updateDisplay(). */
+  CORE_ENTER_ATOMIC();
+  memcpy(pendingRows, dirtyRows, sizeof(dirtyRows));
   memset(dirtyRows, 0x0, sizeof(dirtyRows));
+  CORE_EXIT_ATOMIC();
 
-  return DMD_OK;
+  updateCallback = callback;
+  updateCtx      = ctx;
+  memcpy(updateRows, pendingRows, sizeof(updateRows));
+
+  status = sl_memlcd_draw_async(memlcd, framebuffer, pendingRows, updateDisplayDone, NULL);
+  switch (status) {
+    case SL_STATUS_OK:
+      return DMD_OK;
+
+    case SL_STATUS_EMPTY:
+      /* Nothing to send, the update is complete already. */
+      if (callback != NULL) {
+        callback(DMD_OK, ctx);
+      }
+      return DMD_OK;
+
+    case SL_STATUS_BUSY:
+      restoreDirtyRows(pendingRows);
+      return DMD_ERROR_DRIVER_BUSY;
+
+    default:
+      restoreDirtyRows(pendingRows);
+      return DMD_ERROR_MEMORY_ERROR;
+  }
+#else
+  (void) callback;
+  (void) ctx;
+  return DMD_ERROR_NOT_SUPPORTED;
+#endif
 }
 
 EMSTATUS DMD_getFrameBuffer(void **fb)
@@ -586,4 +675,20 @@ static void setLineDirty(int line)
   dirtyRows[line >> DIRTY_WORD_BITS_LOG2] |= 1 << (line & DIRTY_WORD_BITS_LOG2_MASK);
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Mark the rows of an update that was not sent as dirty again.
+ ******************************************************************************/
+static void restoreDirtyRows(const uint32_t *rows)
+{
+  unsigned int word;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  for (word = 0; word < sizeof(dirtyRows) / sizeof(dirtyRows[0]); word++) {
+    dirtyRows[word] |= rows[word];
+  }
+  CORE_EXIT_ATOMIC();
+}
+
 /** @endcond */
@@ -73,6 +73,8 @@
 #define DMD_ERROR_NOT_SUPPORTED                 (ECODE_DMD_BASE | 0x000a)
 /** Not enough memory.  */
 #define DMD_ERROR_NOT_ENOUGH_MEMORY             (ECODE_DMD_BASE | 0x000b)
+/** Error code: A display update is still in progress */
+#define DMD_ERROR_DRIVER_BUSY                   (ECODE_DMD_BASE | 0x000c)
 
 /* Tests */
 /** Device code test */
@@ -127,6 +129,10 @@ typedef struct __DMD_MemoryError{
   uint8_t  readColor[3];
 } DMD_MemoryError; /**< Typedef for memory error information */
 
+/** Callback of an asynchronous display update, called from interrupt
+    context with DMD_OK or the error of the transfer. */
+typedef void (*DMD_UpdateCallback)(EMSTATUS status, void *ctx);
+
 /***************************************************************************//**
  *  @brief
  *    Initializes the DMD support for memory lcd display
@@ -315,6 +321,29 @@ EMSTATUS DMD_getFrameBuffer (void **framebuffer);
  ******************************************************************************/
 EMSTATUS DMD_updateDisplay (void);
 
+/***************************************************************************//**
+ *  @brief
+ *    Start updating the display device with contents of active framebuffer
+ *    without waiting for the transfer.
+ *
+ *  @details
+ *    Like DMD_updateDisplay(), only the dirty rows/lines are sent. They are
+ *    copied out of the framebuffer before this function returns, so drawing
+ *    can continue during the transfer. Rows drawn meanwhile stay dirty for
+ *    the next update, as do the rows of a transfer that fails.
+ *
+ *  @param[in] callback
+ *    Function called once the update has completed.
+ *  @param[in] ctx
+ *    Context passed to the callback.
+ *
+ *  @return
+ *    DMD_OK if the update has been started and the callback will be called,
+ *    DMD_ERROR_DRIVER_BUSY if the previous update is still in progress,
+ *    error otherwise.
+ ******************************************************************************/
+EMSTATUS DMD_updateDisplayAsync (DMD_UpdateCallback callback, void *ctx);
+
 /** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
 /* Test functions */
 EMSTATUS DMD_testParameterChecks(void);
@@ -225,6 +225,7 @@ typedef enum __GLIB_Font_Class{
   InvalidFont = 0,  /**< Invalid font. */
   FullFont,         /**< Characters and numbers font. */
   NumbersOnlyFont,  /**< Numbers only font. */
+  PackedFont,       /**< Glyph-major bit-packed font, see GLIB_PackedFont_t. */
 } GLIB_Font_Class;
 
 /** @brief Alignment types
@@ -267,6 +268,29 @@ typedef struct __GLIB_Font_t{
   GLIB_Font_Class class;
 } GLIB_Font_t;
 
+/** @brief Pixel data of a PackedFont, pointed to by pFontPixMap
+ *
+ *  Every glyph is stored as fontHeight rows of fontWidth bits in glyphBytes
+ *  consecutive bytes, the leftmost pixel of the first row in the LSB of the
+ *  first byte. This is the bit order of a 1 bpp memory LCD row. The glyph
+ *  table is followed by two padding bytes so that a row can be fetched with
+ *  three byte reads. cntOfMapElements holds the number of glyphs and
+ *  sizeOfMapElement the glyph size in bytes.
+ */
+typedef struct __GLIB_PackedFont_t{
+  /** Bitmaps of all the glyphs. */
+  const uint8_t *pGlyphs;
+
+  /** Ink width of every glyph in pixels, 0 for a blank glyph. */
+  const uint8_t *pWidths;
+
+  /** Number of bytes of each glyph bitmap. */
+  uint8_t glyphBytes;
+
+  /** Character of the first glyph. */
+  char firstChar;
+} GLIB_PackedFont_t;
+
 /** @brief Rectangle structure
  */
 typedef struct __GLIB_Rectangle_t{
@@ -344,6 +368,9 @@ EMSTATUS GLIB_drawString(GLIB_Context_t *pContext, const char* pString, uint32_t
 EMSTATUS GLIB_drawStringOnLine(GLIB_Context_t *pContext, const char *pString, uint8_t line,
                                GLIB_Align_t align, int32_t xOffset, int32_t yOffset, bool opaque);
 
+EMSTATUS GLIB_drawStringOnClearedLine(GLIB_Context_t *pContext, const char *pString, uint8_t line,
+                                      GLIB_Align_t align, int32_t xOffset, int32_t yOffset);
+
 EMSTATUS GLIB_drawChar(GLIB_Context_t *pContext, char myChar, int32_t x,
                        int32_t y, bool opaque);
 
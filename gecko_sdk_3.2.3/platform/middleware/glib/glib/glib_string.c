@@ -26,6 +26,15 @@
 #include "glib.h"
 #include "glib_color.h"
 
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+/* Size of the buffer GLIB_drawStringOnClearedLine() composes a whole text
+   line in, enough for 1 bpp lines up to 256 pixels wide and 8 pixels high. */
+#define GLIB_LINE_BUFFER_LEN    256
+
+static int32_t glyphIndex(const GLIB_Font_t *pFont, char myChar);
+static uint32_t packedGlyphRow(const GLIB_Font_t *pFont, uint32_t fontIdx, uint16_t row);
+/** @endcond */
+
 /**************************************************************************//**
 *  @brief
 *  Draws a char using the font supplied with the library.
@@ -81,6 +90,8 @@ EMSTATUS GLIB_drawChar(GLIB_Context_t *pContext, char myChar, int32_t x, int32_t
     if (myChar == ' ') {
       fontIdx = 11;
     }
+  } else if (pContext->font.class == PackedFont) {
+    fontIdx = myChar - ((const GLIB_PackedFont_t *)pContext->font.pFontPixMap)->firstChar;
   } else { /* FullFont class */
     fontIdx = myChar - ' ';
   }
@@ -95,17 +106,21 @@ EMSTATUS GLIB_drawChar(GLIB_Context_t *pContext, char myChar, int32_t x, int32_t
   pPixMap32 = (uint32_t *)pContext->font.pFontPixMap;
 
   for (row = 0; row < pContext->font.fontHeight; row++) {
-    switch (pContext->font.sizeOfMapElement) {
-      case 1:
-        currentRow = pPixMap8[fontIdx];
-        break;
+    if (pContext->font.class == PackedFont) {
+      currentRow = packedGlyphRow(&pContext->font, fontIdx, row);
+    } else {
+      switch (pContext->font.sizeOfMapElement) {
+        case 1:
+          currentRow = pPixMap8[fontIdx];
+          break;
 
-      case 2:
-        currentRow = pPixMap16[fontIdx];
-        break;
+        case 2:
+          currentRow = pPixMap16[fontIdx];
+          break;
 
-      default:
-        currentRow = pPixMap32[fontIdx];
+        default:
+          currentRow = pPixMap32[fontIdx];
+      }
     }
 
     for (xOffset = 0; xOffset < pContext->font.fontWidth; ++xOffset) {
@@ -314,3 +329,260 @@ EMSTATUS GLIB_drawStringOnLine(GLIB_Context_t *pContext, const char *pString, ui
 
   return GLIB_drawString(pContext, pString, length, x, y, opaque);
 }
+
+/**************************************************************************//**
+*  @brief
+*  Draws a string on the specified line on the display and clears the rest of
+*  the line with the background color in the same pass.
+*
+*  The string is placed as by GLIB_drawStringOnLine() with opaque set. For
+*  fonts up to 16 pixels wide the glyph rows are copied from the font pixel
+*  map straight into a 1 bpp buffer of the whole line, which is then written
+*  to the display with a single DMD_writeData() call. Other fonts, clipping
+*  regions or strings with newlines fall back to filling the line and
+*  calling GLIB_drawStringOnLine().
+*
+*  @param pContext
+*  Pointer to a GLIB_Context_t
+*
+*  @param pString
+*  Pointer to the string that is drawn
+*
+*  @param line
+*  Specifies which line on the display to draw on.
+*
+*  @param align
+*  Horizontal alignment of the string on the line.
+*
+*  @param xOffset
+*  Horizontal offset of the string, as for GLIB_drawStringOnLine().
+*
+*  @param yOffset
+*  Vertical offset of the line, as for GLIB_drawStringOnLine().
+*
+*  @return
+*  Returns GLIB_OK on success, or else error code
+******************************************************************************/
+EMSTATUS GLIB_drawStringOnClearedLine(GLIB_Context_t *pContext, const char *pString, uint8_t line,
+                                      GLIB_Align_t align, int32_t xOffset, int32_t yOffset)
+{
+  EMSTATUS status;
+  uint8_t lineBits[GLIB_LINE_BUFFER_LEN];
+  GLIB_Rectangle_t lineRect;
+  uint32_t savedColor;
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+  bool fgSet;
+  int32_t x, y;
+  int32_t width, height;
+  int32_t cellWidth;
+  int32_t xChar;
+  int32_t fontIdx;
+  uint32_t bytesPerRow;
+  uint32_t glyphMask;
+  uint32_t glyphRow;
+  uint64_t glyphBits = 0;
+  const GLIB_PackedFont_t *pPacked = NULL;
+  const uint8_t *pGlyph;
+  uint32_t bits;
+  uint8_t *pDst;
+  size_t length;
+  size_t i;
+  uint16_t row;
+
+  /* Check arguments */
+  if (pContext == NULL || pString == NULL) {
+    return GLIB_ERROR_INVALID_ARGUMENT;
+  }
+
+  if (pContext->font.class == InvalidFont) {
+    return GLIB_ERROR_INVALID_CHAR;
+  }
+
+  width     = pContext->pDisplayGeometry->xSize;
+  height    = pContext->font.fontHeight;
+  cellWidth = pContext->font.fontWidth + pContext->font.charSpacing;
+  length    = strlen(pString);
+
+  /* Same placement as GLIB_drawStringOnLine() */
+  y = line * (pContext->font.fontHeight + pContext->font.lineSpacing) + yOffset;
+  switch (align) {
+    case GLIB_ALIGN_CENTER:
+      x = (width - (int32_t)(length * pContext->font.fontWidth)) / 2;
+      break;
+    case GLIB_ALIGN_RIGHT:
+      x = width - (int32_t)(length * pContext->font.fontWidth);
+      break;
+    default:
+      x = 0;
+      break;
+  }
+  x += xOffset;
+
+  lineRect.xMin = 0;
+  lineRect.yMin = y;
+  lineRect.xMax = width - 1;
+  lineRect.yMax = y + height - 1;
+  bytesPerRow = width / 8;
+
+  if ((width % 8) || ((bytesPerRow * height) > sizeof(lineBits))
+      || ((pContext->font.class != PackedFont) && (pContext->font.sizeOfMapElement > 2))
+      || (cellWidth > 16)
+      || (pContext->clippingRegion.xMin > lineRect.xMin)
+      || (pContext->clippingRegion.xMax < lineRect.xMax)
+      || (pContext->clippingRegion.yMin > lineRect.yMin)
+      || (pContext->clippingRegion.yMax < lineRect.yMax)
+      || (strchr(pString, '\n') != NULL)) {
+    /* Clear the line with the background color, then draw the string */
+    savedColor = pContext->foregroundColor;
+    pContext->foregroundColor = pContext->backgroundColor;
+    status = GLIB_drawRectFilled(pContext, &lineRect);
+    pContext->foregroundColor = savedColor;
+    if (status != GLIB_OK) {
+      return status;
+    }
+    return GLIB_drawStringOnLine(pContext, pString, line, align, xOffset, yOffset, true);
+  }
+
+  /* Monochrome displays only use the green channel */
+  GLIB_colorTranslate24bpp(pContext->backgroundColor, &red, &green, &blue);
+  memset(lineBits, green ? 0xFF : 0x00, bytesPerRow * height);
+  GLIB_colorTranslate24bpp(pContext->foregroundColor, &red, &green, &blue);
+  fgSet = (green != 0);
+
+  glyphMask = (1UL << pContext->font.fontWidth) - 1;
+
+  for (i = 0; i < length; i++) {
+    fontIdx = glyphIndex(&pContext->font, pString[i]);
+    if (fontIdx < 0) {
+      return GLIB_ERROR_INVALID_CHAR;
+    }
+
+    /* Characters partly outside of the line are cut off */
+    xChar = x + (int32_t)i * cellWidth;
+    if ((xChar + pContext->font.fontWidth <= 0) || (xChar >= width)) {
+      continue;
+    }
+
+    if (pContext->font.class == PackedFont) {
+      pPacked = (const GLIB_PackedFont_t *)pContext->font.pFontPixMap;
+      /* Blank glyphs leave the background as it is */
+      if (pPacked->pWidths[fontIdx] == 0) {
+        continue;
+      }
+      /* Glyphs of up to 64 bits are fetched once and shifted row by row */
+      if (pPacked->glyphBytes <= sizeof(glyphBits)) {
+        pGlyph = &pPacked->pGlyphs[fontIdx * pPacked->glyphBytes];
+        glyphBits = 0;
+        for (row = pPacked->glyphBytes; row > 0; row--) {
+          glyphBits = (glyphBits << 8) | pGlyph[row - 1];
+        }
+      }
+    }
+
+    for (row = 0; row < height; row++) {
+      if ((pContext->font.class == PackedFont)
+          && (pPacked->glyphBytes <= sizeof(glyphBits))) {
+        glyphRow = (uint32_t)glyphBits;
+        glyphBits >>= pContext->font.fontWidth;
+      } else if (pContext->font.class == PackedFont) {
+        glyphRow = packedGlyphRow(&pContext->font, fontIdx, row);
+      } else if (pContext->font.sizeOfMapElement == 1) {
+        glyphRow = ((const uint8_t *)pContext->font.pFontPixMap)[fontIdx];
+      } else {
+        glyphRow = ((const uint16_t *)pContext->font.pFontPixMap)[fontIdx];
+      }
+      glyphRow &= glyphMask;
+      fontIdx += pContext->font.fontRowOffset;
+
+      if (xChar < 0) {
+        glyphRow >>= -xChar;
+        bits = glyphRow;
+        pDst = &lineBits[row * bytesPerRow];
+      } else {
+        bits = glyphRow << (xChar & 0x7);
+        pDst = &lineBits[row * bytesPerRow + (xChar >> 3)];
+      }
+      if (xChar + pContext->font.fontWidth > width) {
+        bits &= (1UL << (width - (xChar < 0 ? 0 : (xChar & ~0x7)))) - 1;
+      }
+
+      /* Bit 1 in the glyph means foreground, the rest stays background */
+      while (bits) {
+        if (fgSet) {
+          *pDst |= (uint8_t)bits;
+        } else {
+          *pDst &= (uint8_t)~bits;
+        }
+        pDst++;
+        bits >>= 8;
+      }
+    }
+  }
+
+  /* Write the whole line in one go */
+  status = DMD_setClippingArea(0, y, width, height);
+  if (status != DMD_OK) {
+    return status;
+  }
+
+  status = DMD_writeData(0, 0, lineBits, width * height);
+  if (status != DMD_OK) {
+    return status;
+  }
+
+  /* Reset driver clipping area to GLIB clipping region */
+  return GLIB_applyClippingRegion(pContext);
+}
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+/**************************************************************************//**
+*  @brief
+*  Returns the index of a character in the font pixel map, or -1 if the font
+*  has no glyph for it.
+******************************************************************************/
+static int32_t glyphIndex(const GLIB_Font_t *pFont, char myChar)
+{
+  int32_t fontIdx;
+
+  if ((myChar < ' ') || (myChar > '~')) {
+    return -1;
+  }
+
+  if (pFont->class == NumbersOnlyFont) {
+    fontIdx = (myChar - '0');
+    if (myChar == ':') {
+      fontIdx = 10;
+    }
+    if (myChar == ' ') {
+      fontIdx = 11;
+    }
+  } else if (pFont->class == PackedFont) {
+    fontIdx = myChar - ((const GLIB_PackedFont_t *)pFont->pFontPixMap)->firstChar;
+  } else { /* FullFont class */
+    fontIdx = myChar - ' ';
+  }
+
+  if ((fontIdx < 0) || (fontIdx > (pFont->cntOfMapElements - 1))) {
+    return -1;
+  }
+
+  return fontIdx;
+}
+
+/**************************************************************************//**
+*  @brief
+*  Returns one row of a glyph of a PackedFont, the leftmost pixel in the LSB.
+******************************************************************************/
+static uint32_t packedGlyphRow(const GLIB_Font_t *pFont, uint32_t fontIdx, uint16_t row)
+{
+  const GLIB_PackedFont_t *pPacked = (const GLIB_PackedFont_t *)pFont->pFontPixMap;
+  uint32_t bit = (uint32_t)row * pFont->fontWidth;
+  const uint8_t *p = &pPacked->pGlyphs[fontIdx * pPacked->glyphBytes + (bit >> 3)];
+
+  /* A row of up to 16 pixels spans at most three bytes */
+  return ((p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16)) >> (bit & 0x7))
+         & ((1UL << pFont->fontWidth) - 1);
+}
+/** @endcond */
@@ -0,0 +1,153 @@
+/**
+ * @file bench_circular_buffer.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host benchmark of the pending indication ring of circular_buffer.c:
+ * - the host time of a write_queue() and read_queue() pair,
+ * - the host time of a write_queue() that replaces a queued value in place,
+ * - the host time of remove_queue_by_characteristic() on a full ring,
+ *   against draining the ring and queueing back every other entry, the
+ *   way an entry was removed before the per-characteristic index, which
+ *   the program checks is slower.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <time.h>
+#include "host_test.h"
+#include "circular_buffer.h"
+
+#define TEST_CONNECTION             (1)
+// calls per timed operation
+#define TIMED_CALLS                 (1000000)
+// full rings per timed removal
+#define TIMED_REMOVALS              (50000)
+
+static uint8_t  value[4] = { 0x12, 0x34, 0x56, 0x78 };
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host monotonic time in ns.
+// ---------------------------------------------------------------------
+static uint64_t host_ns()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void fill()
+{
+  uint32_t i;
+
+  clear_queue();
+  for(i=0;i<QUEUE_DEPTH;i++){
+      if(write_queue(TEST_CONNECTION, (uint16_t)(i + 1), sizeof(value), value))
+        host_test_failures++;
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Remove a characteristic by draining the ring and queueing back the
+// other entries.
+// ---------------------------------------------------------------------
+static void remove_by_requeue(uint16_t characteristic)
+{
+  uint8_t connection[QUEUE_DEPTH];
+  uint16_t handle[QUEUE_DEPTH];
+  size_t len[QUEUE_DEPTH];
+  uint8_t data[QUEUE_DEPTH][MAX_INDICATION_VALUE_LEN];
+  uint32_t count = 0, i;
+
+  while((count < QUEUE_DEPTH) && \
+        !read_queue(&connection[count], &handle[count], &len[count], data[count])){
+      count++;
+  }
+  for(i=0;i<count;i++){
+      if(handle[i] != characteristic)
+        write_queue(connection[i], handle[i], len[i], data[i]);
+  }
+}
+
+static double time_pairs()
+{
+  uint8_t connection, data[MAX_INDICATION_VALUE_LEN];
+  uint16_t handle;
+  size_t len;
+  uint64_t start;
+  uint32_t i;
+
+  clear_queue();
+  start = host_ns();
+  for(i=0;i<TIMED_CALLS;i++){
+      write_queue(TEST_CONNECTION, (uint16_t)((i & 7) + 1), sizeof(value), value);
+      if(read_queue(&connection, &handle, &len, data))
+        host_test_failures++;
+  }
+  return (double)(host_ns() - start) / TIMED_CALLS;
+}
+
+static double time_coalesced()
+{
+  uint64_t start;
+  uint32_t i;
+
+  fill();
+  start = host_ns();
+  for(i=0;i<TIMED_CALLS;i++){
+      value[0] = (uint8_t)i;
+      write_queue(TEST_CONNECTION, (uint16_t)((i & QUEUE_MASK) + 1), sizeof(value), value);
+  }
+  if(get_queue_depth() != QUEUE_DEPTH)
+    host_test_failures++;
+  return (double)(host_ns() - start) / TIMED_CALLS;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host time of a removal from the middle of a full ring, in ns. Only the
+// removal is timed, less the cost of reading the clock.
+// ---------------------------------------------------------------------
+static double time_removal(void (*remove)(uint16_t))
+{
+  uint64_t start, total = 0, clock_cost = 0;
+  uint32_t i;
+
+  for(i=0;i<TIMED_REMOVALS;i++){
+      start = host_ns();
+      clock_cost += host_ns() - start;
+  }
+
+  for(i=0;i<TIMED_REMOVALS;i++){
+      fill();
+      start = host_ns();
+      remove(QUEUE_DEPTH / 2);
+      total += host_ns() - start;
+  }
+  if(total < clock_cost)
+    return 0;
+  return (double)(total - clock_cost) / TIMED_REMOVALS;
+}
+
+int main()
+{
+  double indexed, requeue;
+
+  printf("per call, host time\n");
+  printf("write + read      %6.1f ns\n", time_pairs());
+  printf("coalesced write   %6.1f ns\n", time_coalesced());
+
+  indexed = time_removal(remove_queue_by_characteristic);
+  requeue = time_removal(remove_by_requeue);
+  printf("remove, %2u queued %6.1f ns   drain and requeue %6.1f ns\n", \
+         (unsigned int)QUEUE_DEPTH, indexed, requeue);
+
+  CHECK(indexed < requeue);
+
+  return host_test_result("bench_circular_buffer");
+}
@@ -0,0 +1,234 @@
+/**
+ * @file bench_dmd_memlcd.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host benchmark of the bytes clocked out to the memory LCD for
+ * typical displayPrintf() patterns. The same dirty lines are sent three
+ * ways and the bytes seen by the fake USART1 are counted:
+ * - per line: one sl_memlcd_draw() per dirty line, as DMD_updateDisplay()
+ *   did before the dirty rows were merged into runs,
+ * - runs: DMD_updateDisplay(), one multi-line write per run of dirty lines,
+ * - async: displayFlush(), one LDMA transfer of every dirty line.
+ * The line spacing of the font leaves clean lines between the text rows,
+ * so every row drawn is a run of its own and only async merges rows.
+ * The program fails if a merged update sends more than the per-line one,
+ * or if an identical rewrite sends anything.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "dmd.h"
+#include "sl_memlcd.h"
+#include "sl_memlcd_display.h"
+#include "host_test.h"
+#include "host_hw.h"
+#include "host_fakes.h"
+#include "lcd.h"
+#include "scheduler.h"
+
+// pixel bytes of a line
+#define LINE_BYTES                  ((SL_MEMLCD_DISPLAY_WIDTH * SL_MEMLCD_DISPLAY_BPP) / 8)
+#define CAPTURE_LEN                 (4096)
+// flushes measured per pattern, each with new values
+#define BENCH_ROUNDS                (3)
+// simulated time given to an asynchronous flush
+#define FLUSH_LIMIT_MS              (100)
+
+/**
+ * A displayPrintf() pattern
+ */
+typedef struct {
+  const char *name;
+  uint8_t num_rows;
+  enum display_row rows[DISPLAY_NUMBER_OF_ROWS];
+  bool identical;              // rewrite the strings already shown
+}bench_pattern_t;
+
+/**
+ * Bytes clocked out by the three paths for one pattern
+ */
+typedef struct {
+  uint32_t lines;
+  uint32_t per_line;
+  uint32_t runs;
+  uint32_t num_runs;
+  uint32_t async;
+}bench_result_t;
+
+static const bench_pattern_t patterns[] = {
+  { "one value row",     1, { DISPLAY_ROW_TEMPVALUE }, false },
+  { "two adjacent rows", 2, { DISPLAY_ROW_TEMPVALUE, DISPLAY_ROW_8 }, false },
+  { "two distant rows",  2, { DISPLAY_ROW_CONNECTION, DISPLAY_ROW_11 }, false },
+  { "connection state",  4, { DISPLAY_ROW_CLIENTADDR, DISPLAY_ROW_CONNECTION, \
+                              DISPLAY_ROW_PASSKEY, DISPLAY_ROW_ACTION }, false },
+  { "full screen",       DISPLAY_NUMBER_OF_ROWS, \
+                         { DISPLAY_ROW_NAME, DISPLAY_ROW_BTADDR, DISPLAY_ROW_BTADDR2, \
+                           DISPLAY_ROW_CLIENTADDR, DISPLAY_ROW_CONNECTION, \
+                           DISPLAY_ROW_PASSKEY, DISPLAY_ROW_ACTION, \
+                           DISPLAY_ROW_TEMPVALUE, DISPLAY_ROW_8, DISPLAY_ROW_9, \
+                           DISPLAY_ROW_10, DISPLAY_ROW_11, DISPLAY_ROW_ASSIGNMENT }, false },
+  { "identical rewrite", 1, { DISPLAY_ROW_TEMPVALUE }, true }
+};
+
+static uint8_t  capture[CAPTURE_LEN];
+static bool     flush_done = false;
+
+
+static void handle(uint32_t extsignals)
+{
+  if(extsignals & evtDISPLAY_DONE)
+    flush_done = true;
+}
+
+static bool is_flush_done()
+{
+  return flush_done;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Write the rows of a pattern, the value changes the strings.
+// ---------------------------------------------------------------------
+static void write_rows(const bench_pattern_t *pattern, uint32_t value)
+{
+  uint32_t i;
+
+  for(i=0;i<pattern->num_rows;i++){
+      displayPrintf(pattern->rows[i], "Row %u value %u", \
+                    (unsigned int)pattern->rows[i], \
+                    (unsigned int)(pattern->identical ? 0 : value));
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Flush with displayFlush() and wait for evtDISPLAY_DONE.
+// ---------------------------------------------------------------------
+static bool flush_async()
+{
+  flush_done = false;
+  displayFlush();
+  return host_test_run(host_now() + host_us_to_ticks(FLUSH_LIMIT_MS * 1000ULL), \
+                       handle, is_flush_done);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Obtain the lines of the multi-line writes captured, see sl_memlcd_draw().
+// Every write is the command and the first address, then every line is
+// followed by 0xff and the next address, 0xff after the last line.
+// ---------------------------------------------------------------------
+static uint32_t parse_lines(const uint8_t *buf, size_t len, uint8_t *lines, \
+                            uint32_t *num_runs)
+{
+  uint32_t n = 0;
+  size_t i = 0;
+  uint8_t addr;
+
+  *num_runs = 0;
+  while((i + 2) <= len){
+      addr = buf[i + 1];
+      i += 2;
+      (*num_runs)++;
+      while((i + LINE_BYTES + 2) <= len){
+          lines[n++] = addr - 1;
+          i += LINE_BYTES;
+          addr = buf[i + 1];
+          i += 2;
+          if(addr == 0xff)
+            break;
+      }
+  }
+  return n;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Send the dirty lines of a pattern by the three paths.
+// ---------------------------------------------------------------------
+static void measure(const bench_pattern_t *pattern, uint32_t value, \
+                    bench_result_t *result)
+{
+  uint8_t lines[SL_MEMLCD_DISPLAY_HEIGHT];
+  uint8_t *fb;
+  uint32_t i;
+
+  DMD_getFrameBuffer((void **)&fb);
+
+  // runs, the lines sent are taken from the capture
+  write_rows(pattern, value);
+  host_spi_capture(capture, sizeof(capture));
+  CHECK(DMD_updateDisplay() == DMD_OK);
+  result->runs += host_spi_captured();
+  result->lines += parse_lines(capture, host_spi_captured(), lines, &result->num_runs);
+
+  // per line, the same lines one write each
+  host_spi_capture(capture, sizeof(capture));
+  for(i=0;i<result->lines;i++){
+      CHECK(sl_memlcd_draw(sl_memlcd_get(), fb + (lines[i] * LINE_BYTES), \
+                           lines[i], 1) == SL_STATUS_OK);
+  }
+  result->per_line += host_spi_captured();
+
+  // async, new values dirty the same lines again
+  write_rows(pattern, value + BENCH_ROUNDS);
+  host_spi_capture(capture, sizeof(capture));
+  CHECK(flush_async() || (host_spi_captured() == 0));
+  result->async += host_spi_captured();
+
+  host_spi_capture(NULL, 0);
+}
+
+int main()
+{
+  bench_result_t results[sizeof(patterns) / sizeof(patterns[0])];
+  bench_result_t round;
+  size_t p;
+  uint32_t r;
+
+  displayInit();
+  host_hw_service();
+
+  memset(results, 0, sizeof(results));
+  for(p=0;p<(sizeof(patterns) / sizeof(patterns[0]));p++){
+      // the strings of value 0 are on the LCD before the pattern is measured
+      write_rows(&patterns[p], 0);
+      CHECK(flush_async());
+
+      for(r=1;r<=BENCH_ROUNDS;r++){
+          memset(&round, 0, sizeof(round));
+          measure(&patterns[p], r, &round);
+          results[p].lines += round.lines;
+          results[p].per_line += round.per_line;
+          results[p].runs += round.runs;
+          results[p].num_runs += round.num_runs;
+          results[p].async += round.async;
+      }
+  }
+
+  printf("bytes clocked out per flush\n");
+  printf("%-20s %6s %9s %12s %7s\n", "pattern", "lines", "per line", "runs", "async");
+  for(p=0;p<(sizeof(patterns) / sizeof(patterns[0]));p++){
+      bench_result_t *res = &results[p];
+
+      printf("%-20s %6u %9u %6u in %3u %7u\n", patterns[p].name, \
+             res->lines / BENCH_ROUNDS, res->per_line / BENCH_ROUNDS, \
+             res->runs / BENCH_ROUNDS, res->num_runs / BENCH_ROUNDS, \
+             res->async / BENCH_ROUNDS);
+
+      CHECK(res->runs <= res->per_line);
+      CHECK(res->async <= res->runs);
+      if(patterns[p].identical){
+          CHECK(res->lines == 0);
+          CHECK(res->async == 0);
+      }
+      else{
+          CHECK(res->lines > 0);
+      }
+  }
+
+  return host_test_result("bench_dmd_memlcd");
+}
@@ -0,0 +1,219 @@
+/**
+ * @file bench_fmt.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host benchmark of the small formatter of fmt.c against the C
+ * library vsnprintf(). newlib is not part of the host toolchain, so the
+ * reference is the glibc of the host:
+ * - the output and the return value must match on a table of the formats
+ *   used by the display rows and the log lines, truncated or not, which
+ *   the program checks,
+ * - the host time per call is reported for a log line and a display row,
+ * - the peak stack of a call is reported, measured by running the call on
+ *   a painted stack of its own.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include "host_test.h"
+#include "fmt.h"
+
+#define OUT_LEN                     (128)
+// calls per timed formatter
+#define TIMED_CALLS                 (200000)
+// stack the measured calls run on, painted with STACK_PAINT
+#define STACK_LEN                   (32768)
+#define STACK_PAINT                 (0xA5)
+
+// the log line of LOG_DO() and a row of displayPrintf()
+#define LOG_FORMAT                  "%5"PRIu32":%s:%s: Error code 0x%04x is %s\n"
+#define LOG_ARGS                    (uint32_t)123456, "Error", "handle_status", \
+                                    0x0181u, "SL_STATUS_BT_CTRL_CONN_TIMEOUT"
+#define ROW_FORMAT                  "Passkey %d"
+#define ROW_ARGS                    123456
+
+static uint8_t  call_stack[STACK_LEN] __attribute__((aligned(16)));
+static ucontext_t main_context;
+static ucontext_t call_context;
+static void     (*stack_call)();
+static char     out[OUT_LEN];
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host monotonic time in ns.
+// ---------------------------------------------------------------------
+static uint64_t host_ns()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Format with both formatters into a buffer of the given size and
+// compare the outputs and the return values.
+// ---------------------------------------------------------------------
+static void compare(int line, size_t size, const char *format, ...)
+{
+  char fmt_out[OUT_LEN];
+  char libc_out[OUT_LEN];
+  va_list va, va_libc;
+  int fmt_len, libc_len;
+
+  memset(fmt_out, 0x55, sizeof(fmt_out));
+  memset(libc_out, 0x55, sizeof(libc_out));
+
+  va_start(va, format);
+  va_copy(va_libc, va);
+  fmt_len = fmt_vsnprintf(fmt_out, size, format, va);
+  libc_len = vsnprintf(libc_out, size, format, va_libc);
+  va_end(va_libc);
+  va_end(va);
+
+  // the bytes after the terminator must be left alone as well
+  if((fmt_len != libc_len) || (memcmp(fmt_out, libc_out, sizeof(fmt_out)) != 0)){
+      fprintf(stderr, "%s:%d: \"%s\" size %u: fmt \"%.*s\" (%d), libc \"%.*s\" (%d)\n", \
+              __FILE__, line, format, (unsigned int)size, \
+              size ? (int)strnlen(fmt_out, size) : 0, fmt_out, fmt_len, \
+              size ? (int)strnlen(libc_out, size) : 0, libc_out, libc_len);
+      host_test_failures++;
+  }
+}
+
+#define COMPARE(size, ...)          compare(__LINE__, (size), __VA_ARGS__)
+
+static void test_formats()
+{
+  COMPARE(OUT_LEN, "Temp=%d", 21);
+  COMPARE(OUT_LEN, "Temp=%d", -40);
+  COMPARE(OUT_LEN, "%d %d %d", 0, INT_MAX, INT_MIN);
+  COMPARE(OUT_LEN, "%i|%u|%u", -7, 0u, UINT_MAX);
+  COMPARE(OUT_LEN, "%x %X %x", 0xbeefu, 0xBEEFu, 0u);
+  COMPARE(OUT_LEN, "0x%04x 0x%08X", 0x181u, 0xdeadbeefu);
+  COMPARE(OUT_LEN, "%02X:%02X:%02X:%02X:%02X:%02X", 0x84, 0x2e, 0x14, 0x7f, 0x2e, 0x3c);
+  COMPARE(OUT_LEN, "[%5u] [%-5u] [%05u]", 42u, 42u, 42u);
+  COMPARE(OUT_LEN, "[%5d] [%-5d] [%05d]", -42, -42, -42);
+  COMPARE(OUT_LEN, "[%3d] [%1u]", 12345, 678u);
+  COMPARE(OUT_LEN, "[%s] [%8s] [%-8s] [%2s]", "ab", "ab", "ab", "abcdef");
+  COMPARE(OUT_LEN, "%c%c%c %%", 'B', 'L', 'E');
+  COMPARE(OUT_LEN, "%ld %lu %lx", 100000L, 100000UL, 0xabcdUL);
+  COMPARE(OUT_LEN, "%zu bytes", (size_t)247);
+  COMPARE(OUT_LEN, "%hd %hu", (short)-3, (unsigned short)65535);
+  COMPARE(OUT_LEN, "%5"PRIu32":%s:%s: ", (uint32_t)7, "Info ", "app_init");
+  COMPARE(OUT_LEN, LOG_FORMAT, LOG_ARGS);
+  COMPARE(OUT_LEN, ROW_FORMAT, ROW_ARGS);
+  COMPARE(OUT_LEN, "Sleep Hours: %d", 8);
+  COMPARE(OUT_LEN, "%s", "");
+  COMPARE(OUT_LEN, "no conversion");
+
+  // truncation, the display rows are 21 bytes with the terminator
+  COMPARE(21, "Press PB1 to confirm and %s", "more");
+  COMPARE(21, "%s", "A string longer than the row");
+  COMPARE(21, "%-30d|", 5);
+  COMPARE(21, "%030u", 5u);
+  COMPARE(8, "Temp=%d", -12345);
+  COMPARE(1, "Temp=%d", 21);
+  COMPARE(0, "Temp=%d", 21);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host time of one call of a formatter, in ns.
+// ---------------------------------------------------------------------
+static double time_calls(void (*call)())
+{
+  uint64_t start;
+  uint32_t i;
+
+  start = host_ns();
+  for(i=0;i<TIMED_CALLS;i++){
+      call();
+  }
+  return (double)(host_ns() - start) / TIMED_CALLS;
+}
+
+static void fmt_log_line()
+{
+  fmt_snprintf(out, sizeof(out), LOG_FORMAT, LOG_ARGS);
+}
+
+static void libc_log_line()
+{
+  snprintf(out, sizeof(out), LOG_FORMAT, LOG_ARGS);
+}
+
+static void fmt_row()
+{
+  fmt_snprintf(out, 21, ROW_FORMAT, ROW_ARGS);
+}
+
+static void libc_row()
+{
+  snprintf(out, 21, ROW_FORMAT, ROW_ARGS);
+}
+
+static void no_call()
+{
+}
+
+static void stack_entry()
+{
+  stack_call();
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Run a call on the painted stack and obtain the bytes it touched.
+// ---------------------------------------------------------------------
+static size_t stack_touched(void (*call)())
+{
+  size_t i;
+
+  memset(call_stack, STACK_PAINT, sizeof(call_stack));
+
+  getcontext(&call_context);
+  call_context.uc_stack.ss_sp = call_stack;
+  call_context.uc_stack.ss_size = sizeof(call_stack);
+  call_context.uc_link = &main_context;
+  stack_call = call;
+  makecontext(&call_context, stack_entry, 0);
+  swapcontext(&main_context, &call_context);
+
+  // the stack grows down, find the lowest byte written
+  for(i=0;(i<sizeof(call_stack)) && (call_stack[i] == STACK_PAINT);i++)
+    ;
+  return sizeof(call_stack) - i;
+}
+
+static void report(const char *name, void (*fmt_call)(), void (*libc_call)())
+{
+  size_t base = stack_touched(no_call);
+
+  printf("%-10s fmt %6.0f ns %5u B stack   libc %6.0f ns %5u B stack\n", name, \
+         time_calls(fmt_call), (unsigned int)(stack_touched(fmt_call) - base), \
+         time_calls(libc_call), (unsigned int)(stack_touched(libc_call) - base));
+}
+
+int main()
+{
+  test_formats();
+
+  printf("per call, host time and peak stack above the caller\n");
+  report("log line", fmt_log_line, libc_log_line);
+  report("row", fmt_row, libc_row);
+
+  // the peak stack is the one of the log line
+  CHECK(stack_touched(fmt_log_line) <= stack_touched(libc_log_line));
+
+  return host_test_result("bench_fmt");
+}
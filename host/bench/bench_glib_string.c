@@ -0,0 +1,221 @@
+/**
+ * @file bench_glib_string.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host benchmark of GLIB_drawStringOnClearedLine() against the
+ * erase and draw passes displayPrintf() used before: a row of spaces drawn
+ * with GLIB_drawStringOnLine(), then the string. Random strings are drawn
+ * over random strings on random lines by both paths, for the fonts the
+ * fast path covers and both colour schemes, and the program fails if the
+ * frame buffers differ. The host time per line and per character of both
+ * paths is then reported for a short and a full row.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include <time.h>
+#include "dmd.h"
+#include "glib.h"
+#include "sl_memlcd_display.h"
+#include "font_narrow_6x8_packed.h"
+#include "host_test.h"
+#include "lcd.h"
+
+#define FRAME_BYTES                 ((SL_MEMLCD_DISPLAY_WIDTH * SL_MEMLCD_DISPLAY_HEIGHT * SL_MEMLCD_DISPLAY_BPP) / 8)
+// random strings drawn per font and colour scheme
+#define COMPARE_TRIALS              (2000)
+// lines drawn per timed path
+#define TIMED_LINES                 (20000)
+
+/**
+ * A font the fast path covers
+ */
+typedef struct {
+  const char *name;
+  const GLIB_Font_t *font;
+}bench_font_t;
+
+static const bench_font_t fonts[] = {
+  { "narrow 6x8",        &GLIB_FontNarrow6x8 },
+  { "normal 8x8",        &GLIB_FontNormal8x8 },
+  { "narrow 6x8 packed", &GLIB_FontNarrow6x8Packed }
+};
+
+static GLIB_Context_t glib;
+static uint8_t  *framebuffer;
+static uint8_t  old_frame[FRAME_BYTES];
+static uint32_t random_state = 0x2545F491;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host monotonic time in ns.
+// ---------------------------------------------------------------------
+static uint64_t host_ns()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift32, the same sequence on every run
+static uint32_t random_next()
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+static uint32_t row_chars()
+{
+  uint32_t fit = glib.pDisplayGeometry->xSize / glib.font.fontWidth;
+
+  return (fit < DISPLAY_ROW_LEN) ? fit : DISPLAY_ROW_LEN;
+}
+
+static uint32_t num_lines()
+{
+  return glib.pDisplayGeometry->ySize / (glib.font.fontHeight + glib.font.lineSpacing);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// A random string of 1 to row_chars() printable characters.
+// ---------------------------------------------------------------------
+static void random_string(char *str)
+{
+  uint32_t len = 1 + (random_next() % row_chars());
+  uint32_t i;
+
+  for(i=0;i<len;i++){
+      str[i] = (char)(' ' + (random_next() % ('~' - ' ' + 1)));
+  }
+  str[len] = 0;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// The erase and draw passes of displayPrintf() before the fast path.
+// ---------------------------------------------------------------------
+static EMSTATUS draw_erase_then_string(const char *str, uint8_t line)
+{
+  char erase[DISPLAY_ROW_LEN + 1];
+  EMSTATUS status;
+
+  memset(erase, ' ', row_chars());
+  erase[row_chars()] = 0;
+
+  status = GLIB_drawStringOnLine(&glib, erase, line, GLIB_ALIGN_CENTER, 0, 0, true);
+  if(status != GLIB_OK)
+    return status;
+  return GLIB_drawStringOnLine(&glib, str, line, GLIB_ALIGN_CENTER, 0, 0, true);
+}
+
+static EMSTATUS draw_cleared_line(const char *str, uint8_t line)
+{
+  return GLIB_drawStringOnClearedLine(&glib, str, line, GLIB_ALIGN_CENTER, 0, 0);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Draw random strings over random strings by both paths and compare
+// the frame buffers.
+// ---------------------------------------------------------------------
+static uint32_t compare_paths()
+{
+  char before[DISPLAY_ROW_LEN + 1];
+  char after[DISPLAY_ROW_LEN + 1];
+  uint32_t mismatches = 0;
+  uint32_t trial;
+  uint8_t line;
+
+  for(trial=0;trial<COMPARE_TRIALS;trial++){
+      random_string(before);
+      random_string(after);
+      line = (uint8_t)(random_next() % num_lines());
+
+      CHECK(GLIB_clear(&glib) == GLIB_OK);
+      CHECK(draw_erase_then_string(before, line) == GLIB_OK);
+      CHECK(draw_erase_then_string(after, line) == GLIB_OK);
+      memcpy(old_frame, framebuffer, sizeof(old_frame));
+
+      CHECK(GLIB_clear(&glib) == GLIB_OK);
+      CHECK(draw_cleared_line(before, line) == GLIB_OK);
+      CHECK(draw_cleared_line(after, line) == GLIB_OK);
+
+      if(memcmp(old_frame, framebuffer, sizeof(old_frame)) != 0){
+          if(mismatches == 0)
+            fprintf(stderr, "frame differs for \"%s\" over \"%s\" on line %u\n", \
+                    after, before, line);
+          mismatches++;
+      }
+  }
+  return mismatches;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host time of one line drawn by a path, in ns.
+// ---------------------------------------------------------------------
+static double time_path(EMSTATUS (*draw)(const char *str, uint8_t line), \
+                        const char *str)
+{
+  uint64_t start;
+  uint32_t i;
+
+  start = host_ns();
+  for(i=0;i<TIMED_LINES;i++){
+      draw(str, (uint8_t)(i % num_lines()));
+  }
+  return (double)(host_ns() - start) / TIMED_LINES;
+}
+
+static void report_timing(const char *name, const char *str)
+{
+  size_t len = strlen(str);
+  double old_ns = time_path(draw_erase_then_string, str);
+  double new_ns = time_path(draw_cleared_line, str);
+
+  printf("%-20s %3u chars  erase+draw %8.0f ns/line %6.0f ns/char" \
+         "   cleared line %6.0f ns/line %5.0f ns/char\n", \
+         name, (unsigned int)len, old_ns, old_ns / len, new_ns, new_ns / len);
+}
+
+int main()
+{
+  static const char *schemes[] = { "black on white", "white on black" };
+  uint32_t mismatches;
+  size_t f;
+  int s;
+
+  displayInit();
+  CHECK(GLIB_contextInit(&glib) == GLIB_OK);
+  DMD_getFrameBuffer((void **)&framebuffer);
+
+  for(f=0;f<(sizeof(fonts) / sizeof(fonts[0]));f++){
+      CHECK(GLIB_setFont(&glib, (GLIB_Font_t *)fonts[f].font) == GLIB_OK);
+      for(s=0;s<2;s++){
+          glib.foregroundColor = s ? White : Black;
+          glib.backgroundColor = s ? Black : White;
+
+          mismatches = compare_paths();
+          printf("%-20s %s: %u of %u frames differ\n", fonts[f].name, \
+                 schemes[s], mismatches, COMPARE_TRIALS);
+          CHECK(mismatches == 0);
+      }
+  }
+
+  // the font and colours of displayPrintf()
+  CHECK(GLIB_setFont(&glib, (GLIB_Font_t *)&GLIB_FontNarrow6x8Packed) == GLIB_OK);
+  glib.foregroundColor = Black;
+  glib.backgroundColor = White;
+  report_timing("value row", "Temp=21");
+  report_timing("full row", "Passkey 123456 Conf?");
+
+  return host_test_result("bench_glib_string");
+}
@@ -0,0 +1,120 @@
+/**
+ * @file fake_adc.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the fake ADC0 of the host build. A single
+ * conversion started with ADC_Start() completes HOST_ADC_CONVERSION_US
+ * later with the sample set by host_adc_set_sample().
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "em_adc.h"
+#include "host_hw.h"
+#include "fake_platform.h"
+#include "irq.h"
+
+static uint32_t     sample = 2048;
+static uint32_t     data = 0;
+static uint32_t     ien = 0;
+static uint32_t     flags = 0;
+static host_event_t adc_event;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// End of the conversion.
+// ---------------------------------------------------------------------
+static void adc_fire(void *ctx)
+{
+  (void)ctx;
+
+  data = sample;
+  flags |= ADC_IF_SINGLE;
+  host_stats.adc_conversions++;
+}
+
+/**
+ * @brief Set the ADC0 sample returned by the next conversions.
+ * @param value: the 12-bit sample.
+ */
+void host_adc_set_sample(uint32_t value)
+{
+  sample = value & 0xfff;
+}
+
+/**
+ * @brief Take the ADC0 interrupt if it is pending.
+ * @return true if the ISR was run.
+ */
+bool host_adc_service()
+{
+  if(!(flags & ien) || !NVIC_GetEnableIRQ(ADC0_IRQn))
+    return false;
+  ADC0_IRQHandler();
+  return true;
+}
+
+void ADC_Init(ADC_TypeDef *adc, const ADC_Init_TypeDef *init)
+{
+  (void)adc;
+  (void)init;
+}
+
+void ADC_InitSingle(ADC_TypeDef *adc, const ADC_InitSingle_TypeDef *init)
+{
+  (void)adc;
+  (void)init;
+}
+
+uint8_t ADC_PrescaleCalc(uint32_t adcFreq, uint32_t hfperFreq)
+{
+  (void)adcFreq;
+  (void)hfperFreq;
+  return 0;
+}
+
+uint8_t ADC_TimebaseCalc(uint32_t hfperFreq)
+{
+  (void)hfperFreq;
+  return 0;
+}
+
+void ADC_Start(ADC_TypeDef *adc, uint32_t cmd)
+{
+  (void)adc;
+
+  if(cmd & ADC_CMD_SINGLESTART){
+      host_event_schedule(&adc_event, \
+                          host_now() + host_us_to_ticks(HOST_ADC_CONVERSION_US), \
+                          adc_fire, NULL);
+  }
+}
+
+uint32_t ADC_DataSingleGet(ADC_TypeDef *adc)
+{
+  (void)adc;
+
+  flags &= ~ADC_IF_SINGLE;
+  return data;
+}
+
+void ADC_IntEnable(ADC_TypeDef *adc, uint32_t enable)
+{
+  (void)adc;
+  ien |= enable;
+}
+
+void ADC_IntClear(ADC_TypeDef *adc, uint32_t clear)
+{
+  (void)adc;
+  flags &= ~clear;
+}
+
+uint32_t ADC_IntGetEnabled(ADC_TypeDef *adc)
+{
+  (void)adc;
+  return flags & ien;
+}
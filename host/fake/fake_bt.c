@@ -0,0 +1,509 @@
+/**
+ * @file fake_bt.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the fake Bluetooth stack of the host build,
+ * covering the commands used by the server build of the firmware.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "fake_bt.h"
+#include "host_hw.h"
+
+// number of events the queue holds
+#define HOST_BT_QUEUE_DEPTH         (32)
+// attribute handles stored by the fake GATT server
+#define HOST_BT_MAX_ATTRIBUTES      (128)
+
+/**
+ * A local attribute value
+ */
+typedef struct {
+  uint16_t len;
+  uint8_t value[HOST_BT_MAX_PAYLOAD];
+}host_attribute_t;
+
+static host_bt_event_t  queue[HOST_BT_QUEUE_DEPTH];
+static uint32_t         wptr = 0;
+static uint32_t         rptr = 0;
+static uint32_t         pending_signals = 0;
+// events only come from the trace while it is replayed
+static bool             replaying = false;
+static uint32_t         replay_signals = 0;
+
+static host_attribute_t attributes[HOST_BT_MAX_ATTRIBUTES];
+
+static bool             pairing = false;
+static bool             bonded = false;
+static bool             indication_inflight = false;
+static uint8_t          inflight_connection = 0;
+static uint16_t         inflight_characteristic = 0;
+static host_event_t     confirm_event;
+
+static host_bt_stats_t  bt_stats;
+
+static const bd_addr    identity_address = { { 0x3c, 0x2e, 0x7f, 0x14, 0x2e, 0x84 } };
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// compute next ptr value
+// ---------------------------------------------------------------------
+static uint32_t nextPtr(uint32_t ptr)
+{
+  if(ptr == (HOST_BT_QUEUE_DEPTH - 1))
+    return 0;
+  else
+    return ptr + 1;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Header of an event, see SL_BGAPI_MSG_LEN().
+// ---------------------------------------------------------------------
+static uint32_t event_header(uint32_t id, size_t len)
+{
+  return id | ((len & 0xff) << 8) | ((len >> 8) & 0x7);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// The fake client confirms the indication in flight.
+// ---------------------------------------------------------------------
+static void confirm_fire(void *ctx)
+{
+  sl_bt_evt_gatt_server_characteristic_status_t status;
+
+  (void)ctx;
+
+  memset(&status, 0, sizeof(status));
+  status.connection = inflight_connection;
+  status.characteristic = inflight_characteristic;
+  status.status_flags = sl_bt_gatt_server_confirmation;
+
+  indication_inflight = false;
+  host_bt_push_event(sl_bt_evt_gatt_server_characteristic_status_id, \
+                     &status, sizeof(status));
+}
+
+/**
+ * @brief Obtain the statistics of the fake stack.
+ * @param stats: filled with the statistics.
+ */
+void host_bt_get_stats(host_bt_stats_t *stats)
+{
+  *stats = bt_stats;
+}
+
+/**
+ * @brief Take the next event for sl_bt_on_event(). Queued events come
+ * before the pending external signals.
+ * @param evt: filled with the event.
+ * @return false if no event is pending.
+ */
+bool host_bt_next_event(host_bt_event_t *evt)
+{
+  if(rptr != wptr){
+      *evt = queue[rptr];
+      rptr = nextPtr(rptr);
+  }
+  else if(pending_signals){
+      evt->msg.header = event_header(sl_bt_evt_system_external_signal_id, \
+                                     sizeof(sl_bt_evt_system_external_signal_t));
+      evt->msg.data.evt_system_external_signal.extsignals = pending_signals;
+      pending_signals = 0;
+      bt_stats.signal_events++;
+  }
+  else{
+      return false;
+  }
+
+  bt_stats.events++;
+  return true;
+}
+
+/**
+ * @brief Check whether an event is pending.
+ * @return true if host_bt_next_event() would return an event.
+ */
+bool host_bt_event_pending()
+{
+  return (rptr != wptr) || (pending_signals != 0);
+}
+
+/**
+ * @brief Queue an event. The length in the header is set from len.
+ * @param id: the event id.
+ * @param data: the event data.
+ * @param len: the length of data.
+ */
+void host_bt_push_event(uint32_t id, const void *data, size_t len)
+{
+  host_bt_event_t *evt = &queue[wptr];
+
+  if(replaying){
+      bt_stats.dropped++;
+      return;
+  }
+  if(nextPtr(wptr) == rptr)
+    return;
+  if(len > HOST_BT_MAX_PAYLOAD)
+    len = HOST_BT_MAX_PAYLOAD;
+
+  evt->msg.header = event_header(id, len);
+  memcpy(&evt->raw[SL_BGAPI_MSG_HEADER_LEN], data, len);
+  wptr = nextPtr(wptr);
+}
+
+/**
+ * @brief Queue the boot event.
+ */
+void host_bt_push_boot()
+{
+  sl_bt_evt_system_boot_t boot;
+
+  memset(&boot, 0, sizeof(boot));
+  boot.major = 3;
+  boot.minor = 2;
+  boot.patch = 3;
+  host_bt_push_event(sl_bt_evt_system_boot_id, &boot, sizeof(boot));
+}
+
+/**
+ * @brief Queue the opening of a connection by the fake client.
+ * @param connection: the connection handle.
+ */
+void host_bt_push_connection_opened(uint8_t connection)
+{
+  sl_bt_evt_connection_opened_t opened;
+  int i;
+
+  memset(&opened, 0, sizeof(opened));
+  for(i=0;i<6;i++)
+    opened.address.addr[i] = (uint8_t)(0x10 + i);
+  opened.connection = connection;
+  opened.bonding = 0xff;
+
+  pairing = false;
+  bonded = false;
+  indication_inflight = false;
+  host_event_cancel(&confirm_event);
+  host_bt_push_event(sl_bt_evt_connection_opened_id, &opened, sizeof(opened));
+}
+
+/**
+ * @brief Queue the closing of a connection by the fake client.
+ * @param connection: the connection handle.
+ * @param reason: the reason code.
+ */
+void host_bt_push_connection_closed(uint8_t connection, uint16_t reason)
+{
+  sl_bt_evt_connection_closed_t closed;
+
+  closed.connection = connection;
+  closed.reason = reason;
+
+  pairing = false;
+  bonded = false;
+  indication_inflight = false;
+  host_event_cancel(&confirm_event);
+  host_bt_push_event(sl_bt_evt_connection_closed_id, &closed, sizeof(closed));
+}
+
+/**
+ * @brief Queue the passkey confirmation request of the pairing.
+ * @param connection: the connection handle.
+ * @param passkey: the passkey shown on the LCD.
+ */
+void host_bt_push_confirm_passkey(uint8_t connection, uint32_t passkey)
+{
+  sl_bt_evt_sm_confirm_passkey_t confirm;
+
+  confirm.connection = connection;
+  confirm.passkey = passkey;
+
+  pairing = true;
+  host_bt_push_event(sl_bt_evt_sm_confirm_passkey_id, &confirm, sizeof(confirm));
+}
+
+/**
+ * @brief Queue the ATT MTU exchange.
+ * @param connection: the connection handle.
+ * @param mtu: the negotiated ATT MTU.
+ */
+void host_bt_push_mtu_exchanged(uint8_t connection, uint16_t mtu)
+{
+  sl_bt_evt_gatt_mtu_exchanged_t exchanged;
+
+  exchanged.connection = connection;
+  exchanged.mtu = mtu;
+  host_bt_push_event(sl_bt_evt_gatt_mtu_exchanged_id, &exchanged, sizeof(exchanged));
+}
+
+/**
+ * @brief Queue a write of the client characteristic configuration.
+ * @param connection: the connection handle.
+ * @param characteristic: the characteristic handle.
+ * @param flags: the client config flags, sl_bt_gatt_indication etc.
+ */
+void host_bt_push_client_config(uint8_t connection, uint16_t characteristic, \
+                                uint16_t flags)
+{
+  sl_bt_evt_gatt_server_characteristic_status_t status;
+
+  memset(&status, 0, sizeof(status));
+  status.connection = connection;
+  status.characteristic = characteristic;
+  status.status_flags = sl_bt_gatt_server_client_config;
+  status.client_config_flags = flags;
+  host_bt_push_event(sl_bt_evt_gatt_server_characteristic_status_id, \
+                     &status, sizeof(status));
+}
+
+/**
+ * @brief Write an attribute from the fake client. The value is stored
+ * before the attribute value event is queued.
+ * @param connection: the connection handle.
+ * @param attribute: the attribute handle.
+ * @param value: the value.
+ * @param len: the length of value.
+ */
+void host_bt_push_attribute_value(uint8_t connection, uint16_t attribute, \
+                                  const uint8_t *value, size_t len)
+{
+  uint8_t buf[sizeof(sl_bt_evt_gatt_server_attribute_value_t) + HOST_BT_MAX_PAYLOAD];
+  sl_bt_evt_gatt_server_attribute_value_t *written = (sl_bt_evt_gatt_server_attribute_value_t *)buf;
+
+  if(len > (HOST_BT_MAX_PAYLOAD - sizeof(*written)))
+    len = HOST_BT_MAX_PAYLOAD - sizeof(*written);
+
+  sl_bt_gatt_server_write_attribute_value(attribute, 0, len, value);
+
+  memset(written, 0, sizeof(*written));
+  written->connection = connection;
+  written->attribute = attribute;
+  written->att_opcode = sl_bt_gatt_write_request;
+  written->value.len = (uint8_t)len;
+  memcpy(written->value.data, value, len);
+  host_bt_push_event(sl_bt_evt_gatt_server_attribute_value_id, buf, sizeof(*written) + len);
+}
+
+/**
+ * @brief Check whether the connection has bonded.
+ * @return true once the passkey has been confirmed.
+ */
+bool host_bt_bonded()
+{
+  return bonded;
+}
+
+/**
+ * @brief Enter or leave the replay of a trace. While replaying, the
+ * signals of sl_bt_external_signal() and the events the fake answers
+ * the stack commands with are dropped, the trace already holds them.
+ * @param enable: true to replay.
+ */
+void host_bt_set_replay(bool enable)
+{
+  replaying = enable;
+  replay_signals = 0;
+}
+
+/**
+ * @brief Take the signals raised while replaying.
+ * @param mask: the signals to take.
+ * @return the signals of mask raised since they were last taken.
+ */
+uint32_t host_bt_take_replay_signals(uint32_t mask)
+{
+  uint32_t signals = replay_signals & mask;
+
+  replay_signals &= ~mask;
+  return signals;
+}
+
+void sl_bt_external_signal(uint32_t signals)
+{
+  bt_stats.signals++;
+  if(replaying){
+      replay_signals |= signals;
+      bt_stats.dropped++;
+      return;
+  }
+  pending_signals |= signals;
+}
+
+sl_status_t sl_bt_system_get_identity_address(bd_addr *address, uint8_t *type)
+{
+  *address = identity_address;
+  *type = sl_bt_gap_public_address;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_create_set(uint8_t *handle)
+{
+  *handle = 0;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_set_timing(uint8_t handle, uint32_t interval_min, \
+                                        uint32_t interval_max, uint16_t duration, \
+                                        uint8_t maxevents)
+{
+  (void)handle;
+  (void)interval_min;
+  (void)interval_max;
+  (void)duration;
+  (void)maxevents;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_start(uint8_t handle, uint8_t discover, uint8_t connect)
+{
+  (void)handle;
+  (void)discover;
+  (void)connect;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection, uint16_t min_interval, \
+                                            uint16_t max_interval, uint16_t latency, \
+                                            uint16_t timeout, uint16_t min_ce_length, \
+                                            uint16_t max_ce_length)
+{
+  (void)connection;
+  (void)min_interval;
+  (void)max_interval;
+  (void)latency;
+  (void)timeout;
+  (void)min_ce_length;
+  (void)max_ce_length;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_configure(uint8_t flags, uint8_t io_capabilities)
+{
+  (void)flags;
+  (void)io_capabilities;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_set_bondable_mode(uint8_t bondable)
+{
+  (void)bondable;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_delete_bondings()
+{
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_bonding_confirm(uint8_t connection, uint8_t confirm)
+{
+  (void)connection;
+  (void)confirm;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_passkey_confirm(uint8_t connection, uint8_t confirm)
+{
+  // the confirm passkey event of a replayed trace does not pass the fake
+  if(!pairing && !replaying)
+    return SL_STATUS_INVALID_STATE;
+  pairing = false;
+
+  if(confirm){
+      sl_bt_evt_sm_bonded_t done;
+
+      done.connection = connection;
+      done.bonding = 1;
+      done.security_mode = sl_bt_connection_mode1_level3;
+      bonded = true;
+      host_bt_push_event(sl_bt_evt_sm_bonded_id, &done, sizeof(done));
+  }
+  else{
+      sl_bt_evt_sm_bonding_failed_t failed;
+
+      failed.connection = connection;
+      failed.reason = SL_STATUS_BT_SMP_PASSKEY_ENTRY_FAILED;
+      host_bt_push_event(sl_bt_evt_sm_bonding_failed_id, &failed, sizeof(failed));
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_read_attribute_value(uint16_t attribute, uint16_t offset, \
+                                                   size_t max_value_size, size_t *value_len, \
+                                                   uint8_t *value)
+{
+  host_attribute_t *attr;
+  size_t len;
+
+  if(attribute >= HOST_BT_MAX_ATTRIBUTES)
+    return SL_STATUS_BT_ATT_INVALID_HANDLE;
+  attr = &attributes[attribute];
+  if(offset > attr->len)
+    return SL_STATUS_BT_ATT_INVALID_OFFSET;
+
+  len = attr->len - offset;
+  if(len > max_value_size)
+    len = max_value_size;
+  memcpy(value, &attr->value[offset], len);
+  *value_len = len;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_write_attribute_value(uint16_t attribute, uint16_t offset, \
+                                                    size_t value_len, const uint8_t* value)
+{
+  host_attribute_t *attr;
+
+  if(attribute >= HOST_BT_MAX_ATTRIBUTES)
+    return SL_STATUS_BT_ATT_INVALID_HANDLE;
+  if((offset + value_len) > HOST_BT_MAX_PAYLOAD)
+    return SL_STATUS_BT_ATT_INVALID_ATT_LENGTH;
+
+  attr = &attributes[attribute];
+  memcpy(&attr->value[offset], value, value_len);
+  attr->len = offset + value_len;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_send_indication(uint8_t connection, uint16_t characteristic, \
+                                              size_t value_len, const uint8_t* value)
+{
+  (void)value;
+
+  // ATT allows one indication in flight per connection
+  if(indication_inflight){
+      bt_stats.busy++;
+      return SL_STATUS_INVALID_STATE;
+  }
+
+  indication_inflight = true;
+  inflight_connection = connection;
+  inflight_characteristic = characteristic;
+  host_event_schedule(&confirm_event, \
+                      host_now() + host_us_to_ticks(HOST_BT_CONN_INTERVAL_US), \
+                      confirm_fire, NULL);
+
+  bt_stats.indications++;
+  bt_stats.gatt_bytes += value_len;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_send_notification(uint8_t connection, uint16_t characteristic, \
+                                                size_t value_len, const uint8_t* value)
+{
+  (void)connection;
+  (void)characteristic;
+  (void)value;
+
+  bt_stats.notifications++;
+  bt_stats.gatt_bytes += value_len;
+  return SL_STATUS_OK;
+}
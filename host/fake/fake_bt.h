@@ -0,0 +1,156 @@
+/**
+ * @file fake_bt.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains the controls of the fake Bluetooth
+ * stack of the host build. The fake keeps a queue of events for the host
+ * driver to pass to sl_bt_on_event(), ORs the signals of
+ * sl_bt_external_signal() into one external signal event like the stack
+ * does, stores the local GATT attribute values and plays a GATT client
+ * that confirms every indication one connection interval after it was
+ * sent. A passkey confirmed with sl_bt_sm_passkey_confirm() completes the
+ * bonding.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __FAKE_BT_H__
+#define __FAKE_BT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sl_bt_api.h"
+
+// the connection interval used by the fake client, 60 * 1.25 ms
+#define HOST_BT_CONN_INTERVAL_US    (75000)
+// the largest event payload kept in the queue
+#define HOST_BT_MAX_PAYLOAD         (256)
+
+/**
+ * An event buffer large enough for the variable-length payloads
+ */
+typedef union {
+  sl_bt_msg_t msg;
+  uint8_t raw[SL_BGAPI_MSG_HEADER_LEN + HOST_BT_MAX_PAYLOAD];
+}host_bt_event_t;
+
+/**
+ * Statistics of the fake stack
+ */
+typedef struct {
+  uint32_t events;             // events handed out by host_bt_next_event()
+  uint32_t signal_events;      // the part of events carrying external signals
+  uint32_t signals;            // calls of sl_bt_external_signal()
+  uint32_t indications;
+  uint32_t notifications;
+  uint32_t gatt_bytes;         // payload bytes of indications and notifications
+  uint32_t busy;               // indications refused while one was in flight
+  uint32_t dropped;            // events and signals dropped while replaying
+}host_bt_stats_t;
+
+
+/**
+ * @brief Obtain the statistics of the fake stack.
+ * @param stats: filled with the statistics.
+ */
+void host_bt_get_stats(host_bt_stats_t *stats);
+
+/**
+ * @brief Take the next event for sl_bt_on_event(). Queued events come
+ * before the pending external signals.
+ * @param evt: filled with the event.
+ * @return false if no event is pending.
+ */
+bool host_bt_next_event(host_bt_event_t *evt);
+
+/**
+ * @brief Check whether an event is pending.
+ * @return true if host_bt_next_event() would return an event.
+ */
+bool host_bt_event_pending();
+
+/**
+ * @brief Queue an event. The length in the header is set from len.
+ * @param id: the event id.
+ * @param data: the event data.
+ * @param len: the length of data.
+ */
+void host_bt_push_event(uint32_t id, const void *data, size_t len);
+
+/**
+ * @brief Queue the boot event.
+ */
+void host_bt_push_boot();
+
+/**
+ * @brief Queue the opening of a connection by the fake client.
+ * @param connection: the connection handle.
+ */
+void host_bt_push_connection_opened(uint8_t connection);
+
+/**
+ * @brief Queue the closing of a connection by the fake client.
+ * @param connection: the connection handle.
+ * @param reason: the reason code.
+ */
+void host_bt_push_connection_closed(uint8_t connection, uint16_t reason);
+
+/**
+ * @brief Queue the passkey confirmation request of the pairing.
+ * @param connection: the connection handle.
+ * @param passkey: the passkey shown on the LCD.
+ */
+void host_bt_push_confirm_passkey(uint8_t connection, uint32_t passkey);
+
+/**
+ * @brief Queue the ATT MTU exchange.
+ * @param connection: the connection handle.
+ * @param mtu: the negotiated ATT MTU.
+ */
+void host_bt_push_mtu_exchanged(uint8_t connection, uint16_t mtu);
+
+/**
+ * @brief Queue a write of the client characteristic configuration.
+ * @param connection: the connection handle.
+ * @param characteristic: the characteristic handle.
+ * @param flags: the client config flags, sl_bt_gatt_indication etc.
+ */
+void host_bt_push_client_config(uint8_t connection, uint16_t characteristic, \
+                                uint16_t flags);
+
+/**
+ * @brief Write an attribute from the fake client. The value is stored
+ * before the attribute value event is queued.
+ * @param connection: the connection handle.
+ * @param attribute: the attribute handle.
+ * @param value: the value.
+ * @param len: the length of value.
+ */
+void host_bt_push_attribute_value(uint8_t connection, uint16_t attribute, \
+                                  const uint8_t *value, size_t len);
+
+/**
+ * @brief Check whether the connection has bonded.
+ * @return true once the passkey has been confirmed.
+ */
+bool host_bt_bonded();
+
+/**
+ * @brief Enter or leave the replay of a trace. While replaying, the
+ * signals of sl_bt_external_signal() and the events the fake answers
+ * the stack commands with are dropped, the trace already holds them.
+ * @param enable: true to replay.
+ */
+void host_bt_set_replay(bool enable);
+
+/**
+ * @brief Take the signals raised while replaying.
+ * @param mask: the signals to take.
+ * @return the signals of mask raised since they were last taken.
+ */
+uint32_t host_bt_take_replay_signals(uint32_t mask);
+
+#endif // __FAKE_BT_H__
@@ -0,0 +1,290 @@
+/**
+ * @file fake_i2c.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the fake I2C0 of the host build with the
+ * Si7021 and the ISL29125 behind it. A transfer started with
+ * I2C_TransferInit() takes 9 bit times per byte at HOST_I2C_BIT_RATE and
+ * then raises one I2C0 interrupt, on which I2C_Transfer() returns the
+ * result. I2CSPM_Transfer() completes at once.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "em_i2c.h"
+#include "sl_i2cspm.h"
+#include "host_hw.h"
+#include "fake_platform.h"
+#include "irq.h"
+
+#define SI7021_ADDR                 (0x40)
+#define ISL29125_ADDR               (0x44)
+#define ISL29125_DEVICE_ID          (0x7D)
+#define ISL29125_RESET              (0x46)
+#define ISL29125_GREEN_L            (0x09)
+
+// transfers kept until host_i2c_take_log()
+#define HOST_I2C_LOG_DEPTH          (64)
+
+static uint16_t     si7021_code = 0x6666;
+static uint8_t      isl29125_regs[16] = { [0] = ISL29125_DEVICE_ID };
+static uint8_t      isl29125_ptr = 0;
+
+static uint16_t     nack_addr = 0;
+static uint32_t     nack_count = 0;
+
+static uint32_t     current_route = 0;
+
+static host_i2c_transfer_t transfer_log[HOST_I2C_LOG_DEPTH];
+static uint32_t     log_len = 0;
+
+static I2C_TransferSeq_TypeDef *running_seq = NULL;
+static I2C_TransferReturn_TypeDef running_status = i2cTransferDone;
+static uint64_t     running_start = 0;
+static bool         irq_pending = false;
+static host_event_t i2c_event;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Write bytes to a device.
+// ---------------------------------------------------------------------
+static void device_write(uint16_t addr, const uint8_t *data, uint16_t len)
+{
+  uint16_t i;
+
+  if((addr != ISL29125_ADDR) || (len == 0))
+    return;
+
+  // the first byte is the register address, auto-incremented
+  isl29125_ptr = data[0] & 0x0f;
+  for(i=1;i<len;i++){
+      if((isl29125_ptr == 0) && (data[i] == ISL29125_RESET)){
+          memset(&isl29125_regs[1], 0, 3);
+      }
+      else if(isl29125_ptr != 0){
+          isl29125_regs[isl29125_ptr] = data[i];
+      }
+      isl29125_ptr = (isl29125_ptr + 1) & 0x0f;
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Read bytes from a device.
+// ---------------------------------------------------------------------
+static void device_read(uint16_t addr, uint8_t *data, uint16_t len)
+{
+  uint16_t i;
+
+  for(i=0;i<len;i++){
+      if(addr == SI7021_ADDR){
+          // the code is sent MSB first, a third byte would be the checksum
+          data[i] = (i == 0) ? (uint8_t)(si7021_code >> 8) : \
+                    (i == 1) ? (uint8_t)si7021_code : 0;
+      }
+      else{
+          data[i] = isl29125_regs[isl29125_ptr];
+          isl29125_ptr = (isl29125_ptr + 1) & 0x0f;
+      }
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Run the data phase of a transfer on the devices.
+// ---------------------------------------------------------------------
+static I2C_TransferReturn_TypeDef run_transfer(I2C_TransferSeq_TypeDef *seq, \
+                                               uint64_t start, bool polled)
+{
+  uint16_t addr = seq->addr >> 1;
+  I2C_TransferReturn_TypeDef status = i2cTransferDone;
+
+  if(log_len < HOST_I2C_LOG_DEPTH){
+      transfer_log[log_len].start = start;
+      transfer_log[log_len].addr = addr;
+      transfer_log[log_len].flags = seq->flags;
+      transfer_log[log_len].route = current_route;
+      transfer_log[log_len].status = i2cTransferInProgress;
+  }
+
+  if(polled)
+    host_stats.i2c_polled++;
+  else
+    host_stats.i2c_transfers++;
+
+  if((addr != SI7021_ADDR) && (addr != ISL29125_ADDR)){
+      status = i2cTransferNack;
+  }
+  else if((nack_count > 0) && (addr == nack_addr)){
+      nack_count--;
+      status = i2cTransferNack;
+  }
+  else{
+      switch(seq->flags){
+        case I2C_FLAG_WRITE:
+          device_write(addr, seq->buf[0].data, seq->buf[0].len);
+          break;
+        case I2C_FLAG_READ:
+          device_read(addr, seq->buf[0].data, seq->buf[0].len);
+          break;
+        case I2C_FLAG_WRITE_READ:
+          device_write(addr, seq->buf[0].data, seq->buf[0].len);
+          device_read(addr, seq->buf[1].data, seq->buf[1].len);
+          break;
+        case I2C_FLAG_WRITE_WRITE:
+          {
+            uint8_t data[16];
+            uint16_t len0 = seq->buf[0].len, len1 = seq->buf[1].len;
+
+            if((len0 + len1) > sizeof(data)){
+                status = i2cTransferUsageFault;
+                break;
+            }
+            memcpy(data, seq->buf[0].data, len0);
+            memcpy(&data[len0], seq->buf[1].data, len1);
+            device_write(addr, data, len0 + len1);
+          }
+          break;
+        default:
+          status = i2cTransferUsageFault;
+          break;
+      }
+  }
+
+  if(status == i2cTransferNack)
+    host_stats.i2c_nacks++;
+
+  if(log_len < HOST_I2C_LOG_DEPTH)
+    transfer_log[log_len++].status = status;
+
+  return status;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Bytes on the bus, including the address bytes.
+// ---------------------------------------------------------------------
+static uint32_t bus_bytes(const I2C_TransferSeq_TypeDef *seq)
+{
+  uint32_t bytes = 1 + seq->buf[0].len;
+
+  if(seq->flags == I2C_FLAG_WRITE_READ)
+    bytes += 1 + seq->buf[1].len;
+  else if(seq->flags == I2C_FLAG_WRITE_WRITE)
+    bytes += seq->buf[1].len;
+  return bytes;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// End of the transfer on the bus.
+// ---------------------------------------------------------------------
+static void i2c_fire(void *ctx)
+{
+  (void)ctx;
+
+  running_status = run_transfer(running_seq, running_start, false);
+  irq_pending = true;
+}
+
+/**
+ * @brief Set the 16-bit temperature code returned by the Si7021.
+ * @param code: the code, see the conversion in get_temperature_data_mC().
+ */
+void host_si7021_set_code(uint16_t code)
+{
+  si7021_code = code;
+}
+
+/**
+ * @brief Set the green, red and blue readings returned by the ISL29125.
+ */
+void host_isl29125_set_rgb(uint16_t green, uint16_t red, uint16_t blue)
+{
+  isl29125_regs[ISL29125_GREEN_L]     = (uint8_t)green;
+  isl29125_regs[ISL29125_GREEN_L + 1] = (uint8_t)(green >> 8);
+  isl29125_regs[ISL29125_GREEN_L + 2] = (uint8_t)red;
+  isl29125_regs[ISL29125_GREEN_L + 3] = (uint8_t)(red >> 8);
+  isl29125_regs[ISL29125_GREEN_L + 4] = (uint8_t)blue;
+  isl29125_regs[ISL29125_GREEN_L + 5] = (uint8_t)(blue >> 8);
+}
+
+/**
+ * @brief NACK the next transfers to a device.
+ * @param addr: the 7-bit device address.
+ * @param count: the number of transfers to NACK.
+ */
+void host_i2c_nack_next(uint16_t addr, uint32_t count)
+{
+  nack_addr = addr;
+  nack_count = count;
+}
+
+/**
+ * @brief Obtain the transfers started on I2C0 since the last call.
+ * @param log: filled with up to max transfers, oldest first.
+ * @param max: the capacity of log.
+ * @return the number of transfers copied.
+ */
+uint32_t host_i2c_take_log(host_i2c_transfer_t *log, uint32_t max)
+{
+  uint32_t n = (log_len < max) ? log_len : max;
+
+  memcpy(log, transfer_log, n * sizeof(transfer_log[0]));
+  log_len = 0;
+  return n;
+}
+
+/**
+ * @brief Take the I2C0 interrupt if it is pending.
+ * @return true if the ISR was run.
+ */
+bool host_i2c_service()
+{
+  if(!irq_pending || !NVIC_GetEnableIRQ(I2C0_IRQn))
+    return false;
+  I2C0_IRQHandler();
+  return true;
+}
+
+void I2CSPM_Init(I2CSPM_Init_TypeDef *init)
+{
+  host_stats.i2cspm_inits++;
+  current_route = (init->sclPort * 16) + init->sclPin;
+}
+
+I2C_TransferReturn_TypeDef I2CSPM_Transfer(I2C_TypeDef *i2c, I2C_TransferSeq_TypeDef *seq)
+{
+  (void)i2c;
+  return run_transfer(seq, host_now(), true);
+}
+
+I2C_TransferReturn_TypeDef I2C_TransferInit(I2C_TypeDef *i2c, I2C_TransferSeq_TypeDef *seq)
+{
+  (void)i2c;
+
+  if(running_seq)
+    return i2cTransferUsageFault;
+
+  running_seq = seq;
+  running_start = host_now();
+  running_status = i2cTransferInProgress;
+  host_event_schedule(&i2c_event, \
+                      host_now() + ((bus_bytes(seq) * 9 * HOST_CLOCK_HZ) / HOST_I2C_BIT_RATE), \
+                      i2c_fire, NULL);
+  return i2cTransferInProgress;
+}
+
+I2C_TransferReturn_TypeDef I2C_Transfer(I2C_TypeDef *i2c)
+{
+  (void)i2c;
+
+  irq_pending = false;
+  if(running_status != i2cTransferInProgress)
+    running_seq = NULL;
+  return running_status;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file fake_letimer.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the fake LETIMER0 of the host build. The
+ * counter runs down from COMP0 at the LFA clock divided by the LETIMER0
+ * prescaler, both taken from the fake CMU. The UF and COMP1 flags are set
+ * in IF at the simulated time the counter wraps or matches COMP1, and the
+ * interrupt is taken while IF & IEN is set. IEN is the real register, it
+ * is written directly by the firmware.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "em_letimer.h"
+#include "host_hw.h"
+#include "host_fakes.h"
+#include "fake_platform.h"
+#include "irq.h"
+
+static bool         running = false;
+// host tick count at which the counter was at TOP, after a whole period
+static uint64_t     origin = 0;
+static uint32_t     top = 0;
+static uint32_t     comp1 = 0;
+static host_event_t letimer_event;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host ticks per LETIMER0 count.
+// ---------------------------------------------------------------------
+static uint64_t ticks_per_count()
+{
+  return HOST_CLOCK_HZ / host_cmu_letimer_hz();
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Counts since the origin at the given host tick count.
+// ---------------------------------------------------------------------
+static uint64_t counts_at(uint64_t t)
+{
+  return (t - origin) / ticks_per_count();
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host tick count of the first count index after the given one at which
+// the counter reaches value.
+// ---------------------------------------------------------------------
+static uint64_t next_match(uint64_t counts, uint32_t value)
+{
+  uint64_t period = (uint64_t)top + 1;
+  // the counter is at value on the count index k * period + (top - value)
+  uint64_t first = top - value;
+  uint64_t k;
+
+  if(counts < first)
+    k = first;
+  else
+    k = first + ((((counts - first) / period) + 1) * period);
+
+  return origin + (k * ticks_per_count());
+}
+
+static void letimer_fire(void *ctx);
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Schedule the next UF or COMP1 match.
+// ---------------------------------------------------------------------
+static void schedule_next()
+{
+  uint64_t counts, uf, match;
+
+  if(!running){
+      host_event_cancel(&letimer_event);
+      return;
+  }
+
+  counts = counts_at(host_now());
+  // the UF is the step from 0 back to TOP, the count index of every
+  // multiple of the period
+  uf = origin + ((((counts / ((uint64_t)top + 1)) + 1) * ((uint64_t)top + 1)) * \
+                 ticks_per_count());
+  match = (comp1 <= top) ? next_match(counts, comp1) : UINT64_MAX;
+
+  host_event_schedule(&letimer_event, (uf < match) ? uf : match, letimer_fire, NULL);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Set the flags of the UF or COMP1 match due now.
+// ---------------------------------------------------------------------
+static void letimer_fire(void *ctx)
+{
+  uint64_t counts = counts_at(host_now());
+  uint32_t count = top - (uint32_t)(counts % ((uint64_t)top + 1));
+
+  (void)ctx;
+
+  if(count == top)
+    HOST_REG(LETIMER0->IF) |= LETIMER_IF_UF;
+  if(count == comp1)
+    HOST_REG(LETIMER0->IF) |= LETIMER_IF_COMP1;
+  HOST_REG(LETIMER0->CNT) = count;
+
+  schedule_next();
+}
+
+/**
+ * @brief Take the LETIMER0 interrupt if it is pending.
+ * @return true if the ISR was run.
+ */
+bool host_letimer_service()
+{
+  if(!(LETIMER0->IF & LETIMER0->IEN))
+    return false;
+  LETIMER0_IRQHandler();
+  return true;
+}
+
+void LETIMER_Init(LETIMER_TypeDef *letimer, const LETIMER_Init_TypeDef *init)
+{
+  (void)letimer;
+
+  if(init->comp0Top){
+      top = init->topValue;
+      LETIMER0->COMP0 = top;
+  }
+  HOST_REG(LETIMER0->CNT) = top;
+  LETIMER_Enable(LETIMER0, init->enable);
+}
+
+void LETIMER_RepeatSet(LETIMER_TypeDef *letimer, unsigned int rep, uint32_t value)
+{
+  (void)letimer;
+  if(rep == 0)
+    LETIMER0->REP0 = value;
+  else
+    LETIMER0->REP1 = value;
+}
+
+void LETIMER_CompareSet(LETIMER_TypeDef *letimer, unsigned int comp, uint32_t value)
+{
+  (void)letimer;
+
+  if(comp == 0){
+      top = value;
+      LETIMER0->COMP0 = value;
+  }
+  else{
+      comp1 = value;
+      LETIMER0->COMP1 = value;
+  }
+  schedule_next();
+}
+
+void LETIMER_Enable(LETIMER_TypeDef *letimer, bool enable)
+{
+  (void)letimer;
+
+  if(enable && !running){
+      origin = host_now();
+      HOST_REG(LETIMER0->CNT) = top;
+  }
+  running = enable;
+  schedule_next();
+}
+
+uint32_t LETIMER_CounterGet(LETIMER_TypeDef *letimer)
+{
+  (void)letimer;
+
+  if(!running)
+    return LETIMER0->CNT;
+  return top - (uint32_t)(counts_at(host_now()) % ((uint64_t)top + 1));
+}
+
+void LETIMER_IntClear(LETIMER_TypeDef *letimer, uint32_t flags)
+{
+  (void)letimer;
+  HOST_REG(LETIMER0->IF) &= ~flags;
+}
+
+void LETIMER_IntSet(LETIMER_TypeDef *letimer, uint32_t flags)
+{
+  (void)letimer;
+  HOST_REG(LETIMER0->IF) |= flags;
+}
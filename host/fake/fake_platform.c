@@ -0,0 +1,362 @@
+/**
+ * @file fake_platform.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the fakes of the platform services used by the
+ * firmware that do not need a timing model: the CMU, the GPIO pin setup,
+ * the pin outputs and the push buttons, the CORE critical sections, the
+ * power manager, udelay, the log iostream, app_log() and the status
+ * strings.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_core.h"
+#include "sl_power_manager.h"
+#include "sl_udelay.h"
+#include "sl_iostream.h"
+#include "sl_status.h"
+#include "host_hw.h"
+#include "fake_platform.h"
+#include "irq.h"
+
+// number of modules subscribed to the energy mode transitions
+#define HOST_POWER_MAX_SUBSCRIBERS  (8)
+
+#define LFXO_FREQ                   (32768)
+#define ULFRCO_FREQ                 (1000)
+
+host_stats_t host_stats;
+
+static CMU_Select_TypeDef lfa_select = cmuSelect_LFXO;
+static uint32_t     letimer_div = 1;
+
+static const sl_power_manager_em_transition_event_info_t \
+                    *subscribers[HOST_POWER_MAX_SUBSCRIBERS];
+static uint32_t     num_subscribers = 0;
+static sl_power_manager_em_t current_em = SL_POWER_MANAGER_EM0;
+
+static bool         log_enabled = false;
+
+sl_iostream_t *app_log_iostream = NULL;
+
+
+/**
+ * @brief Obtain the statistics of the fake peripherals.
+ * @param stats: filled with the statistics.
+ */
+void host_get_stats(host_stats_t *stats)
+{
+  *stats = host_stats;
+}
+
+/**
+ * @brief Obtain the LETIMER0 clock, the LFA clock divided by the LETIMER0
+ * prescaler.
+ * @return the LETIMER0 clock in Hz.
+ */
+uint32_t host_cmu_letimer_hz()
+{
+  uint32_t lfa_hz = (lfa_select == cmuSelect_ULFRCO) ? ULFRCO_FREQ : LFXO_FREQ;
+
+  return lfa_hz / letimer_div;
+}
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable)
+{
+  (void)clock;
+  (void)enable;
+}
+
+void CMU_ClockDivSet(CMU_Clock_TypeDef clock, CMU_ClkDiv_TypeDef div)
+{
+  if(clock == cmuClock_LETIMER0)
+    letimer_div = div;
+}
+
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref)
+{
+  if(clock == cmuClock_LFA)
+    lfa_select = ref;
+}
+
+void CMU_LFXOInit(const CMU_LFXOInit_TypeDef *lfxoInit)
+{
+  (void)lfxoInit;
+}
+
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait)
+{
+  (void)osc;
+  (void)enable;
+  (void)wait;
+}
+
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength)
+{
+  (void)port;
+  (void)strength;
+}
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, \
+                     GPIO_Mode_TypeDef mode, unsigned int out)
+{
+  // an input with the pull-up enabled reads high, i.e. a released button
+  if((mode == gpioModeInput) || (mode == gpioModeInputPull)){
+      if(out)
+        HOST_REG(GPIO->P[port].DIN) |= (1UL << pin);
+      else
+        HOST_REG(GPIO->P[port].DIN) &= ~(1UL << pin);
+  }
+  if(out)
+    GPIO->P[port].DOUT |= (1UL << pin);
+  else
+    GPIO->P[port].DOUT &= ~(1UL << pin);
+}
+
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, \
+                       unsigned int intNo, bool risingEdge, \
+                       bool fallingEdge, bool enable)
+{
+  (void)port;
+  (void)pin;
+
+  if(risingEdge)
+    GPIO->EXTIRISE |= (1UL << intNo);
+  else
+    GPIO->EXTIRISE &= ~(1UL << intNo);
+  if(fallingEdge)
+    GPIO->EXTIFALL |= (1UL << intNo);
+  else
+    GPIO->EXTIFALL &= ~(1UL << intNo);
+
+  GPIO->IFC = (1UL << intNo);
+  if(enable)
+    GPIO->IEN |= (1UL << intNo);
+  else
+    GPIO->IEN &= ~(1UL << intNo);
+}
+
+/**
+ * @brief Press or release a push button. The GPIO interrupt of the pin
+ * is taken by the next host_hw_service().
+ * @param port: the GPIO port.
+ * @param pin: the GPIO pin.
+ * @param pressed: true to press, the buttons are active low.
+ */
+void host_gpio_button(uint8_t port, uint8_t pin, bool pressed)
+{
+  uint32_t mask = (1UL << pin);
+  bool high = !pressed;
+  bool was_high = (GPIO->P[port].DIN & mask) != 0;
+
+  if(high == was_high)
+    return;
+
+  if(high)
+    HOST_REG(GPIO->P[port].DIN) |= mask;
+  else
+    HOST_REG(GPIO->P[port].DIN) &= ~mask;
+
+  // the pin number selects the interrupt line, see GPIO_ExtIntConfig()
+  if((high && (GPIO->EXTIRISE & mask)) || (!high && (GPIO->EXTIFALL & mask)))
+    HOST_REG(GPIO->IF) |= mask;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Fold the writes to the bit set and bit clear aliases of the DOUT
+// registers into DOUT, see GPIO_PinOutSet() and BUS_RegMaskedSet(). A set
+// and a clear between two folds are taken in this order.
+// ---------------------------------------------------------------------
+static void fold_dout()
+{
+  volatile uint32_t *set;
+  volatile uint32_t *clr;
+  uint32_t offset;
+  uint32_t port;
+
+  for(port=0;port<(sizeof(GPIO->P) / sizeof(GPIO->P[0]));port++){
+      offset = (uint32_t)(uintptr_t)&GPIO->P[port].DOUT - PER_MEM_BASE;
+      set = (volatile uint32_t *)(uintptr_t)(PER_BITSET_MEM_BASE + offset);
+      clr = (volatile uint32_t *)(uintptr_t)(PER_BITCLR_MEM_BASE + offset);
+
+      GPIO->P[port].DOUT = (GPIO->P[port].DOUT | *set) & ~*clr;
+      *set = 0;
+      *clr = 0;
+  }
+}
+
+/**
+ * @brief Take the GPIO interrupts if they are pending, and update the
+ * pin outputs.
+ * @return true if an ISR was run.
+ */
+bool host_gpio_service()
+{
+  uint32_t pending;
+  bool taken = false;
+
+  fold_dout();
+  HOST_REG(GPIO->IF) &= ~GPIO->IFC;
+  GPIO->IFC = 0;
+
+  pending = GPIO->IF & GPIO->IEN;
+  if(pending & 0x5555UL){
+      GPIO_EVEN_IRQHandler();
+      taken = true;
+  }
+  if(pending & 0xAAAAUL){
+      GPIO_ODD_IRQHandler();
+      taken = true;
+  }
+
+  HOST_REG(GPIO->IF) &= ~GPIO->IFC;
+  GPIO->IFC = 0;
+  fold_dout();
+  return taken;
+}
+
+// the firmware is only interrupted between its steps, see host_hw.h
+CORE_irqState_t CORE_EnterCritical(void)
+{
+  return 0;
+}
+
+void CORE_ExitCritical(CORE_irqState_t irqState)
+{
+  (void)irqState;
+}
+
+CORE_irqState_t CORE_EnterAtomic(void)
+{
+  return 0;
+}
+
+void CORE_ExitAtomic(CORE_irqState_t irqState)
+{
+  (void)irqState;
+}
+
+void sli_power_manager_update_em_requirement(sl_power_manager_em_t em, bool add)
+{
+  if(em > SL_POWER_MANAGER_EM3)
+    return;
+
+  if(add){
+      host_stats.em_requirements[em]++;
+  }
+  else if(host_stats.em_requirements[em] > 0){
+      host_stats.em_requirements[em]--;
+  }
+  else{
+      fprintf(stderr, "host: EM%d requirement removed more often than added\n", em);
+  }
+}
+
+void sl_power_manager_subscribe_em_transition_event(sl_power_manager_em_transition_event_handle_t *event_handle, \
+                                                    const sl_power_manager_em_transition_event_info_t *event_info)
+{
+  (void)event_handle;
+
+  if(num_subscribers < HOST_POWER_MAX_SUBSCRIBERS)
+    subscribers[num_subscribers++] = event_info;
+}
+
+/**
+ * @brief Obtain the lowest energy mode allowed by the requirements.
+ * @return the energy mode the MCU would sleep in.
+ */
+sl_power_manager_em_t host_power_lowest_em()
+{
+  int em;
+
+  for(em=SL_POWER_MANAGER_EM0;em<SL_POWER_MANAGER_EM3;em++){
+      if(host_stats.em_requirements[em] > 0)
+        return (sl_power_manager_em_t)em;
+  }
+  return SL_POWER_MANAGER_EM3;
+}
+
+/**
+ * @brief Move the MCU to an energy mode, notifying the subscribers of the
+ * transition events like the power manager does.
+ * @param em: the energy mode.
+ */
+void host_power_enter(sl_power_manager_em_t em)
+{
+  sl_power_manager_em_t from = current_em;
+  uint32_t events;
+  uint32_t i;
+
+  if(em == from)
+    return;
+
+  // the LEAVING bit of an energy mode follows its ENTERING bit
+  events = (SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM0 << (2 * from)) | \
+           (SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0 << (2 * em));
+  current_em = em;
+
+  for(i=0;i<num_subscribers;i++){
+      if(subscribers[i]->event_mask & events)
+        subscribers[i]->on_event(from, em);
+  }
+}
+
+void sl_udelay_wait(unsigned us)
+{
+  (void)us;
+}
+
+/**
+ * @brief Print the log lines of the firmware to stderr.
+ * @param enable: true to print, they are dropped by default.
+ */
+void host_log_enable(bool enable)
+{
+  log_enabled = enable;
+}
+
+sl_status_t sl_iostream_write(sl_iostream_t *stream, const void *buffer, \
+                              size_t buffer_length)
+{
+  (void)stream;
+
+  if(log_enabled)
+    fwrite(buffer, 1, buffer_length, stderr);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_iostream_printf(sl_iostream_t *stream, const char *format, ...)
+{
+  va_list args;
+
+  (void)stream;
+
+  if(log_enabled){
+      va_start(args, format);
+      vfprintf(stderr, format, args);
+      va_end(args);
+  }
+  return SL_STATUS_OK;
+}
+
+// the time and counter prefixes of app_log() are not configured
+void _app_log_time()
+{
+}
+
+void _app_log_counter()
+{
+}
+
+int32_t sl_status_get_string_n(sl_status_t status, char *buffer, uint32_t buffer_length)
+{
+  return snprintf(buffer, buffer_length, "SL_STATUS 0x%04x", (unsigned int)status);
+}
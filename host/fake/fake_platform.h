@@ -0,0 +1,30 @@
+/**
+ * @file fake_platform.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains the state shared between the fakes of
+ * the host build: the statistics they count into and the low-frequency
+ * clock selected through the fake CMU.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __FAKE_PLATFORM_H__
+#define __FAKE_PLATFORM_H__
+
+#include <stdint.h>
+#include "host_fakes.h"
+
+// statistics of all fakes, returned by host_get_stats()
+extern host_stats_t host_stats;
+
+/**
+ * @brief Obtain the LETIMER0 clock, the LFA clock divided by the LETIMER0
+ * prescaler.
+ * @return the LETIMER0 clock in Hz.
+ */
+uint32_t host_cmu_letimer_hz();
+
+#endif // __FAKE_PLATFORM_H__
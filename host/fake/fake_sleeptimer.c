@@ -0,0 +1,187 @@
+/**
+ * @file fake_sleeptimer.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the fake sleeptimer of the host build, ticking
+ * at 32768 Hz on the simulated clock. A timer callback runs from the event
+ * of its expiry, i.e. in the ISR context like on the target.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "sl_sleeptimer.h"
+#include "host_hw.h"
+
+#define SLEEPTIMER_FREQ             (32768)
+#define TICKS_PER_SLEEPTIMER_TICK   (HOST_CLOCK_HZ / SLEEPTIMER_FREQ)
+
+// number of timers running at the same time
+#define HOST_SLEEPTIMER_MAX_TIMERS  (16)
+
+/**
+ * A running timer
+ */
+typedef struct {
+  sl_sleeptimer_timer_handle_t *handle;
+  uint32_t period;             // in sleeptimer ticks, 0 for a one-shot timer
+  host_event_t event;
+}host_timer_t;
+
+static host_timer_t timers[HOST_SLEEPTIMER_MAX_TIMERS];
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Find the slot of a running timer.
+// ---------------------------------------------------------------------
+static host_timer_t *find_timer(sl_sleeptimer_timer_handle_t *handle)
+{
+  int i;
+
+  for(i=0;i<HOST_SLEEPTIMER_MAX_TIMERS;i++){
+      if(timers[i].handle == handle)
+        return &timers[i];
+  }
+  return NULL;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Expiry of a timer, reloads a periodic timer before its callback.
+// ---------------------------------------------------------------------
+static void timer_fire(void *ctx)
+{
+  host_timer_t *timer = ctx;
+  sl_sleeptimer_timer_handle_t *handle = timer->handle;
+
+  if(timer->period){
+      host_event_schedule(&timer->event, \
+                          timer->event.at + ((uint64_t)timer->period * TICKS_PER_SLEEPTIMER_TICK), \
+                          timer_fire, timer);
+  }
+  else{
+      timer->handle = NULL;
+  }
+
+  handle->callback(handle, handle->callback_data);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Start or restart a timer.
+// ---------------------------------------------------------------------
+static sl_status_t start(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout, \
+                         uint32_t period, sl_sleeptimer_timer_callback_t callback, \
+                         void *callback_data, uint8_t priority, uint16_t option_flags)
+{
+  host_timer_t *timer = find_timer(handle);
+
+  if(!timer)
+    timer = find_timer(NULL);
+  if(!timer)
+    return SL_STATUS_NO_MORE_RESOURCE;
+
+  handle->callback = callback;
+  handle->callback_data = callback_data;
+  handle->priority = priority;
+  handle->option_flags = option_flags;
+  handle->timeout_periodic = period;
+
+  timer->handle = handle;
+  timer->period = period;
+  host_event_schedule(&timer->event, \
+                      host_now() + ((uint64_t)timeout * TICKS_PER_SLEEPTIMER_TICK), \
+                      timer_fire, timer);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_start_timer(sl_sleeptimer_timer_handle_t *handle,
+                                      uint32_t timeout,
+                                      sl_sleeptimer_timer_callback_t callback,
+                                      void *callback_data,
+                                      uint8_t priority,
+                                      uint16_t option_flags)
+{
+  if(find_timer(handle))
+    return SL_STATUS_NOT_READY;
+  return start(handle, timeout, 0, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_restart_timer(sl_sleeptimer_timer_handle_t *handle,
+                                        uint32_t timeout,
+                                        sl_sleeptimer_timer_callback_t callback,
+                                        void *callback_data,
+                                        uint8_t priority,
+                                        uint16_t option_flags)
+{
+  return start(handle, timeout, 0, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_start_periodic_timer(sl_sleeptimer_timer_handle_t *handle,
+                                               uint32_t timeout,
+                                               sl_sleeptimer_timer_callback_t callback,
+                                               void *callback_data,
+                                               uint8_t priority,
+                                               uint16_t option_flags)
+{
+  if(find_timer(handle))
+    return SL_STATUS_NOT_READY;
+  return start(handle, timeout, timeout, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_restart_periodic_timer(sl_sleeptimer_timer_handle_t *handle,
+                                                 uint32_t timeout,
+                                                 sl_sleeptimer_timer_callback_t callback,
+                                                 void *callback_data,
+                                                 uint8_t priority,
+                                                 uint16_t option_flags)
+{
+  return start(handle, timeout, timeout, callback, callback_data, priority, option_flags);
+}
+
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle)
+{
+  host_timer_t *timer = find_timer(handle);
+
+  if(!timer)
+    return SL_STATUS_INVALID_STATE;
+
+  host_event_cancel(&timer->event);
+  timer->handle = NULL;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_is_timer_running(sl_sleeptimer_timer_handle_t *handle,
+                                           bool *running)
+{
+  *running = (find_timer(handle) != NULL);
+  return SL_STATUS_OK;
+}
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return (uint32_t)(host_now() / TICKS_PER_SLEEPTIMER_TICK);
+}
+
+uint64_t sl_sleeptimer_get_tick_count64(void)
+{
+  return host_now() / TICKS_PER_SLEEPTIMER_TICK;
+}
+
+uint32_t sl_sleeptimer_get_timer_frequency(void)
+{
+  return SLEEPTIMER_FREQ;
+}
+
+uint32_t sl_sleeptimer_ms_to_tick(uint16_t time_ms)
+{
+  return (uint32_t)(((uint64_t)time_ms * SLEEPTIMER_FREQ) / 1000);
+}
+
+sl_status_t sl_sleeptimer_ms32_to_tick(uint32_t time_ms, uint32_t *tick)
+{
+  *tick = (uint32_t)(((uint64_t)time_ms * SLEEPTIMER_FREQ) / 1000);
+  return SL_STATUS_OK;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file fake_usart_ldma.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the fake USART1 and LDMA of the host build,
+ * used by the memory LCD driver. Bytes written with USART_Tx() are clocked
+ * out at once. A descriptor chain loaded through LDMA->LINKLOAD is walked
+ * when the load is seen, and the channel completes after its bytes have
+ * been clocked out at the USART baudrate. TXC stays set in USART1->STATUS
+ * since the shift register is always empty when the firmware looks.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include "em_usart.h"
+#include "host_hw.h"
+#include "fake_platform.h"
+
+// the channels of the LDMA
+#define HOST_LDMA_CHANNELS          (DMA_CHAN_COUNT)
+
+static uint32_t     baudrate = 1000000;
+
+static uint8_t      *capture_buf = NULL;
+static size_t       capture_cap = 0;
+static size_t       capture_len = 0;
+
+static bool         fail_next = false;
+static host_event_t ldma_events[HOST_LDMA_CHANNELS];
+
+extern void LDMA_IRQHandler(void);
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Clock one byte out on USART1.
+// ---------------------------------------------------------------------
+static void clock_out(uint8_t data)
+{
+  host_stats.spi_bytes++;
+  if(capture_buf && (capture_len < capture_cap))
+    capture_buf[capture_len++] = data;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Fold the writes to LDMA->IFC into LDMA->IF.
+// ---------------------------------------------------------------------
+static void fold_ifc()
+{
+  HOST_REG(LDMA->IF) &= ~LDMA->IFC;
+  LDMA->IFC = 0;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// End of the transfer of a channel, the context is the channel number.
+// ---------------------------------------------------------------------
+static void ldma_fire(void *ctx)
+{
+  uint32_t ch_mask = 1UL << (uintptr_t)ctx;
+
+  HOST_REG(LDMA->CHEN) &= ~ch_mask;
+  HOST_REG(LDMA->CHBUSY) &= ~ch_mask;
+  if(fail_next){
+      fail_next = false;
+      HOST_REG(LDMA->IF) |= LDMA_IF_ERROR;
+  }
+  else{
+      HOST_REG(LDMA->CHDONE) |= ch_mask;
+      HOST_REG(LDMA->IF) |= ch_mask;
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Walk the descriptor chain of a channel and schedule its completion.
+// ---------------------------------------------------------------------
+static void ldma_load(uint32_t ch)
+{
+  uint32_t link = LDMA->CH[ch].LINK & _LDMA_CH_LINK_LINKADDR_MASK;
+  uint32_t bytes = 0;
+  uint32_t i;
+
+  // the descriptors are addressed with 32 bits, see host_hw.c
+  while(link){
+      const uint32_t *desc = (const uint32_t *)(uintptr_t)link;
+      uint32_t ctrl = desc[0];
+      uint32_t count = ((ctrl & _LDMA_CH_CTRL_XFERCNT_MASK) >> _LDMA_CH_CTRL_XFERCNT_SHIFT) + 1;
+      const uint8_t *src = (const uint8_t *)(uintptr_t)desc[1];
+
+      for(i=0;i<count;i++){
+          clock_out(src[i]);
+      }
+      bytes += count;
+
+      if(!(desc[3] & LDMA_CH_LINK_LINK))
+        break;
+      link = desc[3] & _LDMA_CH_LINK_LINKADDR_MASK;
+  }
+
+  host_stats.spi_dma_bytes += bytes;
+  host_stats.dma_transfers++;
+
+  HOST_REG(LDMA->CHEN) |= (1UL << ch);
+  HOST_REG(LDMA->CHBUSY) |= (1UL << ch);
+  host_event_schedule(&ldma_events[ch], \
+                      host_now() + (((uint64_t)bytes * 8 * HOST_CLOCK_HZ) / baudrate), \
+                      ldma_fire, (void *)(uintptr_t)ch);
+}
+
+/**
+ * @brief Capture the bytes clocked out on USART1, in order.
+ * @param buf: the capture buffer, NULL to stop capturing.
+ * @param cap: the capacity of buf.
+ */
+void host_spi_capture(uint8_t *buf, size_t cap)
+{
+  capture_buf = buf;
+  capture_cap = buf ? cap : 0;
+  capture_len = 0;
+}
+
+/**
+ * @brief Obtain the number of bytes captured so far.
+ * @return the captured length.
+ */
+size_t host_spi_captured()
+{
+  return capture_len;
+}
+
+/**
+ * @brief Fail the next LDMA transfer with a bus error.
+ */
+void host_ldma_fail_next()
+{
+  fail_next = true;
+}
+
+/**
+ * @brief Load the descriptor chains written to LDMA->LINKLOAD and take
+ * the LDMA interrupt if it is pending.
+ * @return true if the ISR was run.
+ */
+bool host_ldma_service()
+{
+  uint32_t ch;
+
+  if(LDMA->LINKLOAD){
+      for(ch=0;ch<HOST_LDMA_CHANNELS;ch++){
+          if(LDMA->LINKLOAD & (1UL << ch))
+            ldma_load(ch);
+      }
+      LDMA->LINKLOAD = 0;
+  }
+
+  fold_ifc();
+  if(!(LDMA->IF & LDMA->IEN) || !NVIC_GetEnableIRQ(LDMA_IRQn))
+    return false;
+
+  LDMA_IRQHandler();
+  fold_ifc();
+  return true;
+}
+
+void USART_InitSync(USART_TypeDef *usart, const USART_InitSync_TypeDef *init)
+{
+  if(init->baudrate > 0)
+    baudrate = init->baudrate;
+  HOST_REG(usart->STATUS) |= USART_STATUS_TXC | USART_STATUS_TXBL;
+}
+
+void USART_Enable(USART_TypeDef *usart, USART_Enable_TypeDef enable)
+{
+  (void)usart;
+  (void)enable;
+}
+
+void USART_Tx(USART_TypeDef *usart, uint8_t data)
+{
+  (void)usart;
+  clock_out(data);
+}
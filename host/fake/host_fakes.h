@@ -0,0 +1,148 @@
+/**
+ * @file host_fakes.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains the controls and the statistics of the
+ * fake peripherals of the host build: I2C0 with the Si7021 and ISL29125
+ * behind it, ADC0, USART1 with the LDMA feeding it, the push buttons and
+ * the power manager. The BT stack fake is in fake_bt.h.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __HOST_FAKES_H__
+#define __HOST_FAKES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "em_i2c.h"
+#include "sl_power_manager.h"
+
+// I2C0 runs at the standard mode clock, 9 bit times per byte
+#define HOST_I2C_BIT_RATE           (100000)
+// ADC0 conversion time of one single-ended sample
+#define HOST_ADC_CONVERSION_US      (20)
+
+/**
+ * One transfer started on I2C0
+ */
+typedef struct {
+  uint64_t start;              // host tick count of I2C_TransferInit()
+  uint16_t addr;               // 7-bit device address
+  uint16_t flags;
+  uint32_t route;              // SCL port * 16 + SCL pin of the active route
+  I2C_TransferReturn_TypeDef status;
+}host_i2c_transfer_t;
+
+/**
+ * Statistics of the fake peripherals
+ */
+typedef struct {
+  uint32_t i2c_transfers;      // transfers started with I2C_TransferInit()
+  uint32_t i2c_polled;         // transfers run with I2CSPM_Transfer()
+  uint32_t i2c_nacks;
+  uint32_t i2cspm_inits;       // I2CSPM_Init() calls, i.e. route changes
+  uint32_t adc_conversions;
+  uint32_t spi_bytes;          // bytes clocked out on USART1
+  uint32_t spi_dma_bytes;      // the part of spi_bytes moved by the LDMA
+  uint32_t dma_transfers;
+  uint32_t em_requirements[SL_POWER_MANAGER_EM3 + 1];  // currently held
+}host_stats_t;
+
+
+/**
+ * @brief Obtain the statistics of the fake peripherals.
+ * @param stats: filled with the statistics.
+ */
+void host_get_stats(host_stats_t *stats);
+
+/**
+ * @brief Set the 16-bit temperature code returned by the Si7021.
+ * @param code: the code, see the conversion in get_temperature_data_mC().
+ */
+void host_si7021_set_code(uint16_t code);
+
+/**
+ * @brief Set the green, red and blue readings returned by the ISL29125.
+ */
+void host_isl29125_set_rgb(uint16_t green, uint16_t red, uint16_t blue);
+
+/**
+ * @brief NACK the next transfers to a device.
+ * @param addr: the 7-bit device address.
+ * @param count: the number of transfers to NACK.
+ */
+void host_i2c_nack_next(uint16_t addr, uint32_t count);
+
+/**
+ * @brief Obtain the transfers started on I2C0 since the last call.
+ * @param log: filled with up to max transfers, oldest first.
+ * @param max: the capacity of log.
+ * @return the number of transfers copied.
+ */
+uint32_t host_i2c_take_log(host_i2c_transfer_t *log, uint32_t max);
+
+/**
+ * @brief Set the ADC0 sample returned by the next conversions.
+ * @param value: the 12-bit sample.
+ */
+void host_adc_set_sample(uint32_t value);
+
+/**
+ * @brief Capture the bytes clocked out on USART1, in order.
+ * @param buf: the capture buffer, NULL to stop capturing.
+ * @param cap: the capacity of buf.
+ */
+void host_spi_capture(uint8_t *buf, size_t cap);
+
+/**
+ * @brief Obtain the number of bytes captured so far.
+ * @return the captured length.
+ */
+size_t host_spi_captured();
+
+/**
+ * @brief Fail the next LDMA transfer with a bus error.
+ */
+void host_ldma_fail_next();
+
+/**
+ * @brief Press or release a push button. The GPIO interrupt of the pin
+ * is taken by the next host_hw_service().
+ * @param port: the GPIO port.
+ * @param pin: the GPIO pin.
+ * @param pressed: true to press, the buttons are active low.
+ */
+void host_gpio_button(uint8_t port, uint8_t pin, bool pressed);
+
+/**
+ * @brief Obtain the lowest energy mode allowed by the requirements.
+ * @return the energy mode the MCU would sleep in.
+ */
+sl_power_manager_em_t host_power_lowest_em();
+
+/**
+ * @brief Move the MCU to an energy mode, notifying the subscribers of the
+ * transition events like the power manager does.
+ * @param em: the energy mode.
+ */
+void host_power_enter(sl_power_manager_em_t em);
+
+/**
+ * @brief Print the log lines of the firmware to stderr.
+ * @param enable: true to print, they are dropped by default.
+ */
+void host_log_enable(bool enable);
+
+// models used by host_hw_service() and host_hw_advance()
+void host_hw_map_registers();
+bool host_letimer_service();
+bool host_i2c_service();
+bool host_adc_service();
+bool host_ldma_service();
+bool host_gpio_service();
+
+#endif // __HOST_FAKES_H__
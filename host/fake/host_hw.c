@@ -0,0 +1,215 @@
+/**
+ * @file host_hw.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the simulated clock, the event engine and the
+ * register map of the host build. The register ranges are mapped before
+ * main() runs, and the host executables are linked without PIE so that
+ * the firmware's 32-bit casts of RAM addresses (e.g. the LDMA descriptors)
+ * hold.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "host_hw.h"
+#include "host_fakes.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE         (0x100000)
+#endif
+
+/**
+ * Register ranges of the EFR32BG13 mapped as plain memory
+ */
+static const struct {
+  uintptr_t base;
+  size_t size;
+}register_ranges[] = {
+  // peripherals, their bit-band alias and the bit set/clear aliases
+  { 0x40000000UL, 0x08000000UL },
+  // ITM, DWT, NVIC, SCB and CoreDebug
+  { 0xE0000000UL, 0x00100000UL },
+  // device information page
+  { 0x0FE08000UL, 0x00001000UL }
+};
+
+static uint64_t     now = 0;
+static host_event_t *event_list = NULL;
+
+
+/**
+ * @brief Map the register ranges, runs before main().
+ */
+__attribute__((constructor(101)))
+void host_hw_map_registers()
+{
+  size_t i;
+
+  for(i=0;i<(sizeof(register_ranges) / sizeof(register_ranges[0]));i++){
+      void *p = mmap((void *)register_ranges[i].base, register_ranges[i].size, \
+                     PROT_READ | PROT_WRITE, \
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, \
+                     -1, 0);
+
+      if(p != (void *)register_ranges[i].base){
+          fprintf(stderr, "host_hw: cannot map the registers at 0x%08lx\n", \
+                  (unsigned long)register_ranges[i].base);
+          exit(EXIT_FAILURE);
+      }
+  }
+}
+
+/**
+ * @brief Obtain the simulated time.
+ * @return the host tick count since the start, at HOST_CLOCK_HZ.
+ */
+uint64_t host_now()
+{
+  return now;
+}
+
+/**
+ * @brief Obtain the simulated time in ms.
+ * @return the ms since the start.
+ */
+uint64_t host_now_ms()
+{
+  return (now * 1000) / HOST_CLOCK_HZ;
+}
+
+/**
+ * @brief Convert a duration in us to host ticks, rounded up.
+ * @param us: the duration in us.
+ * @return the duration in host ticks.
+ */
+uint64_t host_us_to_ticks(uint64_t us)
+{
+  return ((us * HOST_CLOCK_HZ) + 999999) / 1000000;
+}
+
+/**
+ * @brief Schedule an event, or move it if it is already queued.
+ * @param ev: the event.
+ * @param at: the host tick count of the event, not before host_now().
+ * @param fire: called when the event is due.
+ * @param ctx: passed to fire.
+ */
+void host_event_schedule(host_event_t *ev, uint64_t at, \
+                         void (*fire)(void *ctx), void *ctx)
+{
+  host_event_t **pp = &event_list;
+
+  host_event_cancel(ev);
+
+  if(at < now)
+    at = now;
+  ev->at = at;
+  ev->fire = fire;
+  ev->ctx = ctx;
+
+  // events due at the same time fire in the order they were scheduled
+  while(*pp && ((*pp)->at <= at))
+    pp = &(*pp)->next;
+
+  ev->next = *pp;
+  *pp = ev;
+  ev->queued = true;
+}
+
+/**
+ * @brief Cancel an event. Cancelling an event that is not queued does
+ * nothing.
+ * @param ev: the event.
+ */
+void host_event_cancel(host_event_t *ev)
+{
+  host_event_t **pp = &event_list;
+
+  if(!ev->queued)
+    return;
+
+  while(*pp && (*pp != ev))
+    pp = &(*pp)->next;
+  if(*pp)
+    *pp = ev->next;
+
+  ev->next = NULL;
+  ev->queued = false;
+}
+
+/**
+ * @brief Obtain the time of the next event.
+ * @param at: set to the host tick count of the next event.
+ * @return false if no event is queued.
+ */
+bool host_event_next(uint64_t *at)
+{
+  if(!event_list)
+    return false;
+  *at = event_list->at;
+  return true;
+}
+
+/**
+ * @brief Take the pending interrupts of all fake peripherals until none
+ * is left. Called after every step of the firmware.
+ * @return the number of ISRs run.
+ */
+uint32_t host_hw_service()
+{
+  uint32_t isrs = 0;
+  bool taken;
+
+  // an ISR may raise another interrupt, e.g. COMP1 set by the UF handler
+  do{
+      taken = false;
+      if(host_letimer_service())
+        taken = true;
+      if(host_i2c_service())
+        taken = true;
+      if(host_adc_service())
+        taken = true;
+      if(host_ldma_service())
+        taken = true;
+      if(host_gpio_service())
+        taken = true;
+      if(taken)
+        isrs++;
+  }while(taken);
+
+  return isrs;
+}
+
+/**
+ * @brief Move the clock to the next event and fire it, or to the given
+ * time if no event is due before it. Pending interrupts are taken
+ * afterwards.
+ * @param until: the latest host tick count to move to.
+ * @return true if an event was fired.
+ */
+bool host_hw_advance(uint64_t until)
+{
+  host_event_t *ev = event_list;
+
+  if(!ev || (ev->at > until)){
+      if(until > now)
+        now = until;
+      return false;
+  }
+
+  event_list = ev->next;
+  ev->next = NULL;
+  ev->queued = false;
+  if(ev->at > now)
+    now = ev->at;
+
+  ev->fire(ev->ctx);
+  host_hw_service();
+  return true;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file host_hw.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains the simulated clock and the event
+ * engine shared by the fake peripherals of the host build.
+ *
+ * The firmware runs unmodified on the host. The peripheral and core
+ * register ranges of the EFR32BG13 are mapped as plain memory at their
+ * real addresses, so the inline emlib functions and the direct register
+ * accesses of the firmware work. The peripherals the firmware waits on are
+ * modelled by the fakes, which raise their interrupts from timed events.
+ *
+ * Interrupts never preempt the firmware: an interrupt that becomes pending
+ * while the firmware runs is taken by host_hw_service() once the current
+ * step (app_init(), one BT event, one ISR) has returned. Time only moves
+ * in host_hw_advance(), i.e. while the MCU would sleep.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __HOST_HW_H__
+#define __HOST_HW_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// the simulated clock, a multiple of the LFXO (32768 Hz) and the ULFRCO
+// (1000 Hz) so that both low-frequency clocks tick on whole host ticks
+#define HOST_CLOCK_HZ               (32768000ULL)
+
+// write access to a register the device header declares read-only, e.g.
+// the IF and STATUS registers set by the fake peripherals
+#define HOST_REG(reg)               (*(volatile uint32_t *)&(reg))
+
+/**
+ * A timed event of a fake peripheral
+ */
+typedef struct host_event {
+  struct host_event *next;
+  uint64_t at;                 // host tick count of the event
+  void (*fire)(void *ctx);     // called with the clock set to at
+  void *ctx;
+  bool queued;
+}host_event_t;
+
+
+/**
+ * @brief Obtain the simulated time.
+ * @return the host tick count since the start, at HOST_CLOCK_HZ.
+ */
+uint64_t host_now();
+
+/**
+ * @brief Obtain the simulated time in ms.
+ * @return the ms since the start.
+ */
+uint64_t host_now_ms();
+
+/**
+ * @brief Convert a duration in us to host ticks, rounded up.
+ * @param us: the duration in us.
+ * @return the duration in host ticks.
+ */
+uint64_t host_us_to_ticks(uint64_t us);
+
+/**
+ * @brief Schedule an event, or move it if it is already queued.
+ * @param ev: the event.
+ * @param at: the host tick count of the event, not before host_now().
+ * @param fire: called when the event is due.
+ * @param ctx: passed to fire.
+ */
+void host_event_schedule(host_event_t *ev, uint64_t at, \
+                         void (*fire)(void *ctx), void *ctx);
+
+/**
+ * @brief Cancel an event. Cancelling an event that is not queued does
+ * nothing.
+ * @param ev: the event.
+ */
+void host_event_cancel(host_event_t *ev);
+
+/**
+ * @brief Obtain the time of the next event.
+ * @param at: set to the host tick count of the next event.
+ * @return false if no event is queued.
+ */
+bool host_event_next(uint64_t *at);
+
+/**
+ * @brief Take the pending interrupts of all fake peripherals until none
+ * is left. Called after every step of the firmware.
+ * @return the number of ISRs run.
+ */
+uint32_t host_hw_service();
+
+/**
+ * @brief Move the clock to the next event and fire it, or to the given
+ * time if no event is due before it. Pending interrupts are taken
+ * afterwards.
+ * @param until: the latest host tick count to move to.
+ * @return true if an event was fired.
+ */
+bool host_hw_advance(uint64_t until);
+
+#endif // __HOST_HW_H__
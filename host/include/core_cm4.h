@@ -0,0 +1,81 @@
+/**
+ * @file core_cm4.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host build stand-in for the CMSIS Cortex-M4 core header. The
+ * Cortex-M instructions behind the CMSIS intrinsics do not assemble on the
+ * host, so cmsis_gcc.h is kept out and the intrinsics used by the core and
+ * emlib headers are defined as no-ops before the real header is included.
+ * The core registers (NVIC, SCB, DWT) are plain memory mapped by
+ * host_hw.c, the NVIC functions are replaced by those of host_nvic.h.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __HOST_CORE_CM4_H__
+#define __HOST_CORE_CM4_H__
+
+#include <stdint.h>
+
+// keep the Cortex-M intrinsics of cmsis_gcc.h out of the host build
+#define __CMSIS_GCC_H
+
+#define __ASM                    __asm
+#define __INLINE                 inline
+#define __STATIC_INLINE          static inline
+#define __STATIC_FORCEINLINE     __attribute__((always_inline)) static inline
+#define __NO_RETURN              __attribute__((__noreturn__))
+#define __USED                   __attribute__((used))
+#define __WEAK                   __attribute__((weak))
+#define __PACKED                 __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT          struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION           union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)             __attribute__((aligned(x)))
+#define __RESTRICT               __restrict
+#define __COMPILER_BARRIER()     __asm volatile("" ::: "memory")
+
+#define __UNALIGNED_UINT32(x)                (*(uint32_t *)(x))
+#define __UNALIGNED_UINT16_WRITE(addr, val)  (void)(*(uint16_t *)(void *)(addr) = (val))
+#define __UNALIGNED_UINT16_READ(addr)        (*(const uint16_t *)(const void *)(addr))
+#define __UNALIGNED_UINT32_WRITE(addr, val)  (void)(*(uint32_t *)(void *)(addr) = (val))
+#define __UNALIGNED_UINT32_READ(addr)        (*(const uint32_t *)(const void *)(addr))
+
+// interrupts only run between two steps of the simulation, so masking
+// them and the barriers have nothing to do
+__STATIC_FORCEINLINE void __enable_irq(void) {}
+__STATIC_FORCEINLINE void __disable_irq(void) {}
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void) { return 0; }
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t primask) { (void)primask; }
+__STATIC_FORCEINLINE uint32_t __get_BASEPRI(void) { return 0; }
+__STATIC_FORCEINLINE void __set_BASEPRI(uint32_t basepri) { (void)basepri; }
+__STATIC_FORCEINLINE void __NOP(void) {}
+__STATIC_FORCEINLINE void __WFI(void) {}
+__STATIC_FORCEINLINE void __WFE(void) {}
+__STATIC_FORCEINLINE void __SEV(void) {}
+__STATIC_FORCEINLINE void __ISB(void) { __COMPILER_BARRIER(); }
+__STATIC_FORCEINLINE void __DSB(void) { __COMPILER_BARRIER(); }
+__STATIC_FORCEINLINE void __DMB(void) { __COMPILER_BARRIER(); }
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value) { return __builtin_bswap32(value); }
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value) { return value ? (uint8_t)__builtin_clz(value) : 32U; }
+
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t value)
+{
+  uint32_t result = 0;
+  int i;
+
+  for(i=0;i<32;i++){
+      result = (result << 1) | (value & 1U);
+      value >>= 1;
+  }
+  return result;
+}
+
+// the NVIC set/clear register pairs need the functions of host_nvic.h
+#define CMSIS_NVIC_VIRTUAL
+#define CMSIS_NVIC_VIRTUAL_HEADER_FILE "host_nvic.h"
+
+#include_next <core_cm4.h>
+
+#endif // __HOST_CORE_CM4_H__
@@ -0,0 +1,131 @@
+/**
+ * @file em_adc.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host build stand-in for the emlib ADC header, which is not part of
+ * the SDK copy in this tree. It declares the subset of the ADC API used by
+ * adc.c and irq.c. The functions are implemented by fake_adc.c, which
+ * completes a single conversion HOST_ADC_CONVERSION_US after ADC_Start().
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __HOST_EM_ADC_H__
+#define __HOST_EM_ADC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+typedef enum {
+  adcOvsRateSel2 = 0,
+  adcOvsRateSel4,
+  adcOvsRateSel8,
+  adcOvsRateSel16,
+  adcOvsRateSel32,
+  adcOvsRateSel64,
+  adcOvsRateSel128,
+  adcOvsRateSel256,
+  adcOvsRateSel512,
+  adcOvsRateSel1024,
+  adcOvsRateSel2048,
+  adcOvsRateSel4096
+}ADC_OvsRateSel_TypeDef;
+
+typedef enum {
+  adcWarmupNormal = 0,
+  adcWarmupKeepScanRefWarm,
+  adcWarmupKeepADCWarm
+}ADC_Warmup_TypeDef;
+
+typedef enum {
+  adcEm2Disabled = 0,
+  adcEm2ClockOnDemand
+}ADC_EM2ClockConfig_TypeDef;
+
+typedef enum {
+  adcAcqTime1 = 0,
+  adcAcqTime2,
+  adcAcqTime4,
+  adcAcqTime8,
+  adcAcqTime16,
+  adcAcqTime32,
+  adcAcqTime64,
+  adcAcqTime128,
+  adcAcqTime256
+}ADC_AcqTime_TypeDef;
+
+typedef enum {
+  adcRef1V25 = 0,
+  adcRef2V5,
+  adcRefVDD,
+  adcRef5V
+}ADC_Ref_TypeDef;
+
+typedef enum {
+  adcRes12Bit = 0,
+  adcRes8Bit,
+  adcRes6Bit,
+  adcResOVS
+}ADC_Res_TypeDef;
+
+typedef enum {
+  adcPosSelAPORT3XCH10 = 0x6A,
+  adcPosSelAVDD = 0xE0
+}ADC_PosSel_TypeDef;
+
+typedef enum {
+  adcNegSelVSS = 0xFF
+}ADC_NegSel_TypeDef;
+
+typedef enum {
+  adcPRSSELCh0 = 0
+}ADC_PRSSEL_TypeDef;
+
+typedef struct {
+  ADC_OvsRateSel_TypeDef ovsRateSel;
+  ADC_Warmup_TypeDef warmUpMode;
+  uint8_t timebase;
+  uint8_t prescale;
+  bool tailgate;
+  ADC_EM2ClockConfig_TypeDef em2ClockConfig;
+}ADC_Init_TypeDef;
+
+#define ADC_INIT_DEFAULT                                \
+  {                                                     \
+    adcOvsRateSel2,                                     \
+    adcWarmupNormal,                                    \
+    0,                                                  \
+    0,                                                  \
+    false,                                              \
+    adcEm2Disabled                                      \
+  }
+
+typedef struct {
+  ADC_PRSSEL_TypeDef prsSel;
+  ADC_AcqTime_TypeDef acqTime;
+  ADC_Ref_TypeDef reference;
+  ADC_Res_TypeDef resolution;
+  ADC_PosSel_TypeDef posSel;
+  ADC_NegSel_TypeDef negSel;
+  bool diff;
+  bool prsEnable;
+  bool leftAdjust;
+  bool rep;
+  bool singleDmaEm2Wu;
+  bool fifoOverwrite;
+}ADC_InitSingle_TypeDef;
+
+void ADC_Init(ADC_TypeDef *adc, const ADC_Init_TypeDef *init);
+void ADC_InitSingle(ADC_TypeDef *adc, const ADC_InitSingle_TypeDef *init);
+uint8_t ADC_PrescaleCalc(uint32_t adcFreq, uint32_t hfperFreq);
+uint8_t ADC_TimebaseCalc(uint32_t hfperFreq);
+void ADC_Start(ADC_TypeDef *adc, uint32_t cmd);
+uint32_t ADC_DataSingleGet(ADC_TypeDef *adc);
+void ADC_IntEnable(ADC_TypeDef *adc, uint32_t flags);
+void ADC_IntClear(ADC_TypeDef *adc, uint32_t flags);
+uint32_t ADC_IntGetEnabled(ADC_TypeDef *adc);
+
+#endif // __HOST_EM_ADC_H__
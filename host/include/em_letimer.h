@@ -0,0 +1,30 @@
+/**
+ * @file em_letimer.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host build wrapper of the emlib LETIMER header. The inline
+ * LETIMER_IntClear() and LETIMER_IntSet() write the IFC and IFS registers,
+ * which are plain memory on the host and would not change IF. They are
+ * renamed before the real header is included and implemented by
+ * fake_letimer.c, which keeps IF up to date.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __HOST_EM_LETIMER_H__
+#define __HOST_EM_LETIMER_H__
+
+#define LETIMER_IntClear        host_inline_LETIMER_IntClear
+#define LETIMER_IntSet          host_inline_LETIMER_IntSet
+
+#include_next <em_letimer.h>
+
+#undef LETIMER_IntClear
+#undef LETIMER_IntSet
+
+void LETIMER_IntClear(LETIMER_TypeDef *letimer, uint32_t flags);
+void LETIMER_IntSet(LETIMER_TypeDef *letimer, uint32_t flags);
+
+#endif // __HOST_EM_LETIMER_H__
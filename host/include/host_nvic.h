@@ -0,0 +1,73 @@
+/**
+ * @file host_nvic.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host build NVIC functions, included by core_cm4.h through
+ * CMSIS_NVIC_VIRTUAL. The set and clear register pairs of the NVIC are
+ * plain memory on the host, so the enable and pending state of an
+ * interrupt is kept in its set register (ISER, ISPR) and the clear
+ * registers are never written.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __HOST_NVIC_H__
+#define __HOST_NVIC_H__
+
+#define NVIC_SetPriorityGrouping    __NVIC_SetPriorityGrouping
+#define NVIC_GetPriorityGrouping    __NVIC_GetPriorityGrouping
+#define NVIC_EnableIRQ              host_nvic_enable_irq
+#define NVIC_GetEnableIRQ           host_nvic_get_enable_irq
+#define NVIC_DisableIRQ             host_nvic_disable_irq
+#define NVIC_GetPendingIRQ          host_nvic_get_pending_irq
+#define NVIC_SetPendingIRQ          host_nvic_set_pending_irq
+#define NVIC_ClearPendingIRQ        host_nvic_clear_pending_irq
+#define NVIC_GetActive              __NVIC_GetActive
+#define NVIC_SetPriority            __NVIC_SetPriority
+#define NVIC_GetPriority            __NVIC_GetPriority
+#define NVIC_SystemReset            __NVIC_SystemReset
+
+#define HOST_NVIC_WORD(IRQn)        (((uint32_t)(IRQn)) >> 5UL)
+#define HOST_NVIC_BIT(IRQn)         (1UL << (((uint32_t)(IRQn)) & 0x1FUL))
+
+__STATIC_INLINE void host_nvic_enable_irq(IRQn_Type IRQn)
+{
+  if((int32_t)IRQn >= 0)
+    NVIC->ISER[HOST_NVIC_WORD(IRQn)] |= HOST_NVIC_BIT(IRQn);
+}
+
+__STATIC_INLINE void host_nvic_disable_irq(IRQn_Type IRQn)
+{
+  if((int32_t)IRQn >= 0)
+    NVIC->ISER[HOST_NVIC_WORD(IRQn)] &= ~HOST_NVIC_BIT(IRQn);
+}
+
+__STATIC_INLINE uint32_t host_nvic_get_enable_irq(IRQn_Type IRQn)
+{
+  if((int32_t)IRQn < 0)
+    return 0U;
+  return (NVIC->ISER[HOST_NVIC_WORD(IRQn)] & HOST_NVIC_BIT(IRQn)) ? 1U : 0U;
+}
+
+__STATIC_INLINE void host_nvic_set_pending_irq(IRQn_Type IRQn)
+{
+  if((int32_t)IRQn >= 0)
+    NVIC->ISPR[HOST_NVIC_WORD(IRQn)] |= HOST_NVIC_BIT(IRQn);
+}
+
+__STATIC_INLINE void host_nvic_clear_pending_irq(IRQn_Type IRQn)
+{
+  if((int32_t)IRQn >= 0)
+    NVIC->ISPR[HOST_NVIC_WORD(IRQn)] &= ~HOST_NVIC_BIT(IRQn);
+}
+
+__STATIC_INLINE uint32_t host_nvic_get_pending_irq(IRQn_Type IRQn)
+{
+  if((int32_t)IRQn < 0)
+    return 0U;
+  return (NVIC->ISPR[HOST_NVIC_WORD(IRQn)] & HOST_NVIC_BIT(IRQn)) ? 1U : 0U;
+}
+
+#endif // __HOST_NVIC_H__
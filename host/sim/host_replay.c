@@ -0,0 +1,310 @@
+/**
+ * @file host_replay.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the replayer of the event traces captured by
+ * src/trace.c. The level of PB0 is not captured, so every PB0 signal
+ * record toggles the button before it is replayed, the GPIO interrupt is
+ * taken on both edges.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "app.h"
+#include "em_gpio.h"
+#include "host_hw.h"
+#include "host_fakes.h"
+#include "fake_platform.h"
+#include "fake_bt.h"
+#include "host_replay.h"
+#include "src/gpio.h"
+#include "src/scheduler.h"
+#include "src/trace.h"
+
+// magic, version, reserved and length
+#define TRACE_FILE_HEADER_LEN       (8)
+// type and timestamp fields of a record
+#define TRACE_REC_PREFIX_LEN        (5)
+// the word following the prefix, the header or the signals
+#define TRACE_REC_WORD_LEN          (4)
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Read a whole file.
+// ---------------------------------------------------------------------
+static uint8_t *read_file(const char *path, size_t *size)
+{
+  FILE *f = fopen(path, "rb");
+  uint8_t *buf = NULL;
+  long end;
+
+  if(!f){
+      perror(path);
+      return NULL;
+  }
+
+  if((fseek(f, 0, SEEK_END) == 0) && ((end = ftell(f)) >= 0) && \
+     (fseek(f, 0, SEEK_SET) == 0)){
+      buf = malloc((size_t)end + 1);
+      if(buf && (fread(buf, 1, (size_t)end, f) == (size_t)end)){
+          *size = (size_t)end;
+      }
+      else{
+          free(buf);
+          buf = NULL;
+      }
+  }
+
+  if(!buf)
+    fprintf(stderr, "%s: cannot read the file\n", path);
+  fclose(f);
+  return buf;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Decode the hex digits of a VCOM dump in place, the line breaks between
+// them are skipped. Decoding stops at the first other character.
+// ---------------------------------------------------------------------
+static size_t decode_hex(uint8_t *buf, size_t size)
+{
+  size_t in = 0, out = 0;
+  char digits[3] = { 0 };
+  int n = 0;
+
+  for(in=0;in<size;in++){
+      if((buf[in] == '\r') || (buf[in] == '\n'))
+        continue;
+      if(!isxdigit(buf[in]))
+        break;
+
+      digits[n++] = (char)buf[in];
+      if(n == 2){
+          buf[out++] = (uint8_t)strtoul(digits, NULL, 16);
+          n = 0;
+      }
+  }
+  return out;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host tick count of the first LETIMER0 tick within a ms, the time from
+// which letimerMilliseconds() returns that ms.
+// ---------------------------------------------------------------------
+static uint64_t ms_to_ticks(uint32_t ms)
+{
+  uint64_t hz = host_cmu_letimer_hz();
+
+  return ((((uint64_t)ms * hz) + 999) / 1000) * (HOST_CLOCK_HZ / hz);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Let the firmware run and sleep until the given simulated time, or
+// until the fake peripherals have raised the given signals if they do
+// before it.
+// ---------------------------------------------------------------------
+static void run_until(uint64_t at, uint32_t signals, void (*sleep)(uint64_t until))
+{
+  uint32_t raised = 0;
+
+  for(;;){
+      app_process_action();
+      host_hw_service();
+      raised |= host_bt_take_replay_signals(signals);
+      if((host_now() >= at) || (signals && (raised == signals)))
+        break;
+      sleep(at);
+  }
+}
+
+/**
+ * @brief Load a trace file, either the binary file written by
+ * host_trace_save() or a VCOM capture holding the hex dump of
+ * trace_dump().
+ * @param path: the trace file.
+ * @param len: set to the length of the trace.
+ * @return the trace records to free() after use, NULL on error.
+ */
+uint8_t *host_trace_load(const char *path, uint32_t *len)
+{
+  size_t size = 0, start, body;
+  uint8_t *buf = read_file(path, &size);
+  char *magic;
+  uint32_t trace_len;
+
+  if(!buf)
+    return NULL;
+
+  // a VCOM capture has the log lines of the firmware around the dump,
+  // the magic comes before the first zero byte in both kinds of files
+  buf[size] = '\0';
+  magic = strstr((char *)buf, TRACE_MAGIC);
+  if(!magic){
+      fprintf(stderr, "%s: no %s header\n", path, TRACE_MAGIC);
+      free(buf);
+      return NULL;
+  }
+
+  start = (size_t)((uint8_t *)magic - buf) + strlen(TRACE_MAGIC);
+  if((start < size) && (buf[start] == TRACE_FORMAT_VERSION)){
+      body = size - start;
+  }
+  else{
+      body = decode_hex(&buf[start], size - start);
+  }
+  memmove(buf, &buf[start], body);
+
+  // the version, the reserved byte and the length follow the magic
+  if((body < (TRACE_FILE_HEADER_LEN - strlen(TRACE_MAGIC))) || \
+     (buf[0] != TRACE_FORMAT_VERSION)){
+      fprintf(stderr, "%s: not a version %d trace\n", path, TRACE_FORMAT_VERSION);
+      free(buf);
+      return NULL;
+  }
+
+  trace_len = (uint32_t)buf[2] | ((uint32_t)buf[3] << 8);
+  body -= TRACE_FILE_HEADER_LEN - strlen(TRACE_MAGIC);
+  if(body < trace_len){
+      fprintf(stderr, "%s: %u of %u trace bytes present\n", path, \
+              (unsigned int)body, trace_len);
+      trace_len = (uint32_t)body;
+  }
+
+  memmove(buf, &buf[TRACE_FILE_HEADER_LEN - strlen(TRACE_MAGIC)], trace_len);
+  *len = trace_len;
+  return buf;
+}
+
+/**
+ * @brief Save a trace as a binary file, the file header of trace_dump()
+ * followed by the records.
+ * @param path: the trace file.
+ * @param trace: the trace records.
+ * @param len: the length of the trace.
+ * @return true on success.
+ */
+bool host_trace_save(const char *path, const uint8_t *trace, uint32_t len)
+{
+  uint8_t header[TRACE_FILE_HEADER_LEN];
+  FILE *f = fopen(path, "wb");
+  bool ok;
+
+  if(!f){
+      perror(path);
+      return false;
+  }
+
+  memcpy(header, TRACE_MAGIC, strlen(TRACE_MAGIC));
+  header[4] = TRACE_FORMAT_VERSION;
+  header[5] = 0;
+  header[6] = (uint8_t)(len & 0xFF);
+  header[7] = (uint8_t)((len >> 8) & 0xFF);
+
+  ok = (fwrite(header, 1, sizeof(header), f) == sizeof(header)) && \
+       (fwrite(trace, 1, len, f) == len);
+  ok = (fclose(f) == 0) && ok;
+  if(!ok)
+    fprintf(stderr, "%s: cannot write the trace\n", path);
+  return ok;
+}
+
+/**
+ * @brief Boot the firmware and replay a trace at maximum speed.
+ * @param trace: the trace records.
+ * @param len: the length of the trace.
+ * @param dispatch: passes one event to sl_bt_on_event().
+ * @param sleep: lets the MCU sleep until the given host tick count at the
+ * latest, see host_hw_advance().
+ * @param stats: filled with the counters of the replay.
+ * @return false if the trace is corrupted, the records before the
+ * corruption have been replayed.
+ */
+bool host_trace_replay(const uint8_t *trace, uint32_t len, \
+                       void (*dispatch)(sl_bt_msg_t *evt), \
+                       void (*sleep)(uint64_t until), \
+                       host_replay_stats_t *stats)
+{
+  host_bt_event_t evt;
+  uint32_t offset = 0;
+  bool ok = true;
+
+  memset(stats, 0, sizeof(*stats));
+
+  host_bt_set_replay(true);
+  app_init();
+  host_hw_service();
+
+  while((offset + TRACE_REC_PREFIX_LEN + TRACE_REC_WORD_LEN) <= len){
+
+      uint8_t  type = trace[offset];
+      uint32_t timestamp, word, payload_len = 0;
+
+      memcpy(&timestamp, &trace[offset + 1], sizeof(timestamp));
+      memcpy(&word, &trace[offset + TRACE_REC_PREFIX_LEN], sizeof(word));
+      offset += TRACE_REC_PREFIX_LEN + TRACE_REC_WORD_LEN;
+
+      if(type == TRACE_REC_BT_EVT){
+          payload_len = SL_BT_MSG_LEN(word);
+          if((payload_len > HOST_BT_MAX_PAYLOAD) || ((offset + payload_len) > len)){
+              fprintf(stderr, "replay: truncated record at offset %u\n", offset);
+              ok = false;
+              break;
+          }
+          evt.msg.header = word;
+          memcpy(evt.msg.data.payload, &trace[offset], payload_len);
+      }
+      else if(type == TRACE_REC_SIGNAL){
+          evt.msg.header = sl_bt_evt_system_external_signal_id | \
+                           (sizeof(sl_bt_evt_system_external_signal_t) << 8);
+          evt.msg.data.evt_system_external_signal.extsignals = word;
+      }
+      else{
+          fprintf(stderr, "replay: unknown record type %d at offset %u\n", type, offset);
+          ok = false;
+          break;
+      }
+      offset += payload_len;
+
+      if(!stats->records)
+        stats->first_ms = timestamp;
+      stats->last_ms = timestamp;
+      stats->records++;
+
+      run_until(ms_to_ticks(timestamp), 0, sleep);
+
+      if(type == TRACE_REC_BT_EVT){
+          if(SL_BT_MSG_ID(word) == sl_bt_evt_system_external_signal_id){
+              stats->skipped++;
+              continue;
+          }
+          stats->bt_events++;
+      }
+      else{
+          if(word & evtGPIO_PB0){
+              host_gpio_button(EXTCOMIN_PB0_port, EXTCOMIN_PB0_pin, \
+                               GPIO_PinInGet(EXTCOMIN_PB0_port, EXTCOMIN_PB0_pin) != 0);
+          }
+          // the ms of the timestamp does not order the signals raised
+          // within it, wait for the fakes to raise this one as well
+          run_until(ms_to_ticks(timestamp + 1), word, sleep);
+          stats->signals++;
+      }
+
+      dispatch(&evt.msg);
+      host_hw_service();
+  }
+
+  // let the last records take effect
+  run_until(host_now(), 0, sleep);
+  host_bt_set_replay(false);
+  return ok;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file host_replay.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains the replayer of the event traces
+ * captured by src/trace.c, see the trace format in src/trace.h.
+ *
+ * The firmware is booted against the fakes and the records are fed back
+ * in order, with the simulated clock moved to the timestamp of every
+ * record first so that the timers and the fake peripherals see the timing
+ * of the capture. A signal record is held until the fake peripherals have
+ * raised the same signal, within the ms of its timestamp, which restores
+ * the order of the events that happened within one ms. A BT message record is passed to sl_bt_on_event() as
+ * it was captured. A signal record is passed as the external signal event
+ * carrying its bitmask, and the external signal events captured by
+ * sl_bt_on_event() are skipped since the signal records already hold
+ * them. Nothing else reaches sl_bt_on_event(): the fake stack drops the
+ * signals raised by the fake peripherals and the events it would answer
+ * the stack commands with, see host_bt_set_replay().
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __HOST_REPLAY_H__
+#define __HOST_REPLAY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_bt_api.h"
+
+/**
+ * Counters of a replay
+ */
+typedef struct {
+  uint32_t records;
+  uint32_t bt_events;          // BT message records passed to sl_bt_on_event()
+  uint32_t signals;            // signal records passed to sl_bt_on_event()
+  uint32_t skipped;            // captured external signal events
+  uint32_t first_ms;           // timestamps of the first and the last record
+  uint32_t last_ms;
+}host_replay_stats_t;
+
+
+/**
+ * @brief Load a trace file, either the binary file written by
+ * host_trace_save() or a VCOM capture holding the hex dump of
+ * trace_dump().
+ * @param path: the trace file.
+ * @param len: set to the length of the trace.
+ * @return the trace records to free() after use, NULL on error.
+ */
+uint8_t *host_trace_load(const char *path, uint32_t *len);
+
+/**
+ * @brief Save a trace as a binary file, the file header of trace_dump()
+ * followed by the records.
+ * @param path: the trace file.
+ * @param trace: the trace records.
+ * @param len: the length of the trace.
+ * @return true on success.
+ */
+bool host_trace_save(const char *path, const uint8_t *trace, uint32_t len);
+
+/**
+ * @brief Boot the firmware and replay a trace at maximum speed.
+ * @param trace: the trace records.
+ * @param len: the length of the trace.
+ * @param dispatch: passes one event to sl_bt_on_event().
+ * @param sleep: lets the MCU sleep until the given host tick count at the
+ * latest, see host_hw_advance().
+ * @param stats: filled with the counters of the replay.
+ * @return false if the trace is corrupted, the records before the
+ * corruption have been replayed.
+ */
+bool host_trace_replay(const uint8_t *trace, uint32_t len, \
+                       void (*dispatch)(sl_bt_msg_t *evt), \
+                       void (*sleep)(uint64_t until), \
+                       host_replay_stats_t *stats);
+
+#endif // __HOST_REPLAY_H__
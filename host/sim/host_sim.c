@@ -0,0 +1,372 @@
+/**
+ * @file host_sim.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the driver of the host simulation. It runs the
+ * unmodified firmware against the fake stack and peripherals through a
+ * scripted session: boot, connection, passkey confirmed with PB0, bonding,
+ * indications and notifications enabled, then measurement cycles until
+ * the end of the simulated time. The simulated clock only moves while the
+ * firmware sleeps, so a session of minutes runs in a fraction of a second.
+ *
+ * Reported on stdout:
+ * - BT events dispatched through sl_bt_on_event() per host second, and
+ *   the host time spent per event,
+ * - the latency of every measurement cycle in simulated ms, from the
+ *   measurement tick to the sample entering the sensor batch,
+ * - the measurement cycles completed per host second,
+ * - the share of simulated time spent in every energy mode.
+ *
+ * With -w the trace captured by src/trace.c during the session is saved,
+ * with -r a captured trace is replayed instead of the scripted session,
+ * see host_replay.h.
+ *
+ * The exit status is non-zero if the session did not bond or completed
+ * no measurement cycle, or if the replayed trace is corrupted, which is
+ * what the ctest entries check.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "app.h"
+#include "gatt_db.h"
+#include "sl_bluetooth.h"
+#include "host_hw.h"
+#include "host_fakes.h"
+#include "fake_bt.h"
+#include "host_replay.h"
+#include "src/gpio.h"
+#include "src/irq.h"
+#include "src/trace.h"
+
+// simulated length of the session by default, in seconds
+#define SIM_DEFAULT_SECONDS         (60)
+// connection handle used by the fake client
+#define SIM_CONNECTION              (1)
+#define SIM_PASSKEY                 (123456)
+#define SIM_MTU                     (247)
+
+/**
+ * One step of the scripted session
+ */
+typedef struct {
+  uint32_t at_ms;              // simulated time of the step
+  void (*run)();
+  host_event_t event;
+}sim_step_t;
+
+/**
+ * Measurements of the session
+ */
+typedef struct {
+  uint64_t events;
+  uint64_t event_ns;           // host time spent in sl_bt_on_event()
+  uint64_t event_ns_max;
+  uint64_t cycles;             // samples added to the sensor batch
+  uint64_t latency_ms;         // sum of the cycle latencies
+  uint32_t latency_ms_min;
+  uint32_t latency_ms_max;
+  uint64_t em_ticks[SL_POWER_MANAGER_EM3 + 1];
+}sim_metrics_t;
+
+static sim_metrics_t metrics = { .latency_ms_min = UINT32_MAX };
+
+bool app_is_ok_to_sleep(void);
+void __real_ble_batch_add_sample(uint32_t timestamp_ms);
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Host monotonic time in ns.
+// ---------------------------------------------------------------------
+static uint64_t host_ns()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief The sample of a completed measurement cycle enters the sensor
+ * batch, linked in with --wrap so that ble.c is unchanged.
+ * @param timestamp_ms: the start of the cycle in letimerMilliseconds().
+ */
+void __wrap_ble_batch_add_sample(uint32_t timestamp_ms)
+{
+  uint32_t latency = letimerMilliseconds() - timestamp_ms;
+
+  metrics.cycles++;
+  metrics.latency_ms += latency;
+  if(latency < metrics.latency_ms_min)
+    metrics.latency_ms_min = latency;
+  if(latency > metrics.latency_ms_max)
+    metrics.latency_ms_max = latency;
+
+  __real_ble_batch_add_sample(timestamp_ms);
+}
+
+static void step_connect()
+{
+  host_bt_push_connection_opened(SIM_CONNECTION);
+  host_bt_push_mtu_exchanged(SIM_CONNECTION, SIM_MTU);
+  host_bt_push_confirm_passkey(SIM_CONNECTION, SIM_PASSKEY);
+}
+
+static void step_press_pb0()
+{
+  host_gpio_button(EXTCOMIN_PB0_port, EXTCOMIN_PB0_pin, true);
+}
+
+static void step_release_pb0()
+{
+  host_gpio_button(EXTCOMIN_PB0_port, EXTCOMIN_PB0_pin, false);
+}
+
+static void step_subscribe()
+{
+  host_bt_push_client_config(SIM_CONNECTION, gattdb_temperature_measurement, \
+                             sl_bt_gatt_indication);
+  host_bt_push_client_config(SIM_CONNECTION, gattdb_light_measurement, \
+                             sl_bt_gatt_notification);
+  host_bt_push_client_config(SIM_CONNECTION, gattdb_sound_measurement, \
+                             sl_bt_gatt_notification);
+  host_bt_push_client_config(SIM_CONNECTION, gattdb_sensor_batch, \
+                             sl_bt_gatt_notification);
+}
+
+static sim_step_t steps[] = {
+  { .at_ms = 100, .run = step_connect },
+  { .at_ms = 300, .run = step_press_pb0 },
+  { .at_ms = 400, .run = step_release_pb0 },
+  { .at_ms = 500, .run = step_subscribe }
+};
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Run a scripted step.
+// ---------------------------------------------------------------------
+static void step_fire(void *ctx)
+{
+  sim_step_t *step = ctx;
+
+  step->run();
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Pass one BT event to the firmware and time it.
+// ---------------------------------------------------------------------
+static void dispatch(sl_bt_msg_t *evt)
+{
+  uint64_t start, spent;
+
+  start = host_ns();
+  sl_bt_on_event(evt);
+  spent = host_ns() - start;
+
+  metrics.events++;
+  metrics.event_ns += spent;
+  if(spent > metrics.event_ns_max)
+    metrics.event_ns_max = spent;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Pass the pending BT events to the firmware, like sl_bt_step().
+// ---------------------------------------------------------------------
+static void dispatch_events()
+{
+  host_bt_event_t evt;
+
+  while(host_bt_next_event(&evt)){
+      dispatch(&evt.msg);
+      host_hw_service();
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Sleep in the lowest energy mode allowed until the next event.
+// ---------------------------------------------------------------------
+static void sleep_until_event(uint64_t end)
+{
+  sl_power_manager_em_t em = SL_POWER_MANAGER_EM0;
+  uint64_t from = host_now();
+
+  if(app_is_ok_to_sleep())
+    em = host_power_lowest_em();
+
+  host_power_enter(em);
+  host_hw_advance(end);
+  metrics.em_ticks[em] += host_now() - from;
+  host_power_enter(SL_POWER_MANAGER_EM0);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Print the measurements of the session.
+// ---------------------------------------------------------------------
+static void print_metrics(double wall_s)
+{
+  host_stats_t hw;
+  host_bt_stats_t bt;
+  uint64_t sim_ticks = host_now();
+  int em;
+
+  host_get_stats(&hw);
+  host_bt_get_stats(&bt);
+
+  printf("simulated time          %.1f s in %.3f s host time\n", \
+         (double)sim_ticks / HOST_CLOCK_HZ, wall_s);
+  printf("BT events               %llu, %.0f per host second\n", \
+         (unsigned long long)metrics.events, metrics.events / wall_s);
+  printf("host time per event     mean %.2f us, max %.2f us\n", \
+         metrics.events ? (metrics.event_ns / 1000.0) / metrics.events : 0.0, \
+         metrics.event_ns_max / 1000.0);
+  printf("measurement cycles      %llu, %.0f per host second\n", \
+         (unsigned long long)metrics.cycles, metrics.cycles / wall_s);
+  if(metrics.cycles){
+      printf("cycle latency           min %u ms, mean %.1f ms, max %u ms\n", \
+             metrics.latency_ms_min, (double)metrics.latency_ms / metrics.cycles, \
+             metrics.latency_ms_max);
+  }
+  for(em=SL_POWER_MANAGER_EM0;em<=SL_POWER_MANAGER_EM3;em++){
+      printf("time in EM%d             %.2f %%\n", em, \
+             sim_ticks ? (100.0 * metrics.em_ticks[em]) / sim_ticks : 0.0);
+  }
+  printf("I2C transfers           %u queued, %u polled, %u NACKed, %u route changes\n", \
+         hw.i2c_transfers, hw.i2c_polled, hw.i2c_nacks, hw.i2cspm_inits);
+  printf("ADC conversions         %u\n", hw.adc_conversions);
+  printf("LCD SPI bytes           %u, %u by %u LDMA transfers\n", \
+         hw.spi_bytes, hw.spi_dma_bytes, hw.dma_transfers);
+  printf("GATT                    %u indications, %u notifications, %u bytes\n", \
+         bt.indications, bt.notifications, bt.gatt_bytes);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Run the scripted session until the given simulated time.
+// ---------------------------------------------------------------------
+static void run_session(uint64_t end)
+{
+  size_t i;
+
+  for(i=0;i<(sizeof(steps) / sizeof(steps[0]));i++){
+      host_event_schedule(&steps[i].event, \
+                          ((uint64_t)steps[i].at_ms * HOST_CLOCK_HZ) / 1000, \
+                          step_fire, &steps[i]);
+  }
+
+  app_init();
+  host_hw_service();
+  host_bt_push_boot();
+
+  while(host_now() < end){
+      dispatch_events();
+      app_process_action();
+      host_hw_service();
+
+      if(host_bt_event_pending())
+        continue;
+
+      sleep_until_event(end);
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Replay a trace file.
+// ---------------------------------------------------------------------
+static bool run_replay(const char *path)
+{
+  host_replay_stats_t replay;
+  uint8_t *trace;
+  uint32_t len;
+  bool ok;
+
+  trace = host_trace_load(path, &len);
+  if(!trace)
+    return false;
+
+  ok = host_trace_replay(trace, len, dispatch, sleep_until_event, &replay);
+  free(trace);
+
+  printf("replayed records        %u, %u BT events, %u signals, %u signal events skipped\n", \
+         replay.records, replay.bt_events, replay.signals, replay.skipped);
+  printf("trace span              %u ms to %u ms\n", replay.first_ms, replay.last_ms);
+  return ok && (replay.records > 0);
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr, "usage: %s [-s seconds] [-w trace] [-r trace] [-v]\n" \
+                  "  -s  simulated length of the session, default %d s\n" \
+                  "  -w  save the trace captured during the session\n" \
+                  "  -r  replay a trace instead of the scripted session\n" \
+                  "  -v  print the firmware log to stderr\n", \
+          name, SIM_DEFAULT_SECONDS);
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t seconds = SIM_DEFAULT_SECONDS;
+  const char *save_path = NULL;
+  const char *replay_path = NULL;
+  uint64_t wall_start;
+  bool replay_ok = true;
+  int opt;
+
+  while((opt = getopt(argc, argv, "s:w:r:v")) != -1){
+      switch(opt){
+        case 's':
+          seconds = (uint32_t)strtoul(optarg, NULL, 0);
+          break;
+        case 'w':
+          save_path = optarg;
+          break;
+        case 'r':
+          replay_path = optarg;
+          break;
+        case 'v':
+          host_log_enable(true);
+          break;
+        default:
+          usage(argv[0]);
+          return EXIT_FAILURE;
+      }
+  }
+
+  wall_start = host_ns();
+
+  if(replay_path)
+    replay_ok = run_replay(replay_path);
+  else
+    run_session((uint64_t)seconds * HOST_CLOCK_HZ);
+
+  print_metrics((host_ns() - wall_start) / 1e9);
+
+  if(save_path){
+      uint32_t len;
+      const uint8_t *trace = trace_get_buffer(&len);
+
+      if(!host_trace_save(save_path, trace, len))
+        return EXIT_FAILURE;
+  }
+
+  if(!replay_ok){
+      fprintf(stderr, "host_sim: the trace could not be replayed\n");
+      return EXIT_FAILURE;
+  }
+  if(!host_bt_bonded() || (metrics.cycles == 0)){
+      fprintf(stderr, "host_sim: the session did not complete a measurement cycle\n");
+      return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file host_test.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the helpers shared by the host unit tests.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "host_test.h"
+#include "host_hw.h"
+#include "fake_bt.h"
+
+uint32_t host_test_failures = 0;
+
+
+/**
+ * @brief Run the fakes and pass the external signals raised by the
+ * firmware to a handler, until the done condition holds or the given
+ * simulated time is reached.
+ * @param until: the latest host tick count to run to.
+ * @param handle: called with the external signals of every wakeup.
+ * @param done: checked after every wakeup, may be NULL.
+ * @return true if the done condition holds.
+ */
+bool host_test_run(uint64_t until, void (*handle)(uint32_t extsignals), \
+                   bool (*done)())
+{
+  host_bt_event_t evt;
+
+  for(;;){
+      host_hw_service();
+      while(host_bt_next_event(&evt)){
+          if(SL_BT_MSG_ID(evt.msg.header) == sl_bt_evt_system_external_signal_id)
+            handle(evt.msg.data.evt_system_external_signal.extsignals);
+          host_hw_service();
+      }
+
+      if(done && done())
+        return true;
+      if(host_now() >= until)
+        return false;
+      host_hw_advance(until);
+  }
+}
+
+/**
+ * @brief Print the result of a test program.
+ * @param name: the name of the test.
+ * @return the exit status of the test program.
+ */
+int host_test_result(const char *name)
+{
+  if(host_test_failures){
+      printf("%s: %u checks failed\n", name, host_test_failures);
+      return EXIT_FAILURE;
+  }
+  printf("%s: passed\n", name);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file host_test.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains the helpers shared by the host unit
+ * tests. Every test is a program of its own, linked against the firmware
+ * and the fakes, that returns a non-zero exit status if a check failed.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __HOST_TEST_H__
+#define __HOST_TEST_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+extern uint32_t host_test_failures;
+
+/**
+ * Report a failed condition and carry on with the test
+ */
+#define CHECK(cond)                                                     \
+  do{                                                                   \
+    if(!(cond)){                                                        \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        host_test_failures++;                                           \
+    }                                                                   \
+  }while(0)
+
+/**
+ * @brief Run the fakes and pass the external signals raised by the
+ * firmware to a handler, until the done condition holds or the given
+ * simulated time is reached.
+ * @param until: the latest host tick count to run to.
+ * @param handle: called with the external signals of every wakeup.
+ * @param done: checked after every wakeup, may be NULL.
+ * @return true if the done condition holds.
+ */
+bool host_test_run(uint64_t until, void (*handle)(uint32_t extsignals), \
+                   bool (*done)());
+
+/**
+ * @brief Print the result of a test program.
+ * @param name: the name of the test.
+ * @return the exit status of the test program.
+ */
+int host_test_result(const char *name);
+
+#endif // __HOST_TEST_H__
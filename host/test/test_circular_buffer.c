@@ -0,0 +1,261 @@
+/**
+ * @file test_circular_buffer.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host unit test of the pending indication ring of
+ * circular_buffer.c: the entries come out in order, all QUEUE_DEPTH
+ * entries are used across the wrap of the free-running pointers, a newer
+ * value of a queued characteristic replaces it in place, also in a full
+ * ring, a removed entry is skipped, and a producer and a consumer thread
+ * running at the same time never see a torn, lost or stale entry.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include "host_test.h"
+#include "circular_buffer.h"
+
+#define TEST_CONNECTION             (1)
+// characteristics of the concurrent test, the ring holds one entry each
+#define THREAD_CHARACTERISTICS      (4)
+// values written per characteristic by the producer thread
+#define THREAD_VALUES               (200000)
+// values after which the producer lets the consumer run, on a single CPU
+// the threads only interleave when one of them is preempted
+#define THREAD_YIELD_VALUES         (64)
+
+/**
+ * An entry as read back from the ring
+ */
+typedef struct {
+  uint8_t connection;
+  uint16_t characteristic;
+  size_t value_len;
+  uint8_t value[MAX_INDICATION_VALUE_LEN];
+}entry_t;
+
+static volatile bool producer_done = false;
+// writes refused while the producer thread runs, read after the join
+static uint32_t producer_errors = 0;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Queue a 4-byte little-endian value of the characteristic.
+// Returns false if successful, like write_queue().
+// ---------------------------------------------------------------------
+static bool put(uint16_t characteristic, uint32_t value)
+{
+  uint8_t bytes[4];
+
+  bytes[0] = (uint8_t)value;
+  bytes[1] = (uint8_t)(value >> 8);
+  bytes[2] = (uint8_t)(value >> 16);
+  bytes[3] = (uint8_t)(value >> 24);
+  return write_queue(TEST_CONNECTION, characteristic, sizeof(bytes), bytes);
+}
+
+static uint32_t value_of(const entry_t *entry)
+{
+  return (uint32_t)entry->value[0] | ((uint32_t)entry->value[1] << 8) | \
+         ((uint32_t)entry->value[2] << 16) | ((uint32_t)entry->value[3] << 24);
+}
+
+static bool get(entry_t *entry)
+{
+  memset(entry, 0, sizeof(*entry));
+  return read_queue(&entry->connection, &entry->characteristic, \
+                    &entry->value_len, &entry->value[0]);
+}
+
+static void test_order_and_wrap()
+{
+  entry_t entry;
+  uint32_t round, i;
+  bool full, empty;
+
+  clear_queue();
+  CHECK(get(&entry));
+
+  // the pointers run past QUEUE_DEPTH several times
+  for(round=0;round<5;round++){
+      for(i=0;i<QUEUE_DEPTH;i++){
+          CHECK(!put((uint16_t)(i + 1), (round << 16) | i));
+      }
+      // all the entries are used, a new characteristic does not fit
+      get_queue_status(NULL, NULL, &full, &empty);
+      CHECK(full && !empty);
+      CHECK(get_queue_depth() == QUEUE_DEPTH);
+      CHECK(put(QUEUE_DEPTH + 1, 0));
+
+      for(i=0;i<QUEUE_DEPTH;i++){
+          CHECK(!get(&entry));
+          CHECK(entry.connection == TEST_CONNECTION);
+          CHECK(entry.characteristic == (i + 1));
+          CHECK(entry.value_len == 4);
+          CHECK(value_of(&entry) == ((round << 16) | i));
+      }
+      CHECK(get(&entry));
+      get_queue_status(NULL, NULL, &full, &empty);
+      CHECK(!full && empty);
+  }
+
+  // an entry too long for the compact layout is refused
+  {
+    uint8_t big[MAX_INDICATION_VALUE_LEN + 1] = { 0 };
+    CHECK(write_queue(TEST_CONNECTION, 1, sizeof(big), big));
+    CHECK(write_queue(TEST_CONNECTION, 1, 1, NULL));
+    CHECK(get_queue_depth() == 0);
+  }
+}
+
+static void test_coalescing()
+{
+  entry_t entry;
+  uint32_t i;
+
+  clear_queue();
+
+  // latest value wins and keeps the position of the first one
+  CHECK(!put(21, 1));
+  CHECK(!put(32, 2));
+  CHECK(!put(21, 3));
+  CHECK(!put(45, 4));
+  CHECK(!put(21, 5));
+  CHECK(get_queue_depth() == 3);
+
+  CHECK(!get(&entry) && (entry.characteristic == 21) && (value_of(&entry) == 5));
+  CHECK(!get(&entry) && (entry.characteristic == 32) && (value_of(&entry) == 2));
+
+  // once taken, a new value is queued behind the others
+  CHECK(!put(21, 6));
+  CHECK(!get(&entry) && (entry.characteristic == 45) && (value_of(&entry) == 4));
+  CHECK(!get(&entry) && (entry.characteristic == 21) && (value_of(&entry) == 6));
+  CHECK(get(&entry));
+
+  // a full ring still takes a newer value of a queued characteristic
+  for(i=0;i<QUEUE_DEPTH;i++){
+      CHECK(!put((uint16_t)(i + 1), i));
+  }
+  CHECK(!put(QUEUE_DEPTH, 1000));
+  CHECK(!put(1, 1001));
+  CHECK(get_queue_depth() == QUEUE_DEPTH);
+  CHECK(!get(&entry) && (entry.characteristic == 1) && (value_of(&entry) == 1001));
+  for(i=1;i<QUEUE_DEPTH;i++){
+      CHECK(!get(&entry) && (entry.characteristic == (i + 1)));
+  }
+  CHECK(value_of(&entry) == 1000);
+  CHECK(get(&entry));
+}
+
+static void test_remove()
+{
+  entry_t entry;
+
+  clear_queue();
+  CHECK(!put(21, 1));
+  CHECK(!put(32, 2));
+  CHECK(!put(37, 3));
+  CHECK(!put(45, 4));
+
+  // the head, one in the middle and the tail
+  remove_queue_by_characteristic(21);
+  remove_queue_by_characteristic(37);
+  remove_queue_by_characteristic(45);
+  // not queued, nothing happens
+  remove_queue_by_characteristic(50);
+
+  CHECK(!get(&entry) && (entry.characteristic == 32) && (value_of(&entry) == 2));
+  CHECK(get(&entry));
+  CHECK(get_queue_depth() == 0);
+
+  // a removed characteristic is queued again as a new entry
+  CHECK(!put(37, 5));
+  CHECK(!get(&entry) && (entry.characteristic == 37) && (value_of(&entry) == 5));
+  CHECK(get(&entry));
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Producer thread, the ISR side: every characteristic gets increasing
+// values, so a torn or stale entry reads back out of order.
+// ---------------------------------------------------------------------
+static void *producer(void *arg)
+{
+  uint32_t i, c;
+
+  (void)arg;
+  for(i=1;i<=THREAD_VALUES;i++){
+      for(c=0;c<THREAD_CHARACTERISTICS;c++){
+          // at most one entry per characteristic, the ring never fills
+          if(put((uint16_t)(c + 1), i)){
+              producer_errors++;
+          }
+      }
+      if((i % THREAD_YIELD_VALUES) == 0)
+        sched_yield();
+  }
+  __atomic_store_n(&producer_done, true, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static void test_threads()
+{
+  uint32_t last[THREAD_CHARACTERISTICS] = { 0 };
+  uint32_t reads = 0, stale = 0, torn = 0;
+  pthread_t thread;
+  entry_t entry;
+  uint32_t c, value;
+  bool done;
+
+  clear_queue();
+  producer_done = false;
+  producer_errors = 0;
+  CHECK(pthread_create(&thread, NULL, producer, NULL) == 0);
+
+  do{
+      done = __atomic_load_n(&producer_done, __ATOMIC_ACQUIRE);
+      while(!get(&entry)){
+          c = entry.characteristic - 1;
+          if((c >= THREAD_CHARACTERISTICS) || (entry.value_len != 4)){
+              torn++;
+              continue;
+          }
+          value = value_of(&entry);
+          if(value > THREAD_VALUES)
+            torn++;
+          // a characteristic only ever moves forward
+          if(value <= last[c])
+            stale++;
+          last[c] = value;
+          reads++;
+      }
+  }while(!done);
+
+  CHECK(pthread_join(thread, NULL) == 0);
+  printf("%u entries read of %u written, the rest coalesced\n", \
+         reads, THREAD_VALUES * THREAD_CHARACTERISTICS);
+  CHECK(producer_errors == 0);
+  CHECK(torn == 0);
+  CHECK(stale == 0);
+  // the latest value of every characteristic is delivered
+  for(c=0;c<THREAD_CHARACTERISTICS;c++){
+      CHECK(last[c] == THREAD_VALUES);
+  }
+  CHECK(get_queue_depth() == 0);
+}
+
+int main()
+{
+  test_order_and_wrap();
+  test_coalescing();
+  test_remove();
+  test_threads();
+
+  return host_test_result("test_circular_buffer");
+}
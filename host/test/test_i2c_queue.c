@@ -0,0 +1,305 @@
+/**
+ * @file test_i2c_queue.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host unit test of the I2C0 job queue against the fake
+ * I2C_TransferInit()/I2C_Transfer() of fake_i2c.c: the jobs complete in
+ * submission order, I2CSPM_Init() only runs on a route change, NACKed
+ * jobs are retried after a doubling backoff and reported once the
+ * retries are used up or the backoff timer cannot be started, and a full
+ * queue refuses jobs.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "em_gpio.h"
+#include "sl_sleeptimer.h"
+#include "host_test.h"
+#include "host_hw.h"
+#include "host_fakes.h"
+#include "i2c_queue.h"
+
+#define SI7021_ADDR                 (0x40)
+#define ISL29125_ADDR               (0x44)
+#define ISL29125_DEVICE_ID          (0x7D)
+
+// the routes as logged by the fake, SCL port * 16 + SCL pin
+#define LOG_ROUTE_SI7021            ((gpioPortC * 16) + 10)
+#define LOG_ROUTE_ISL29125          ((gpioPortD * 16) + 10)
+
+// simulated time given to a test to drain the queue
+#define RUN_LIMIT_MS                (1000)
+// more timers than the fake sleeptimer runs at the same time
+#define MAX_FILLER_TIMERS           (32)
+
+/**
+ * Result of one job as seen by its callback
+ */
+typedef struct {
+  uint32_t calls;
+  uint32_t order;              // completions before this one
+  I2C_TransferReturn_TypeDef status;
+  uint8_t data[2];
+  uint8_t reg;
+}job_result_t;
+
+static uint32_t completions = 0;
+
+
+static void job_done(I2C_TransferReturn_TypeDef status, void *ctx)
+{
+  job_result_t *result = ctx;
+
+  result->calls++;
+  result->order = completions++;
+  result->status = status;
+}
+
+static void handle(uint32_t extsignals)
+{
+  i2c_queue_process(extsignals);
+}
+
+static bool run_until_idle()
+{
+  return host_test_run(host_now() + host_us_to_ticks(RUN_LIMIT_MS * 1000ULL), \
+                       handle, i2c_queue_is_idle);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// A 2-byte read of the Si7021 or a register read of the ISL29125.
+// ---------------------------------------------------------------------
+static i2c_job_t make_job(i2c_route_t route, job_result_t *result)
+{
+  i2c_job_t job;
+
+  memset(result, 0, sizeof(*result));
+  memset(&job, 0, sizeof(job));
+
+  job.route = route;
+  job.callback = job_done;
+  job.ctx = result;
+
+  if(route == I2C_ROUTE_SI7021){
+      job.addr = SI7021_ADDR;
+      job.flags = I2C_FLAG_READ;
+      job.read_data = result->data;
+      job.read_len = sizeof(result->data);
+  }
+  else{
+      job.addr = ISL29125_ADDR;
+      job.flags = I2C_FLAG_WRITE_READ;
+      job.write_data = &result->reg;
+      job.write_len = 1;
+      job.read_data = result->data;
+      job.read_len = 1;
+  }
+  return job;
+}
+
+static uint64_t ms_to_ticks(uint32_t ms)
+{
+  return host_us_to_ticks((uint64_t)ms * 1000);
+}
+
+static void test_route_batching()
+{
+  static const i2c_route_t routes[] = {
+      I2C_ROUTE_SI7021, I2C_ROUTE_SI7021, I2C_ROUTE_SI7021,
+      I2C_ROUTE_ISL29125, I2C_ROUTE_ISL29125, I2C_ROUTE_SI7021
+  };
+  enum { NUM_JOBS = sizeof(routes) / sizeof(routes[0]) };
+  job_result_t results[NUM_JOBS];
+  host_i2c_transfer_t log[NUM_JOBS + 1];
+  host_stats_t before, after;
+  uint32_t i, n;
+
+  host_get_stats(&before);
+  completions = 0;
+
+  for(i=0;i<NUM_JOBS;i++){
+      i2c_job_t job = make_job(routes[i], &results[i]);
+      CHECK(i2c_queue_submit(&job));
+  }
+  CHECK(run_until_idle());
+
+  for(i=0;i<NUM_JOBS;i++){
+      CHECK(results[i].calls == 1);
+      CHECK(results[i].order == i);
+      CHECK(results[i].status == i2cTransferDone);
+      if(routes[i] == I2C_ROUTE_SI7021)
+        CHECK((results[i].data[0] == 0x66) && (results[i].data[1] == 0x66));
+      else
+        CHECK(results[i].data[0] == ISL29125_DEVICE_ID);
+  }
+
+  // one I2CSPM_Init() per change of route, none within a batch
+  host_get_stats(&after);
+  CHECK((after.i2cspm_inits - before.i2cspm_inits) == 3);
+
+  n = host_i2c_take_log(log, NUM_JOBS + 1);
+  CHECK(n == NUM_JOBS);
+  for(i=0;i<n;i++){
+      CHECK(log[i].route == ((routes[i] == I2C_ROUTE_SI7021) ? \
+                             LOG_ROUTE_SI7021 : LOG_ROUTE_ISL29125));
+  }
+
+  // the bus is released once the queue has drained
+  CHECK(after.em_requirements[SL_POWER_MANAGER_EM1] == 0);
+}
+
+static void test_nack_retry()
+{
+  job_result_t result;
+  i2c_job_t job = make_job(I2C_ROUTE_SI7021, &result);
+  host_i2c_transfer_t log[I2C_JOB_MAX_RETRIES + 2];
+  host_stats_t before, after;
+  uint32_t n;
+
+  host_get_stats(&before);
+  host_i2c_nack_next(SI7021_ADDR, 2);
+
+  CHECK(i2c_queue_submit(&job));
+  CHECK(run_until_idle());
+
+  CHECK(result.calls == 1);
+  CHECK(result.status == i2cTransferDone);
+
+  n = host_i2c_take_log(log, I2C_JOB_MAX_RETRIES + 2);
+  CHECK(n == 3);
+  if(n == 3){
+      CHECK(log[0].status == i2cTransferNack);
+      CHECK(log[1].status == i2cTransferNack);
+      CHECK(log[2].status == i2cTransferDone);
+
+      // the backoff doubles and is bounded by one ms of slack
+      CHECK((log[1].start - log[0].start) >= ms_to_ticks(I2C_JOB_BACKOFF_MS));
+      CHECK((log[1].start - log[0].start) < ms_to_ticks(I2C_JOB_BACKOFF_MS + 1));
+      CHECK((log[2].start - log[1].start) >= ms_to_ticks(I2C_JOB_BACKOFF_MS * 2));
+      CHECK((log[2].start - log[1].start) < ms_to_ticks((I2C_JOB_BACKOFF_MS * 2) + 1));
+  }
+
+  // the retries stay on the route of the job
+  host_get_stats(&after);
+  CHECK(after.i2cspm_inits == before.i2cspm_inits);
+  CHECK(after.em_requirements[SL_POWER_MANAGER_EM1] == 0);
+}
+
+static void test_nack_give_up()
+{
+  job_result_t failed, next;
+  i2c_job_t job = make_job(I2C_ROUTE_SI7021, &failed);
+  host_i2c_transfer_t log[I2C_JOB_MAX_RETRIES + 2];
+  uint64_t backoff = ms_to_ticks(I2C_JOB_BACKOFF_MS);
+  uint32_t i, n;
+
+  host_i2c_nack_next(SI7021_ADDR, 100);
+
+  CHECK(i2c_queue_submit(&job));
+  CHECK(run_until_idle());
+
+  CHECK(failed.calls == 1);
+  CHECK(failed.status == i2cTransferNack);
+
+  n = host_i2c_take_log(log, I2C_JOB_MAX_RETRIES + 2);
+  CHECK(n == (I2C_JOB_MAX_RETRIES + 1));
+  for(i=1;i<n;i++){
+      CHECK(log[i].status == i2cTransferNack);
+      CHECK((log[i].start - log[i - 1].start) >= backoff);
+      CHECK((log[i].start - log[i - 1].start) < (backoff + ms_to_ticks(1)));
+      backoff *= 2;
+  }
+
+  // the queue carries on with the next job
+  host_i2c_nack_next(0, 0);
+  job = make_job(I2C_ROUTE_SI7021, &next);
+  CHECK(i2c_queue_submit(&job));
+  CHECK(run_until_idle());
+  CHECK((next.calls == 1) && (next.status == i2cTransferDone));
+  host_i2c_take_log(log, I2C_JOB_MAX_RETRIES + 2);
+}
+
+static void filler_expired(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+}
+
+static void test_backoff_timer_failure()
+{
+  static sl_sleeptimer_timer_handle_t fillers[MAX_FILLER_TIMERS];
+  job_result_t failed, next;
+  i2c_job_t job = make_job(I2C_ROUTE_SI7021, &failed);
+  host_i2c_transfer_t log[I2C_JOB_MAX_RETRIES + 2];
+  host_stats_t stats;
+  uint32_t i, n = 0;
+
+  // take every timer of the fake sleeptimer
+  while((n < MAX_FILLER_TIMERS) && \
+        (sl_sleeptimer_start_timer_ms(&fillers[n], RUN_LIMIT_MS * 10, \
+                                      filler_expired, NULL, 0, 0) == SL_STATUS_OK)){
+      n++;
+  }
+  CHECK(n < MAX_FILLER_TIMERS);
+
+  // the job fails at once instead of waiting for a backoff that never ends
+  host_i2c_nack_next(SI7021_ADDR, 100);
+  CHECK(i2c_queue_submit(&job));
+  CHECK(run_until_idle());
+  CHECK(failed.calls == 1);
+  CHECK(failed.status == i2cTransferNack);
+  CHECK(host_i2c_take_log(log, I2C_JOB_MAX_RETRIES + 2) == 1);
+  host_get_stats(&stats);
+  CHECK(stats.em_requirements[SL_POWER_MANAGER_EM1] == 0);
+
+  for(i=0;i<n;i++){
+      sl_sleeptimer_stop_timer(&fillers[i]);
+  }
+
+  // the queue carries on with the next job
+  host_i2c_nack_next(0, 0);
+  job = make_job(I2C_ROUTE_SI7021, &next);
+  CHECK(i2c_queue_submit(&job));
+  CHECK(run_until_idle());
+  CHECK((next.calls == 1) && (next.status == i2cTransferDone));
+  host_i2c_take_log(log, I2C_JOB_MAX_RETRIES + 2);
+}
+
+static void test_queue_full()
+{
+  job_result_t results[I2C_QUEUE_DEPTH];
+  uint32_t i, accepted = 0;
+
+  // one entry is left empty
+  for(i=0;i<I2C_QUEUE_DEPTH;i++){
+      i2c_job_t job = make_job(I2C_ROUTE_ISL29125, &results[i]);
+      if(i2c_queue_submit(&job))
+        accepted++;
+  }
+  CHECK(accepted == (I2C_QUEUE_DEPTH - 1));
+
+  CHECK(run_until_idle());
+  for(i=0;i<accepted;i++){
+      CHECK((results[i].calls == 1) && (results[i].status == i2cTransferDone));
+  }
+  CHECK(results[I2C_QUEUE_DEPTH - 1].calls == 0);
+}
+
+int main()
+{
+  host_i2c_transfer_t log[1];
+
+  host_i2c_take_log(log, 1);
+
+  test_route_batching();
+  test_nack_retry();
+  test_nack_give_up();
+  test_backoff_timer_failure();
+  test_queue_full();
+
+  return host_test_result("test_i2c_queue");
+}
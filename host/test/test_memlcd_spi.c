@@ -0,0 +1,263 @@
+/**
+ * @file test_memlcd_spi.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host unit test of the asynchronous LCD update against the fake
+ * LDMA of fake_usart_ldma.c: the dirty lines go out in one multi-line
+ * update in line order, with the frame buffer as it was when the flush
+ * started, evtDISPLAY_DONE is raised once the bytes have been clocked
+ * out, CS and the EM1 requirement are held until then, the synchronous
+ * draws are refused meanwhile, and the lines drawn during a transfer or
+ * sent by a failed one go out with the next flush.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "em_gpio.h"
+#include "dmd.h"
+#include "glib.h"
+#include "sl_memlcd.h"
+#include "sl_memlcd_display.h"
+#include "host_test.h"
+#include "host_hw.h"
+#include "host_fakes.h"
+#include "lcd.h"
+#include "scheduler.h"
+
+// command of a multi-line update, see sl_memlcd.c
+#define MEMLCD_CMD_UPDATE           (0x01)
+// pixel bytes of a line
+#define LINE_BYTES                  ((SL_MEMLCD_DISPLAY_WIDTH * SL_MEMLCD_DISPLAY_BPP) / 8)
+#define FRAME_BYTES                 (LINE_BYTES * SL_MEMLCD_DISPLAY_HEIGHT)
+// the address, the pixels and the dummy byte of every line
+#define UPDATE_BYTES(lines)         (2 + ((lines) * (LINE_BYTES + 2)))
+// lines of glyphs in a text row
+#define ROW_LINES                   (8)
+
+// simulated time given to a flush
+#define FLUSH_LIMIT_MS              (100)
+
+static uint8_t  capture[UPDATE_BYTES(SL_MEMLCD_DISPLAY_HEIGHT) + 16];
+static uint8_t  snapshot[FRAME_BYTES];
+static uint8_t  *framebuffer;
+static uint32_t flushes_done = 0;
+
+
+static void handle(uint32_t extsignals)
+{
+  if(extsignals & evtDISPLAY_DONE)
+    flushes_done++;
+}
+
+static bool is_flushed()
+{
+  return flushes_done > 0;
+}
+
+static void count_update(EMSTATUS status, void *ctx)
+{
+  (void)status;
+  (*(uint32_t *)ctx)++;
+}
+
+// GPIO_PinOutGet() reads the bit-band alias, which the fakes do not model
+static unsigned int cs_state()
+{
+  return (GPIO->P[SL_MEMLCD_SPI_CS_PORT].DOUT >> SL_MEMLCD_SPI_CS_PIN) & 1;
+}
+
+static uint32_t em1_held()
+{
+  host_stats_t stats;
+
+  host_get_stats(&stats);
+  return stats.em_requirements[SL_POWER_MANAGER_EM1];
+}
+
+static uint32_t dma_transfers()
+{
+  host_stats_t stats;
+
+  host_get_stats(&stats);
+  return stats.dma_transfers;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Start a flush with the frame buffer saved and the SPI bytes captured.
+// ---------------------------------------------------------------------
+static void start_flush()
+{
+  memcpy(snapshot, framebuffer, sizeof(snapshot));
+  host_spi_capture(capture, sizeof(capture));
+  flushes_done = 0;
+  displayFlush();
+}
+
+static bool wait_flush()
+{
+  return host_test_run(host_now() + host_us_to_ticks(FLUSH_LIMIT_MS * 1000ULL), \
+                       handle, is_flushed);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Check the layout of the captured update, see sl_memlcd_draw_async():
+// the command, then the address, the pixels and a dummy byte of every
+// line, then a dummy byte. The pixels must be those of the snapshot.
+// ---------------------------------------------------------------------
+static uint32_t check_update(uint8_t *lines)
+{
+  size_t len = host_spi_captured();
+  uint32_t n = 0;
+  size_t i = 1;
+  uint8_t line;
+
+  CHECK(len >= 2);
+  if(len < 2)
+    return 0;
+  CHECK(capture[0] == MEMLCD_CMD_UPDATE);
+
+  while((i + LINE_BYTES + 2) <= len){
+      line = capture[i] - 1;
+      CHECK(line < SL_MEMLCD_DISPLAY_HEIGHT);
+      if(line >= SL_MEMLCD_DISPLAY_HEIGHT)
+        return n;
+      // the lines go out in order
+      CHECK((n == 0) || (line > lines[n - 1]));
+      CHECK(memcmp(&capture[i + 1], &snapshot[line * LINE_BYTES], LINE_BYTES) == 0);
+      CHECK(capture[i + 1 + LINE_BYTES] == 0xff);
+      lines[n++] = line;
+      i += LINE_BYTES + 2;
+  }
+  CHECK(i == (len - 1));
+  CHECK(capture[len - 1] == 0xff);
+  return n;
+}
+
+static void test_order_and_completion()
+{
+  uint8_t lines[SL_MEMLCD_DISPLAY_HEIGHT];
+  uint8_t again[SL_MEMLCD_DISPLAY_HEIGHT];
+  uint32_t em1 = em1_held();
+  uint32_t transfers = dma_transfers();
+  uint64_t start, expected;
+  uint32_t n;
+
+  // drawn out of line order
+  displayPrintf(DISPLAY_ROW_11, "Row 11");
+  displayPrintf(DISPLAY_ROW_NAME, "Server");
+  displayPrintf(DISPLAY_ROW_CONNECTION, "Connected");
+
+  start = host_now();
+  start_flush();
+  // the lines have been copied, drawing goes on during the transfer
+  displayPrintf(DISPLAY_ROW_CONNECTION, "Disconnected");
+  host_hw_service();
+
+  CHECK(flushes_done == 0);
+  CHECK(cs_state() == 1);
+  CHECK(em1_held() == (em1 + 1));
+  CHECK(dma_transfers() == (transfers + 1));
+  // the synchronous draws are refused, the asynchronous one keeps running
+  CHECK(sl_memlcd_draw(sl_memlcd_get(), framebuffer, 0, 1) == SL_STATUS_BUSY);
+  CHECK(DMD_updateDisplay() == DMD_ERROR_MEMORY_ERROR);
+  CHECK(DMD_updateDisplayAsync(NULL, NULL) == DMD_ERROR_DRIVER_BUSY);
+
+  CHECK(wait_flush());
+  CHECK(flushes_done == 1);
+  CHECK(cs_state() == 0);
+  CHECK(em1_held() == em1);
+
+  n = check_update(lines);
+  CHECK(n == (3 * ROW_LINES));
+  CHECK(host_spi_captured() == UPDATE_BYTES(3 * ROW_LINES));
+  // evtDISPLAY_DONE comes once the last byte has been clocked out
+  expected = ((uint64_t)host_spi_captured() * 8 * HOST_CLOCK_HZ) / \
+             sl_memlcd_get()->spi_freq;
+  CHECK((host_now() - start) >= expected);
+
+  // the row drawn during the transfer is sent by the next flush
+  start_flush();
+  CHECK(wait_flush());
+  CHECK(check_update(again) == ROW_LINES);
+  // the connection row is the second of the three rows drawn
+  CHECK(memcmp(again, &lines[ROW_LINES], ROW_LINES) == 0);
+  CHECK(dma_transfers() == (transfers + 2));
+  CHECK(em1_held() == em1);
+}
+
+static void test_failed_transfer()
+{
+  uint8_t lines[SL_MEMLCD_DISPLAY_HEIGHT];
+  uint32_t em1 = em1_held();
+  size_t sent;
+
+  displayPrintf(DISPLAY_ROW_TEMPVALUE, "Temp=21");
+  host_ldma_fail_next();
+  start_flush();
+  CHECK(wait_flush());
+  CHECK(cs_state() == 0);
+  CHECK(em1_held() == em1);
+  sent = host_spi_captured();
+  CHECK(sent == UPDATE_BYTES(ROW_LINES));
+
+  // the lines of the failed transfer are sent again by the next flush
+  start_flush();
+  CHECK(wait_flush());
+  CHECK(check_update(lines) == ROW_LINES);
+  CHECK(host_spi_captured() == sent);
+  CHECK(em1_held() == em1);
+}
+
+static void test_descriptor_chain()
+{
+  uint8_t lines[SL_MEMLCD_DISPLAY_HEIGHT];
+  uint32_t transfers = dma_transfers();
+  GLIB_Context_t *glib;
+
+  // a full frame takes more than one LDMA descriptor
+  glib = displayBeginDraw(DISPLAY_ROW_NAME, DISPLAY_ROW_ASSIGNMENT);
+  glib->backgroundColor = Black;
+  CHECK(GLIB_clear(glib) == GLIB_OK);
+  glib->backgroundColor = White;
+  displayEndDraw();
+
+  start_flush();
+  CHECK(wait_flush());
+  CHECK(check_update(lines) == SL_MEMLCD_DISPLAY_HEIGHT);
+  CHECK(host_spi_captured() == UPDATE_BYTES(SL_MEMLCD_DISPLAY_HEIGHT));
+  CHECK(dma_transfers() == (transfers + 1));
+}
+
+static void test_nothing_dirty()
+{
+  uint32_t calls = 0;
+  uint32_t em1 = em1_held();
+
+  host_spi_capture(capture, sizeof(capture));
+  // the update completes at once without a transfer
+  CHECK(DMD_updateDisplayAsync(count_update, &calls) == DMD_OK);
+  CHECK(calls == 1);
+  CHECK(host_spi_captured() == 0);
+  CHECK(em1_held() == em1);
+  CHECK(cs_state() == 0);
+}
+
+int main()
+{
+  displayInit();
+  host_hw_service();
+  DMD_getFrameBuffer((void **)&framebuffer);
+
+  test_order_and_completion();
+  test_failed_transfer();
+  test_descriptor_chain();
+  test_nothing_dirty();
+
+  host_spi_capture(NULL, 0);
+  return host_test_result("test_memlcd_spi");
+}
@@ -0,0 +1,255 @@
+/**
+ * @file test_sampling.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host unit test of the adaptive sampling policy of sampling.c: the
+ * interval doubles after stable_count readings within the deadband, up to
+ * max_interval, a step change drops it back to one tick, a sensor is due
+ * once per interval, and a policy written over GATT is clamped, read back
+ * as applied and measures every sensor on the next tick.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "host_test.h"
+#include "fake_bt.h"
+#include "gatt_db.h"
+#include "sampling.h"
+#include "ble.h"
+
+#define TEST_CONNECTION             (1)
+
+// the defaults of sampling.c
+#define TEMP_DEADBAND               (200)
+#define TEMP_STABLE_COUNT           (5)
+#define TEMP_MAX_INTERVAL           (20)
+
+// a bedroom at 21 C, in 0.001 C
+#define TEMP_REFERENCE              (21000)
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Feed the same reading a number of times.
+// ---------------------------------------------------------------------
+static void feed(sampling_sensor_t sensor, int32_t value, uint32_t count)
+{
+  uint32_t i;
+
+  for(i=0;i<count;i++){
+      sampling_update(sensor, value);
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Write the policy characteristic from the fake client and let the
+// firmware handle the attribute value event.
+// ---------------------------------------------------------------------
+static void write_policies(const uint8_t *payload, size_t len)
+{
+  host_bt_event_t evt;
+
+  host_bt_push_attribute_value(TEST_CONNECTION, gattdb_sampling_policy, payload, len);
+  while(host_bt_next_event(&evt)){
+      handle_ble_event(&evt.msg);
+  }
+}
+
+static size_t read_policies(uint8_t *payload)
+{
+  size_t len = 0;
+
+  CHECK(sl_bt_gatt_server_read_attribute_value(gattdb_sampling_policy, 0, \
+                                               SAMPLING_POLICY_PAYLOAD_LEN, \
+                                               &len, payload) == SL_STATUS_OK);
+  return len;
+}
+
+static void test_doubling_and_cap()
+{
+  uint32_t expected = 1;
+
+  sampling_reset();
+  // the first reading is the reference
+  sampling_update(SAMPLING_TEMP, TEMP_REFERENCE);
+  CHECK(sampling_get_interval(SAMPLING_TEMP) == 1);
+
+  while(expected < TEMP_MAX_INTERVAL){
+      // one reading short of stable_count keeps the interval
+      feed(SAMPLING_TEMP, TEMP_REFERENCE + 100, TEMP_STABLE_COUNT - 1);
+      CHECK(sampling_get_interval(SAMPLING_TEMP) == expected);
+
+      // the edge of the deadband is still stable
+      sampling_update(SAMPLING_TEMP, TEMP_REFERENCE - TEMP_DEADBAND);
+      expected *= 2;
+      if(expected > TEMP_MAX_INTERVAL)
+        expected = TEMP_MAX_INTERVAL;
+      CHECK(sampling_get_interval(SAMPLING_TEMP) == expected);
+  }
+
+  // 1, 2, 4, 8, 16 then capped at 20
+  CHECK(expected == TEMP_MAX_INTERVAL);
+  feed(SAMPLING_TEMP, TEMP_REFERENCE, 4 * TEMP_STABLE_COUNT);
+  CHECK(sampling_get_interval(SAMPLING_TEMP) == TEMP_MAX_INTERVAL);
+
+  // the other sensors are not affected
+  CHECK(sampling_get_interval(SAMPLING_LIGHT) == 1);
+  CHECK(sampling_get_interval(SAMPLING_SOUND) == 1);
+}
+
+static void test_step_change()
+{
+  sampling_reset();
+  sampling_update(SAMPLING_LIGHT, 5);
+  feed(SAMPLING_LIGHT, 5, 3 * 5);
+  CHECK(sampling_get_interval(SAMPLING_LIGHT) == 8);
+
+  // the lights switch on
+  sampling_update(SAMPLING_LIGHT, 300);
+  CHECK(sampling_get_interval(SAMPLING_LIGHT) == 1);
+
+  // the step is the new reference
+  feed(SAMPLING_LIGHT, 305, 5);
+  CHECK(sampling_get_interval(SAMPLING_LIGHT) == 2);
+
+  // the reference stays at 300, a slow drift is a step once it is more
+  // than the deadband away from it
+  sampling_update(SAMPLING_LIGHT, 304);
+  sampling_update(SAMPLING_LIGHT, 308);
+  sampling_update(SAMPLING_LIGHT, 310);
+  CHECK(sampling_get_interval(SAMPLING_LIGHT) == 2);
+  sampling_update(SAMPLING_LIGHT, 311);
+  CHECK(sampling_get_interval(SAMPLING_LIGHT) == 1);
+
+  // a noise burst and a reset of the connection
+  sampling_update(SAMPLING_SOUND, 350);
+  feed(SAMPLING_SOUND, 350, 5);
+  CHECK(sampling_get_interval(SAMPLING_SOUND) == 2);
+  sampling_update(SAMPLING_SOUND, 700);
+  CHECK(sampling_get_interval(SAMPLING_SOUND) == 1);
+  feed(SAMPLING_SOUND, 700, 5);
+  sampling_reset();
+  CHECK(sampling_get_interval(SAMPLING_SOUND) == 1);
+}
+
+static void test_due_ticks()
+{
+  uint32_t due = 0;
+  uint32_t tick;
+
+  sampling_reset();
+  CHECK(sampling_tick(SAMPLING_TEMP));
+  sampling_update(SAMPLING_TEMP, TEMP_REFERENCE);
+
+  // measure on the ticks the sensor is due
+  for(tick=0;(tick < 100) && (sampling_get_interval(SAMPLING_TEMP) < 4);tick++){
+      if(sampling_tick(SAMPLING_TEMP))
+        sampling_update(SAMPLING_TEMP, TEMP_REFERENCE);
+  }
+  CHECK(sampling_get_interval(SAMPLING_TEMP) == 4);
+  // 5 ticks at an interval of 1, then 10 at an interval of 2
+  CHECK(tick == (TEMP_STABLE_COUNT + 2 * TEMP_STABLE_COUNT));
+
+  // due on every 4th tick from the doubling on
+  for(tick=1;tick<=40;tick++){
+      if(sampling_tick(SAMPLING_TEMP)){
+          CHECK((tick % 4) == 0);
+          due++;
+      }
+  }
+  CHECK(due == 10);
+}
+
+static void test_policy_payload()
+{
+  static const uint8_t clamped_in[SAMPLING_POLICY_PAYLOAD_LEN] = {
+      0x34, 0x12, 0, 0,          // stable_count and max_interval of 0
+      0xff, 0xff, 1, 255,        // max_interval above SAMPLING_MAX_INTERVAL
+      0x00, 0x00, 2, 3
+  };
+  static const uint8_t clamped_out[SAMPLING_POLICY_PAYLOAD_LEN] = {
+      0x34, 0x12, 1, 1,
+      0xff, 0xff, 1, SAMPLING_MAX_INTERVAL,
+      0x00, 0x00, 2, 3
+  };
+  uint8_t defaults[SAMPLING_POLICY_PAYLOAD_LEN];
+  uint8_t payload[SAMPLING_POLICY_PAYLOAD_LEN];
+
+  sampling_get_policies(defaults);
+  CHECK(defaults[0] == (TEMP_DEADBAND & 0xff));
+  CHECK(defaults[1] == (TEMP_DEADBAND >> 8));
+  CHECK(defaults[2] == TEMP_STABLE_COUNT);
+  CHECK(defaults[3] == TEMP_MAX_INTERVAL);
+
+  // a payload of the wrong length is refused
+  CHECK(!sampling_set_policies(clamped_in, sizeof(clamped_in) - 1));
+  sampling_get_policies(payload);
+  CHECK(memcmp(payload, defaults, sizeof(payload)) == 0);
+
+  CHECK(sampling_set_policies(clamped_in, sizeof(clamped_in)));
+  sampling_get_policies(payload);
+  CHECK(memcmp(payload, clamped_out, sizeof(payload)) == 0);
+
+  // a max_interval of 1 measures on every tick
+  sampling_update(SAMPLING_TEMP, TEMP_REFERENCE);
+  feed(SAMPLING_TEMP, TEMP_REFERENCE, 10);
+  CHECK(sampling_get_interval(SAMPLING_TEMP) == 1);
+
+  CHECK(sampling_set_policies(defaults, sizeof(defaults)));
+}
+
+static void test_policy_over_gatt()
+{
+  static const uint8_t written[SAMPLING_POLICY_PAYLOAD_LEN] = {
+      100, 0, 0, 200,
+      20, 0, 3, 0,
+      10, 0, 2, 8
+  };
+  static const uint8_t applied[SAMPLING_POLICY_PAYLOAD_LEN] = {
+      100, 0, 1, SAMPLING_MAX_INTERVAL,
+      20, 0, 3, 1,
+      10, 0, 2, 8
+  };
+  uint8_t defaults[SAMPLING_POLICY_PAYLOAD_LEN];
+  uint8_t payload[SAMPLING_POLICY_PAYLOAD_LEN];
+
+  sampling_get_policies(defaults);
+
+  // the sound sensor sleeps until the policy is written
+  sampling_reset();
+  sampling_update(SAMPLING_SOUND, 350);
+  feed(SAMPLING_SOUND, 350, 5);
+  CHECK(sampling_get_interval(SAMPLING_SOUND) == 2);
+
+  // the client reads back the clamped policies in effect
+  write_policies(written, sizeof(written));
+  CHECK(read_policies(payload) == SAMPLING_POLICY_PAYLOAD_LEN);
+  CHECK(memcmp(payload, applied, sizeof(payload)) == 0);
+  // and every sensor is measured on the next tick
+  CHECK(sampling_get_interval(SAMPLING_SOUND) == 1);
+  CHECK(sampling_tick(SAMPLING_SOUND));
+
+  // a write of the wrong length reads back as the policies in effect
+  write_policies(defaults, sizeof(defaults) - 2);
+  CHECK(read_policies(payload) == SAMPLING_POLICY_PAYLOAD_LEN);
+  CHECK(memcmp(payload, applied, sizeof(payload)) == 0);
+
+  write_policies(defaults, sizeof(defaults));
+  CHECK(read_policies(payload) == SAMPLING_POLICY_PAYLOAD_LEN);
+  CHECK(memcmp(payload, defaults, sizeof(payload)) == 0);
+}
+
+int main()
+{
+  test_doubling_and_cap();
+  test_step_change();
+  test_due_ticks();
+  test_policy_payload();
+  test_policy_over_gatt();
+
+  return host_test_result("test_sampling");
+}
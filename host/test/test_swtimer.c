@@ -0,0 +1,204 @@
+/**
+ * @file test_swtimer.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief Host unit test of the software timers on the fake LETIMER0:
+ * the timers expire in the order of their expiry, and in start order at
+ * the same tick, a periodic timer does not drift over 10000 periods, and
+ * a timer may stop itself or another timer from its callback.
+ * @version 0.1
+ * @date 2022-05-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "host_test.h"
+#include "host_hw.h"
+#include "app.h"
+#include "irq.h"
+#include "timers.h"
+#include "swtimer.h"
+
+#define MAX_TIMERS                  (8)
+// the periodic timer of the drift test, not a whole number of ticks
+#define DRIFT_PERIOD_MS             (3)
+#define DRIFT_PERIODS               (10000)
+
+/**
+ * Expiries seen by the callbacks
+ */
+typedef struct {
+  uint32_t order[MAX_TIMERS];
+  uint32_t tick[MAX_TIMERS];
+  uint32_t count;
+}expiry_log_t;
+
+static swtimer_t timers[MAX_TIMERS];
+static expiry_log_t expiries;
+
+// drift test
+static uint32_t drift_expiries = 0;
+static uint32_t drift_origin;
+static int32_t  drift_max = 0;
+static int32_t  drift_min = 0;
+static int32_t  drift_last = 0;
+
+// self-stop test
+static uint32_t self_stop_calls = 0;
+static uint32_t victim_calls = 0;
+
+
+static void handle(uint32_t extsignals)
+{
+  (void)extsignals;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// LETIMER0 tick count of a time after the origin, rounded like swtimer.c.
+// ---------------------------------------------------------------------
+static uint32_t ms_to_tick(uint32_t origin, uint64_t ms)
+{
+  return origin + (uint32_t)((ms * letimerTickFrequency()) / 1000);
+}
+
+static void run_ms(uint32_t ms)
+{
+  host_test_run(host_now() + host_us_to_ticks((uint64_t)ms * 1000), handle, NULL);
+}
+
+static void log_expiry(swtimer_t *timer, void *data)
+{
+  (void)timer;
+
+  if(expiries.count < MAX_TIMERS){
+      expiries.order[expiries.count] = (uint32_t)(uintptr_t)data;
+      expiries.tick[expiries.count] = letimerTicks();
+  }
+  expiries.count++;
+}
+
+static void test_ordering()
+{
+  // two timers at 10 ms, and one past the end of the LETIMER0 period
+  static const uint32_t timeout_ms[] = { 50, 10, 30, 10, 20, 9000 };
+  static const uint32_t expected[] = { 1, 3, 4, 2, 0, 5 };
+  enum { NUM = sizeof(timeout_ms) / sizeof(timeout_ms[0]) };
+  uint32_t origin[NUM];
+  uint32_t i, idx;
+
+  expiries.count = 0;
+  for(i=0;i<NUM;i++){
+      origin[i] = letimerTicks();
+      CHECK(swtimer_start(&timers[i], timeout_ms[i], 0, log_expiry, (void *)(uintptr_t)i));
+  }
+
+  // a stopped timer never expires, whether it is the head or not
+  CHECK(swtimer_start(&timers[6], 5, 0, log_expiry, (void *)6));
+  CHECK(swtimer_start(&timers[7], 25, 0, log_expiry, (void *)7));
+  swtimer_stop(&timers[6]);
+  swtimer_stop(&timers[7]);
+  CHECK(!swtimer_is_running(&timers[6]) && !swtimer_is_running(&timers[7]));
+
+  run_ms(10000);
+
+  CHECK(expiries.count == NUM);
+  for(i=0;(i<NUM) && (i<expiries.count);i++){
+      CHECK(expiries.order[i] == expected[i]);
+      idx = expiries.order[i];
+      if(idx < NUM){
+          // COMP1 fires on the expiry tick
+          CHECK((expiries.tick[i] - ms_to_tick(origin[idx], timeout_ms[idx])) <= 1);
+          CHECK(!swtimer_is_running(&timers[idx]));
+      }
+  }
+
+  // the bounds of the arguments
+  CHECK(!swtimer_start(&timers[0], SWTIMER_MAX_MS + 1, 0, log_expiry, NULL));
+  CHECK(!swtimer_start(&timers[0], 10, 0, NULL, NULL));
+  CHECK(!swtimer_is_running(&timers[0]));
+}
+
+static void drift_expiry(swtimer_t *timer, void *data)
+{
+  uint32_t expected;
+  int32_t diff;
+
+  (void)data;
+
+  drift_expiries++;
+  expected = ms_to_tick(drift_origin, (uint64_t)drift_expiries * DRIFT_PERIOD_MS);
+  diff = (int32_t)(letimerTicks() - expected);
+  if(diff > drift_max)
+    drift_max = diff;
+  if(diff < drift_min)
+    drift_min = diff;
+  drift_last = diff;
+
+  if(drift_expiries == DRIFT_PERIODS)
+    swtimer_stop(timer);
+}
+
+static bool drift_done()
+{
+  return drift_expiries >= DRIFT_PERIODS;
+}
+
+static void test_drift()
+{
+  drift_origin = letimerTicks();
+  CHECK(swtimer_start(&timers[0], DRIFT_PERIOD_MS, DRIFT_PERIOD_MS, drift_expiry, NULL));
+
+  CHECK(host_test_run(host_now() + host_us_to_ticks((DRIFT_PERIODS + 10ULL) * DRIFT_PERIOD_MS * 1000), \
+                      handle, drift_done));
+
+  // every expiry is on its own tick, the rounding does not add up
+  CHECK(drift_expiries == DRIFT_PERIODS);
+  CHECK(drift_min >= 0);
+  CHECK(drift_max <= 1);
+  CHECK(drift_last <= 1);
+  CHECK(!swtimer_is_running(&timers[0]));
+}
+
+static void victim_expiry(swtimer_t *timer, void *data)
+{
+  (void)timer;
+  (void)data;
+  victim_calls++;
+}
+
+static void self_stop_expiry(swtimer_t *timer, void *data)
+{
+  swtimer_t *victim = data;
+
+  self_stop_calls++;
+  // the other timer expires on the same tick, after this one
+  swtimer_stop(victim);
+  if(self_stop_calls == 5)
+    swtimer_stop(timer);
+}
+
+static void test_self_stop()
+{
+  CHECK(swtimer_start(&timers[0], 10, 10, self_stop_expiry, &timers[1]));
+  CHECK(swtimer_start(&timers[1], 10, 0, victim_expiry, NULL));
+
+  run_ms(1000);
+
+  CHECK(self_stop_calls == 5);
+  CHECK(victim_calls == 0);
+  CHECK(!swtimer_is_running(&timers[0]));
+  CHECK(!swtimer_is_running(&timers[1]));
+}
+
+int main()
+{
+  initLETIMER0(LETIMER_PERIOD_MS, 0, LOWEST_ENERGY_MODE);
+  run_ms(1);
+
+  test_ordering();
+  test_drift();
+  test_self_stop();
+
+  return host_test_result("test_swtimer");
+}
@@ -15,7 +15,7 @@
 #include "em_cmu.h"
 #include <math.h>
 
-#define INCLUDE_LOG_DEBUG 1
+#define LOG_LEVEL LOG_LEVEL_INFO
 #include "src/log.h"
 
 // Init to max ADC clock for Series 1
@@ -87,3 +87,20 @@ uint32_t ADCmVtodB(uint32_t volts_mv)
   uint32_t spl_db = volts_db - (-6);
   return spl_db;
 }
+
+/**
+ * @brief This function converts the voltage measured from the ADC to sound level
+ * in units of 0.1 dB.
+ * @param volts_mv: voltage in millivolts
+ * @return int : sound level in 0.1 dB
+ */
+uint32_t ADCmVtodBx10(uint32_t volts_mv)
+{
+  if(volts_mv == 0)
+    return 0;
+
+  int volts_ddb = (int)(200*log10(volts_mv));
+  //reducing the system sensitivity of -6 dB
+  uint32_t spl_ddb = volts_ddb - (-60);
+  return spl_ddb;
+}
@@ -25,5 +25,13 @@ void initADC0();
  */
 uint32_t ADCmVtodB(uint32_t volts_mv);
 
+/**
+ * @brief This function converts the voltage measured from the ADC to sound level
+ * in units of 0.1 dB.
+ * @param volts_mv: voltage in millivolts
+ * @return int : sound level in 0.1 dB
+ */
+uint32_t ADCmVtodBx10(uint32_t volts_mv);
+
 
 #endif /* SRC_ADC_H_ */
@@ -13,11 +13,14 @@
  *
  */
 
+#include <math.h>
+#include <string.h>
 #include "ble.h"
 #include "sl_bluetooth.h"
 #include "sl_status.h"
 #include "gatt_db.h"
 #include "lcd.h"
+#include "dashboard.h"
 #include "gpio.h"
 #include "scheduler.h"
 #include "ble_device_type.h"
@@ -25,14 +28,20 @@
 #include "scheduler.h"
 #include "adc.h"
 #include "app.h"
+#include "sampling.h"
+#include "irq.h"
 
 //for debugging only
-#define INCLUDE_LOG_DEBUG 1
+#define LOG_LEVEL LOG_LEVEL_INFO
 #include "src/log.h"
 
 
 //#define DEBUG_MODE
 
+// default ATT MTU and the ATT header length of an indication or notification
+#define ATT_MTU_DEFAULT               (23)
+#define ATT_VALUE_HEADER_LEN          (3)
+
 //BLE private data
 static conn_properties_t  ble_data = {
     .bonded = false,
@@ -42,6 +51,11 @@ static conn_properties_t  ble_data = {
     .sound_indicate_enabled = false,
     .light_indicate_enabled = false,
     .sleep_hours_enabled = false,
+    .batch_indicate_enabled = false,
+    .light_notify_enabled = false,
+    .sound_notify_enabled = false,
+    .batch_notify_enabled = false,
+    .mtu = ATT_MTU_DEFAULT,
     .myAddress = {},
     .addressType = 0,
     .connOn = 0,
@@ -72,9 +86,9 @@ static uint32_t optimal_sound_value = 0;
  */
 void LCD_display_optimal_values()
 {
-   displayPrintf(DISPLAY_ROW_TEMPVALUE, "Temp:%d C", optimal_temp_value);
-   displayPrintf(DISPLAY_ROW_8, " Light:%d lux", optimal_light_value);
-   displayPrintf(DISPLAY_ROW_9, "Sound:%d dB", optimal_sound_value);
+   dashboardSetValue(DASHBOARD_TEMP, (int32_t)optimal_temp_value);
+   dashboardSetValue(DASHBOARD_LIGHT, (int32_t)optimal_light_value);
+   dashboardSetValue(DASHBOARD_SOUND, (int32_t)optimal_sound_value);
 }
 
 
@@ -101,27 +115,81 @@ static void reset_bleDataInternals()
   ble_data.sleep_hours_enabled = false;
   //reset sound_indicate_enabled
   ble_data.sound_indicate_enabled = false;
+  //reset batch_indicate_enabled
+  ble_data.batch_indicate_enabled = false;
+  //reset the notification subscriptions
+  ble_data.light_notify_enabled = false;
+  ble_data.sound_notify_enabled = false;
+  ble_data.batch_notify_enabled = false;
+  //fall back to the default ATT MTU
+  ble_data.mtu = ATT_MTU_DEFAULT;
   //reset advertisingSetHandle
   ble_data.advertisingSetHandle = 0;
+  //drop the pending indications
+  clear_queue();
 }
 
 /**
- * Send the indication to the client if there is no ongoing indication.Otherwise
- * the indication will be enqueued.
+ * The latest measurement payloads, sent whenever the client is
+ * indicated on the measurement characteristics.
+ */
+static uint8_t temp_payload[TEMP_PAYLOAD_LEN];
+static uint8_t light_payload[LIGHT_PAYLOAD_LEN];
+static uint8_t sound_payload[SOUND_PAYLOAD_LEN];
+
+/**
+ * The latest measurements in their native units, sampled into
+ * the sensor batch at the end of every measurement cycle.
+ */
+static int32_t  latest_temp_mC = 0;
+static uint32_t latest_lux = 0;
+static uint32_t latest_sound_ddB = 0;
+
+/**
+ * The sensor batch: a sample count byte followed by batch_count samples.
+ * batch_pending is set when a flush had to wait for the confirmation of
+ * the indication in flight.
+ */
+static uint8_t  batch_payload[BATCH_PAYLOAD_LEN];
+static uint32_t batch_count = 0;
+static uint32_t batch_oldest_ms = 0;
+static bool     batch_pending = false;
+
+/**
+ * Sequence numbers of the notified characteristics. Each one restarts
+ * from 0 when the client subscribes and advances on every notification,
+ * including the ones the stack could not queue.
+ */
+static uint16_t light_seq = 0;
+static uint16_t sound_seq = 0;
+static uint16_t batch_seq = 0;
+// notification payload: the sequence number followed by the value
+static uint8_t  stream_payload[STREAM_SEQ_LEN + BATCH_PAYLOAD_LEN];
+
+// declare the batch flush function called in handle_pending_indications().
+static void batch_flush();
+
+/**
+ * Send the indication to the client if there is no ongoing indication. Otherwise
+ * the value is queued. A value already queued for the characteristic is
+ * replaced in place, so at most one indication per characteristic is pending
+ * and the client always receives the latest value.
  * @param bleDataPtr: the pointer of ble_data
  * @param characteristic_handle: the handle of the target characteristic
+ * @param value_len: the length of the characteristic value
+ * @param value: the characteristic value to send
  * @return: 1 if error otherwise 0.
  */
-static int send_indication(conn_properties_t *bleDataPtr, uint32_t characteristic_handle)
+static int send_indication(conn_properties_t *bleDataPtr, uint32_t characteristic_handle, \
+                           size_t value_len, uint8_t *value)
 {
   sl_status_t sc;
-  uint8_t sensor_indication_value = 1;
   if(!bleDataPtr->indication_inflight){
       sc = sl_bt_gatt_server_send_indication(
           ble_data.connectionHandle,
           characteristic_handle,
-          1,
-          (const uint8_t *)&sensor_indication_value);
+          value_len,
+          (const uint8_t *)value);
 
       if(sc != SL_STATUS_OK){
           //output the error message
@@ -134,35 +202,317 @@ static int send_indication(conn_properties_t *bleDataPtr, uint32_t characteristi
   }
   else{
       LOG_INFO("indication_inflight = 1 !\r\n");
-      //queue the indication so that it can be sent later
-     if(write_queue(ble_data.connectionHandle, characteristic_handle, \
-     1, (uint8_t *)&sensor_indication_value)){
-         LOG_ERROR("Failed to enqueue the indication\r\n");
-         return 1;
-     }
+      //queue the latest value so that it can be sent later
+      if(write_queue(ble_data.connectionHandle, characteristic_handle, \
+                     value_len, value)){
+          LOG_ERROR("Failed to enqueue the indication\r\n");
+          return 1;
+      }
   }
   return 0;
 }
 
 /**
- * Handle the pending indications stored in the circular buffer.
+ * Send the next pending indication. The characteristics are sent in the
+ * order they were first queued, and one that is queued again goes to the
+ * back, so no characteristic is starved.
  * @param bleDataPtr: the pointer of ble_data
  */
 static void handle_pending_indications(conn_properties_t *bleDataPtr)
 {
-    //retrieve the pending indication entity if any
-    if(get_queue_depth() > 0){
+    pending_indication_t pending_indicate;
 
-        pending_indication_t pending_indicate;
+    //retrieve the pending indication entity if any
+    while(!bleDataPtr->indication_inflight && \
+          !read_queue(&pending_indicate.connection, &pending_indicate.characteristic, \
+                      &pending_indicate.value_len, &pending_indicate.value[0])){
 
-        if(!read_queue(&pending_indicate.connection, &pending_indicate.characteristic, \
-                             &pending_indicate.value_len, &pending_indicate.value[0])){
+        send_indication(bleDataPtr, pending_indicate.characteristic, \
+                        pending_indicate.value_len, &pending_indicate.value[0]);
+    }
 
-            send_indication(bleDataPtr, pending_indicate.characteristic);
-        }
+    //send the sensor batch that waited for the confirmation
+    if(!bleDataPtr->indication_inflight && batch_pending){
+        batch_flush();
     }
 }
 
+/**
+ * Send the notification to the client. Notifications are not confirmed,
+ * so several of them can go out in one connection event. The value is
+ * prefixed with the sequence number of the characteristic.
+ * @param characteristic_handle: the handle of the target characteristic
+ * @param seq: the sequence number of the characteristic
+ * @param value_len: the length of the characteristic value
+ * @param value: the characteristic value to send
+ * @return: 1 if error otherwise 0.
+ */
+static int send_notification(uint32_t characteristic_handle, uint16_t *seq, \
+                             size_t value_len, uint8_t *value)
+{
+  sl_status_t sc;
+  uint8_t *p = &stream_payload[0];
+
+  UINT16_TO_BITSTREAM(p, *seq);
+  memcpy(p, value, value_len);
+  // a dropped notification still consumes its sequence number so that
+  // the client sees the gap
+  (*seq)++;
+
+  sc = sl_bt_gatt_server_send_notification(
+      ble_data.connectionHandle,
+      characteristic_handle,
+      STREAM_SEQ_LEN + value_len,
+      (const uint8_t *)&stream_payload[0]);
+
+  if(sc != SL_STATUS_OK){
+      LOG_WARN("Failed to send the notification, error code = 0x%x\r\n", sc);
+      return 1;
+  }
+  return 0;
+}
+
+/**
+ * Publish a new measurement to the client if the client has subscribed
+ * to the characteristic. Notifications take precedence over indications
+ * when the client has enabled both.
+ * @param indicate_enabled: the indication subscription flag
+ * @param notify_enabled: the notification subscription flag
+ * @param seq: the sequence number of the characteristic, NULL if the
+ * characteristic is never notified
+ * @param characteristic_handle: the handle of the target characteristic
+ * @param value_len: the length of the measurement payload
+ * @param value: the measurement payload
+ */
+static void publish_measurement(bool indicate_enabled, bool notify_enabled, uint16_t *seq, \
+                                uint32_t characteristic_handle, size_t value_len, uint8_t *value)
+{
+  if(!ble_data.connOn || !ble_data.bonded){
+      return;
+  }
+
+  if(notify_enabled && seq){
+      send_notification(characteristic_handle, seq, value_len, value);
+  }
+  else if(indicate_enabled){
+      if(send_indication(&ble_data, characteristic_handle, value_len, value)){
+          LOG_ERROR("Failed to indicate the measurement of characteristic %d\r\n", \
+                    characteristic_handle);
+      }
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Update the subscription flags of a streamed characteristic from the
+// client configuration and restart its sequence number.
+// ---------------------------------------------------------------------
+static void update_stream_config(uint16_t client_config_flags, bool *indicate_enabled, \
+                                 bool *notify_enabled, uint16_t *seq)
+{
+  *indicate_enabled = (client_config_flags & sl_bt_gatt_server_indication) != 0;
+  *notify_enabled = (client_config_flags & sl_bt_gatt_server_notification) != 0;
+  *seq = 0;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Store the sampling policies in effect in the GATT database, so a client
+// reads back the clamped values after a write.
+// ---------------------------------------------------------------------
+static void update_sampling_policy_attribute()
+{
+  uint8_t payload[SAMPLING_POLICY_PAYLOAD_LEN];
+  sl_status_t sc;
+
+  sampling_get_policies(&payload[0]);
+  sc = sl_bt_gatt_server_write_attribute_value(gattdb_sampling_policy, 0, \
+                                               sizeof(payload), &payload[0]);
+  if(sc != SL_STATUS_OK){
+      LOG_ERROR("Failed to write the sampling policy attribute, rc = 0x%x\r\n", sc);
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Number of samples that fit in one ATT payload with the negotiated MTU.
+// ---------------------------------------------------------------------
+static uint32_t batch_capacity()
+{
+  uint32_t header_len = ATT_VALUE_HEADER_LEN + 1;
+  uint32_t capacity;
+
+  if(ble_data.batch_notify_enabled)
+    header_len += STREAM_SEQ_LEN;
+
+  capacity = (ble_data.mtu - header_len) / BATCH_SAMPLE_LEN;
+
+  if(capacity > BATCH_MAX_SAMPLES)
+    capacity = BATCH_MAX_SAMPLES;
+  if(capacity == 0)
+    capacity = 1;
+  return capacity;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Send the accumulated samples in one ATT payload. An indicated flush is
+// deferred until the confirmation if an indication is in flight, since
+// the pending indication queue only holds short measurement payloads.
+// ---------------------------------------------------------------------
+static void batch_flush()
+{
+  if(!ble_data.connOn || !ble_data.bonded || (batch_count == 0) || \
+      !(ble_data.batch_indicate_enabled || ble_data.batch_notify_enabled)){
+      batch_pending = false;
+      return;
+  }
+
+  batch_payload[0] = (uint8_t)batch_count;
+
+  if(ble_data.batch_notify_enabled){
+      send_notification(gattdb_sensor_batch, &batch_seq, \
+                        1 + (batch_count * BATCH_SAMPLE_LEN), &batch_payload[0]);
+      batch_count = 0;
+      batch_pending = false;
+      return;
+  }
+
+  if(ble_data.indication_inflight){
+      batch_pending = true;
+      return;
+  }
+
+  if(send_indication(&ble_data, gattdb_sensor_batch, \
+                     1 + (batch_count * BATCH_SAMPLE_LEN), &batch_payload[0])){
+      LOG_ERROR("Failed to indicate the sensor batch of %u samples\r\n", batch_count);
+      return;
+  }
+
+  batch_count = 0;
+  batch_pending = false;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Flush a partial batch whose oldest sample is BATCH_FLUSH_AGE_MS old.
+// Checked on every measurement tick, since stretched sampling or skipped
+// cycles may add no sample for a long time.
+// ---------------------------------------------------------------------
+static void batch_flush_if_aged(uint32_t now_ms)
+{
+  if((batch_count > 0) && !batch_pending && \
+      ((now_ms - batch_oldest_ms) >= BATCH_FLUSH_AGE_MS)){
+      batch_flush();
+  }
+}
+
+/**
+ * @brief Add the latest temperature, light and sound measurements as one
+ * timestamped sample to the sensor batch. The batch is indicated to the
+ * client once it holds BATCH_FLUSH_COUNT samples, as many samples as fit
+ * in the negotiated ATT MTU, or its oldest sample is BATCH_FLUSH_AGE_MS
+ * old. The age is also checked on every measurement tick.
+ * @param timestamp_ms: the start time of the measurement cycle, in ms.
+ */
+void ble_batch_add_sample(uint32_t timestamp_ms)
+{
+  uint32_t capacity = batch_capacity();
+  uint32_t flush_count = (capacity < BATCH_FLUSH_COUNT) ? capacity : BATCH_FLUSH_COUNT;
+  uint32_t lux = (latest_lux > UINT16_MAX) ? UINT16_MAX : latest_lux;
+  uint32_t sound_ddB = (latest_sound_ddB > UINT16_MAX) ? UINT16_MAX : latest_sound_ddB;
+  uint8_t *p;
+
+  // samples are only kept for a subscribed client
+  if(!ble_data.connOn || !ble_data.bonded || \
+      !(ble_data.batch_indicate_enabled || ble_data.batch_notify_enabled)){
+      batch_count = 0;
+      batch_pending = false;
+      return;
+  }
+
+  if(batch_count >= capacity){
+      // the previous flush is still waiting, drop the oldest sample
+      LOG_WARN("Sensor batch full, dropping the oldest sample\r\n");
+      memmove(&batch_payload[1], &batch_payload[1 + BATCH_SAMPLE_LEN], \
+              (capacity - 1) * BATCH_SAMPLE_LEN);
+      batch_count = capacity - 1;
+      memcpy(&batch_oldest_ms, &batch_payload[1], sizeof(batch_oldest_ms));
+  }
+
+  if(batch_count == 0)
+    batch_oldest_ms = timestamp_ms;
+
+  p = &batch_payload[1 + (batch_count * BATCH_SAMPLE_LEN)];
+  INT32_TO_BITSTREAM(p, timestamp_ms);
+  INT32_TO_BITSTREAM(p, latest_temp_mC);
+  UINT16_TO_BITSTREAM(p, lux);
+  UINT16_TO_BITSTREAM(p, sound_ddB);
+  batch_count++;
+
+  if((batch_count >= flush_count) || \
+      ((timestamp_ms - batch_oldest_ms) >= BATCH_FLUSH_AGE_MS)){
+      batch_flush();
+  }
+}
+
+/**
+ * @brief Send the temperature measurement to the client. The value is
+ * packed as a Health Thermometer temperature measurement, i.e. a flags
+ * byte (Celsius, no timestamp) followed by an IEEE-11073 32-bit FLOAT.
+ * @param temp_mC: the temperature in units of 0.001 Celsius.
+ */
+void ble_send_temperature(int32_t temp_mC)
+{
+  uint8_t *p = &temp_payload[0];
+  uint32_t temperature_flt = UINT32_TO_FLOAT(temp_mC, -3);
+
+  latest_temp_mC = temp_mC;
+
+  UINT32_TO_BITSTREAM(p, temperature_flt);
+
+  publish_measurement(ble_data.temp_indicate_enabled, false, NULL, \
+                      gattdb_temperature_measurement, sizeof(temp_payload), &temp_payload[0]);
+}
+
+/**
+ * @brief Send the light measurement to the client as a little-endian
+ * uint16 in units of lux, saturated at 0xFFFF.
+ * @param lux: the light density in lux.
+ */
+void ble_send_light(uint32_t lux)
+{
+  uint8_t *p = &light_payload[0];
+
+  latest_lux = lux;
+  if(lux > UINT16_MAX)
+    lux = UINT16_MAX;
+
+  UINT16_TO_BITSTREAM(p, lux);
+
+  publish_measurement(ble_data.light_indicate_enabled, ble_data.light_notify_enabled, &light_seq, \
+                      gattdb_light_measurement, sizeof(light_payload), &light_payload[0]);
+}
+
+/**
+ * @brief Send the sound measurement to the client as a little-endian
+ * uint16 in units of 0.1 dB, saturated at 0xFFFF.
+ * @param sound_ddB: the sound level in units of 0.1 dB.
+ */
+void ble_send_sound(uint32_t sound_ddB)
+{
+  uint8_t *p = &sound_payload[0];
+
+  latest_sound_ddB = sound_ddB;
+  if(sound_ddB > UINT16_MAX)
+    sound_ddB = UINT16_MAX;
+
+  UINT16_TO_BITSTREAM(p, sound_ddB);
+
+  publish_measurement(ble_data.sound_indicate_enabled, ble_data.sound_notify_enabled, &sound_seq, \
+                      gattdb_sound_measurement, sizeof(sound_payload), &sound_payload[0]);
+}
+
 
 /**
  * @brief Bluetooth stack event handler. This overrides the dummy
@@ -208,6 +558,9 @@ void handle_ble_event(sl_bt_msg_t *evt)
       // Initialize the LCD display
       displayInit();
 
+      // Publish the default sampling policies
+      update_sampling_policy_attribute();
+
       // Extract unique Identity BT Address.
       sc = sl_bt_system_get_identity_address(&ble_data.myAddress, &ble_data.addressType);
       if(sc != SL_STATUS_OK){
@@ -287,6 +640,8 @@ void handle_ble_event(sl_bt_msg_t *evt)
       ble_data.indication_inflight = false;
       // update the connection handle
       ble_data.connectionHandle = evt->data.evt_connection_opened.connection;
+      // measure every sensor on the first ticks of the connection
+      sampling_reset();
 
       // set the connection timing parameters
       sc = sl_bt_connection_set_parameters(
@@ -307,6 +662,8 @@ void handle_ble_event(sl_bt_msg_t *evt)
     case sl_bt_evt_connection_closed_id:
 
       reset_bleDataInternals();
+      // abort the measurement cycle, its events are dropped while unpaired
+      sensor_pipeline_reset();
       // Delete all bondings
       sl_bt_sm_delete_bondings();
       // display advertising as the current connection state
@@ -327,14 +684,19 @@ void handle_ble_event(sl_bt_msg_t *evt)
     // handle external signal event
     case sl_bt_evt_system_external_signal_id:
 
-       if(evt->data.evt_system_external_signal.extsignals == evtGPIO_PB0) {
+       if(evt->data.evt_system_external_signal.extsignals & evtMEASURE_TICK) {
+           batch_flush_if_aged(letimerMilliseconds());
+       }
+
+       if(evt->data.evt_system_external_signal.extsignals & evtGPIO_PB0) {
            unsigned int pad_value = 1 - GPIO_PinInGet(EXTCOMIN_PB0_port, EXTCOMIN_PB0_pin);
 
+          // rows 7 to 10 belong to the dashboard
           if(pad_value){
-              displayPrintf(DISPLAY_ROW_9, "Button Pressed");
+              displayPrintf(DISPLAY_ROW_11, "Button Pressed");
           }
           else{
-              displayPrintf(DISPLAY_ROW_9, "Button Released");
+              displayPrintf(DISPLAY_ROW_11, "Button Released");
           }
           if(!ble_data.bonded){
               // accept or reject the reported passkey confirm value based on PB0 value
@@ -364,17 +726,24 @@ void handle_ble_event(sl_bt_msg_t *evt)
               break;
             }
             case gattdb_sound_measurement:{
-              ble_data.sound_indicate_enabled = true;
+              update_stream_config(evt->data.evt_gatt_server_characteristic_status.client_config_flags, \
+                                   &ble_data.sound_indicate_enabled, &ble_data.sound_notify_enabled, &sound_seq);
               break;
             }
             case gattdb_light_measurement:{
-              ble_data.light_indicate_enabled = true;
+              update_stream_config(evt->data.evt_gatt_server_characteristic_status.client_config_flags, \
+                                   &ble_data.light_indicate_enabled, &ble_data.light_notify_enabled, &light_seq);
               break;
             }
             case gattdb_sleep_hours:{
               ble_data.sleep_hours_enabled = true;
               break;
             }
+            case gattdb_sensor_batch:{
+              update_stream_config(evt->data.evt_gatt_server_characteristic_status.client_config_flags, \
+                                   &ble_data.batch_indicate_enabled, &ble_data.batch_notify_enabled, &batch_seq);
+              break;
+            }
             default:break;
         }
       }
@@ -402,14 +771,14 @@ void handle_ble_event(sl_bt_msg_t *evt)
             }
 
             if(value_len != sizeof(optimal_light_value)){
-                LOG_WARN("Warning: received light value length is not 4  but %d!\r\n",value_len);
+                LOG_WARN("Warning: received light value length is not 4  but %d!\r\n",(int)value_len);
             }
 
             LOG_INFO("optimal light value = %d\r\n",optimal_light_value);
 
-            //send the indication to the client
+            //acknowledge the update with the latest light measurement
             LOG_INFO("Send the indication for the light update\r\n");
-            if(send_indication(&ble_data, gattdb_light_measurement)){
+            if(send_indication(&ble_data, gattdb_light_measurement, sizeof(light_payload), &light_payload[0])){
                 LOG_ERROR("Failed to send the indication for the light characteristic\r\n");
             }
       }
@@ -430,14 +799,14 @@ void handle_ble_event(sl_bt_msg_t *evt)
             }
 
             if(value_len != sizeof(optimal_temp_value)){
-                LOG_WARN("Warning: received temp value length is not 4  but %d!\r\n",value_len);
+                LOG_WARN("Warning: received temp value length is not 4  but %d!\r\n",(int)value_len);
             }
 
             LOG_INFO("optimal temp value = %d\r\n",optimal_temp_value);
 
-            //send the indication to the client
+            //acknowledge the update with the latest temperature measurement
             LOG_INFO("Send the indication for the temperature update\r\n");
-            if(send_indication(&ble_data, gattdb_temperature_measurement)){
+            if(send_indication(&ble_data, gattdb_temperature_measurement, sizeof(temp_payload), &temp_payload[0])){
                 LOG_ERROR("Failed to send the indication for the temperature characteristic\r\n");
             }
       }
@@ -458,15 +827,15 @@ void handle_ble_event(sl_bt_msg_t *evt)
             }
 
             if(value_len != sizeof(optimal_sound_value)){
-                LOG_WARN("Warning: received sound value length is not 4  but %d!\r\n",value_len);
+                LOG_WARN("Warning: received sound value length is not 4  but %d!\r\n",(int)value_len);
             }
 
 
             LOG_INFO("optimal sound value = %d\r\n",optimal_sound_value);
 
-            //send the indication to the client
+            //acknowledge the update with the latest sound measurement
             LOG_INFO("Send the indication for the sound update\r\n");
-            if(send_indication(&ble_data, gattdb_sound_measurement)){
+            if(send_indication(&ble_data, gattdb_sound_measurement, sizeof(sound_payload), &sound_payload[0])){
                 LOG_ERROR("Failed to send the indication for the sound characteristic\r\n");
             }
       }
@@ -489,17 +858,48 @@ void handle_ble_event(sl_bt_msg_t *evt)
           }
 
           if(value_len != sizeof(sleep_hours)){
-              LOG_WARN("Warning: received sleep_hours value length is not 4  but %d!\r\n",value_len);
+              LOG_WARN("Warning: received sleep_hours value length is not 4  but %d!\r\n",(int)value_len);
           }
 
 
-          //send the indication to the client
+          //acknowledge the update with the received sleep hours
           LOG_INFO("Send the indication for the sleep hours update\r\n");
-          if(send_indication(&ble_data, gattdb_sleep_hours)){
+          if(send_indication(&ble_data, gattdb_sleep_hours, sizeof(*sleep_hours), (uint8_t *)sleep_hours)){
               LOG_ERROR("Failed to send the indication for the sleep_hours characteristic\r\n");
           }
       }
 
+      // Update the sampling policies of the sensors
+      if(evt->data.evt_gatt_server_attribute_value.attribute == gattdb_sampling_policy){
+
+          uint8_t payload[SAMPLING_POLICY_PAYLOAD_LEN];
+          size_t value_len = 0;
+          sl_status_t sc = sl_bt_gatt_server_read_attribute_value(gattdb_sampling_policy,
+                                                                  0,
+                                                                  sizeof(payload),
+                                                                  &value_len,
+                                                                  &payload[0]
+                                                                  );
+
+          if(sc != SL_STATUS_OK){
+              LOG_ERROR("Failed to read the GATT database for the sampling policy, rc = 0x%x\r\n",sc);
+          }
+          else if(!sampling_set_policies(&payload[0], value_len)){
+              LOG_WARN("Warning: received sampling policy length is not %d but %d!\r\n", \
+                       SAMPLING_POLICY_PAYLOAD_LEN, (int)value_len);
+          }
+
+          //a rejected or clamped write reads back as the policies in effect
+          update_sampling_policy_attribute();
+      }
+
+      break;
+
+    // Indicates that the ATT MTU has been negotiated with the client,
+    // which sets how many samples fit in one sensor batch indication.
+    case sl_bt_evt_gatt_mtu_exchanged_id:
+      ble_data.mtu = evt->data.evt_gatt_mtu_exchanged.mtu;
+      LOG_INFO("ATT MTU = %u, %u samples per batch\r\n", ble_data.mtu, batch_capacity());
       break;
 
     case sl_bt_evt_sm_confirm_bonding_id:
@@ -531,12 +931,6 @@ void handle_ble_event(sl_bt_msg_t *evt)
       LOG_ERROR("Device bonding process failed\r\n");
       break;
 
-    case sl_bt_evt_system_soft_timer_id:
-
-      displayUpdate();
-
-      break;
-
     default:
       break;
     } // end - switch
@@ -619,6 +1013,164 @@ bool user_input_status()
   return user_input_confirm;
 }
 
+// -----------------------------------------------
+// Private function, original from Dan Walkes. I fixed a sign extension bug.
+// Convert IEEE-11073 32-bit float to signed integer.
+// -----------------------------------------------
+static int32_t FLOAT_TO_INT32(const uint8_t *value_start_little_endian)
+{
+  uint8_t signByte = 0;
+  int32_t mantissa;
+  // input data format is:
+  // [0] = flags byte
+  // [3][2][1] = mantissa (2's complement)
+  // [4] = exponent (2's complement)
+  // BT value_start_little_endian[0] has the flags byte
+  int8_t exponent = (int8_t)value_start_little_endian[4];
+  // sign extend the mantissa value if the mantissa is negative
+  if (value_start_little_endian[3] & 0x80) { // msb of [3] is the sign of the mantissa
+      signByte = 0xFF;
+  }
+  mantissa = (int32_t) (value_start_little_endian[1] << 0) | \
+  (value_start_little_endian[2] << 8) | \
+  (value_start_little_endian[3] << 16) | \
+  (signByte << 24) ;
+
+  // value = 10^exponent * mantissa, pow() returns a double type
+  return (int32_t) (pow(10, exponent) * mantissa);
+
+} // FLOAT_TO_INT32
+
+// -----------------------------------------------
+// Private function used only by this .c file.
+// Read a little-endian 32-bit value from the payload.
+// -----------------------------------------------
+static uint32_t BITSTREAM_TO_UINT32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | \
+         ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Decode the samples carried in a sensor batch indication.
+ * @param samples: the first sample of the batch
+ * @param num_samples: the number of samples in the batch
+ */
+static void handle_sensor_batch(const uint8_t *samples, uint8_t num_samples)
+{
+  uint8_t i;
+
+  LOG_INFO("Server batch of %u samples\r\n", num_samples);
+
+#if LOG_ENABLED(LOG_LEVEL_INFO)
+  for(i=0;i<num_samples;i++){
+      const uint8_t *p = &samples[i * BATCH_SAMPLE_LEN];
+      int32_t temp_mC = (int32_t)BITSTREAM_TO_UINT32(&p[4]);
+      uint32_t sound_ddB = p[10] | (p[11] << 8);
+
+      LOG_INFO("  t = %u ms: temp = %d C, light = %u lux, sound = %u.%u dB\r\n", \
+               BITSTREAM_TO_UINT32(&p[0]), temp_mC / 1000, (p[8] | (p[9] << 8)), \
+               sound_ddB / 10, sound_ddB % 10);
+  }
+#else
+  (void)samples;
+  (void)i;
+#endif
+}
+
+/**
+ * Decode a measurement sent by the server.
+ * @param characteristic: the handle of the characteristic
+ * @param value: the measurement payload
+ * @param value_len: the length of the measurement payload
+ */
+static void decode_measurement(uint16_t characteristic, uint8_t *value, uint8_t value_len)
+{
+  if((characteristic == ble_data.thermometer_characteristic_handle) && \
+      (value_len == TEMP_PAYLOAD_LEN)){
+      LOG_INFO("Server temperature = %d C\r\n", FLOAT_TO_INT32(value));
+  }
+  else if((characteristic == ble_data.light_sensor_characteristic_handle) && \
+      (value_len == LIGHT_PAYLOAD_LEN)){
+      LOG_INFO("Server light = %u lux\r\n", (value[0] | (value[1] << 8)));
+  }
+  else if((characteristic == ble_data.sound_sensor_characteristic_handle) && \
+      (value_len == SOUND_PAYLOAD_LEN)){
+      LOG_INFO("Server sound = %u.%u dB\r\n", (value[0] | (value[1] << 8)) / 10, \
+               (value[0] | (value[1] << 8)) % 10);
+  }
+  else if((characteristic == ble_data.sensor_batch_characteristic_handle) && \
+      (value_len >= 1) && (value_len == (1 + (value[0] * BATCH_SAMPLE_LEN)))){
+      handle_sensor_batch(&value[1], value[0]);
+  }
+}
+
+/**
+ * Sequence tracking of one notified characteristic. ATT delivers the
+ * notifications of a link in order, so a jump in the sequence number
+ * means that the packets in between were lost.
+ */
+typedef struct {
+  bool synced;
+  uint16_t expected_seq;
+  uint32_t received;
+  uint32_t lost;
+}stream_stats_t;
+
+static stream_stats_t light_stream;
+static stream_stats_t sound_stream;
+static stream_stats_t batch_stream;
+
+// -----------------------------------------------
+// Private function used only by this .c file.
+// Gap detector: account the packets lost before the one carrying seq.
+// -----------------------------------------------
+static void check_stream_seq(stream_stats_t *stream, uint16_t seq, const char *name)
+{
+  if(stream->synced && (seq != stream->expected_seq)){
+      // modulo 2^16, so the wrap of the sequence number is not a gap
+      uint16_t gap = (uint16_t)(seq - stream->expected_seq);
+
+      stream->lost += gap;
+      LOG_WARN("%s stream: %u packets lost before seq %u, %u lost / %u received\r\n", \
+               name, gap, seq, stream->lost, stream->received);
+  }
+
+  stream->synced = true;
+  stream->expected_seq = seq + 1;
+  stream->received++;
+}
+
+/**
+ * Check the sequence number of a notification from the server and
+ * decode the measurement that follows it.
+ * @param evt: the characteristic value event holding the notification
+ */
+static void handle_measurement_notification(sl_bt_msg_t *evt)
+{
+  uint16_t characteristic = evt->data.evt_gatt_characteristic_value.characteristic;
+  uint8_t *value = evt->data.evt_gatt_characteristic_value.value.data;
+  uint8_t value_len = evt->data.evt_gatt_characteristic_value.value.len;
+  uint16_t seq;
+
+  if(value_len < STREAM_SEQ_LEN){
+      return;
+  }
+
+  seq = value[0] | (value[1] << 8);
+
+  if(characteristic == ble_data.light_sensor_characteristic_handle)
+    check_stream_seq(&light_stream, seq, "light");
+  else if(characteristic == ble_data.sound_sensor_characteristic_handle)
+    check_stream_seq(&sound_stream, seq, "sound");
+  else if(characteristic == ble_data.sensor_batch_characteristic_handle)
+    check_stream_seq(&batch_stream, seq, "batch");
+  else
+    return;
+
+  decode_measurement(characteristic, &value[STREAM_SEQ_LEN], value_len - STREAM_SEQ_LEN);
+}
+
 
 /**
  * @brief Bluetooth stack event handler. This overrides the dummy
@@ -728,6 +1280,10 @@ void handle_ble_event(sl_bt_msg_t *evt)
       ble_data.connectionHandle = 0;
       //reset ble_data.bonded
       ble_data.bonded = false;
+      //the server restarts its sequence numbers on the next subscription
+      memset(&light_stream, 0, sizeof(light_stream));
+      memset(&sound_stream, 0, sizeof(sound_stream));
+      memset(&batch_stream, 0, sizeof(batch_stream));
       // Delete all bondings
       sl_bt_sm_delete_bondings();
       // clear LCD displays
@@ -757,6 +1313,10 @@ void handle_ble_event(sl_bt_msg_t *evt)
       if(memcmp(evt->data.evt_gatt_service.uuid.data, get_sleep_hours_service_uuid(), \
                 sizeof(*get_sleep_hours_service_uuid())) == 0)
           ble_data.sleep_hours_service_handle = evt->data.evt_gatt_service.service;
+      //Sensor batch
+      if(memcmp(evt->data.evt_gatt_service.uuid.data, get_sensor_batch_service_uuid(), \
+                sizeof(*get_sensor_batch_service_uuid())) == 0)
+          ble_data.sensor_batch_service_handle = evt->data.evt_gatt_service.service;
 
       break;
 
@@ -790,11 +1350,33 @@ void handle_ble_event(sl_bt_msg_t *evt)
           LOG_INFO("sleep_hours_characteristic_handle is assigned\r\n");
       }
 
+      //Sensor batch
+      if(memcmp(evt->data.evt_gatt_characteristic.uuid.data, get_sensor_batch_char_uuid(), \
+                sizeof(*get_sensor_batch_char_uuid())) == 0){
+          ble_data.sensor_batch_characteristic_handle = evt->data.evt_gatt_characteristic.characteristic;
+          LOG_INFO("sensor_batch_characteristic_handle is assigned\r\n");
+      }
+
       break;
 
 
     // This event is generated when a characteristic value was received e.g. an indication
     case sl_bt_evt_gatt_characteristic_value_id:
+
+      if(evt->data.evt_gatt_characteristic_value.att_opcode == sl_bt_gatt_handle_value_indication){
+          // confirm every indication so that the server can send the next one
+          sc = sl_bt_gatt_send_characteristic_confirmation(ble_data.connectionHandle);
+          if(sc != SL_STATUS_OK){
+              LOG_ERROR("Failed to send the confirmation for the indication, rc = 0x%x\r\n", sc);
+          }
+
+          decode_measurement(evt->data.evt_gatt_characteristic_value.characteristic,
+                             evt->data.evt_gatt_characteristic_value.value.data,
+                             evt->data.evt_gatt_characteristic_value.value.len);
+      }
+      else if(evt->data.evt_gatt_characteristic_value.att_opcode == sl_bt_gatt_handle_value_notification){
+          handle_measurement_notification(evt);
+      }
       break;
 
     case sl_bt_evt_system_external_signal_id:
@@ -802,7 +1384,7 @@ void handle_ble_event(sl_bt_msg_t *evt)
       /**
        * Update Sleep Time & Sleep Hours
        */
-      if(evt->data.evt_system_external_signal.extsignals == evtLETIMER0_UF){
+      if(evt->data.evt_system_external_signal.extsignals & evtSLEEP_HOUR_TICK){
 
           if(ble_handle_sleep_values()){
 
@@ -834,7 +1416,7 @@ void handle_ble_event(sl_bt_msg_t *evt)
        * 2. Selecting sleep time
        * 3. Selecting hours of sleep
        */
-      if(evt->data.evt_system_external_signal.extsignals == evtGPIO_PB0)
+      if(evt->data.evt_system_external_signal.extsignals & evtGPIO_PB0)
       {
         unsigned int pad_value = 1 - GPIO_PinInGet(EXTCOMIN_PB0_port, EXTCOMIN_PB0_pin);
         if(!ble_data.bonded)
@@ -899,7 +1481,7 @@ void handle_ble_event(sl_bt_msg_t *evt)
        * 2. Confirming Sleep time
        * 3. Confirming Sleep Hours
        */
-      if(evt->data.evt_system_external_signal.extsignals == evtGPIO_PB1 )
+      if(evt->data.evt_system_external_signal.extsignals & evtGPIO_PB1)
       {
 
           if(ble_data.bonded){
@@ -985,11 +1567,6 @@ void handle_ble_event(sl_bt_msg_t *evt)
       LOG_ERROR("Device bonding process failed\r\n");
       break;
 
-    case sl_bt_evt_system_soft_timer_id:
-      // Prevent charge buildup within the Liquid Crystal Cells.
-      displayUpdate();
-      break;
-
     default:
       break;
     } // end - switch
@@ -16,12 +16,38 @@
 
 #include "sl_bt_api.h"
 #include <stdbool.h>
+#include "ble_device_type.h"
 
 #define  UINT8_TO_BITSTREAM(p, n)     { *(p)++ = (uint8_t)(n); }
+#define  UINT16_TO_BITSTREAM(p, n)    { *(p)++ = (uint8_t)(n); *(p)++ = (uint8_t)((n) >> 8); }
+#define  INT32_TO_BITSTREAM(p, n)     { *(p)++ = (uint8_t)(n); *(p)++ = (uint8_t)((n) >> 8); \
+                                        *(p)++ = (uint8_t)((n) >> 16); *(p)++ = (uint8_t)((n) >> 24); }
 #define  UINT32_TO_BITSTREAM(p, n)    { *(p)++ = (uint8_t)(0); *(p)++ = (uint8_t)(n); *(p)++ = (uint8_t)((n) >> 8); \
                                         *(p)++ = (uint8_t)((n) >> 16); *(p)++ = (uint8_t)((n) >> 24); }
 
-#define UINT32_TO_FLOAT(m, e)         (((uint32_t)(m) & 0x00FFFFFFU) | (uint32_t)((int32_t)(e) << 24))
+#define UINT32_TO_FLOAT(m, e)         (((uint32_t)(m) & 0x00FFFFFFU) | ((uint32_t)(uint8_t)(e) << 24))
+
+// lengths of the measurement payloads sent in indications
+#define TEMP_PAYLOAD_LEN              (5)   // flags + IEEE-11073 FLOAT
+#define LIGHT_PAYLOAD_LEN             (2)   // uint16, lux
+#define SOUND_PAYLOAD_LEN             (2)   // uint16, 0.1 dB
+
+// sensor batch payload: a sample count byte followed by the samples
+#define BATCH_SAMPLE_LEN              (12)  // uint32 ms, sint32 0.001 C, uint16 lux, uint16 0.1 dB
+#define BATCH_MAX_SAMPLES             (20)  // fills an ATT MTU of 247
+#define BATCH_PAYLOAD_LEN             (1 + (BATCH_MAX_SAMPLES * BATCH_SAMPLE_LEN))
+// the batch is flushed once it holds this many samples or its oldest
+// sample is this old, whichever comes first
+#define BATCH_FLUSH_COUNT             (10)
+#define BATCH_FLUSH_AGE_MS            (30000)
+
+// Streaming mode of the light, sound and sensor batch characteristics.
+// Notifications are prefixed with a little-endian uint16 sequence number
+// so that the client can detect lost packets. Set to 1 to make the client
+// subscribe to notifications for the measurements, the acknowledgments
+// of its writes are still indicated.
+#define SENSOR_STREAM_NOTIFY          (0)
+#define STREAM_SEQ_LEN                (2)
 
 
 // BLE Data Structure, save all of our private BT data in here.
@@ -45,6 +71,11 @@ bool temp_indicate_enabled;
 bool sound_indicate_enabled;
 bool light_indicate_enabled;
 bool sleep_hours_enabled;
+bool batch_indicate_enabled;
+bool light_notify_enabled;
+bool sound_notify_enabled;
+bool batch_notify_enabled;
+uint16_t mtu;
 
 // values unique for client
 char display_bt_addr2[18];
@@ -58,6 +89,8 @@ uint32_t sound_sensor_service_handle;
 uint16_t sound_sensor_characteristic_handle;
 uint32_t sleep_hours_service_handle;
 uint16_t sleep_hours_characteristic_handle;
+uint32_t sensor_batch_service_handle;
+uint16_t sensor_batch_characteristic_handle;
 
 } conn_properties_t;
 
@@ -101,6 +134,38 @@ uint8_t get_sleep_time();
  * the client device.
  */
 void LCD_display_optimal_values();
+
+/**
+ * @brief Send the temperature measurement to the client. The value is
+ * packed as a Health Thermometer temperature measurement, i.e. a flags
+ * byte (Celsius, no timestamp) followed by an IEEE-11073 32-bit FLOAT.
+ * @param temp_mC: the temperature in units of 0.001 Celsius.
+ */
+void ble_send_temperature(int32_t temp_mC);
+
+/**
+ * @brief Send the light measurement to the client as a little-endian
+ * uint16 in units of lux, saturated at 0xFFFF.
+ * @param lux: the light density in lux.
+ */
+void ble_send_light(uint32_t lux);
+
+/**
+ * @brief Send the sound measurement to the client as a little-endian
+ * uint16 in units of 0.1 dB, saturated at 0xFFFF.
+ * @param sound_ddB: the sound level in units of 0.1 dB.
+ */
+void ble_send_sound(uint32_t sound_ddB);
+
+/**
+ * @brief Add the latest temperature, light and sound measurements as one
+ * timestamped sample to the sensor batch. The batch is indicated to the
+ * client once it holds BATCH_FLUSH_COUNT samples, as many samples as fit
+ * in the negotiated ATT MTU, or its oldest sample is BATCH_FLUSH_AGE_MS
+ * old. The age is also checked on every measurement tick.
+ * @param timestamp_ms: the start time of the measurement cycle, in ms.
+ */
+void ble_batch_add_sample(uint32_t timestamp_ms);
 #endif
 
 
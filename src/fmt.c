@@ -0,0 +1,215 @@
+/**
+ * @file fmt.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the small string
+ * formatter. It only handles integers, characters and strings, so it
+ * needs no floating point support and very little stack compared to the
+ * newlib vsnprintf().
+ * @version 0.1
+ * @date 2022-04-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "fmt.h"
+
+// number of digits of the largest 32-bit value in base 10
+#define FMT_MAX_DIGITS              (10)
+
+/**
+ * The output of one fmt_vsnprintf() call
+ */
+typedef struct {
+  char *buf;
+  size_t size;
+  size_t len;      // length of the untruncated output
+}fmt_out_t;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Append count copies of a char to the output.
+// ---------------------------------------------------------------------
+static void put_chars(fmt_out_t *out, char c, uint32_t count)
+{
+  while(count--){
+      if((out->len + 1) < out->size)
+        out->buf[out->len] = c;
+      out->len++;
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Append len chars of text to the output.
+// ---------------------------------------------------------------------
+static void put_text(fmt_out_t *out, const char *text, size_t len)
+{
+  size_t room = (out->size > (out->len + 1)) ? (out->size - out->len - 1) : 0;
+
+  if(len < room)
+    room = len;
+  if(room)
+    memcpy(&out->buf[out->len], text, room);
+  out->len += len;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Append a field padded to width, the sign goes before zero padding.
+// ---------------------------------------------------------------------
+static void put_field(fmt_out_t *out, const char *text, uint32_t text_len, \
+                      char sign, uint32_t width, bool left, bool zero)
+{
+  uint32_t field_len = text_len + (sign ? 1 : 0);
+  uint32_t pad = (width > field_len) ? (width - field_len) : 0;
+
+  if(!left && !zero)
+    put_chars(out, ' ', pad);
+  if(sign)
+    put_chars(out, sign, 1);
+  if(!left && zero)
+    put_chars(out, '0', pad);
+  put_text(out, text, text_len);
+  if(left)
+    put_chars(out, ' ', pad);
+}
+
+/**
+ * @brief Format a string into a buffer like vsnprintf(). The output is
+ * truncated to size - 1 characters and always null terminated if size is
+ * not 0.
+ * @param buf: the output buffer.
+ * @param size: the size of the output buffer in bytes.
+ * @param format: the format string.
+ * @param va: the arguments of the format string.
+ * @return the length of the untruncated output, not counting the null
+ * terminator.
+ */
+int fmt_vsnprintf(char *buf, size_t size, const char *format, va_list va)
+{
+  static const char hex_digits[] = "0123456789abcdef0123456789ABCDEF";
+  fmt_out_t out = { buf, size, 0 };
+  char digits[FMT_MAX_DIGITS];
+
+  while(*format){
+      const char *spec = format;
+      const char *text;
+      uint32_t text_len;
+      uint32_t width = 0;
+      uint32_t value;
+      uint32_t base;
+      bool left = false, zero = false, is_long = false;
+      char sign = 0;
+
+      // copy the text up to the next conversion in one go
+      if(*format != '%'){
+          while(*format && (*format != '%'))
+            format++;
+          put_text(&out, spec, format - spec);
+          continue;
+      }
+      format++;
+
+      // flags, width and length modifiers
+      for(;;format++){
+          if(*format == '-')
+            left = true;
+          else if(*format == '0')
+            zero = true;
+          else
+            break;
+      }
+      while((*format >= '0') && (*format <= '9'))
+        width = (width * 10) + (uint32_t)(*format++ - '0');
+      while((*format == 'l') || (*format == 'h') || (*format == 'z')){
+          if(*format != 'h')
+            is_long = true;
+          format++;
+      }
+
+      switch(*format){
+        case 'd':
+        case 'i':{
+          int32_t v = is_long ? (int32_t)va_arg(va, long) : (int32_t)va_arg(va, int);
+          value = (v < 0) ? (0U - (uint32_t)v) : (uint32_t)v;
+          sign = (v < 0) ? '-' : 0;
+          base = 10;
+          break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+          value = is_long ? (uint32_t)va_arg(va, unsigned long) : (uint32_t)va_arg(va, unsigned int);
+          base = (*format == 'u') ? 10 : 16;
+          break;
+
+        case 's':
+          text = va_arg(va, const char *);
+          if(text == NULL)
+            text = "(null)";
+          put_field(&out, text, strlen(text), 0, width, left, false);
+          format++;
+          continue;
+
+        case 'c':
+          digits[0] = (char)va_arg(va, int);
+          put_field(&out, digits, 1, 0, width, left, false);
+          format++;
+          continue;
+
+        case '%':
+          put_chars(&out, '%', 1);
+          format++;
+          continue;
+
+        default:
+          // unsupported conversion, copy it without taking an argument
+          put_text(&out, spec, format - spec);
+          continue;
+      }
+
+      // convert the value from the least significant digit
+      text_len = 0;
+      do {
+          uint32_t digit = value % base;
+          if((*format == 'X') && (digit > 9))
+            digit += 16;
+          digits[FMT_MAX_DIGITS - 1 - text_len++] = hex_digits[digit];
+          value /= base;
+      } while(value);
+      format++;
+
+      put_field(&out, &digits[FMT_MAX_DIGITS - text_len], text_len, sign, \
+                width, left, zero);
+  }
+
+  if(size)
+    buf[(out.len < size) ? out.len : (size - 1)] = 0;
+
+  return (int)out.len;
+}
+
+/**
+ * @brief Format a string into a buffer like snprintf(), see fmt_vsnprintf().
+ * @param buf: the output buffer.
+ * @param size: the size of the output buffer in bytes.
+ * @param format: the format string.
+ * @return the length of the untruncated output, not counting the null
+ * terminator.
+ */
+int fmt_snprintf(char *buf, size_t size, const char *format, ...)
+{
+  va_list va;
+  int len;
+
+  va_start(va, format);
+  len = fmt_vsnprintf(buf, size, format, va);
+  va_end(va);
+
+  return len;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file fmt.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the small string
+ * formatter used by the LCD and the logging code in place of the newlib
+ * vsnprintf().
+ *
+ * Only the conversions used by this project are supported:
+ *   %d %i %u %x %X %c %s %%
+ * with the '-' and '0' flags and a field width, e.g. "%5u", "%02X" or
+ * "%-8s". The 'l', 'h' and 'z' length modifiers are accepted; values are
+ * formatted as 32-bit integers. Any other conversion, e.g. %f, is copied
+ * to the output as it is and consumes no argument.
+ * @version 0.1
+ * @date 2022-04-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __FMT_H__
+#define __FMT_H__
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/**
+ * @brief Format a string into a buffer like vsnprintf(). The output is
+ * truncated to size - 1 characters and always null terminated if size is
+ * not 0.
+ * @param buf: the output buffer.
+ * @param size: the size of the output buffer in bytes.
+ * @param format: the format string.
+ * @param va: the arguments of the format string.
+ * @return the length of the untruncated output, not counting the null
+ * terminator.
+ */
+int fmt_vsnprintf(char *buf, size_t size, const char *format, va_list va);
+
+/**
+ * @brief Format a string into a buffer like snprintf(), see fmt_vsnprintf().
+ * @param buf: the output buffer.
+ * @param size: the size of the output buffer in bytes.
+ * @param format: the format string.
+ * @return the length of the untruncated output, not counting the null
+ * terminator.
+ */
+int fmt_snprintf(char *buf, size_t size, const char *format, ...)
+  __attribute__ ((format (printf, 3, 4)));
+
+#endif // __FMT_H__
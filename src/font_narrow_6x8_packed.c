@@ -0,0 +1,122 @@
+/**
+ * @file font_narrow_6x8_packed.c
+ * @brief Generated by tools/gen_packed_font.py from glib_font_narrow_6x8.c, do not edit.
+ */
+
+#include <stdint.h>
+#include "font_narrow_6x8_packed.h"
+
+static const uint8_t GLIB_FontNarrow6x8PackedGlyphs[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // ' '
+  0x04, 0x41, 0x10, 0x00, 0x40, 0x00, // '!'
+  0x8a, 0xa2, 0x00, 0x00, 0x00, 0x00, // '"'
+  0x8a, 0xf2, 0x29, 0x9f, 0xa2, 0x00, // '#'
+  0x84, 0x17, 0x38, 0xd0, 0x43, 0x00, // '$'
+  0xc3, 0x84, 0x10, 0x42, 0x86, 0x01, // '%'
+  0x46, 0x52, 0x08, 0x55, 0x62, 0x01, // '&'
+  0x06, 0x21, 0x00, 0x00, 0x00, 0x00, // "'"
+  0x08, 0x21, 0x08, 0x02, 0x81, 0x00, // '('
+  0x02, 0x81, 0x20, 0x08, 0x21, 0x00, // ')'
+  0x00, 0x51, 0x39, 0x15, 0x01, 0x00, // '*'
+  0x00, 0x41, 0x7c, 0x04, 0x01, 0x00, // '+'
+  0x00, 0x00, 0x00, 0x06, 0x21, 0x00, // ','
+  0x00, 0x00, 0x7c, 0x00, 0x00, 0x00, // '-'
+  0x00, 0x00, 0x00, 0x80, 0x61, 0x00, // '.'
+  0x00, 0x00, 0x21, 0x84, 0x10, 0x00, // '/'
+  0x4e, 0x94, 0x55, 0x53, 0xe4, 0x00, // '0'
+  0x84, 0x41, 0x10, 0x04, 0xe1, 0x00, // '1'
+  0x4e, 0x04, 0x21, 0x84, 0xf0, 0x01, // '2'
+  0x1f, 0x42, 0x20, 0x50, 0xe4, 0x00, // '3'
+  0x08, 0xa3, 0x24, 0x1f, 0x82, 0x00, // '4'
+  0x5f, 0xf0, 0x40, 0x50, 0xe4, 0x00, // '5'
+  0x8c, 0x10, 0x3c, 0x51, 0xe4, 0x00, // '6'
+  0x1f, 0x84, 0x10, 0x82, 0x20, 0x00, // '7'
+  0x4e, 0x14, 0x39, 0x51, 0xe4, 0x00, // '8'
+  0x4e, 0x14, 0x79, 0x10, 0x62, 0x00, // '9'
+  0x80, 0x61, 0x00, 0x86, 0x01, 0x00, // ':'
+  0x80, 0x61, 0x00, 0x06, 0x21, 0x00, // ';'
+  0x10, 0x42, 0x08, 0x04, 0x02, 0x01, // '<'
+  0x00, 0xf0, 0x01, 0x1f, 0x00, 0x00, // '='
+  0x81, 0x40, 0x20, 0x84, 0x10, 0x00, // '>'
+  0x4e, 0x04, 0x21, 0x04, 0x40, 0x00, // '?'
+  0x0e, 0x04, 0x59, 0x55, 0xe5, 0x00, // '@'
+  0x4e, 0x14, 0x45, 0x5f, 0x14, 0x01, // 'A'
+  0x4f, 0x14, 0x3d, 0x51, 0xf4, 0x00, // 'B'
+  0x4e, 0x14, 0x04, 0x41, 0xe4, 0x00, // 'C'
+  0x47, 0x12, 0x45, 0x51, 0x72, 0x00, // 'D'
+  0x5f, 0x10, 0x3c, 0x41, 0xf0, 0x01, // 'E'
+  0x5f, 0x10, 0x3c, 0x41, 0x10, 0x00, // 'F'
+  0x4e, 0x14, 0x74, 0x51, 0xe4, 0x00, // 'G'
+  0x51, 0x14, 0x7d, 0x51, 0x14, 0x01, // 'H'
+  0x0e, 0x41, 0x10, 0x04, 0xe1, 0x00, // 'I'
+  0x1c, 0x82, 0x20, 0x48, 0x62, 0x00, // 'J'
+  0x51, 0x52, 0x0c, 0x45, 0x12, 0x01, // 'K'
+  0x41, 0x10, 0x04, 0x41, 0xf0, 0x01, // 'L'
+  0xd1, 0x56, 0x55, 0x51, 0x14, 0x01, // 'M'
+  0x51, 0x34, 0x55, 0x59, 0x14, 0x01, // 'N'
+  0x4e, 0x14, 0x45, 0x51, 0xe4, 0x00, // 'O'
+  0x4f, 0x14, 0x3d, 0x41, 0x10, 0x00, // 'P'
+  0x4e, 0x14, 0x45, 0x55, 0x62, 0x01, // 'Q'
+  0x4f, 0x14, 0x3d, 0x45, 0x12, 0x01, // 'R'
+  0x5e, 0x10, 0x38, 0x10, 0xf4, 0x00, // 'S'
+  0x1f, 0x41, 0x10, 0x04, 0x41, 0x00, // 'T'
+  0x51, 0x14, 0x45, 0x51, 0xe4, 0x00, // 'U'
+  0x51, 0x14, 0x45, 0x91, 0x42, 0x00, // 'V'
+  0x51, 0x14, 0x55, 0x55, 0xa5, 0x00, // 'W'
+  0x51, 0xa4, 0x10, 0x4a, 0x14, 0x01, // 'X'
+  0x51, 0x14, 0x29, 0x04, 0x41, 0x00, // 'Y'
+  0x1f, 0x84, 0x10, 0x42, 0xf0, 0x01, // 'Z'
+  0x8e, 0x20, 0x08, 0x82, 0xe0, 0x00, // '['
+  0x00, 0x10, 0x08, 0x04, 0x02, 0x01, // '\\'
+  0x0e, 0x82, 0x20, 0x08, 0xe2, 0x00, // ']'
+  0x84, 0x12, 0x01, 0x00, 0x00, 0x00, // '^'
+  0x00, 0x00, 0x00, 0x00, 0xf0, 0x01, // '_'
+  0x02, 0x81, 0x00, 0x00, 0x00, 0x00, // '`'
+  0x00, 0xe0, 0x40, 0x5e, 0xe4, 0x01, // 'a'
+  0x41, 0xd0, 0x4c, 0x51, 0xf4, 0x00, // 'b'
+  0x00, 0xe0, 0x04, 0x41, 0xe4, 0x00, // 'c'
+  0x10, 0x64, 0x65, 0x51, 0xe4, 0x01, // 'd'
+  0x00, 0xe0, 0x44, 0x5f, 0xe0, 0x00, // 'e'
+  0x8c, 0x24, 0x1c, 0x82, 0x20, 0x00, // 'f'
+  0x80, 0x17, 0x45, 0x1e, 0xe4, 0x00, // 'g'
+  0x41, 0xd0, 0x4c, 0x51, 0x14, 0x01, // 'h'
+  0x04, 0x60, 0x10, 0x04, 0xe1, 0x00, // 'i'
+  0x08, 0xc0, 0x20, 0x48, 0x62, 0x00, // 'j'
+  0x41, 0x90, 0x14, 0x43, 0x91, 0x00, // 'k'
+  0x06, 0x41, 0x10, 0x04, 0xe1, 0x00, // 'l'
+  0x00, 0xb0, 0x54, 0x55, 0x14, 0x01, // 'm'
+  0x00, 0xd0, 0x4c, 0x51, 0x14, 0x01, // 'n'
+  0x00, 0xe0, 0x44, 0x51, 0xe4, 0x00, // 'o'
+  0x00, 0xf0, 0x44, 0x4f, 0x10, 0x00, // 'p'
+  0x00, 0x60, 0x65, 0x1e, 0x04, 0x01, // 'q'
+  0x00, 0xd0, 0x4c, 0x41, 0x10, 0x00, // 'r'
+  0x00, 0xe0, 0x04, 0x0e, 0xf4, 0x00, // 's'
+  0x82, 0x70, 0x08, 0x82, 0xc4, 0x00, // 't'
+  0x00, 0x10, 0x45, 0x51, 0x66, 0x01, // 'u'
+  0x00, 0x10, 0x45, 0x91, 0x42, 0x00, // 'v'
+  0x00, 0x10, 0x45, 0x55, 0xa5, 0x00, // 'w'
+  0x00, 0x10, 0x29, 0x84, 0x12, 0x01, // 'x'
+  0x00, 0x10, 0x45, 0x1e, 0xe4, 0x00, // 'y'
+  0x00, 0xf0, 0x21, 0x84, 0xf0, 0x01, // 'z'
+  0x8c, 0x20, 0x04, 0x82, 0xc0, 0x00, // '{'
+  0x04, 0x41, 0x10, 0x04, 0x41, 0x00, // '|'
+  0x06, 0x82, 0x40, 0x08, 0x62, 0x00, // '}'
+  0x80, 0x50, 0x21, 0x00, 0x00, 0x00, // '~'
+  0x00, 0x00
+};
+
+static const uint8_t GLIB_FontNarrow6x8PackedWidths[] = {
+  0, 3, 4, 5, 5, 5, 5, 3, 4, 4, 5, 5, 3, 5, 3, 5,
+  5, 4, 5, 5, 5, 5, 5, 5, 5, 5, 3, 3, 5, 5, 4, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 4, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 4, 5, 4, 5, 5,
+  4, 5, 5, 5, 5, 5, 5, 5, 5, 4, 4, 4, 4, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 4, 3, 5, 5,
+};
+
+static const GLIB_PackedFont_t GLIB_FontNarrow6x8PackedData = {
+  GLIB_FontNarrow6x8PackedGlyphs, GLIB_FontNarrow6x8PackedWidths, 6, ' '
+};
+
+const GLIB_Font_t GLIB_FontNarrow6x8Packed = { (void *)&GLIB_FontNarrow6x8PackedData,
+  95, 6, 0, 6, 8, 2, 0, PackedFont };
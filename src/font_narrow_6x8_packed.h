@@ -0,0 +1,13 @@
+/**
+ * @file font_narrow_6x8_packed.h
+ * @brief Generated by tools/gen_packed_font.py from glib_font_narrow_6x8.c, do not edit.
+ */
+
+#ifndef __FONT_NARROW_6X8_PACKED_H__
+#define __FONT_NARROW_6X8_PACKED_H__
+
+#include "glib.h"
+
+extern const GLIB_Font_t GLIB_FontNarrow6x8Packed;
+
+#endif // __FONT_NARROW_6X8_PACKED_H__
@@ -13,12 +13,13 @@
  */
 
 #include "i2c.h"
+#include "i2c_queue.h"
 #include "timers.h"
 #include "sl_i2cspm.h"
 #include "em_i2c.h"
 #include "em_assert.h"
 
-#define INCLUDE_LOG_DEBUG 1
+#define LOG_LEVEL LOG_LEVEL_INFO
 #include "src/log.h"
 
 #define MEASURE_TEMP_No_Hold_Master_Mode             (0xF3)
@@ -105,124 +106,62 @@ static uint8_t ISL29125_write_data[4];
 static uint8_t ISL29125_read_data[6];
 static uint16_t rgb[3];
 static uint32_t xyz[3];
-I2C_TransferSeq_TypeDef ISL29125_seq;
-I2C_TransferSeq_TypeDef I7021_seq;
 uint8_t deviceID = 0;
 uint8_t isl29125_config_data = 0;
 
 
 /**
- * @brief This function initializes I2C0.
+ * @brief This function routes I2C0 to the ISL29125 pins.
  */
 void initI2C0_for_ISL29125()
 {
-  I2CSPM_Init_TypeDef I2C0_Config = {
-          .port            = I2C0,
-          .sclPort         = gpioPortD,
-          .sclPin          = 10,
-          .sdaPort         = gpioPortD,
-          .sdaPin          = 11,
-          .portLocationScl = 17,
-          .portLocationSda = 19,
-          .i2cRefFreq      = 0,
-          .i2cMaxFreq      = I2C_FREQ_STANDARD_MAX,
-          .i2cClhr         = i2cClockHLRStandard
-      };
-
-  I2CSPM_Init(&I2C0_Config);
+  i2c_queue_select_route(I2C_ROUTE_ISL29125);
 }
 
+/**
+ * @brief This function routes I2C0 to the Si7021 pins.
+ */
 void initI2C0_for_I7021()
 {
-  I2CSPM_Init_TypeDef i2c_config = {
-      .port = I2C0,
-      .sclPort = gpioPortC,
-      .sclPin = 10,
-      .sdaPort = gpioPortC,
-      .sdaPin = 11,
-      .portLocationScl = 14,
-      .portLocationSda = 16,
-      .i2cRefFreq = 0,
-      .i2cMaxFreq = I2C_FREQ_STANDARD_MAX,
-      .i2cClhr = i2cClockHLRStandard
-  };
-
-  I2CSPM_Init(&i2c_config);
+  i2c_queue_select_route(I2C_ROUTE_SI7021);
 }
 
 
 /**
- * Interrupt-based I2C transaction function for ISL29125 using I2C0.
+ * Queue an interrupt-driven I2C transaction on I2C0.
+ * @param route: the pin route the sensor is wired to
+ * @param addr: the 7-bit sensor address
  * @param flag: I2C transaction type
  * @param writeCmd: buffer holding the data to be written
  * @param writeLen: the length of the write data buffer
  * @param readCmd: buffer holding the data to be read
  * @param readLen: the length of the read data buffer
+ * @param callback: the completion callback
+ * @param ctx: the context passed to the callback
  */
-static void ISL29125_transaction_ISR(uint16_t flag,
-                                 uint8_t *writeCmd,
-                                 size_t writeLen,
-                                 uint8_t *readCmd,
-                                 size_t readLen)
+static void sensor_transaction_ISR(i2c_route_t route,
+                                   uint16_t addr,
+                                   uint16_t flag,
+                                   uint8_t *writeCmd,
+                                   size_t writeLen,
+                                   uint8_t *readCmd,
+                                   size_t readLen,
+                                   i2c_job_callback_t callback,
+                                   void *ctx)
 {
+  i2c_job_t job = {
+      .route      = route,
+      .addr       = addr,
+      .flags      = flag,
+      .write_data = writeCmd,
+      .write_len  = writeLen,
+      .read_data  = readCmd,
+      .read_len   = readLen,
+      .callback   = callback,
+      .ctx        = ctx
+  };
 
-  I2C_TransferReturn_TypeDef ret;
-
-  ISL29125_seq.addr = ISL29125_I2C_ADDR << 1;
-  ISL29125_seq.flags = flag;
-
-  switch (flag) {
-    // Send the write command from writeCmd, possibly with writeData
-    case I2C_FLAG_WRITE:
-      ISL29125_seq.buf[0].data = writeCmd;
-      ISL29125_seq.buf[0].len  = writeLen;
-
-      break;
-
-    // Receive data into readCmd of readLen
-    case I2C_FLAG_READ:
-      ISL29125_seq.buf[0].data = readCmd;
-      ISL29125_seq.buf[0].len  = readLen;
-
-      break;
-
-    // Send the write command from writeCmd
-    // and receive data into readCmd of readLen
-    case I2C_FLAG_WRITE_READ:
-      ISL29125_seq.buf[0].data = writeCmd;
-      ISL29125_seq.buf[0].len  = writeLen;
-
-      ISL29125_seq.buf[1].data = readCmd;
-      ISL29125_seq.buf[1].len  = readLen;
-
-      break;
-
-    case I2C_FLAG_WRITE_WRITE:
-      ISL29125_seq.buf[0].data = &writeCmd[0];
-      ISL29125_seq.buf[0].len  = 1;
-
-      ISL29125_seq.buf[1].data = &writeCmd[1];
-      ISL29125_seq.buf[1].len  = writeLen - 1;
-      break;
-
-    default:
-      break;
-  }
-
-
-  //configure NVIC to generate an IRQ for the I2C0 module
-  if(!NVIC_GetEnableIRQ(I2C0_IRQn)){
-      NVIC_ClearPendingIRQ(I2C0_IRQn);
-      NVIC_EnableIRQ(I2C0_IRQn);
-  }
-
-  //initiate the I2C transfer
-  ret = I2C_TransferInit(I2C0, &ISL29125_seq);
-  if(ret < 0){
-      LOG_ERROR("I2C_TransferInit( ) error = %d\r\n", ret);
-  }
-
-  return;
+  i2c_queue_submit(&job);
 }
 
 /**
@@ -308,7 +247,8 @@ void reset_ISL29125()
 void read_deviceID()
 {
   ISL29125_write_data[0] = ISL29125_DEVICE_ID;
-  ISL29125_transaction_ISR(I2C_FLAG_WRITE_READ, &ISL29125_write_data[0], 1, &deviceID, 1);
+  sensor_transaction_ISR(I2C_ROUTE_ISL29125, ISL29125_I2C_ADDR, I2C_FLAG_WRITE_READ, \
+                         &ISL29125_write_data[0], 1, &deviceID, 1, NULL, NULL);
 }
 
 /**
@@ -333,17 +273,22 @@ void configure_ISL29125()
 void read_ISL29125_configuration()
 {
   ISL29125_write_data[0] = ISL29125_CONFIG_1;
-  ISL29125_transaction_ISR(I2C_FLAG_WRITE_READ, &ISL29125_write_data[0], 1, &isl29125_config_data, 1);
+  sensor_transaction_ISR(I2C_ROUTE_ISL29125, ISL29125_I2C_ADDR, I2C_FLAG_WRITE_READ, \
+                         &ISL29125_write_data[0], 1, &isl29125_config_data, 1, NULL, NULL);
 }
 
 /**
  * Measure the sensor data in R,G,B channels.
+ * @param callback: called once the RGB registers have been read
+ * @param ctx: the context passed to the callback
  */
-void ISL29125_measure_RGB()
+void ISL29125_measure_RGB(i2c_job_callback_t callback, void *ctx)
 {
   // Start measurement for GREEN_L DATA and wait for data to become ready
   ISL29125_write_data[0] = ISL29125_GREEN_L;
-  ISL29125_transaction_ISR(I2C_FLAG_WRITE_READ, &ISL29125_write_data[0], 1, &ISL29125_read_data[0], 6);
+  sensor_transaction_ISR(I2C_ROUTE_ISL29125, ISL29125_I2C_ADDR, I2C_FLAG_WRITE_READ, \
+                         &ISL29125_write_data[0], 1, &ISL29125_read_data[0], 6, \
+                         callback, ctx);
   return;
 }
 
@@ -393,95 +338,29 @@ uint32_t calculate_light_density_in_lux()
 
 
 /**
- * Interrupt-based I2C transaction function for I7021 using I2C1.
- * @param flag: I2C transaction type
- * @param writeCmd: buffer holding the data to be written
- * @param writeLen: the length of the write data buffer
- * @param readCmd: buffer holding the data to be read
- * @param readLen: the length of the read data buffer
+ * @brief Send 0xF3 command to the sensor via I2C0 using
+ * the interrupt-driven I2C job queue.
+ * @param callback: called once the command has been sent
+ * @param ctx: the context passed to the callback
  */
-static void I7021_transaction_ISR(uint16_t flag,
-                                 uint8_t *writeCmd,
-                                 size_t writeLen,
-                                 uint8_t *readCmd,
-                                 size_t readLen)
-{
-  I2C_TransferReturn_TypeDef ret;
-
-  I7021_seq.addr = SI7021_ADDR << 1;
-  I7021_seq.flags = flag;
-
-  switch (flag) {
-      // Send the write command from writeCmd, possibly with writeData
-      case I2C_FLAG_WRITE:
-        I7021_seq.buf[0].data = writeCmd;
-        I7021_seq.buf[0].len  = writeLen;
-
-        break;
-
-      // Receive data into readCmd of readLen
-      case I2C_FLAG_READ:
-        I7021_seq.buf[0].data = readCmd;
-        I7021_seq.buf[0].len  = readLen;
-
-        break;
-
-      // Send the write command from writeCmd
-      // and receive data into readCmd of readLen
-      case I2C_FLAG_WRITE_READ:
-        I7021_seq.buf[0].data = writeCmd;
-        I7021_seq.buf[0].len  = writeLen;
-
-        I7021_seq.buf[1].data = readCmd;
-        I7021_seq.buf[1].len  = readLen;
-
-        break;
-
-      case I2C_FLAG_WRITE_WRITE:
-        I7021_seq.buf[0].data = &writeCmd[0];
-        I7021_seq.buf[0].len  = 1;
-
-        I7021_seq.buf[1].data = &writeCmd[1];
-        I7021_seq.buf[1].len  = writeLen - 1;
-        break;
-
-      default:
-        break;
-  }
-
-  if(!NVIC_GetEnableIRQ(I2C0_IRQn)){
-      NVIC_ClearPendingIRQ(I2C0_IRQn);
-      NVIC_EnableIRQ(I2C0_IRQn);
-  }
-
-  //initiate the I2C transfer
-  ret = I2C_TransferInit(I2C0, &I7021_seq);
-  if(ret < 0){
-      LOG_ERROR("I2C_TransferInit( ) error = %d\r\n", ret);
-  }
-
-  return;
-}
-
-/**
- * @brief Send 0xF3 command to the sensor via I2C1 using
- * interrupt-driven I2C_TransferInit( ).
- */
-void I7021_write()
+void I7021_write(i2c_job_callback_t callback, void *ctx)
 {
   SI7021_write_data[0] = MEASURE_TEMP_No_Hold_Master_Mode;
-  I7021_transaction_ISR(I2C_FLAG_WRITE, &SI7021_write_data[0], 1, NULL, 0);
+  sensor_transaction_ISR(I2C_ROUTE_SI7021, SI7021_ADDR, I2C_FLAG_WRITE, \
+                         &SI7021_write_data[0], 1, NULL, 0, callback, ctx);
 }
 
 /**
  * @brief Receive the sensor response based on the
- * command 0xF3 sent to the sensor via I2C1. The operation
- * is performed via interrupt-driven I2C_TransferInit( ).
+ * command 0xF3 sent to the sensor via I2C0. The operation
+ * is performed via the interrupt-driven I2C job queue.
+ * @param callback: called once the response has been read
+ * @param ctx: the context passed to the callback
  */
-
-void I7021_read()
+void I7021_read(i2c_job_callback_t callback, void *ctx)
 {
-  I7021_transaction_ISR(I2C_FLAG_READ, NULL, 0, &SI7021_read_data[0], 2);
+  sensor_transaction_ISR(I2C_ROUTE_SI7021, SI7021_ADDR, I2C_FLAG_READ, \
+                         NULL, 0, &SI7021_read_data[0], 2, callback, ctx);
 }
 
 
@@ -499,3 +378,16 @@ uint32_t get_temperature_data()
   return (uint32_t)temperature;
 }
 
+/**
+ * @brief obtain the temperature data read from the Si7021 sensor
+ * in units of 0.001 Celsius, computed with integer math.
+ */
+int32_t get_temperature_data_mC()
+{
+  uint32_t tempData = SI7021_read_data[0] << 8;
+  tempData |= SI7021_read_data[1];
+  //temperature conversion of the Si7021 sensor, scaled by 1000. The
+  //product needs 34 bits for the full 16-bit code range.
+  return (int32_t)(((uint64_t)175720 * tempData) >> 16) - 46850;
+}
+
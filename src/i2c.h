@@ -14,9 +14,11 @@
 #define __I2C_H__
 
 #include <stdint.h>
+#include "i2c_queue.h"
 
 /**
- * @brief This function initializes I2C0.
+ * @brief This function routes I2C0 to the Si7021 or ISL29125 pins,
+ * I2CSPM_Init( ) is only run when the route changes.
  */
 
 void initI2C0_for_I7021();
@@ -39,8 +41,10 @@ void configure_ISL29125();
 
 /**
  * Measure the sensor data in R,G,B channels.
+ * @param callback: called once the RGB registers have been read
+ * @param ctx: the context passed to the callback
  */
-void ISL29125_measure_RGB();
+void ISL29125_measure_RGB(i2c_job_callback_t callback, void *ctx);
 
 /**
  * RGB -> XYZ transformation.
@@ -66,20 +70,29 @@ void read_deviceID();
 void read_ISL29125_configuration();
 
 /**
- * @brief Send 0xF3 command to the sensor via I2C1 using
- * interrupt-driven I2C_TransferInit( ).
+ * @brief Send 0xF3 command to the sensor via I2C0 using
+ * the interrupt-driven I2C job queue.
+ * @param callback: called once the command has been sent
+ * @param ctx: the context passed to the callback
  */
-void I7021_write();
+void I7021_write(i2c_job_callback_t callback, void *ctx);
 /**
  * @brief Receive the sensor response based on the
- * command 0xF3 sent to the sensor via I2C1. The operation
- * is performed via interrupt-driven I2C_TransferInit( ).
+ * command 0xF3 sent to the sensor via I2C0. The operation
+ * is performed via the interrupt-driven I2C job queue.
+ * @param callback: called once the response has been read
+ * @param ctx: the context passed to the callback
  */
-void I7021_read();
+void I7021_read(i2c_job_callback_t callback, void *ctx);
 /**
  * @brief obtain the temperature data read from the Si7021 sensor.
  */
 uint32_t get_temperature_data();
+/**
+ * @brief obtain the temperature data read from the Si7021 sensor
+ * in units of 0.001 Celsius, computed with integer math.
+ */
+int32_t get_temperature_data_mC();
 
 
 #endif //__I2C_H__
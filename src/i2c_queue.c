@@ -0,0 +1,334 @@
+/**
+ * @file i2c_queue.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the interrupt-driven
+ * I2C0 job queue. Only the job at the head of the queue is on the bus.
+ * The ISR advances its transfer and signals the scheduler once the
+ * transfer has finished, and the retry decision and the completion
+ * callback run in the scheduler context from i2c_queue_process().
+ * @version 0.1
+ * @date 2022-04-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "i2c_queue.h"
+#include "sl_i2cspm.h"
+#include "sl_sleeptimer.h"
+#include "sl_power_manager.h"
+#include "em_core.h"
+#include "scheduler.h"
+#include "energy.h"
+
+#define LOG_LEVEL LOG_LEVEL_WARN
+#include "src/log.h"
+
+// EM1 is held for one job and its retries, warn if it is held longer
+#define I2C_EM1_HOLD_LIMIT_MS       (100)
+
+
+/**
+ * I2CSPM configuration of every pin route, indexed by i2c_route_t
+ */
+static const I2CSPM_Init_TypeDef route_config[NUM_I2C_ROUTES] = {
+  [I2C_ROUTE_SI7021] = {
+      .port            = I2C0,
+      .sclPort         = gpioPortC,
+      .sclPin          = 10,
+      .sdaPort         = gpioPortC,
+      .sdaPin          = 11,
+      .portLocationScl = 14,
+      .portLocationSda = 16,
+      .i2cRefFreq      = 0,
+      .i2cMaxFreq      = I2C_FREQ_STANDARD_MAX,
+      .i2cClhr         = i2cClockHLRStandard
+  },
+  [I2C_ROUTE_ISL29125] = {
+      .port            = I2C0,
+      .sclPort         = gpioPortD,
+      .sclPin          = 10,
+      .sdaPort         = gpioPortD,
+      .sdaPin          = 11,
+      .portLocationScl = 17,
+      .portLocationSda = 19,
+      .i2cRefFreq      = 0,
+      .i2cMaxFreq      = I2C_FREQ_STANDARD_MAX,
+      .i2cClhr         = i2cClockHLRStandard
+  }
+};
+
+static i2c_job_t    jobs[I2C_QUEUE_DEPTH];
+static uint32_t     wptr = 0;
+static uint32_t     rptr = 0;
+
+// the head job is on the bus or waiting for its retry
+static bool         job_active = false;
+static bool         job_backoff = false;
+static uint32_t     job_attempts = 0;
+static volatile I2C_TransferReturn_TypeDef job_status = i2cTransferDone;
+
+static i2c_route_t  current_route = I2C_ROUTE_NONE;
+static I2C_TransferSeq_TypeDef seq;
+static sl_sleeptimer_timer_handle_t backoff_timer;
+static bool         em1_held = false;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// compute next ptr value
+// ---------------------------------------------------------------------
+static uint32_t nextPtr(uint32_t ptr)
+{
+  if(ptr == (I2C_QUEUE_DEPTH - 1))
+    return 0;
+  else
+    return ptr + 1;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Keep EM1 as the lowest energy mode while a transfer is on the bus.
+// ---------------------------------------------------------------------
+static void hold_em1(bool hold)
+{
+  if(hold && !em1_held){
+      ENERGY_ADD_EM_REQUIREMENT(SL_POWER_MANAGER_EM1, I2C_EM1_HOLD_LIMIT_MS);
+  }
+  else if(!hold && em1_held){
+      ENERGY_REMOVE_EM_REQUIREMENT(SL_POWER_MANAGER_EM1);
+  }
+  em1_held = hold;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Sleeptimer callback ending the backoff, runs in the ISR context.
+// ---------------------------------------------------------------------
+static void backoff_expired(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+  schedulerSetEventI2C0Retry();
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Put the job at the head of the queue on the bus.
+// ---------------------------------------------------------------------
+static void start_head_job()
+{
+  i2c_job_t *job = &jobs[rptr];
+  I2C_TransferReturn_TypeDef ret;
+
+  job_active = true;
+  job_backoff = false;
+
+  i2c_queue_select_route(job->route);
+
+  seq.addr = job->addr << 1;
+  seq.flags = job->flags;
+
+  switch (job->flags) {
+    // Send the write command from write_data, possibly with writeData
+    case I2C_FLAG_WRITE:
+      seq.buf[0].data = job->write_data;
+      seq.buf[0].len  = job->write_len;
+      break;
+
+    // Receive data into read_data of read_len
+    case I2C_FLAG_READ:
+      seq.buf[0].data = job->read_data;
+      seq.buf[0].len  = job->read_len;
+      break;
+
+    // Send the write command from write_data
+    // and receive data into read_data of read_len
+    case I2C_FLAG_WRITE_READ:
+      seq.buf[0].data = job->write_data;
+      seq.buf[0].len  = job->write_len;
+
+      seq.buf[1].data = job->read_data;
+      seq.buf[1].len  = job->read_len;
+      break;
+
+    case I2C_FLAG_WRITE_WRITE:
+      seq.buf[0].data = &job->write_data[0];
+      seq.buf[0].len  = 1;
+
+      seq.buf[1].data = &job->write_data[1];
+      seq.buf[1].len  = job->write_len - 1;
+      break;
+
+    default:
+      break;
+  }
+
+  hold_em1(true);
+
+  //configure NVIC to generate an IRQ for the I2C0 module
+  if(!NVIC_GetEnableIRQ(I2C0_IRQn)){
+      NVIC_ClearPendingIRQ(I2C0_IRQn);
+      NVIC_EnableIRQ(I2C0_IRQn);
+  }
+
+  //initiate the I2C transfer
+  ret = I2C_TransferInit(I2C0, &seq);
+  if(ret < 0){
+      LOG_ERROR("I2C_TransferInit( ) error = %d\r\n", ret);
+      //report the failure through the normal completion path
+      job_status = ret;
+      schedulerSetEventI2C0TranNACK();
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Retry the head job or pop it and report its result.
+// ---------------------------------------------------------------------
+static void finish_head_job(I2C_TransferReturn_TypeDef status)
+{
+  i2c_job_t job;
+  sl_status_t sc;
+
+  if((status != i2cTransferDone) && (job_attempts < I2C_JOB_MAX_RETRIES)){
+      uint32_t backoff_ms = I2C_JOB_BACKOFF_MS << job_attempts;
+      job_attempts++;
+      LOG_WARN("I2C job to 0x%02x failed (%d), retry %u in %u ms\r\n", \
+               jobs[rptr].addr, status, job_attempts, backoff_ms);
+
+      sc = sl_sleeptimer_start_timer_ms(&backoff_timer, backoff_ms, \
+                                        backoff_expired, NULL, 0, 0);
+      if(sc == SL_STATUS_OK){
+          // the bus is idle during the backoff
+          hold_em1(false);
+          job_backoff = true;
+          return;
+      }
+
+      // without the timer the retry would never run, fail the job now
+      LOG_ERROR("Failed to start the I2C backoff timer, rc = 0x%x\r\n", \
+                (unsigned int)sc);
+  }
+
+  if(status != i2cTransferDone){
+      LOG_ERROR("I2C job to 0x%02x failed (%d) after %u retries\r\n", \
+                jobs[rptr].addr, status, job_attempts);
+  }
+
+  // pop the job before the callback so that it can submit the next one
+  job = jobs[rptr];
+  rptr = nextPtr(rptr);
+  job_active = false;
+  job_attempts = 0;
+
+  if(job.callback){
+      job.callback(status, job.ctx);
+  }
+
+  if(job_active){
+      // the callback has already started a new job
+      return;
+  }
+
+  if(rptr != wptr){
+      start_head_job();
+  }
+  else{
+      hold_em1(false);
+      NVIC_DisableIRQ(I2C0_IRQn);
+  }
+}
+
+/**
+ * @brief Route I2C0 to the given pins. I2CSPM_Init() is skipped when
+ * I2C0 is already on the requested route.
+ * @param route: the pin route to select.
+ */
+void i2c_queue_select_route(i2c_route_t route)
+{
+  if((route == current_route) || (route == I2C_ROUTE_NONE) || \
+      (route >= NUM_I2C_ROUTES)){
+      return;
+  }
+
+  I2CSPM_Init((I2CSPM_Init_TypeDef *)&route_config[route]);
+  current_route = route;
+}
+
+/**
+ * @brief Submit a job. The job is copied into the queue and started at
+ * once if the bus is idle.
+ * @param job: the job to submit.
+ * @return true if the job was queued, false if the queue is full.
+ */
+bool i2c_queue_submit(const i2c_job_t *job)
+{
+  if(nextPtr(wptr) == rptr){
+      LOG_ERROR("I2C job queue is full, job to 0x%02x dropped\r\n", job->addr);
+      return false;
+  }
+
+  jobs[wptr] = *job;
+  wptr = nextPtr(wptr);
+
+  if(!job_active){
+      start_head_job();
+  }
+
+  return true;
+}
+
+/**
+ * @brief Drive the queue from the scheduler context. Finished jobs are
+ * either retried or reported to their callback, and the next job is
+ * started.
+ * @param extsignals: the external signals of the current wakeup.
+ * @return the I2C event bits handled by the queue.
+ */
+uint32_t i2c_queue_process(uint32_t extsignals)
+{
+  uint32_t handled = extsignals & (evtI2C0_TRANDONE | evtI2C0_TRANNACK | evtI2C0_RETRY);
+
+  if((extsignals & (evtI2C0_TRANDONE | evtI2C0_TRANNACK)) && \
+      job_active && !job_backoff){
+      finish_head_job(job_status);
+  }
+
+  if((extsignals & evtI2C0_RETRY) && job_backoff){
+      start_head_job();
+  }
+
+  return handled;
+}
+
+/**
+ * @brief Advance the running transfer, called from I2C0_IRQHandler().
+ * The scheduler is signalled once the transfer has finished.
+ */
+void i2c_queue_irq_handler()
+{
+  I2C_TransferReturn_TypeDef status = I2C_Transfer(I2C0);
+
+  if(status == i2cTransferInProgress){
+      return;
+  }
+
+  job_status = status;
+
+  if(status == i2cTransferDone){
+      schedulerSetEventI2C0TranDone();
+  }
+  else{
+      schedulerSetEventI2C0TranNACK();
+  }
+}
+
+/**
+ * @brief Check whether the queue has no running or pending job.
+ * @return true if the queue is idle.
+ */
+bool i2c_queue_is_idle()
+{
+  return (!job_active && (rptr == wptr));
+}
@@ -0,0 +1,108 @@
+/**
+ * @file i2c_queue.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the interrupt-driven
+ * I2C0 job queue shared by the Si7021 and the ISL29125 sensors.
+ *
+ * Callers submit a job with a completion callback. Jobs run one after
+ * another in submission order, and I2CSPM_Init() is only re-run when the
+ * next job uses a different pin route from the previous one. NACKs and
+ * other transfer errors are retried up to I2C_JOB_MAX_RETRIES times with
+ * a doubling backoff before the callback reports the failure.
+ *
+ * The driver only touches the hardware through emlib (I2C_TransferInit(),
+ * I2C_Transfer(), I2CSPM_Init()) and sl_sleeptimer, so it can be linked
+ * on a host against fake versions of those functions.
+ * @version 0.1
+ * @date 2022-04-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __I2C_QUEUE_H__
+#define __I2C_QUEUE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "em_i2c.h"
+
+// number of entries in the job queue, one entry is left empty
+#define I2C_QUEUE_DEPTH             (8)
+// number of times a failed job is retried before its callback is called
+#define I2C_JOB_MAX_RETRIES         (3)
+// backoff before the first retry, doubled on every further retry
+#define I2C_JOB_BACKOFF_MS          (1)
+
+/**
+ * Pin routes of I2C0
+ */
+typedef enum {
+  I2C_ROUTE_NONE = 0,  //!< I2C_ROUTE_NONE
+  I2C_ROUTE_SI7021,    //!< I2C_ROUTE_SI7021, PC10/PC11
+  I2C_ROUTE_ISL29125,  //!< I2C_ROUTE_ISL29125, PD10/PD11
+  NUM_I2C_ROUTES       //!< NUM_I2C_ROUTES
+}i2c_route_t;
+
+/**
+ * Completion callback of a job, called from the scheduler context.
+ * status is i2cTransferDone on success, otherwise the error of the last
+ * attempt.
+ */
+typedef void (*i2c_job_callback_t)(I2C_TransferReturn_TypeDef status, void *ctx);
+
+/**
+ * One I2C transaction. The data buffers must stay valid until the
+ * callback is called.
+ */
+typedef struct {
+  i2c_route_t route;            // pin route the target device is wired to
+  uint16_t addr;                // 7-bit device address
+  uint16_t flags;               // I2C_FLAG_WRITE, I2C_FLAG_READ, ...
+  uint8_t *write_data;
+  size_t write_len;
+  uint8_t *read_data;
+  size_t read_len;
+  i2c_job_callback_t callback;  // may be NULL
+  void *ctx;                    // passed back to the callback
+}i2c_job_t;
+
+
+/**
+ * @brief Route I2C0 to the given pins. I2CSPM_Init() is skipped when
+ * I2C0 is already on the requested route.
+ * @param route: the pin route to select.
+ */
+void i2c_queue_select_route(i2c_route_t route);
+
+/**
+ * @brief Submit a job. The job is copied into the queue and started at
+ * once if the bus is idle.
+ * @param job: the job to submit.
+ * @return true if the job was queued, false if the queue is full.
+ */
+bool i2c_queue_submit(const i2c_job_t *job);
+
+/**
+ * @brief Drive the queue from the scheduler context. Finished jobs are
+ * either retried or reported to their callback, and the next job is
+ * started.
+ * @param extsignals: the external signals of the current wakeup.
+ * @return the I2C event bits handled by the queue.
+ */
+uint32_t i2c_queue_process(uint32_t extsignals);
+
+/**
+ * @brief Advance the running transfer, called from I2C0_IRQHandler().
+ * The scheduler is signalled once the transfer has finished.
+ */
+void i2c_queue_irq_handler();
+
+/**
+ * @brief Check whether the queue has no running or pending job.
+ * @return true if the queue is idle.
+ */
+bool i2c_queue_is_idle();
+
+#endif // __I2C_QUEUE_H__
@@ -16,10 +16,13 @@
 #include "scheduler.h"
 #include "app.h"
 #include "em_i2c.h"
+#include "i2c_queue.h"
 #include "timers.h"
+#include "swtimer.h"
 #include "em_adc.h"
+#include "em_core.h"
 
-#define INCLUDE_LOG_DEBUG 1
+#define LOG_LEVEL LOG_LEVEL_INFO
 #include "src/log.h"
 
 static uint32_t uf_counter = 0;
@@ -76,20 +79,20 @@ void LETIMER0_IRQHandler(void)
   //find the source of interrupts
   uint32_t flags = LETIMER_IntGetEnabled(LETIMER0);
 
-  //set the underflow event if UF flag is set
+  //clear flags first, letimerTicks() counts a pending UF as elapsed
+  LETIMER_IntClear(LETIMER0, flags);
+
+  //count the periods for the timestamps
   if(flags & LETIMER_IF_UF){
       uf_counter++;
-      schedulerSetEventLE0_UF();
   }
 
-  //set the COMP1 event if COMP1 flag is set
-  if(flags & LETIMER_IF_COMP1){
-      schedulerSetEventLE0_COMP1();
+  //COMP1 is the alarm of the software timers, and every UF starts a
+  //period in which the next software timer may expire
+  if(flags & (LETIMER_IF_UF | LETIMER_IF_COMP1)){
+      swtimer_irq_handler();
   }
 
-  //clear flags
-  LETIMER_IntClear(LETIMER0, flags);
-
 } //LETIMER0_IRQHandler
 
 
@@ -102,20 +105,8 @@ void LETIMER0_IRQHandler(void)
 void I2C0_IRQHandler(void)
 {
   uint32_t flags = I2C_IntGetEnabled(I2C0);
-  I2C_TransferReturn_TypeDef transerStatus;
-  //get the transfer status
-  transerStatus = I2C_Transfer(I2C0);
-
-  switch(transerStatus){
-    case i2cTransferDone:
-      schedulerSetEventI2C0TranDone();
-      break;
-    case i2cTransferNack:
-      schedulerSetEventI2C0TranNACK();
-      break;
-    default:
-      break;
-  }
+  //advance the transfer of the running I2C job
+  i2c_queue_irq_handler();
 
   I2C_IntClear(I2C0,flags);
 } //I2C0_IRQHandler
@@ -185,12 +176,52 @@ void ADC0_IRQHandler(void)
 
 
 
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Number of LETIMER0 ticks since the program start, without wrapping.
+// ---------------------------------------------------------------------
+static uint64_t letimer_ticks64()
+{
+  // the counter runs from TOP down to 0, so a period is TOP + 1 ticks
+  uint32_t top = getLETIMER0TOP();
+  uint32_t periods, count;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  periods = uf_counter;
+  count = LETIMER_CounterGet(LETIMER0);
+  if(LETIMER_IntGet(LETIMER0) & LETIMER_IF_UF){
+      // the counter may have reloaded after the first read
+      count = LETIMER_CounterGet(LETIMER0);
+      periods++;
+  }
+  CORE_EXIT_CRITICAL();
+
+  return ((uint64_t)periods * (top + 1)) + (top - count);
+}
+
+/**
+ * @brief This function returns the number of LETIMER0 ticks since the
+ * program start. A UF that is pending but not yet handled is counted, so
+ * the value never goes backwards.
+ * @return the tick count, wraps around after 2^32 ticks.
+ */
+uint32_t letimerTicks()
+{
+  return (uint32_t)letimer_ticks64();
+}
+
 /**
  * @brief This function computes the timestamp value since the program start.
+ * It counts the same ticks as letimerTicks().
  * @return the accumulated timestamp value
  */
 uint32_t letimerMilliseconds()
 {
-  uint32_t elapsed_partial_ticks = getLETIMER0TOP() - LETIMER_CounterGet(LETIMER0);
-  return ((uf_counter * LETIMER_PERIOD_MS) + elapsed_partial_ticks);
+  uint32_t freq = letimerTickFrequency();
+
+  // LETIMER0 is not running yet
+  if(freq == 0)
+    return 0;
+  return (uint32_t)((letimer_ticks64() * 1000) / freq);
 }
@@ -44,6 +44,14 @@ void GPIO_EVEN_IRQHandler(void);
  */
 uint32_t letimerMilliseconds();
 
+/**
+ * @brief This function returns the number of LETIMER0 ticks since the
+ * program start. A UF that is pending but not yet handled is counted, so
+ * the value never goes backwards.
+ * @return the tick count, wraps around after 2^32 ticks.
+ */
+uint32_t letimerTicks();
+
 
 /**
  * @brief This function overwrites the weak version of ADC0_IRQHandler
@@ -55,26 +55,20 @@
 #include "ble_device_type.h"
 #include "glib.h" // the low-level graphics driver/library
 #include "dmd.h"  // the dot matrix display driver
+#include "font_narrow_6x8_packed.h" // generated by tools/gen_packed_font.py
 
 
 #include "lcd.h"
+#include "fmt.h"
 #include "gpio.h"
+#include "scheduler.h"
 
 
 // Include logging specifically for this .c file
-#define INCLUDE_LOG_DEBUG 1
+#define LOG_LEVEL LOG_LEVEL_WARN
 #include "log.h"
 
 
-#define SOFTTIMER_ONE_SECOND_TICKS     (32768)
-#define LCD_SERVICE_TIMER_HANDLE       (4)
-
-uint8_t getLCDServiceTimerHandle()
-{
-  return LCD_SERVICE_TIMER_HANDLE;
-}
-
-
 /**
  * A global structure containing information about the data we want to
  * display on a given LCD display
@@ -89,6 +83,19 @@ struct display_data {
 	// GLIB_Context required for use with GLIB_ functions
 	GLIB_Context_t           glibContext;
 
+  // the string currently shown on every row, used to skip identical writes
+  char                     row_shadow[DISPLAY_NUMBER_OF_ROWS][DISPLAY_ROW_LEN+1];
+
+  // number of displayPrintf() calls that redrew a row and that were skipped
+  uint32_t                 updates_performed;
+  uint32_t                 updates_suppressed;
+
+  // set when rows have been drawn into the frame buffer but not sent yet
+  bool                     frame_dirty;
+
+  // set while an asynchronous update is being sent, cleared by its callback
+  volatile bool            flush_busy;
+
 };
 
 
@@ -119,11 +126,17 @@ static struct display_data         *displayGetData() {
  *    Example:
  *       displayPrintf(DISPLAY_ROW_TEMPVALUE, "Temp=%d", temp);
  *
- *    The implementation always erases a row first before drawing the
- *    string passed in. This is done so that all pixels from the previously
- *    displayed text will be erased.
+ *    The implementation always clears the whole row while drawing the
+ *    string passed in, in a single pass over the frame buffer. This is done
+ *    so that all pixels from the previously displayed text will be erased.
  *    To erase a row, pass in a format string of either "" or " ".
  *
+ *    If the formatted string is identical to the one already shown on the
+ *    row, nothing is drawn and the LCD is not updated.
+ *
+ *    With DISPLAY_DEFERRED_FLUSH the row is only drawn into the frame
+ *    buffer, and the LCD is updated by the next displayFlush().
+ *
  *    Row indexes >= DISPLAY_NUMBER_OF_ROWS will throw a LOG_ERROR() msg and
  *    return.
  *    Format strings that expand to more than DISPLAY_ROW_LEN characters will
@@ -141,7 +154,6 @@ void displayPrintf(enum display_row row, const char *format, ...)
    struct display_data    *display = displayGetData();
    size_t                 strLen;
    char                   strToDisplay[DISPLAY_ROW_LEN+1]; // +1 for null terminator
-   char                   strToErase[DISPLAY_ROW_LEN+1];   // +1 for null terminator
 
    // Range check the row number
    if (row >= DISPLAY_NUMBER_OF_ROWS) {
@@ -161,7 +173,7 @@ void displayPrintf(enum display_row row, const char *format, ...)
    //            And we have to use the "v" versions as these are designed to
    //            accept the variadic (variable length) argument list.
    va_start(va, format);  // initialize the list with args after format
-   strLen = vsnprintf(strToDisplay, DISPLAY_ROW_LEN+1, format, va);
+   strLen = fmt_vsnprintf(strToDisplay, DISPLAY_ROW_LEN+1, format, va);
    // strLen represents the number of characters in the string after substitution,
    // including the null terminator, not the number of characters copied to strToDisplay
    va_end(va);
@@ -181,53 +193,156 @@ void displayPrintf(enum display_row row, const char *format, ...)
          // For feedback to the user, we don't count the null terminator char, so
          // DISPLAY_ROW_LEN and not DISPLAY_ROW_LEN+1
          LOG_WARN("Your formatted string for row=%d was truncated to (%d) characters", row, DISPLAY_ROW_LEN);
-         LOG_WARN("  The truncated string is: %s", strToDisplay);
+         LOG_WARN_TEXT("  The truncated string is: %s", strToDisplay);
      } // if
    } // else
 
 
-   // We always erase the whole line first, then draw the new string. This way
-   // we don't leave any pixels set from the previous characters.
-   for (int i=0; i<DISPLAY_ROW_LEN; i++) {
-       strToErase[i] = ' ';         // space
-   }
-   strToErase[DISPLAY_ROW_LEN] = 0; // null
-
-   // Erase the row
-   status = GLIB_drawStringOnLine(&display->glibContext,
-                                   &strToErase[0],
-                                   row,
-                                   GLIB_ALIGN_CENTER,
-                                   0,        // x offset
-                                   0,        // y offset
-                                   true);    // opaque
-   if (status != GLIB_OK) {
-       LOG_ERROR("Erase GLIB_drawStringOnLine() returned non-zero error code=0x%04x\r\n", (unsigned int) status);
+   // Skip the redraw and the LCD update if the row already shows this string
+   if (strcmp(display->row_shadow[row], strToDisplay) == 0) {
+       display->updates_suppressed++;
+       return;
    }
+   strcpy(display->row_shadow[row], strToDisplay);
+   display->updates_performed++;
 
 
-   // Draw the new string on the memory lcd display
-   status = GLIB_drawStringOnLine(&display->glibContext,
-                                  &strToDisplay[0],
-                                  row,
-                                  GLIB_ALIGN_CENTER,
-                                  0,        // x offset
-                                  0,        // y offset
-                                  true);    // opaque
+   // Draw the new string and clear the rest of the row in a single pass, so
+   // we don't leave any pixels set from the previous characters.
+   status = GLIB_drawStringOnClearedLine(&display->glibContext,
+                                         &strToDisplay[0],
+                                         row,
+                                         GLIB_ALIGN_CENTER,
+                                         0,        // x offset
+                                         0);       // y offset
    if (status != GLIB_OK) {
-       LOG_ERROR("Draw GLIB_drawStringOnLine() returned non-zero error code=0x%04x\r\n", (unsigned int) status);
+       LOG_ERROR("GLIB_drawStringOnClearedLine() returned non-zero error code=0x%04x\r\n", (unsigned int) status);
    }
 
 
+#if DISPLAY_DEFERRED_FLUSH
+   // Leave the LCD update to displayFlush()
+   display->frame_dirty = true;
+#else
    // Update the data the LCD is displaying
    status = DMD_updateDisplay();
    if (status != DMD_OK) {
        LOG_ERROR("DMD_updateDisplay() returned non-zero error code=0x%04x\r\n", (unsigned int) status);
    }
+#endif
 
 } // displayPrintf()
 
 
+#if DISPLAY_ASYNC_FLUSH
+/**
+ * Completion of an asynchronous LCD update, called from the LDMA interrupt.
+ * @param status: DMD_OK or the error of the transfer.
+ * @param ctx: not used.
+ */
+static void displayFlushDone(EMSTATUS status, void *ctx)
+{
+  struct display_data    *display = displayGetData();
+
+  (void) ctx;
+
+  // the DMD marks the rows of a failed transfer dirty again, resend them
+  if (status != DMD_OK) {
+      display->frame_dirty = true;
+  }
+  display->flush_busy = false;
+  // wake up the event loop to send the rows drawn during the transfer
+  schedulerSetEventDisplayDone();
+}
+#endif
+
+
+/**
+ * Send the rows drawn since the last flush to the LCD in a single
+ * DMD_updateDisplay() call. Only the dirty rows go out over SPI. This is
+ * a no-op if nothing has been drawn or DISPLAY_DEFERRED_FLUSH is 0.
+ *
+ * With DISPLAY_ASYNC_FLUSH the rows are sent by the LDMA and this function
+ * returns before the transfer has completed. While a transfer is running
+ * the new rows are kept for the flush of the evtDISPLAY_DONE event.
+ */
+void displayFlush()
+{
+  EMSTATUS               status;
+  struct display_data    *display = displayGetData();
+
+  if (!display->frame_dirty) {
+      return;
+  }
+
+#if DISPLAY_ASYNC_FLUSH
+  if (display->flush_busy) {
+      return;
+  }
+  display->frame_dirty = false;
+  display->flush_busy = true;
+
+  status = DMD_updateDisplayAsync(displayFlushDone, NULL);
+  if (status != DMD_OK) {
+      // the rows stay dirty in the DMD, retry with the next event
+      display->flush_busy = false;
+      display->frame_dirty = true;
+      LOG_ERROR("DMD_updateDisplayAsync() returned non-zero error code=0x%04x\r\n", (unsigned int) status);
+  }
+#else
+  display->frame_dirty = false;
+
+  // DMD_updateDisplay() only sends the rows marked dirty by the draws
+  status = DMD_updateDisplay();
+  if (status != DMD_OK) {
+      LOG_ERROR("DMD_updateDisplay() returned non-zero error code=0x%04x\r\n", (unsigned int) status);
+  }
+#endif
+
+} // displayFlush()
+
+
+
+
+/**
+ * Start drawing directly into the frame buffer, for widgets that do not
+ * fit the text rows. The rows first..last are treated as overwritten, so
+ * the next displayPrintf() to one of them redraws it.
+ * @param first the first text row covered by the drawing
+ * @param last the last text row covered by the drawing
+ * @return the GLIB context of the display
+ */
+GLIB_Context_t *displayBeginDraw(enum display_row first, enum display_row last)
+{
+  struct display_data    *display = displayGetData();
+  enum display_row       i;
+
+  // no formatted string is empty, so the next write to these rows redraws them
+  for (i=first; (i<=last) && (i<DISPLAY_NUMBER_OF_ROWS); i++) {
+      display->row_shadow[i][0] = 0;
+  }
+
+  return &display->glibContext;
+}
+
+
+/**
+ * Finish a drawing started with displayBeginDraw(). The drawn rows go out
+ * with the next displayFlush(), or at once if DISPLAY_DEFERRED_FLUSH is 0.
+ */
+void displayEndDraw()
+{
+#if DISPLAY_DEFERRED_FLUSH
+  displayGetData()->frame_dirty = true;
+#else
+  EMSTATUS status = DMD_updateDisplay();
+  if (status != DMD_OK) {
+      LOG_ERROR("DMD_updateDisplay() returned non-zero error code=0x%04x\r\n", (unsigned int) status);
+  }
+#endif
+}
+
+
 
 
 /**
@@ -245,6 +360,11 @@ void displayInit()
     memset(display,0,sizeof(struct display_data));
     display->last_extcomin_state_high = false;
 
+    // All rows are blank once the display has been cleared below
+    for (int i=0; i<DISPLAY_NUMBER_OF_ROWS; i++) {
+        strcpy(display->row_shadow[i], " ");
+    }
+
 
     // Edit #1
     // Students: If you created a function for A3, A4 and A5 that turns power on and
@@ -286,7 +406,7 @@ void displayInit()
 
 
     // Use Narrow font
-    status = GLIB_setFont(&display->glibContext, (GLIB_Font_t *) &GLIB_FontNarrow6x8);
+    status = GLIB_setFont(&display->glibContext, (GLIB_Font_t *) &GLIB_FontNarrow6x8Packed);
     if (status != GLIB_OK) {
         LOG_ERROR("GLIB_setFont() returned non-zero error code=0x%04x\r\n", (unsigned int) status);
     }
@@ -298,28 +418,9 @@ void displayInit()
     }
 
 
-	  // The BT stack implements timers that we can setup and then have the stack pass back
-	  // events when the timer expires.
-	  // This assignment has us using the Sharp LCD which needs to be serviced approx
-	  // every 1 second, in order to toggle the input "EXTCOMIN" input to the LCD display.
-	  // The documentation is a bit sketchy, but apparently charge can build up within
-	  // the LCD and it needs to be bled off. So toggling the EXTCOMIN input is the method by
-	  // which this takes place.
-	  // We will get a sl_bt_evt_system_soft_timer_id event as a result of calling
-	  // sl_bt_system_set_soft_timer() i.e. starting the timer.
-
-    // Edit #3
-    // Students: Figure out what parameters to pass in to sl_bt_system_set_soft_timer() to
-    //           set up a 1 second repeating soft timer and uncomment the following lines
-
-	  sl_status_t          timer_response;
-	  timer_response = sl_bt_system_set_soft_timer(SOFTTIMER_ONE_SECOND_TICKS, \
-	                                               LCD_SERVICE_TIMER_HANDLE, false);
-	  if (timer_response != SL_STATUS_OK) {
-	      LOG_ERROR("Failed to create a soft timer, error = %d\r\n", timer_response);
-     }
-
-
+	  // The Sharp LCD needs its EXTCOMIN input toggled approx every 1 second
+	  // to bleed off the charge that builds up within the LCD. The toggle is
+	  // one of the periodic tasks, see periodic.h.
 
 } // displayInit()
 
@@ -327,8 +428,8 @@ void displayInit()
 
 
 /**
- * Call this function from your event handler in response to sl_bt_evt_system_soft_timer_id
- * events to prevent charge buildup within the Liquid Crystal Cells.
+ * Called by the periodic EXTCOMIN task, in the ISR context, to prevent
+ * charge buildup within the Liquid Crystal Cells.
  * See details in https://www.silabs.com/documents/public/application-notes/AN0048.pdf
  */
 void displayUpdate()
@@ -348,6 +449,24 @@ void displayUpdate()
 } // displayUpdate()
 
 
+/**
+ * Obtain the number of displayPrintf() calls that redrew a row and the
+ * number of calls skipped because the row already showed the same string,
+ * counted since displayInit().
+ * @param performed the number of rows redrawn, may be NULL
+ * @param suppressed the number of identical writes skipped, may be NULL
+ */
+void displayGetStats(uint32_t *performed, uint32_t *suppressed)
+{
+  struct display_data *display = displayGetData();
+
+  if (performed)
+    *performed = display->updates_performed;
+  if (suppressed)
+    *suppressed = display->updates_suppressed;
+}
+
+
 /**
  * Set up the LCD display when the device is booted.
  * @param device_name the name of the device that displays the identity information
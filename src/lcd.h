@@ -26,6 +26,7 @@
 #ifndef SRC_LCD_H_
 #define SRC_LCD_H_
 
+#include "glib.h"
 
 
 
@@ -54,6 +55,16 @@ enum display_row {
 // The number of characters per row
 #define DISPLAY_ROW_LEN      20
 
+// Set to 1 to batch the row draws: displayPrintf() only draws into the
+// frame buffer and displayFlush() sends the dirty rows to the LCD once per
+// event. Set to 0 to update the LCD on every displayPrintf() call.
+#define DISPLAY_DEFERRED_FLUSH   (1)
+
+// Set to 1 to let displayFlush() hand the dirty rows to the LDMA and return
+// at once. The end of the transfer raises evtDISPLAY_DONE, and rows drawn
+// during the transfer are sent by the flush of that event.
+#define DISPLAY_ASYNC_FLUSH      (1)
+
 
 
 // function prototypes
@@ -61,6 +72,40 @@ enum display_row {
 void displayInit();
 void displayUpdate();
 void displayPrintf(enum display_row row, const char *format, ...);
+
+/**
+ * Obtain the number of displayPrintf() calls that redrew a row and the
+ * number of calls skipped because the row already showed the same string,
+ * counted since displayInit().
+ * @param performed the number of rows redrawn, may be NULL
+ * @param suppressed the number of identical writes skipped, may be NULL
+ */
+void displayGetStats(uint32_t *performed, uint32_t *suppressed);
+
+/**
+ * Send the rows drawn since the last flush to the LCD in a single
+ * DMD_updateDisplay() call. Only the dirty rows go out over SPI. This is
+ * a no-op if nothing has been drawn or DISPLAY_DEFERRED_FLUSH is 0.
+ * With DISPLAY_ASYNC_FLUSH the function returns before the rows are sent.
+ */
+void displayFlush();
+
+/**
+ * Start drawing directly into the frame buffer, for widgets that do not
+ * fit the text rows. The rows first..last are treated as overwritten, so
+ * the next displayPrintf() to one of them redraws it.
+ * @param first the first text row covered by the drawing
+ * @param last the last text row covered by the drawing
+ * @return the GLIB context of the display
+ */
+GLIB_Context_t *displayBeginDraw(enum display_row first, enum display_row last);
+
+/**
+ * Finish a drawing started with displayBeginDraw(). The drawn rows go out
+ * with the next displayFlush(), or at once if DISPLAY_DEFERRED_FLUSH is 0.
+ */
+void displayEndDraw();
+
 /**
  * Set up the LCD display when the device is booted.
  * @param device_name the name of the device that displays the identity information
@@ -71,6 +116,4 @@ void displayPrintf(enum display_row row, const char *format, ...);
 void setup_display(const char *device_name, uint8_t *addr, \
                    const char *assignment_name, const char *state);
 
-uint8_t getLCDServiceTimerHandle();
-
 #endif /* SRC_LCD_H_ */
@@ -17,9 +17,33 @@
 #include <stdbool.h>
 
 // Include logging for this file
-#define INCLUDE_LOG_DEBUG 1
+#define LOG_LEVEL LOG_LEVEL_ERROR
 #include "log.h"
 #include "irq.h"
+#include "fmt.h"
+#include "em_core.h"
+
+// longer log lines are truncated
+#define LOG_LINE_LEN       (128)
+
+// size of the binary log ring in 32-bit words
+#define LOG_RING_WORDS     (256)
+// LOG_DO() passes at most 3 + 12 arguments
+#define LOG_MAX_ARGS       (15)
+// first byte of every binary record sent by logDrain()
+#define LOG_SYNC_BYTE      (0xB1)
+// records sent per logDrain() call, so the BT stack is not held up
+#define LOG_DRAIN_RECORDS  (8)
+
+// A record is a header word, the format string address in bits 0..23 and
+// the number of arguments in bits 24..31, followed by the arguments. The
+// flash of the EFR32BG13 starts at 0 and is 512 kB, so 24 bits are enough.
+static uint32_t  log_ring[LOG_RING_WORDS];
+static uint32_t  log_wptr = 0;
+static uint32_t  log_rptr = 0;
+static uint32_t  log_dropped = 0;
+
+volatile uint8_t log_level_mask = LOG_MASK_ALL;
 
 
 /**
@@ -74,7 +98,8 @@ void printSLErrorString(sl_status_t status) {
   //   that only when this returned value is strictly positive and less than
   //   buffer_length, the status string has been completely written in the buffer.
   if ((result > 0) && (result < 128)) {
-      LOG_ERROR("Error code 0x%04x is %s", (unsigned int) status, &buffer[0] );
+      // the string is on the stack, so it is sent as text
+      LOG_ERROR_TEXT("Error code 0x%04x is %s", (unsigned int) status, &buffer[0] );
   } else {
       LOG_ERROR("Unable to convert error code 0x%04x into a string", (unsigned int) status);
   }
@@ -83,5 +108,170 @@ void printSLErrorString(sl_status_t status) {
 
 
 
+/**
+ * Format a log line with fmt_vsnprintf() and write it to the app_log stream.
+ * This takes far less stack and time than the newlib printf() used by
+ * app_log(). A line longer than LOG_LINE_LEN-1 characters is truncated and
+ * ends with a newline. With LOG_BINARY the binary records stored so far are
+ * sent first, so the text line comes out in order.
+ */
+void logPrintf(const char *format, ...)
+{
+#if defined(APP_LOG_ENABLE) && APP_LOG_ENABLE
+  char      line[LOG_LINE_LEN];
+  va_list   va;
+  int       len;
+
+#if LOG_BINARY
+  while (logPending()) {
+      logDrain();
+  }
+#endif
+
+  va_start(va, format);
+  len = fmt_vsnprintf(line, sizeof(line), format, va);
+  va_end(va);
+
+  if (len >= (int) sizeof(line)) {
+      len = sizeof(line) - 1;
+      line[len - 1] = '\n';
+  }
+
+  sl_iostream_write(app_log_iostream, line, len);
+#else
+  (void) format;
+#endif
+
+} // logPrintf()
+
+
+
+/**
+ * Store a log line in the binary log ring: the address of the format string
+ * and nargs raw 32-bit arguments. This is safe to call from an ISR and only
+ * takes a few tens of cycles. When the ring is full the line is dropped and
+ * counted, and logDrain() reports the count.
+ */
+void logBinary(const char *format, uint32_t nargs, ...)
+{
+  va_list   va;
+  uint32_t  used;
+
+  if (nargs > LOG_MAX_ARGS) {
+      nargs = LOG_MAX_ARGS;
+  }
+
+  va_start(va, nargs);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+
+  used = (log_wptr - log_rptr + LOG_RING_WORDS) % LOG_RING_WORDS;
+  if ((used + 1 + nargs) >= LOG_RING_WORDS) {
+      log_dropped++;
+  } else {
+      log_ring[log_wptr] = ((uint32_t) format & 0x00FFFFFF) | (nargs << 24);
+      log_wptr = (log_wptr + 1) % LOG_RING_WORDS;
+      while (nargs--) {
+          log_ring[log_wptr] = va_arg(va, uint32_t);
+          log_wptr = (log_wptr + 1) % LOG_RING_WORDS;
+      }
+  }
+
+  CORE_EXIT_CRITICAL();
+
+  va_end(va);
+
+} // logBinary()
+
+
 
+/**
+ * Check whether binary log records are waiting for logDrain().
+ */
+bool logPending(void)
+{
+  return (log_rptr != log_wptr) || (log_dropped != 0);
+
+} // logPending()
+
+
+
+/**
+ * Send up to LOG_DRAIN_RECORDS binary log records to the app_log stream.
+ * Each record goes out as LOG_SYNC_BYTE, the header word and the argument
+ * words, little endian. Dropped lines are reported by a record with a
+ * format address of 0 and the number of dropped lines as its argument.
+ */
+void logDrain(void)
+{
+  uint8_t   frame[1 + 4 * (1 + LOG_MAX_ARGS)];
+  uint32_t  words[1 + LOG_MAX_ARGS];
+  uint32_t  count, i;
+  int       records;
+
+  for (records = 0; records < LOG_DRAIN_RECORDS; records++) {
+
+      CORE_DECLARE_IRQ_STATE;
+      CORE_ENTER_CRITICAL();
+
+      if (log_rptr != log_wptr) {
+          words[0] = log_ring[log_rptr];
+          count = 1 + (words[0] >> 24);
+          for (i = 1; i < count; i++) {
+              words[i] = log_ring[(log_rptr + i) % LOG_RING_WORDS];
+          }
+          log_rptr = (log_rptr + count) % LOG_RING_WORDS;
+      } else if (log_dropped) {
+          words[0] = (1 << 24);
+          words[1] = log_dropped;
+          count = 2;
+          log_dropped = 0;
+      } else {
+          count = 0;
+      }
+
+      CORE_EXIT_CRITICAL();
+
+      if (count == 0) {
+          break;
+      }
+
+      frame[0] = LOG_SYNC_BYTE;
+      for (i = 0; i < count; i++) {
+          frame[1 + 4*i]     = (uint8_t) (words[i]);
+          frame[1 + 4*i + 1] = (uint8_t) (words[i] >> 8);
+          frame[1 + 4*i + 2] = (uint8_t) (words[i] >> 16);
+          frame[1 + 4*i + 3] = (uint8_t) (words[i] >> 24);
+      }
+
+#if defined(APP_LOG_ENABLE) && APP_LOG_ENABLE
+      sl_iostream_write(app_log_iostream, frame, 1 + 4*count);
+#endif
+  }
+
+} // logDrain()
+
+
+
+/**
+ * Select the levels to log at run time, a combination of LOG_MASK() bits.
+ * Levels removed at compile time by LOG_LEVEL or LOG_LEVEL_MAX stay off
+ * whatever the mask.
+ */
+void logSetLevelMask(uint8_t mask)
+{
+  log_level_mask = mask;
+
+} // logSetLevelMask()
+
+
+
+/**
+ * @return the levels currently logged, a combination of LOG_MASK() bits.
+ */
+uint8_t logGetLevelMask(void)
+{
+  return log_level_mask;
 
+} // logGetLevelMask()
@@ -16,45 +16,161 @@
 #define SRC_LOG_H_
 #include "stdio.h"
 #include <inttypes.h>
+#include <stdbool.h>
 
 #include "app_log.h"   // for LOG_INFO() / printf() / app_log() output the VCOM port
 #include "sl_status.h" // for sl_status_print()
 
 
+// Log levels. A module keeps the levels up to LOG_LEVEL, which it defines
+// before including this file:
+//     #define LOG_LEVEL LOG_LEVEL_WARN
+//     #include "src/log.h"
+// The LOG_xxx() calls of the other levels expand to nothing, so neither
+// their format strings nor their arguments end up in the image. Modules
+// that define INCLUDE_LOG_DEBUG 1 instead keep all the levels.
+#define LOG_LEVEL_NONE     (0)
+#define LOG_LEVEL_ERROR    (1)
+#define LOG_LEVEL_WARN     (2)
+#define LOG_LEVEL_INFO     (3)
+#define LOG_LEVEL_DEBUG    (4)
+
+// Cap on the level of every module, e.g. LOG_LEVEL_ERROR for a production
+// build that keeps the error messages only.
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX      LOG_LEVEL_DEBUG
+#endif
+
+#ifndef LOG_LEVEL
+#if INCLUDE_LOG_DEBUG
+#define LOG_LEVEL          LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL          LOG_LEVEL_NONE
+#endif
+#endif
+
+// True if the calls of a level are compiled in this module, for use in #if
+// around code that only prepares log arguments
+#define LOG_ENABLED(level) ((LOG_LEVEL >= (level)) && (LOG_LEVEL_MAX >= (level)))
+
+// Bit of a level in the runtime mask, see logSetLevelMask()
+#define LOG_MASK(level)    (1U << (level))
+#define LOG_MASK_ALL       (LOG_MASK(LOG_LEVEL_ERROR) | LOG_MASK(LOG_LEVEL_WARN) | \
+                            LOG_MASK(LOG_LEVEL_INFO) | LOG_MASK(LOG_LEVEL_DEBUG))
+
+
 #ifndef LOG_ERROR
+#if LOG_ENABLED(LOG_LEVEL_ERROR)
 #define LOG_ERROR(message,...) \
-	LOG_DO(message,"Error", ##__VA_ARGS__)
+	LOG_DO(LOG_LEVEL_ERROR,message,"Error", ##__VA_ARGS__)
+#else
+#define LOG_ERROR(message,...)  do {} while (0)
+#endif
 #endif
 
 #ifndef LOG_WARN
+#if LOG_ENABLED(LOG_LEVEL_WARN)
 #define LOG_WARN(message,...) \
-	LOG_DO(message,"Warn ", ##__VA_ARGS__)
+	LOG_DO(LOG_LEVEL_WARN,message,"Warn ", ##__VA_ARGS__)
+#else
+#define LOG_WARN(message,...)   do {} while (0)
+#endif
 #endif
 
 #ifndef LOG_INFO
+#if LOG_ENABLED(LOG_LEVEL_INFO)
 #define LOG_INFO(message,...) \
-	LOG_DO(message,"Info ", ##__VA_ARGS__)
+	LOG_DO(LOG_LEVEL_INFO,message,"Info ", ##__VA_ARGS__)
+#else
+#define LOG_INFO(message,...)   do {} while (0)
+#endif
 #endif
 
+#ifndef LOG_DEBUG
+#if LOG_ENABLED(LOG_LEVEL_DEBUG)
+#define LOG_DEBUG(message,...) \
+	LOG_DO(LOG_LEVEL_DEBUG,message,"Debug", ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(message,...)  do {} while (0)
+#endif
+#endif
 
 
-// File by file logging control
-#if INCLUDE_LOG_DEBUG
 
-#define LOG_DO(message,level, ...) \
-  app_log( "%5"PRIu32":%s:%s: " message "\n", loggerGetTimestamp(), level, __func__, ##__VA_ARGS__ )
-uint32_t loggerGetTimestamp (void);
-void     printSLErrorString (sl_status_t status);
+// Set to 1 to store each log line as the address of its format string plus
+// its raw arguments in a RAM ring, which logDrain() sends over VCOM from the
+// main loop. tools/log_decode.py turns the output back into text with the
+// help of the .axf file. %s arguments are only decoded if they point into
+// flash, see LOG_ERROR_TEXT() for the lines with strings in RAM. Set to 0
+// to format and send every log line at once.
+#ifndef LOG_BINARY
+#define LOG_BINARY         (1)
+#endif
+
+// Levels compiled in that are currently logged, read directly by LOG_DO()
+// to keep the check cheap. Change it with logSetLevelMask().
+extern volatile uint8_t log_level_mask;
+
+#if LOG_BINARY
+
+// the number of arguments passed to LOG_DO(), up to 12
+#define LOG_NARGS(...) \
+  LOG_NARGS_(0, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, N, ...) N
+
+// the timestamp, the level and the function name come first
+#define LOG_DO(lvl,message,level, ...) \
+  do { \
+    if (log_level_mask & LOG_MASK(lvl)) \
+      logBinary( "%5"PRIu32":%s:%s: " message "\n", LOG_NARGS(__VA_ARGS__) + 3, \
+                 loggerGetTimestamp(), level, __func__, ##__VA_ARGS__ ); \
+  } while (0)
 
 #else
 
-/*
- * Remove all logging related code where logging is not enabled
- */
-//#define LOG_DO(message,level, ...)
-static inline void LOG_DO() {}
+#define LOG_DO(lvl,message,level, ...) \
+  LOG_DO_TEXT(lvl,message,level, ##__VA_ARGS__)
+
+#endif // LOG_BINARY
+
+// formatted with fmt_vsnprintf() rather than the newlib printf() behind app_log()
+#define LOG_DO_TEXT(lvl,message,level, ...) \
+  do { \
+    if (log_level_mask & LOG_MASK(lvl)) \
+      logPrintf( "%5"PRIu32":%s:%s: " message "\n", loggerGetTimestamp(), level, __func__, ##__VA_ARGS__ ); \
+  } while (0)
+
+// Like LOG_ERROR() and LOG_WARN(), but the line is formatted and sent at once
+// even with LOG_BINARY. Use them for lines with %s arguments in RAM, e.g. a
+// stack buffer: a binary record only keeps the address of the string, which
+// tools/log_decode.py cannot turn back into the text. Not for use in ISRs.
+#if LOG_ENABLED(LOG_LEVEL_ERROR)
+#define LOG_ERROR_TEXT(message,...) \
+	LOG_DO_TEXT(LOG_LEVEL_ERROR,message,"Error", ##__VA_ARGS__)
+#else
+#define LOG_ERROR_TEXT(message,...)  do {} while (0)
+#endif
+
+#if LOG_ENABLED(LOG_LEVEL_WARN)
+#define LOG_WARN_TEXT(message,...) \
+	LOG_DO_TEXT(LOG_LEVEL_WARN,message,"Warn ", ##__VA_ARGS__)
+#else
+#define LOG_WARN_TEXT(message,...)   do {} while (0)
+#endif
+
+uint32_t loggerGetTimestamp (void);
+void     printSLErrorString (sl_status_t status);
+void     logPrintf (const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+void     logBinary (const char *format, uint32_t nargs, ...) __attribute__ ((format (printf, 1, 3)));
 
-#endif // #else
+// Send the binary log records stored so far, called from the main loop.
+void     logDrain (void);
+// Check whether binary log records are waiting for logDrain().
+bool     logPending (void);
+// Select the levels to log at run time, a combination of LOG_MASK() bits.
+// Levels removed at compile time stay off whatever the mask.
+void     logSetLevelMask (uint8_t mask);
+uint8_t  logGetLevelMask (void);
 
 
 #endif /* SRC_LOG_H_ */
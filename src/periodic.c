@@ -0,0 +1,172 @@
+/**
+ * @file periodic.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the periodic tasks.
+ * The tasks are run from the sleeptimer callback, i.e. in the ISR
+ * context, so they only raise scheduler events or toggle a pin.
+ * @version 0.1
+ * @date 2022-04-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stddef.h>
+#include "periodic.h"
+#include "sl_sleeptimer.h"
+#include "app.h"
+#include "lcd.h"
+#include "scheduler.h"
+
+#define LOG_LEVEL LOG_LEVEL_ERROR
+#include "src/log.h"
+
+#if (PERIODIC_SLACK_MS * 2) >= EXTCOMIN_PERIOD_MS
+#error "PERIODIC_SLACK_MS must be below half of the shortest period"
+#endif
+
+/**
+ * Schedule of one periodic task
+ */
+typedef struct {
+  uint32_t period_ms;
+  void (*run)();             // called in the ISR context
+  uint32_t periods;          // periods elapsed since the start tick
+  uint32_t due;              // tick count of the next run
+  uint32_t runs;
+}periodic_entry_t;
+
+static periodic_entry_t tasks[PERIODIC_NUM_TASKS] = {
+  [PERIODIC_MEASUREMENT] = {
+      .period_ms = MEASUREMENT_PERIOD_MS,
+      .run       = schedulerSetEventMeasureTick
+  },
+  [PERIODIC_EXTCOMIN] = {
+      .period_ms = EXTCOMIN_PERIOD_MS,
+      .run       = displayUpdate
+  },
+  [PERIODIC_SLEEP_HOUR] = {
+      .period_ms = SLEEP_HOUR_PERIOD_MS,
+      .run       = schedulerSetEventSleepHourTick
+  }
+};
+
+static sl_sleeptimer_timer_handle_t periodic_timer;
+static uint32_t start_tick;
+static uint32_t slack_ticks;
+static uint32_t wakeups = 0;
+
+static void periodic_expired(sl_sleeptimer_timer_handle_t *handle, void *data);
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Compute the next due tick of a task from the start tick.
+// ---------------------------------------------------------------------
+static void compute_due(periodic_entry_t *task)
+{
+  uint64_t ms = (uint64_t)(task->periods + 1) * task->period_ms;
+
+  task->due = start_tick + \
+              (uint32_t)((ms * sl_sleeptimer_get_timer_frequency()) / 1000);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Start the timer for the task due first.
+// ---------------------------------------------------------------------
+static void start_timer(uint32_t now)
+{
+  int32_t  wait = INT32_MAX;
+  int32_t  task_wait;
+  sl_status_t sc;
+  int i;
+
+  for(i=0;i<PERIODIC_NUM_TASKS;i++){
+      task_wait = (int32_t)(tasks[i].due - now);
+      if(task_wait < wait)
+        wait = task_wait;
+  }
+  if(wait < 1)
+    wait = 1;
+
+  sc = sl_sleeptimer_start_timer(&periodic_timer, (uint32_t)wait, \
+                                 periodic_expired, NULL, 0, 0);
+  if(sc != SL_STATUS_OK){
+      LOG_ERROR("Failed to start the periodic timer, rc = 0x%x\r\n", (unsigned int)sc);
+  }
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Sleeptimer callback, runs every task due within the slack window.
+// ---------------------------------------------------------------------
+static void periodic_expired(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+  int i;
+
+  (void)handle;
+  (void)data;
+
+  wakeups++;
+
+  for(i=0;i<PERIODIC_NUM_TASKS;i++){
+      periodic_entry_t *task = &tasks[i];
+
+      if((int32_t)(task->due - now) > (int32_t)slack_ticks)
+        continue;
+
+      task->run();
+      task->runs++;
+
+      // periods missed while the MCU was busy are skipped
+      do{
+          task->periods++;
+          compute_due(task);
+      }while((int32_t)(task->due - now) <= 0);
+  }
+
+  start_timer(now);
+}
+
+/**
+ * @brief Start all periodic tasks. The first run of a task is one
+ * period later.
+ */
+void periodic_init()
+{
+  int i;
+
+  start_tick = sl_sleeptimer_get_tick_count();
+  slack_ticks = sl_sleeptimer_ms_to_tick(PERIODIC_SLACK_MS);
+
+  for(i=0;i<PERIODIC_NUM_TASKS;i++){
+      tasks[i].periods = 0;
+      tasks[i].runs = 0;
+      compute_due(&tasks[i]);
+  }
+
+  start_timer(start_tick);
+}
+
+/**
+ * @brief Obtain the number of times the timer woke the MCU.
+ * @return the number of timer expiries.
+ */
+uint32_t periodic_get_wakeups()
+{
+  return wakeups;
+}
+
+/**
+ * @brief Obtain the number of runs of a task. The runs of all tasks
+ * minus the wakeups is the number of wakeups saved by coalescing.
+ * @param task: the task.
+ * @return the number of runs.
+ */
+uint32_t periodic_get_runs(periodic_task_t task)
+{
+  if(task >= PERIODIC_NUM_TASKS)
+    return 0;
+  return tasks[task].runs;
+}
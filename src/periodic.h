@@ -0,0 +1,59 @@
+/**
+ * @file periodic.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the periodic tasks of
+ * the application: the measurement tick, the LCD EXTCOMIN toggle and the
+ * sleep hours countdown. All of them run on one sl_sleeptimer timer.
+ *
+ * When the timer expires, every task due within PERIODIC_SLACK_MS of the
+ * expiry runs early instead of waking the MCU again a moment later. A
+ * task running early does not move its schedule: every due time is
+ * computed from the start tick and the number of periods, so the tasks
+ * neither drift nor lose phase against each other.
+ *
+ * The periods and the slack are set in app.h. The slack must be below
+ * half of the shortest period.
+ * @version 0.1
+ * @date 2022-04-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __PERIODIC_H__
+#define __PERIODIC_H__
+
+#include <stdint.h>
+
+/**
+ * Periodic tasks
+ */
+typedef enum {
+  PERIODIC_MEASUREMENT = 0,  //!< sets evtMEASURE_TICK
+  PERIODIC_EXTCOMIN,         //!< toggles the LCD EXTCOMIN pin
+  PERIODIC_SLEEP_HOUR,       //!< sets evtSLEEP_HOUR_TICK
+  PERIODIC_NUM_TASKS         //!< PERIODIC_NUM_TASKS
+}periodic_task_t;
+
+
+/**
+ * @brief Start all periodic tasks. The first run of a task is one
+ * period later.
+ */
+void periodic_init();
+
+/**
+ * @brief Obtain the number of times the timer woke the MCU.
+ * @return the number of timer expiries.
+ */
+uint32_t periodic_get_wakeups();
+
+/**
+ * @brief Obtain the number of runs of a task. The runs of all tasks
+ * minus the wakeups is the number of wakeups saved by coalescing.
+ * @param task: the task.
+ * @return the number of runs.
+ */
+uint32_t periodic_get_runs(periodic_task_t task);
+
+#endif // __PERIODIC_H__
@@ -0,0 +1,320 @@
+/**
+ * @file profiler.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the event-loop profiler.
+ * Entries live in a small table that is searched linearly, since only a
+ * few dozen (kind, id) pairs are ever seen. All recording happens in the
+ * main loop, so the table needs no critical section.
+ * @version 0.1
+ * @date 2022-04-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "profiler.h"
+
+#if PROFILER_ENABLE
+
+#include <stdbool.h>
+#include "app_log.h"
+
+#if defined(__arm__)
+#include "em_device.h"
+#if defined(SL_COMPONENT_CATALOG_PRESENT)
+#include "sl_component_catalog.h"
+#endif
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+#include "sl_power_manager.h"
+#endif
+#else
+#include <time.h>
+// the host clock counts nanoseconds
+#define PROFILER_HOST_CYCLE_HZ      (1000000000UL)
+#endif
+
+#define LOG_LEVEL LOG_LEVEL_INFO
+#include "src/log.h"
+
+/**
+ * Statistics of one (kind, id) pair
+ */
+typedef struct {
+  uint32_t id;
+  uint8_t  kind;                          // 0 if the entry is free
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint16_t histogram[PROFILER_NUM_BUCKETS];
+}prof_entry_t;
+
+static prof_entry_t prof_entries[PROFILER_MAX_ENTRIES];
+static uint32_t prof_num_entries = 0;
+static uint32_t prof_dropped = 0;
+static uint32_t prof_wakeups = 0;
+// cycle count and energy mode of the last wakeup, set by the power manager
+static uint32_t prof_wake_start;
+static uint32_t prof_wake_from;
+static bool     prof_wake_pending = false;
+
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+
+static void profiler_on_em_transition(sl_power_manager_em_t from, \
+                                      sl_power_manager_em_t to);
+
+static sl_power_manager_em_transition_event_handle_t prof_em_handle;
+static sl_power_manager_em_transition_event_info_t prof_em_info = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0,
+  .on_event   = profiler_on_em_transition
+};
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Power manager callback, stamp the wakeup out of EM1 or below.
+// ---------------------------------------------------------------------
+static void profiler_on_em_transition(sl_power_manager_em_t from, \
+                                      sl_power_manager_em_t to)
+{
+  (void)to;
+
+  prof_wake_start = profiler_cycles();
+  prof_wake_from = (uint32_t)from;
+  prof_wake_pending = true;
+  prof_wakeups++;
+}
+
+#endif // defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Histogram bucket of a duration, see the bucket layout in profiler.h.
+// ---------------------------------------------------------------------
+static uint32_t profiler_bucket(uint32_t cycles)
+{
+  uint32_t bits = cycles ? (32 - (uint32_t)__builtin_clz(cycles)) : 0;
+
+  if(bits <= PROFILER_BUCKET_SHIFT)
+    return 0;
+  bits -= PROFILER_BUCKET_SHIFT;
+  return (bits < PROFILER_NUM_BUCKETS) ? bits : (PROFILER_NUM_BUCKETS - 1);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Append a little-endian value of len bytes.
+// ---------------------------------------------------------------------
+static uint8_t *put_le(uint8_t *p, uint64_t value, uint32_t len)
+{
+  while(len--){
+      *p++ = (uint8_t)value;
+      value >>= 8;
+  }
+  return p;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Serialize the blob header into PROFILER_HEADER_LEN bytes.
+// ---------------------------------------------------------------------
+static void profiler_put_header(uint8_t *p, uint32_t entries)
+{
+#if defined(__arm__)
+  uint32_t cycle_hz = SystemCoreClockGet();
+#else
+  uint32_t cycle_hz = PROFILER_HOST_CYCLE_HZ;
+#endif
+
+  memcpy(p, PROFILER_MAGIC, 4);
+  p += 4;
+  *p++ = PROFILER_FORMAT_VERSION;
+  *p++ = (uint8_t)entries;
+  *p++ = PROFILER_NUM_BUCKETS;
+  *p++ = PROFILER_BUCKET_SHIFT;
+  p = put_le(p, cycle_hz, 4);
+  p = put_le(p, prof_wakeups, 4);
+  put_le(p, prof_dropped, 4);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Serialize one entry into PROFILER_ENTRY_LEN bytes.
+// ---------------------------------------------------------------------
+static void profiler_put_entry(uint8_t *p, const prof_entry_t *e)
+{
+  int i;
+
+  *p++ = e->kind;
+  p = put_le(p, e->id, 4);
+  p = put_le(p, e->count, 4);
+  p = put_le(p, e->min, 4);
+  p = put_le(p, e->max, 4);
+  p = put_le(p, e->sum, 8);
+  for(i=0;i<PROFILER_NUM_BUCKETS;i++)
+    p = put_le(p, e->histogram[i], 2);
+}
+
+/**
+ * @brief Start the cycle counter, clear all entries and subscribe to the
+ * wakeups of the power manager.
+ */
+void profiler_init()
+{
+#if defined(__arm__)
+  // the DWT is only clocked while trace is enabled
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+  profiler_reset();
+
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+  sl_power_manager_subscribe_em_transition_event(&prof_em_handle, &prof_em_info);
+#endif
+}
+
+/**
+ * @brief Clear all entries.
+ */
+void profiler_reset()
+{
+  memset(prof_entries, 0, sizeof(prof_entries));
+  prof_num_entries = 0;
+  prof_dropped = 0;
+  prof_wakeups = 0;
+  prof_wake_pending = false;
+}
+
+/**
+ * @brief Read the free running cycle counter.
+ * @return the current cycle count.
+ */
+uint32_t profiler_cycles()
+{
+#if defined(__arm__)
+  return DWT->CYCCNT;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((ts.tv_sec * PROFILER_HOST_CYCLE_HZ) + ts.tv_nsec);
+#endif
+}
+
+/**
+ * @brief Add one duration to the entry of a (kind, id) pair. New pairs
+ * are dropped and counted once all entries are in use.
+ * @param kind: what the id refers to.
+ * @param id: the BT message ID or the state.
+ * @param start: the profiler_cycles() value at the start of the
+ * measured code.
+ */
+void profiler_record(prof_kind_t kind, uint32_t id, uint32_t start)
+{
+  // unsigned subtraction handles the wrap of the counter
+  uint32_t cycles = profiler_cycles() - start;
+  prof_entry_t *e;
+  uint32_t i;
+
+  for(i=0;i<prof_num_entries;i++){
+      if((prof_entries[i].kind == kind) && (prof_entries[i].id == id))
+        break;
+  }
+
+  if(i == prof_num_entries){
+      if(prof_num_entries == PROFILER_MAX_ENTRIES){
+          prof_dropped++;
+          return;
+      }
+      prof_entries[i].kind = (uint8_t)kind;
+      prof_entries[i].id = id;
+      prof_entries[i].min = UINT32_MAX;
+      prof_num_entries++;
+  }
+
+  e = &prof_entries[i];
+  e->count++;
+  e->sum += cycles;
+  if(cycles < e->min)
+    e->min = cycles;
+  if(cycles > e->max)
+    e->max = cycles;
+
+  i = profiler_bucket(cycles);
+  // saturate rather than wrap
+  if(e->histogram[i] != UINT16_MAX)
+    e->histogram[i]++;
+}
+
+/**
+ * @brief Record the time since the last wakeup, if the CPU has woken up
+ * since the previous call. Called at the start of sl_bt_on_event().
+ */
+void profiler_record_wakeup()
+{
+  if(!prof_wake_pending)
+    return;
+
+  prof_wake_pending = false;
+  profiler_record(PROF_KIND_WAKEUP, prof_wake_from, prof_wake_start);
+}
+
+/**
+ * @brief Serialize the entries into a blob, see the format above.
+ * @param buf: the output buffer.
+ * @param size: the size of the output buffer, PROFILER_BLOB_MAX_LEN
+ * bytes always fit all entries.
+ * @return the number of bytes written, entries that do not fit are
+ * left out.
+ */
+uint32_t profiler_get_blob(uint8_t *buf, uint32_t size)
+{
+  uint32_t entries, i;
+
+  if(size < PROFILER_HEADER_LEN)
+    return 0;
+
+  entries = (size - PROFILER_HEADER_LEN) / PROFILER_ENTRY_LEN;
+  if(entries > prof_num_entries)
+    entries = prof_num_entries;
+
+  profiler_put_header(buf, entries);
+  for(i=0;i<entries;i++){
+      profiler_put_entry(&buf[PROFILER_HEADER_LEN + (i * PROFILER_ENTRY_LEN)], \
+                         &prof_entries[i]);
+  }
+
+  return PROFILER_HEADER_LEN + (entries * PROFILER_ENTRY_LEN);
+}
+
+/**
+ * @brief Dump the blob as hex over VCOM.
+ */
+void profiler_dump()
+{
+  uint8_t  rec[PROFILER_ENTRY_LEN];
+  uint32_t i, j;
+
+  LOG_INFO("profiler: %u entries, %u dropped\r\n", \
+           (unsigned int)prof_num_entries, (unsigned int)prof_dropped);
+
+  // one line for the header, then one line per entry
+  profiler_put_header(rec, prof_num_entries);
+  for(j=0;j<PROFILER_HEADER_LEN;j++)
+    app_log("%02X", rec[j]);
+  app_log("\r\n");
+
+  for(i=0;i<prof_num_entries;i++){
+      profiler_put_entry(rec, &prof_entries[i]);
+      for(j=0;j<PROFILER_ENTRY_LEN;j++)
+        app_log("%02X", rec[j]);
+      app_log("\r\n");
+  }
+  app_log("\r\n");
+}
+
+#endif // PROFILER_ENABLE
@@ -0,0 +1,133 @@
+/**
+ * @file profiler.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the event-loop profiler.
+ * The profiler measures how long sl_bt_on_event() and handle_ble_event()
+ * take for every BT message ID, how long every state of the temperature,
+ * light and sound state machines takes per step, and how long it takes
+ * from a wakeup out of sleep to the dispatch of the next BT message.
+ *
+ * Durations are measured in CPU cycles with the DWT cycle counter on the
+ * target. A host build (any non-ARM compiler) uses a nanosecond clock
+ * behind the same interface, and reports 1 GHz as its cycle rate.
+ *
+ * Every (kind, id) pair owns one entry with the count, min, max and sum
+ * of its durations and a log2 histogram. Bucket 0 counts durations below
+ * 2^PROFILER_BUCKET_SHIFT cycles, bucket k counts durations in
+ * [2^(PROFILER_BUCKET_SHIFT+k-1), 2^(PROFILER_BUCKET_SHIFT+k)) and the
+ * last bucket also counts everything above it.
+ *
+ * Blob format (little-endian, entries are packed back-to-back):
+ *
+ *   header : [magic:4 = "PROF"][version:1][entries:1][buckets:1][bucket_shift:1]
+ *            [cycle_hz:4][wakeups:4][dropped:4]
+ *   entry  : [kind:1][id:4][count:4][min:4][max:4][sum:8][histogram:2 x buckets]
+ *
+ * @version 0.1
+ * @date 2022-04-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdint.h>
+
+/**
+ * Set to 1 to compile in the event-loop profiler.
+ */
+#define PROFILER_ENABLE             (0)
+
+#define PROFILER_MAX_ENTRIES        (32)
+#define PROFILER_NUM_BUCKETS        (16)
+// bucket 0 holds durations below 64 cycles, i.e. 1.7 us at 38.4 MHz
+#define PROFILER_BUCKET_SHIFT       (6)
+#define PROFILER_FORMAT_VERSION     (1)
+#define PROFILER_MAGIC              "PROF"
+
+#define PROFILER_HEADER_LEN         (20)
+#define PROFILER_ENTRY_LEN          (25 + (2 * PROFILER_NUM_BUCKETS))
+#define PROFILER_BLOB_MAX_LEN       (PROFILER_HEADER_LEN + \
+                                     (PROFILER_MAX_ENTRIES * PROFILER_ENTRY_LEN))
+
+/**
+ * What the id of an entry refers to
+ */
+typedef enum {
+  PROF_KIND_BT_EVENT = 1,  //!< sl_bt_on_event(), id = SL_BT_MSG_ID()
+  PROF_KIND_BLE_HANDLER,   //!< handle_ble_event(), id = SL_BT_MSG_ID()
+  PROF_KIND_TEMP_STATE,    //!< temperature_state_machine(), id = state
+  PROF_KIND_LIGHT_STATE,   //!< light_state_machine(), id = state
+  PROF_KIND_SOUND_STATE,   //!< sound_state_machine(), id = state
+  PROF_KIND_WAKEUP         //!< wakeup to the next BT message, id = EM left
+}prof_kind_t;
+
+
+#if PROFILER_ENABLE
+
+/**
+ * @brief Start the cycle counter, clear all entries and subscribe to the
+ * wakeups of the power manager.
+ */
+void profiler_init();
+
+/**
+ * @brief Clear all entries.
+ */
+void profiler_reset();
+
+/**
+ * @brief Read the free running cycle counter.
+ * @return the current cycle count.
+ */
+uint32_t profiler_cycles();
+
+/**
+ * @brief Add one duration to the entry of a (kind, id) pair. New pairs
+ * are dropped and counted once all entries are in use.
+ * @param kind: what the id refers to.
+ * @param id: the BT message ID or the state.
+ * @param start: the profiler_cycles() value at the start of the
+ * measured code.
+ */
+void profiler_record(prof_kind_t kind, uint32_t id, uint32_t start);
+
+/**
+ * @brief Record the time since the last wakeup, if the CPU has woken up
+ * since the previous call. Called at the start of sl_bt_on_event().
+ */
+void profiler_record_wakeup();
+
+/**
+ * @brief Serialize the entries into a blob, see the format above.
+ * @param buf: the output buffer.
+ * @param size: the size of the output buffer, PROFILER_BLOB_MAX_LEN
+ * bytes always fit all entries.
+ * @return the number of bytes written, entries that do not fit are
+ * left out.
+ */
+uint32_t profiler_get_blob(uint8_t *buf, uint32_t size);
+
+/**
+ * @brief Dump the blob as hex over VCOM.
+ */
+void profiler_dump();
+
+#else
+
+/*
+ * Remove all profiler related code where profiling is not enabled
+ */
+static inline void profiler_init() {}
+static inline void profiler_reset() {}
+static inline uint32_t profiler_cycles() { return 0; }
+static inline void profiler_record(prof_kind_t kind, uint32_t id, uint32_t start) \
+  { (void)kind; (void)id; (void)start; }
+static inline void profiler_record_wakeup() {}
+static inline void profiler_dump() {}
+
+#endif // PROFILER_ENABLE
+
+#endif // __PROFILER_H__
@@ -0,0 +1,194 @@
+/**
+ * @file sampling.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the adaptive sampling
+ * policy. The reference reading only moves on a step change, so a slow
+ * drift is caught once it adds up to more than the deadband.
+ * @version 0.1
+ * @date 2022-04-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdlib.h>
+#include "sampling.h"
+
+#define LOG_LEVEL LOG_LEVEL_INFO
+#include "src/log.h"
+
+/**
+ * Sampling state of one sensor
+ */
+typedef struct {
+  uint32_t interval;      // measurement ticks between two readings
+  uint32_t countdown;     // ticks left until the next reading
+  uint32_t stable;        // successive readings within the deadband
+  int32_t  reference;     // reading of the last step change
+  bool     has_reference;
+}sampling_state_t;
+
+static sampling_policy_t policies[SAMPLING_NUM_SENSORS] = {
+  [SAMPLING_TEMP]  = { .deadband = 200, .stable_count = 5, .max_interval = 20 },
+  [SAMPLING_LIGHT] = { .deadband = 10,  .stable_count = 5, .max_interval = 20 },
+  [SAMPLING_SOUND] = { .deadband = 30,  .stable_count = 5, .max_interval = 10 }
+};
+
+static sampling_state_t states[SAMPLING_NUM_SENSORS];
+
+static const char *sensor_names[SAMPLING_NUM_SENSORS] = {
+  [SAMPLING_TEMP]  = "temp",
+  [SAMPLING_LIGHT] = "light",
+  [SAMPLING_SOUND] = "sound"
+};
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Set the interval of a sensor, the next reading is one interval later.
+// ---------------------------------------------------------------------
+static void set_interval(sampling_sensor_t sensor, uint32_t interval)
+{
+  sampling_state_t *state = &states[sensor];
+
+  if(interval != state->interval){
+      LOG_INFO("Sampling %s every %u ticks\r\n", sensor_names[sensor], \
+               (unsigned int)interval);
+  }
+
+  state->interval = interval;
+  state->countdown = interval;
+  state->stable = 0;
+}
+
+/**
+ * @brief Drop every sensor back to an interval of one tick, so the next
+ * measurement tick measures all of them.
+ */
+void sampling_reset()
+{
+  int i;
+
+  for(i=0;i<SAMPLING_NUM_SENSORS;i++){
+      states[i].interval = 1;
+      states[i].countdown = 1;
+      states[i].stable = 0;
+      states[i].has_reference = false;
+  }
+}
+
+/**
+ * @brief Count one measurement tick for a sensor.
+ * @param sensor: the sensor.
+ * @return true if the sensor is due for a measurement on this tick.
+ */
+bool sampling_tick(sampling_sensor_t sensor)
+{
+  sampling_state_t *state = &states[sensor];
+
+  // the countdown is 0 before the first reset
+  if(state->countdown > 1){
+      state->countdown--;
+      return false;
+  }
+
+  state->countdown = state->interval;
+  return true;
+}
+
+/**
+ * @brief Update the interval of a sensor with a new reading.
+ * @param sensor: the sensor.
+ * @param value: the reading, in the unit of the sensor.
+ */
+void sampling_update(sampling_sensor_t sensor, int32_t value)
+{
+  sampling_state_t *state = &states[sensor];
+  const sampling_policy_t *policy = &policies[sensor];
+  uint32_t interval;
+
+  if(!state->has_reference || (abs(value - state->reference) > policy->deadband)){
+      // step change, measure on every tick again
+      state->reference = value;
+      state->has_reference = true;
+      set_interval(sensor, 1);
+      return;
+  }
+
+  if(++state->stable < policy->stable_count){
+      return;
+  }
+
+  interval = state->interval * 2;
+  if(interval > policy->max_interval)
+    interval = policy->max_interval;
+  set_interval(sensor, interval);
+}
+
+/**
+ * @brief Obtain the current interval of a sensor.
+ * @param sensor: the sensor.
+ * @return the interval, in measurement ticks.
+ */
+uint32_t sampling_get_interval(sampling_sensor_t sensor)
+{
+  return states[sensor].interval;
+}
+
+/**
+ * @brief Replace the policies of all sensors with a GATT payload. Values
+ * out of range are clamped, and every sensor drops back to an interval of
+ * one tick.
+ * @param payload: the policy records.
+ * @param len: the payload length.
+ * @return false if len is not SAMPLING_POLICY_PAYLOAD_LEN.
+ */
+bool sampling_set_policies(const uint8_t *payload, size_t len)
+{
+  int i;
+
+  if(len != SAMPLING_POLICY_PAYLOAD_LEN){
+      return false;
+  }
+
+  for(i=0;i<SAMPLING_NUM_SENSORS;i++){
+      const uint8_t *record = &payload[i * SAMPLING_POLICY_LEN];
+      sampling_policy_t *policy = &policies[i];
+
+      policy->deadband = (uint16_t)(record[0] | (record[1] << 8));
+      policy->stable_count = record[2];
+      policy->max_interval = record[3];
+
+      if(policy->stable_count < 1)
+        policy->stable_count = 1;
+      if(policy->max_interval < 1)
+        policy->max_interval = 1;
+      if(policy->max_interval > SAMPLING_MAX_INTERVAL)
+        policy->max_interval = SAMPLING_MAX_INTERVAL;
+
+      LOG_INFO("Sampling %s: deadband = %u, stable = %u, max = %u ticks\r\n", \
+               sensor_names[i], policy->deadband, policy->stable_count, \
+               policy->max_interval);
+  }
+
+  sampling_reset();
+  return true;
+}
+
+/**
+ * @brief Encode the policies of all sensors as a GATT payload.
+ * @param payload: filled with SAMPLING_POLICY_PAYLOAD_LEN bytes.
+ */
+void sampling_get_policies(uint8_t *payload)
+{
+  int i;
+
+  for(i=0;i<SAMPLING_NUM_SENSORS;i++){
+      uint8_t *record = &payload[i * SAMPLING_POLICY_LEN];
+
+      record[0] = (uint8_t)(policies[i].deadband & 0xff);
+      record[1] = (uint8_t)(policies[i].deadband >> 8);
+      record[2] = policies[i].stable_count;
+      record[3] = policies[i].max_interval;
+  }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file sampling.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the adaptive sampling
+ * policy. Every sensor is measured once per sampling interval, counted in
+ * measurement ticks. The interval starts at one tick and doubles every
+ * time stable_count successive readings stay within the deadband of the
+ * reference reading, up to max_interval ticks. A reading outside the
+ * deadband is a step change: it becomes the new reference and the
+ * interval drops back to one tick.
+ *
+ * The policies are written over GATT as SAMPLING_POLICY_PAYLOAD_LEN bytes,
+ * one SAMPLING_POLICY_LEN record per sensor in the order temperature,
+ * light, sound. A record holds a uint16 deadband in the unit of the
+ * sensor batch samples (0.001 C, lux, 0.1 dB), a uint8 stable_count and
+ * a uint8 max_interval, all little-endian. A max_interval of 1 measures
+ * the sensor on every tick.
+ * @version 0.1
+ * @date 2022-04-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __SAMPLING_H__
+#define __SAMPLING_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// the longest interval, in measurement ticks
+#define SAMPLING_MAX_INTERVAL           (100)
+
+#define SAMPLING_POLICY_LEN             (4)
+#define SAMPLING_POLICY_PAYLOAD_LEN     (SAMPLING_POLICY_LEN * SAMPLING_NUM_SENSORS)
+
+/**
+ * Sensors measured under a sampling policy
+ */
+typedef enum {
+  SAMPLING_TEMP = 0,      //!< temperature in 0.001 C
+  SAMPLING_LIGHT,         //!< light density in lux
+  SAMPLING_SOUND,         //!< sound level in 0.1 dB
+  SAMPLING_NUM_SENSORS    //!< SAMPLING_NUM_SENSORS
+}sampling_sensor_t;
+
+/**
+ * Sampling policy of one sensor
+ */
+typedef struct {
+  uint16_t deadband;      // largest change of a stable reading
+  uint8_t  stable_count;  // stable readings before the interval doubles
+  uint8_t  max_interval;  // longest interval, in measurement ticks
+}sampling_policy_t;
+
+
+/**
+ * @brief Drop every sensor back to an interval of one tick, so the next
+ * measurement tick measures all of them.
+ */
+void sampling_reset();
+
+/**
+ * @brief Count one measurement tick for a sensor.
+ * @param sensor: the sensor.
+ * @return true if the sensor is due for a measurement on this tick.
+ */
+bool sampling_tick(sampling_sensor_t sensor);
+
+/**
+ * @brief Update the interval of a sensor with a new reading.
+ * @param sensor: the sensor.
+ * @param value: the reading, in the unit of the sensor.
+ */
+void sampling_update(sampling_sensor_t sensor, int32_t value);
+
+/**
+ * @brief Obtain the current interval of a sensor.
+ * @param sensor: the sensor.
+ * @return the interval, in measurement ticks.
+ */
+uint32_t sampling_get_interval(sampling_sensor_t sensor);
+
+/**
+ * @brief Replace the policies of all sensors with a GATT payload. Values
+ * out of range are clamped, and every sensor drops back to an interval of
+ * one tick.
+ * @param payload: the policy records.
+ * @param len: the payload length.
+ * @return false if len is not SAMPLING_POLICY_PAYLOAD_LEN.
+ */
+bool sampling_set_policies(const uint8_t *payload, size_t len);
+
+/**
+ * @brief Encode the policies of all sensors as a GATT payload.
+ * @param payload: filled with SAMPLING_POLICY_PAYLOAD_LEN bytes.
+ */
+void sampling_get_policies(uint8_t *payload);
+
+#endif // __SAMPLING_H__
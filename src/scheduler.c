@@ -14,6 +14,7 @@
  */
 
 #include <math.h>
+#include <stdbool.h>
 #include "scheduler.h"
 #include "em_core.h"
 #include "em_adc.h"
@@ -27,12 +28,16 @@
 #include "ble.h"
 #include "gatt_db.h"
 #include "lcd.h"
+#include "dashboard.h"
 #include "adc.h"
 #include "ble_device_type.h"
-#include "circular_buffer.h"
+#include "trace.h"
+#include "profiler.h"
+#include "swtimer.h"
+#include "sampling.h"
 
 //for debugging only
-#define INCLUDE_LOG_DEBUG 1
+#define LOG_LEVEL LOG_LEVEL_INFO
 #include "src/log.h"
 
 
@@ -61,43 +66,230 @@ typedef enum {
   state_READ_SOUND_LVL
 }sound_state_t;
 
+/**
+ * Each sensor service is one stage of the measurement pipeline. The
+ * stages due under their sampling policy are started together on the
+ * measurement tick and every stage clears its bit once its measurement
+ * is displayed.
+ */
 typedef enum {
-  NO_SERVICE=0,
-  SOUND_SERVICE,
-  LIGHT_SERVICE,
-  TEMP_SERVICE
+  NO_SERVICE    = 0,
+  SOUND_SERVICE = (1 << 0),
+  LIGHT_SERVICE = (1 << 1),
+  TEMP_SERVICE  = (1 << 2),
+  ALL_SERVICES  = (SOUND_SERVICE | LIGHT_SERVICE | TEMP_SERVICE)
 }service_t;
 
+/**
+ * Latency of one measurement cycle, in ms
+ */
+typedef struct {
+  uint32_t cycle_start;
+  uint32_t temp_start;
+  uint32_t temp_end;
+  uint32_t light_start;
+  uint32_t light_end;
+  uint32_t sound_start;
+  uint32_t sound_end;
+}pipeline_latency_t;
+
+// set to 1 to log the per-stage and end-to-end latency of every cycle
+#define REPORT_PIPELINE_LATENCY     (0)
+
+// bitmask of the pipeline stages still running in the current cycle
+static uint32_t sensor_services = NO_SERVICE;
+static pipeline_latency_t latency;
+// stages whose I2C job has completed or failed, set by the job callback
+static uint32_t i2c_done_stages = NO_SERVICE;
+static uint32_t i2c_failed_stages = NO_SERVICE;
+// waits of the temperature stage, independent of the other stages
+static swtimer_t temp_timer;
+// state of every pipeline stage, kept here so a reset can rewind them
+static htm_state_t temp_next_state = state_IDLE;
+static light_state_t light_next_state = state_READ_RGB;
+static sound_state_t sound_next_state = state_SINGLE_SCAN;
+// pipeline stage measuring each sensor of the sampling policy
+static const service_t sampled_services[SAMPLING_NUM_SENSORS] = {
+  [SAMPLING_TEMP]  = TEMP_SERVICE,
+  [SAMPLING_LIGHT] = LIGHT_SERVICE,
+  [SAMPLING_SOUND] = SOUND_SERVICE
+};
+
+
+// -----------------------------------------------
+// Private function used only by this .c file.
+// Completion callback of the sensor I2C jobs, the context
+// is the pipeline stage that submitted the job.
+// -----------------------------------------------
+static void sensor_i2c_done(I2C_TransferReturn_TypeDef status, void *ctx)
+{
+  uint32_t stage = (uint32_t)(uintptr_t)ctx;
+
+  // a job still on the bus when the pipeline was reset finishes late
+  if(!(sensor_services & stage)){
+      return;
+  }
+
+  if(status == i2cTransferDone){
+      i2c_done_stages |= stage;
+  }
+  else{
+      i2c_failed_stages |= stage;
+  }
+}
+
+// -----------------------------------------------
+// Private function used only by this .c file.
+// Software timer callback ending a wait of the temperature
+// stage, runs in the ISR context.
+// -----------------------------------------------
+static void temp_timer_expired(swtimer_t *timer, void *data)
+{
+  (void)timer;
+  (void)data;
+  schedulerSetEventTempTimer();
+}
+
+// -----------------------------------------------
+// Private function used only by this .c file.
+// Check whether the I2C job of the stage has finished. ok reports
+// whether it succeeded within the driver's retries.
+// -----------------------------------------------
+static bool i2c_job_finished(service_t stage, bool *ok)
+{
+  if(!((i2c_done_stages | i2c_failed_stages) & stage)){
+      return false;
+  }
+
+  *ok = ((i2c_done_stages & stage) != 0);
+  i2c_done_stages &= ~stage;
+  i2c_failed_stages &= ~stage;
+  return true;
+}
+
+// -----------------------------------------------
+// Private function used only by this .c file.
+// Mark the stage as finished and report the cycle latency once
+// the last running stage is done.
+// -----------------------------------------------
+static void sensor_stage_done(service_t stage, uint32_t *end_ms)
+{
+  *end_ms = letimerMilliseconds();
+  sensor_services &= ~stage;
+
+  if(sensor_services != NO_SERVICE){
+      return;
+  }
+
+#if DEVICE_IS_BLE_SERVER
+  // one sample per cycle, stamped with the start of the cycle
+  ble_batch_add_sample(latency.cycle_start);
+#endif
 
-// global flag that activates all services
-static service_t sensor_service = NO_SERVICE;
+#if REPORT_PIPELINE_LATENCY
+  uint32_t cycle_end = latency.temp_end;
+  if(latency.light_end > cycle_end)
+    cycle_end = latency.light_end;
+  if(latency.sound_end > cycle_end)
+    cycle_end = latency.sound_end;
+
+  LOG_INFO("Cycle = %u ms: temp = %u ms, light = %u ms, sound = %u ms\r\n", \
+           (cycle_end - latency.cycle_start), \
+           (latency.temp_end - latency.temp_start), \
+           (latency.light_end - latency.light_start), \
+           (latency.sound_end - latency.sound_start));
+#endif
+}
 
 /**
- * Activate all services by enabling the temperature service as a starter
+ * Activate the services due on this measurement tick under their
+ * sampling policy by starting their stages of the measurement pipeline.
+ * The sound scan runs on ADC0 while the temperature and light jobs share
+ * I2C0 through the I2C job queue.
  */
 void activate_services()
 {
-  sensor_service = TEMP_SERVICE;
+  uint32_t services = NO_SERVICE;
+  int i;
+
+  if(sensor_services != NO_SERVICE){
+      LOG_WARN("Previous measurement cycle still running, 0x%x pending\r\n", \
+               (unsigned int)sensor_services);
+      return;
+  }
+
+  for(i=0;i<SAMPLING_NUM_SENSORS;i++){
+      if(sampling_tick((sampling_sensor_t)i))
+        services |= sampled_services[i];
+  }
+  if(services == NO_SERVICE){
+      return;
+  }
+
+  // stages skipped in this cycle report no latency
+  latency.cycle_start = letimerMilliseconds();
+  latency.temp_start = latency.temp_end = latency.cycle_start;
+  latency.light_start = latency.light_end = latency.cycle_start;
+  latency.sound_start = latency.sound_end = latency.cycle_start;
+  sensor_services = services;
+}
+
+/**
+ * Abort the measurement cycle in progress and rewind every pipeline
+ * stage to its first state. Called when the connection closes, since
+ * the stage events of a cycle are not dispatched while the link is down
+ * and the cycle would otherwise never finish.
+ */
+void sensor_pipeline_reset()
+{
+  swtimer_stop(&temp_timer);
+
+  sensor_services = NO_SERVICE;
+  i2c_done_stages = NO_SERVICE;
+  i2c_failed_stages = NO_SERVICE;
+
+  temp_next_state = state_IDLE;
+  light_next_state = state_READ_RGB;
+  sound_next_state = state_SINGLE_SCAN;
 }
 
 /**
  * @brief This function sets the event bit associated
- * with LETIMER0 UF interrupts.
+ * with the periodic measurement tick.
  */
-void schedulerSetEventLE0_UF()
+void schedulerSetEventMeasureTick()
 {
   CORE_DECLARE_IRQ_STATE;
   // enter the critical section
   CORE_ENTER_CRITICAL();
-  // mask the read-temp event bit
-  sl_bt_external_signal(evtLETIMER0_UF);
+  // mask the measurement tick bit
+  sl_bt_external_signal(evtMEASURE_TICK);
+  // record the raised signal
+  trace_record_signal(evtMEASURE_TICK);
   // exit the critical section
   CORE_EXIT_CRITICAL();
 }
 
 /**
  * @brief This function sets the event bit associated
- * with LETIMER0 COMP1 interrupts.
+ * with the periodic sleep hours tick.
+ */
+void schedulerSetEventSleepHourTick()
+{
+  CORE_DECLARE_IRQ_STATE;
+  // enter the critical section
+  CORE_ENTER_CRITICAL();
+  // mask the sleep hours tick bit
+  sl_bt_external_signal(evtSLEEP_HOUR_TICK);
+  // record the raised signal
+  trace_record_signal(evtSLEEP_HOUR_TICK);
+  // exit the critical section
+  CORE_EXIT_CRITICAL();
+}
+
+/**
+ * @brief This function sets the event bit associated
+ * with the end of a timeWaitUs_irq() wait.
  */
 void schedulerSetEventLE0_COMP1()
 {
@@ -106,6 +298,8 @@ void schedulerSetEventLE0_COMP1()
   CORE_ENTER_CRITICAL();
   // mask the COMP1 bit
   sl_bt_external_signal(evtLETIMER0_COMP1);
+  // record the raised signal
+  trace_record_signal(evtLETIMER0_COMP1);
   // exit the critical section
   CORE_EXIT_CRITICAL();
 }
@@ -121,6 +315,8 @@ void schedulerSetEventADC0_TRANDONE()
   CORE_ENTER_CRITICAL();
   // mask the COMP1 bit
   sl_bt_external_signal(evtADC0_TRANDONE);
+  // record the raised signal
+  trace_record_signal(evtADC0_TRANDONE);
   // exit the critical section
   CORE_EXIT_CRITICAL();
 }
@@ -136,6 +332,8 @@ void schedulerSetEventI2C0TranDone()
   CORE_ENTER_CRITICAL();
   // mask the I2C0 event bit
   sl_bt_external_signal(evtI2C0_TRANDONE);
+  // record the raised signal
+  trace_record_signal(evtI2C0_TRANDONE);
   // exit the critical section
   CORE_EXIT_CRITICAL();
 }
@@ -151,6 +349,25 @@ void schedulerSetEventI2C0TranNACK()
   CORE_ENTER_CRITICAL();
   // mask the I2C0 event bit
   sl_bt_external_signal(evtI2C0_TRANNACK);
+  // record the raised signal
+  trace_record_signal(evtI2C0_TRANNACK);
+  // exit the critical section
+  CORE_EXIT_CRITICAL();
+}
+
+/**
+ * @brief This function sets the event bit associated
+ * with the end of an I2C0 job retry backoff.
+ */
+void schedulerSetEventI2C0Retry()
+{
+  CORE_DECLARE_IRQ_STATE;
+  // enter the critical section
+  CORE_ENTER_CRITICAL();
+  // mask the I2C0 retry event bit
+  sl_bt_external_signal(evtI2C0_RETRY);
+  // record the raised signal
+  trace_record_signal(evtI2C0_RETRY);
   // exit the critical section
   CORE_EXIT_CRITICAL();
 }
@@ -166,6 +383,8 @@ void schedulerSetEventGPIO_PB0()
   CORE_ENTER_CRITICAL();
   // mask the PB0 event bit
   sl_bt_external_signal(evtGPIO_PB0);
+  // record the raised signal
+  trace_record_signal(evtGPIO_PB0);
   // exit the critical section
   CORE_EXIT_CRITICAL();
 }
@@ -181,144 +400,167 @@ void schedulerSetEventGPIO_PB1()
   CORE_ENTER_CRITICAL();
   // mask the PB1 event bit
   sl_bt_external_signal(evtGPIO_PB1);
+  // record the raised signal
+  trace_record_signal(evtGPIO_PB1);
+  // exit the critical section
+  CORE_EXIT_CRITICAL();
+}
+
+/**
+ * @brief This function sets the event bit associated
+ * with the end of an asynchronous LCD update.
+ */
+void schedulerSetEventDisplayDone()
+{
+  CORE_DECLARE_IRQ_STATE;
+  // enter the critical section
+  CORE_ENTER_CRITICAL();
+  // mask the display done event bit
+  sl_bt_external_signal(evtDISPLAY_DONE);
+  // record the raised signal
+  trace_record_signal(evtDISPLAY_DONE);
+  // exit the critical section
+  CORE_EXIT_CRITICAL();
+}
+
+/**
+ * @brief This function sets the event bit associated
+ * with the expiry of the temperature stage's software timer.
+ */
+void schedulerSetEventTempTimer()
+{
+  CORE_DECLARE_IRQ_STATE;
+  // enter the critical section
+  CORE_ENTER_CRITICAL();
+  // mask the temperature timer event bit
+  sl_bt_external_signal(evtTEMP_TIMER);
+  // record the raised signal
+  trace_record_signal(evtTEMP_TIMER);
   // exit the critical section
   CORE_EXIT_CRITICAL();
 }
 
 
 // -----------------------------------------------
-// Private function, original from Dan Walkes. I fixed a sign extension bug.
-// We'll need this for Client A7 assignment to convert health thermometer
-// indications back to an integer. Convert IEEE-11073 32-bit float to signed integer.
+// Private function used only by this .c file.
+// Remove the handled event bits from the external signal bitmask so that
+// the state machines running later in the same wakeup do not act on them
+// a second time.
 // -----------------------------------------------
-//static int32_t FLOAT_TO_INT32(const uint8_t *value_start_little_endian)
-//{
-//  uint8_t signByte = 0;
-//  int32_t mantissa;
-//  // input data format is:
-//  // [0] = flags byte
-//  // [3][2][1] = mantissa (2's complement)
-//  // [4] = exponent (2's complement)
-//  // BT value_start_little_endian[0] has the flags byte
-//  int8_t exponent = (int8_t)value_start_little_endian[4];
-//  // sign extend the mantissa value if the mantissa is negative
-//  if (value_start_little_endian[3] & 0x80) { // msb of [3] is the sign of the mantissa
-//      signByte = 0xFF;
-//  }
-//  mantissa = (int32_t) (value_start_little_endian[1] << 0) | \
-//  (value_start_little_endian[2] << 8) | \
-//  (value_start_little_endian[3] << 16) | \
-//  (signByte << 24) ;
-//
-//  // value = 10^exponent * mantissa, pow() returns a double type
-//  return (int32_t) (pow(10, exponent) * mantissa);
-//
-//} // FLOAT_TO_INT32
+static void consume_events(sl_bt_msg_t *evt, uint32_t events)
+{
+  evt->data.evt_system_external_signal.extsignals &= ~events;
+}
 
+
+/**
+ * @brief The finite state machine is designed to
+ * manipulate the Si7021sensor. The supported service
+ * is the temperature measurement. The write and read jobs
+ * are queued on I2C0, which is free for the light stage
+ * during the conversion wait.
+ * @param evt: the pointer of the BT event message.
+ */
 void temperature_state_machine(sl_bt_msg_t *evt)
 {
-  if(sensor_service != TEMP_SERVICE){
+  if(!(sensor_services & TEMP_SERVICE)){
       return;
   }
 
   uint32_t event = 0;
-  static htm_state_t next_state = state_IDLE;
+  bool ok;
+  htm_state_t curr_state;
+  uint32_t start;
+
+  // keep stepping while the state machine makes progress
+  do{
+    curr_state = temp_next_state;
+    start = profiler_cycles();
+    event = evt->data.evt_system_external_signal.extsignals;
 
-  htm_state_t curr_state = next_state;
-  event = evt->data.evt_system_external_signal.extsignals;
+    switch(curr_state){
 
-  switch(curr_state){
+      case state_IDLE:{
 
-    case state_IDLE:{
+//          LOG_INFO("Current state = state_IDLE\r\n");
+          latency.temp_start = letimerMilliseconds();
+          //delay 1 ms to transition to state_TIMEVT_1
+          swtimer_start(&temp_timer, 1, 0, temp_timer_expired, NULL);
+          temp_next_state = state_TIMEVT_1;
 
-//        LOG_INFO("Current state = state_IDLE\r\n");
-        //delay 1 ms to transition to state_TIMEVT_1
-        timeWaitUs_irq(1000);
-        next_state = state_TIMEVT_1;
+          break;
+        }
 
-        break;
+      case state_TIMEVT_1:{
+          temp_next_state = state_TIMEVT_1; //default
+//          LOG_INFO("Current state = state_TIMEVT_1\r\n");
+          if(event & evtTEMP_TIMER) {
+              consume_events(evt, evtTEMP_TIMER);
+              //queue the I2C send command
+              I7021_write(sensor_i2c_done, (void *)(uintptr_t)TEMP_SERVICE);
+              temp_next_state = state_I2C_WRITE_COMP;
+          }
+          break;
       }
-
-    case state_TIMEVT_1:{
-        next_state = state_TIMEVT_1; //default
-//        LOG_INFO("Current state = state_TIMEVT_1\r\n");
-        if(event == evtLETIMER0_COMP1) {
-            //disable LETIMER0 COMP1 interrupt
-            set_LETIMER0COMP1_irq(false);
-            //initialize I2C0
-            initI2C0_for_I7021();
-            //add the power requirement so that EM1 is the minimum power mode
-            sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
-            //initiate I2C send command
-            I7021_write();
-            next_state = state_I2C_WRITE_COMP;
+      case state_I2C_WRITE_COMP:{
+        temp_next_state = state_I2C_WRITE_COMP; //default
+//        LOG_INFO("Current state = state_I2C_WRITE_COMP\r\n");
+
+        if(i2c_job_finished(TEMP_SERVICE, &ok)){
+            if(!ok){
+                //give up on this cycle, the driver has already retried
+                temp_next_state = state_IDLE;
+                sensor_stage_done(TEMP_SERVICE, &latency.temp_end);
+                break;
+            }
+            //wait for I2C to process the command
+            swtimer_start(&temp_timer, MAX_TEMP_CONV_TIME_MS, 0, \
+                          temp_timer_expired, NULL);
+            temp_next_state = state_TIMEVT_2;
         }
         break;
-    }
-    case state_I2C_WRITE_COMP:{
-      next_state = state_I2C_WRITE_COMP; //default
-//      LOG_INFO("Current state = state_I2C_WRITE_COMP\r\n");
-
-      if(event == evtI2C0_TRANDONE){
-          //disable I2C interrupt
-          NVIC_DisableIRQ(I2C0_IRQn);
-          //remove the power requirement
-          sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
-          //wait for I2C to process the command
-          timeWaitUs_irq((MAX_TEMP_CONV_TIME_MS * MS_TO_US));
-          next_state = state_TIMEVT_2;
       }
-      if(event == evtI2C0_TRANNACK){
-          //resend the I2C command
-          I7021_write();
+      case state_TIMEVT_2:{
+        temp_next_state = state_TIMEVT_2; //default
+//        LOG_INFO("Current state = state_TIMEVT_2\r\n");
+        if(event & evtTEMP_TIMER) {
+              consume_events(evt, evtTEMP_TIMER);
+              //queue the I2C read command
+              I7021_read(sensor_i2c_done, (void *)(uintptr_t)TEMP_SERVICE);
+              temp_next_state = state_I2C_READ_COMP;
+          }
+          break;
       }
-      break;
-    }
-    case state_TIMEVT_2:{
-      next_state = state_TIMEVT_2; //default
-//      LOG_INFO("Current state = state_TIMEVT_2\r\n");
-      if(event == evtLETIMER0_COMP1) {
-            //disable LETIMER0 COMP1 interrupt
-            set_LETIMER0COMP1_irq(false);
-            //add the power requirement so that EM1 is the minimum power mode
-            sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
-            //initiate I2C send command
-            I7021_read();
-            next_state = state_I2C_READ_COMP;
-        }
-        break;
-    }
-    case state_I2C_READ_COMP:{
-      next_state = state_I2C_READ_COMP; //default
-//      LOG_INFO("Current state = state_I2C_READ_COMP\r\n");
-      if(event == evtI2C0_TRANDONE){
-            //disable I2C interrupt
-            NVIC_DisableIRQ(I2C0_IRQn);
-            //remove the power requirement
-            sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
-
-            //read the current temperature
-            uint32_t temperature_value = get_temperature_data();
-            // update the LCD display with temperature data
-            displayPrintf(DISPLAY_ROW_TEMPVALUE, "Temp=%d C",temperature_value);
-
-            //reset I2C0
-            I2C_Reset(I2C0);
-            //set next state to IDLE to jump back the loop
-            next_state = state_IDLE;
-            //reset service
-            sensor_service = LIGHT_SERVICE;
-        }
+      case state_I2C_READ_COMP:{
+        temp_next_state = state_I2C_READ_COMP; //default
+//        LOG_INFO("Current state = state_I2C_READ_COMP\r\n");
+        if(i2c_job_finished(TEMP_SERVICE, &ok)){
+              if(ok){
+                  //read the current temperature
+                  int32_t temperature_mC = get_temperature_data_mC();
+                  // stretch or reset the temperature sampling interval
+                  sampling_update(SAMPLING_TEMP, temperature_mC);
+                  // update the LCD display with temperature data
+                  dashboardSetValue(DASHBOARD_TEMP, temperature_mC / 1000);
+#if DEVICE_IS_BLE_SERVER
+                  // send the measurement to the client
+                  ble_send_temperature(temperature_mC);
+#endif
+              }
 
-      if(event == evtI2C0_TRANNACK){
-          //resend the I2C command
-          I7021_read();
+              //set next state to IDLE to jump back the loop
+              temp_next_state = state_IDLE;
+              //this stage is done for the current cycle
+              sensor_stage_done(TEMP_SERVICE, &latency.temp_end);
+          }
+          break;
       }
+      default:
         break;
     }
-    default:
-      break;
-  }
+    profiler_record(PROF_KIND_TEMP_STATE, curr_state, start);
+
+  }while((temp_next_state != curr_state) && (sensor_services & TEMP_SERVICE));
 }
 
 
@@ -331,63 +573,66 @@ void temperature_state_machine(sl_bt_msg_t *evt)
 
 void light_state_machine(sl_bt_msg_t *evt)
 {
-  if(sensor_service != LIGHT_SERVICE){
+  if(!(sensor_services & LIGHT_SERVICE)){
       return;
   }
 
-  uint32_t event = 0;
-  static light_state_t next_state = state_READ_RGB;
+  bool ok;
+  light_state_t curr_state;
+  uint32_t start;
 
-  light_state_t curr_state = next_state;
-  event = evt->data.evt_system_external_signal.extsignals;
+  (void)evt;
 
-  switch(curr_state){
+  do{
+    curr_state = light_next_state;
+    start = profiler_cycles();
 
-    case state_READ_RGB:{
-          next_state = state_COMP_LUX;
-          initI2C0_for_ISL29125();
-//          LOG_INFO("state = state_READ_RGB\r\n");
-          //add the power requirement so that EM1 is the minimum power mode
-          sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
-         //read the RGB values from the sensor
-         ISL29125_measure_RGB();
-        break;
-    }
-    case state_COMP_LUX:{
-        next_state = state_COMP_LUX; //default
-//        LOG_INFO("state = state_COMP_LUX\r\n");
-
-        if(event == evtI2C0_TRANDONE){
-            //remove the power requirement
-            sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
-            //convert the RGB to XYZ
-            ISL29125_transform_RBG_to_XYZ();
-            //Calculate the light intensity in units of lux
-            uint32_t light_data = calculate_light_density_in_lux();
-            // print out the current light density
-//            LOG_INFO("Light density = %u lux\r\n", light_data);
-            //display the updated light setting
-            displayPrintf(DISPLAY_ROW_8, " Light:%d lux", light_data);
-
-            //reset service
-            sensor_service = SOUND_SERVICE;
-            //reset the state
-            next_state = state_READ_RGB;
-            //reset I2C0
-            I2C_Reset(I2C0);
-        }
+    switch(curr_state){
+
+      case state_READ_RGB:{
+            light_next_state = state_COMP_LUX;
+//            LOG_INFO("state = state_READ_RGB\r\n");
+            latency.light_start = letimerMilliseconds();
+           //queue the read of the RGB values from the sensor
+           ISL29125_measure_RGB(sensor_i2c_done, (void *)(uintptr_t)LIGHT_SERVICE);
+          break;
+      }
+      case state_COMP_LUX:{
+          light_next_state = state_COMP_LUX; //default
+//          LOG_INFO("state = state_COMP_LUX\r\n");
+
+          if(i2c_job_finished(LIGHT_SERVICE, &ok)){
+              if(ok){
+                  //convert the RGB to XYZ
+                  ISL29125_transform_RBG_to_XYZ();
+                  //Calculate the light intensity in units of lux
+                  uint32_t light_data = calculate_light_density_in_lux();
+                  // stretch or reset the light sampling interval
+                  sampling_update(SAMPLING_LIGHT, (int32_t)light_data);
+                  // print out the current light density
+//                  LOG_INFO("Light density = %u lux\r\n", light_data);
+                  //display the updated light setting
+                  dashboardSetValue(DASHBOARD_LIGHT, (int32_t)light_data);
+#if DEVICE_IS_BLE_SERVER
+                  // send the measurement to the client
+                  ble_send_light(light_data);
+#endif
+              }
 
-        else if(event == evtI2C0_TRANNACK){
-             //read the RGB values from the sensor again
-            LOG_INFO("NACK received, re-run ISL29125_measure_RGB( )\r\n");
-            ISL29125_measure_RGB();
+              //reset the state
+              light_next_state = state_READ_RGB;
+              //this stage is done for the current cycle
+              sensor_stage_done(LIGHT_SERVICE, &latency.light_end);
           }
-        break;
+          break;
+      }
+
+      default:
+            break;
     }
+    profiler_record(PROF_KIND_LIGHT_STATE, curr_state, start);
 
-    default:
-          break;
-  }
+  }while((light_next_state != curr_state) && (sensor_services & LIGHT_SERVICE));
 }
 
 
@@ -399,50 +644,84 @@ void light_state_machine(sl_bt_msg_t *evt)
  */
 void sound_state_machine(sl_bt_msg_t *evt)
 {
-    if(sensor_service != SOUND_SERVICE){
+    if(!(sensor_services & SOUND_SERVICE)){
         return;
     }
 
     uint32_t event = 0;
-    static sound_state_t next_state = state_SINGLE_SCAN;
-    sound_state_t curr_state = next_state;
-    event = evt->data.evt_system_external_signal.extsignals;
+    sound_state_t curr_state;
+    uint32_t start;
 
-    switch(curr_state){
+    do{
+      curr_state = sound_next_state;
+      start = profiler_cycles();
+      event = evt->data.evt_system_external_signal.extsignals;
 
-        case state_SINGLE_SCAN:{
-            next_state = state_SINGLE_SCAN; //default
-//            LOG_INFO("Current state = state_SINGLE_SCAN\r\n");
+      switch(curr_state){
 
-             // start ADC to scan
-              ADC_Start(ADC0, ADC_CMD_SINGLESTART);
-              next_state = state_READ_SOUND_LVL;
+          case state_SINGLE_SCAN:{
+              sound_next_state = state_SINGLE_SCAN; //default
+//              LOG_INFO("Current state = state_SINGLE_SCAN\r\n");
 
-            break;
-          }
-        case state_READ_SOUND_LVL:{
-            next_state = state_READ_SOUND_LVL; //default
-//            LOG_INFO("Current state = state_READ_SOUND_LVL\r\n");
-            if(event == evtADC0_TRANDONE){
-              // get and log the ADC data
-                uint32_t *adc0_data = getADC0Data();
-                // 5000/4096 = 1.221
-                uint32_t millivolts = (uint32_t)(*adc0_data * 1.221);
-                uint32_t sound_db = ADCmVtodB(millivolts);
-//                LOG_INFO("Sound = %d db\r\n", sound_db);
-                //display the updated sound setting
-                displayPrintf(DISPLAY_ROW_9, "Sound:%d dB", sound_db);
-
-                //reset service
-                sensor_service = NO_SERVICE;
-                // reset the state
-                next_state = state_SINGLE_SCAN;
+              latency.sound_start = letimerMilliseconds();
+               // start ADC to scan
+                ADC_Start(ADC0, ADC_CMD_SINGLESTART);
+                sound_next_state = state_READ_SOUND_LVL;
+
+              break;
             }
-            break;
+          case state_READ_SOUND_LVL:{
+              sound_next_state = state_READ_SOUND_LVL; //default
+//              LOG_INFO("Current state = state_READ_SOUND_LVL\r\n");
+              if(event & evtADC0_TRANDONE){
+                  consume_events(evt, evtADC0_TRANDONE);
+                // get and log the ADC data
+                  uint32_t *adc0_data = getADC0Data();
+                  // 5000/4096 = 1.221
+                  uint32_t millivolts = (uint32_t)(*adc0_data * 1.221);
+                  uint32_t sound_ddb = ADCmVtodBx10(millivolts);
+                  // stretch or reset the sound sampling interval
+                  sampling_update(SAMPLING_SOUND, (int32_t)sound_ddb);
+//                  LOG_INFO("Sound = %d db\r\n", sound_ddb / 10);
+                  //display the updated sound setting
+                  dashboardSetValue(DASHBOARD_SOUND, (int32_t)(sound_ddb / 10));
+#if DEVICE_IS_BLE_SERVER
+                  // send the measurement to the client
+                  ble_send_sound(sound_ddb);
+#endif
+
+                  // reset the state
+                  sound_next_state = state_SINGLE_SCAN;
+                  //this stage is done for the current cycle
+                  sensor_stage_done(SOUND_SERVICE, &latency.sound_end);
+              }
+              break;
+          }
+          default:
+             break;
         }
-        default:
-           break;
-      }
+      profiler_record(PROF_KIND_SOUND_STATE, curr_state, start);
+
+    }while((sound_next_state != curr_state) && (sensor_services & SOUND_SERVICE));
+}
+
+
+/**
+ * @brief Run one step of every active pipeline stage. I2C completions
+ * are first passed through the I2C job queue, whose callbacks mark the
+ * temperature and light jobs as finished.
+ * @param evt: the pointer of the BT event message.
+ */
+void sensor_pipeline_state_machine(sl_bt_msg_t *evt)
+{
+  uint32_t handled;
+
+  handled = i2c_queue_process(evt->data.evt_system_external_signal.extsignals);
+  consume_events(evt, handled);
+
+  temperature_state_machine(evt);
+  light_state_machine(evt);
+  sound_state_machine(evt);
 }
 
 
@@ -467,6 +746,9 @@ typedef enum {
   state_DISCOVER_SLEEP_HOUR_SERVICE,            //!< state_DISCOVER_SLEEP_HOUR_SERVICE
   state_DISCOVER_SLEEP_HOUR_CHARACTERISTIC,     //!< state_DISCOVER_SLEEP_HOUR_CHARACTERISTIC
   state_ENABLE_SLEEP_HOUR_INDICATIONS,          //!< state_ENABLE_SLEEP_HOUR_INDICATIONS
+  state_DISCOVER_SENSOR_BATCH_SERVICE,          //!< state_DISCOVER_SENSOR_BATCH_SERVICE
+  state_DISCOVER_SENSOR_BATCH_CHARACTERISTIC,   //!< state_DISCOVER_SENSOR_BATCH_CHARACTERISTIC
+  state_ENABLE_SENSOR_BATCH_INDICATIONS,        //!< state_ENABLE_SENSOR_BATCH_INDICATIONS
   state_PENDING,                                //!< state_PENDING
   state_RUNNING                                 //!< state_RUNNING
 }discover_state_t;
@@ -487,6 +769,15 @@ typedef enum {
 }write_data_state_t;
 
 
+// Client configuration of the light, sound and sensor batch characteristics.
+// In streaming mode the measurements are notified while the server still
+// acknowledges the client writes with indications.
+#if SENSOR_STREAM_NOTIFY
+#define SENSOR_STREAM_CONFIG    (sl_bt_gatt_notification | sl_bt_gatt_indication)
+#else
+#define SENSOR_STREAM_CONFIG    (sl_bt_gatt_indication)
+#endif
+
 // Health Thermometer service UUID defined by Bluetooth SIG
 static uint8_t thermo_service_uuid[2] = { 0x09, 0x18 };
 // Temperature Measurement characteristic UUID defined by Bluetooth SIG
@@ -500,6 +791,9 @@ static uint8_t sound_sensor_char_UUID[16]       = {0x29, 0x8b, 0x48, 0xbd, 0x6f,
 //Sleep hours
 static uint8_t sleep_hours_service_UUID[16]     = {0x58, 0xbb, 0x62, 0xfa, 0x6b, 0x1f, 0x4e, 0xa1, 0x3a, 0x47, 0x7f, 0x23, 0x5d, 0xbe,  0x11, 0xfe};
 static uint8_t sleep_hours_char_UUID[16]         =  {0x82, 0x9a, 0x16, 0x45, 0x50, 0xd4, 0xef, 0xbc, 0x2a, 0x4b, 0x8a, 0xf0, 0x4e, 0xa9, 0x99, 0xb9};
+//Sensor batch
+static uint8_t sensor_batch_service_UUID[16]    = {0x36, 0x7e, 0x9d, 0x4b, 0xf0, 0xc2, 0x51, 0x8a, 0x7e, 0x4d, 0xb4, 0x93, 0x1e, 0x2c, 0x0f, 0x6a};
+static uint8_t sensor_batch_char_UUID[16]       = {0x84, 0x5d, 0xf0, 0xc1, 0x93, 0x7a, 0xe2, 0xb6, 0x39, 0x4c, 0x1a, 0x5f, 0x27, 0x8b, 0x4e, 0x0d};
 
 // global flag to indicate the current connection is closed
 static bool client_conn_closed = false;
@@ -593,6 +887,24 @@ uint8_t *get_sleep_hours_char_uuid()
   return &sleep_hours_char_UUID[0];
 }
 
+/**
+ * Obtain the UUID of the sensor batch service
+ * @return the address of the sensor_batch_service_UUID
+ */
+uint8_t *get_sensor_batch_service_uuid()
+{
+  return &sensor_batch_service_UUID[0];
+}
+
+/**
+ * Obtain the UUID of the sensor batch characteristic
+ * @return the address of the sensor_batch_char_UUID
+ */
+uint8_t *get_sensor_batch_char_uuid()
+{
+  return &sensor_batch_char_UUID[0];
+}
+
 //declare the inner state machine function called in discovery_state_machine().
 static void server_update_state_machine(sl_bt_msg_t *evt);
 
@@ -831,7 +1143,7 @@ void discovery_state_machine(sl_bt_msg_t *evt)
             sc = sl_bt_gatt_set_characteristic_notification (
                 evt->data.evt_gatt_procedure_completed.connection,
                 bleDataPtr->light_sensor_characteristic_handle,
-                sl_bt_gatt_indication);
+                SENSOR_STREAM_CONFIG);
 
             if (sc != SL_STATUS_OK)
             {
@@ -901,7 +1213,7 @@ void discovery_state_machine(sl_bt_msg_t *evt)
             sc = sl_bt_gatt_set_characteristic_notification (
                 evt->data.evt_gatt_procedure_completed.connection,
                 bleDataPtr->sound_sensor_characteristic_handle,
-                sl_bt_gatt_indication);
+                SENSOR_STREAM_CONFIG);
 
             if (sc != SL_STATUS_OK)
             {
@@ -980,6 +1292,75 @@ void discovery_state_machine(sl_bt_msg_t *evt)
              break;
            }
 
+           next_state = state_DISCOVER_SENSOR_BATCH_SERVICE;
+         }
+         break;
+       }
+
+       case state_DISCOVER_SENSOR_BATCH_SERVICE:{
+
+         LOG_INFO("Current state = state_DISCOVER_SENSOR_BATCH_SERVICE\r\n");
+         next_state = state_DISCOVER_SENSOR_BATCH_SERVICE;
+
+         if (event == sl_bt_evt_gatt_procedure_completed_id)
+         {
+           sc = sl_bt_gatt_discover_primary_services_by_uuid (
+               evt->data.evt_gatt_procedure_completed.connection,
+               sizeof(sensor_batch_service_UUID),
+               (const uint8_t*) sensor_batch_service_UUID);
+
+           if (sc != SL_STATUS_OK)
+           {
+             LOG_ERROR("Failed to discover the sensor batch service\r\n");
+             break;
+           }
+           next_state = state_DISCOVER_SENSOR_BATCH_CHARACTERISTIC;
+         }
+         break;
+       }
+
+       case state_DISCOVER_SENSOR_BATCH_CHARACTERISTIC:{
+
+          LOG_INFO("Current state = state_DISCOVER_SENSOR_BATCH_CHARACTERISTIC\r\n");
+          next_state = state_DISCOVER_SENSOR_BATCH_CHARACTERISTIC;
+
+          if (event == sl_bt_evt_gatt_procedure_completed_id)
+          {
+            sc = sl_bt_gatt_discover_characteristics_by_uuid (
+                evt->data.evt_gatt_procedure_completed.connection,
+                bleDataPtr->sensor_batch_service_handle,
+                sizeof(sensor_batch_char_UUID),
+                (const uint8_t*) sensor_batch_char_UUID);
+
+            if (sc != SL_STATUS_OK)
+            {
+              LOG_ERROR("Failed to discover the sensor batch characteristic, rc = 0x%x\r\n",sc);
+              break;
+            }
+
+            next_state = state_ENABLE_SENSOR_BATCH_INDICATIONS;
+          }
+          break;
+       }
+
+       case state_ENABLE_SENSOR_BATCH_INDICATIONS:{
+
+         LOG_INFO("Current state = state_ENABLE_SENSOR_BATCH_INDICATIONS\r\n");
+         next_state = state_ENABLE_SENSOR_BATCH_INDICATIONS;
+
+         if (event == sl_bt_evt_gatt_procedure_completed_id)
+         {
+           sc = sl_bt_gatt_set_characteristic_notification (
+               evt->data.evt_gatt_procedure_completed.connection,
+               bleDataPtr->sensor_batch_characteristic_handle,
+               SENSOR_STREAM_CONFIG);
+
+           if (sc != SL_STATUS_OK)
+           {
+             LOG_ERROR("Failed to enable the sensor batch indication, rc = 0x%x\r\n",sc);
+             break;
+           }
+
            next_state = state_PENDING;
          }
          break;
@@ -1031,8 +1412,30 @@ void discovery_state_machine(sl_bt_msg_t *evt)
        }
   }
 
+// -----------------------------------------------
+// Private function used only by this .c file.
+// Check whether the event completes the write of a characteristic
+// value. The server acknowledges a write with an indication of the
+// characteristic, which the periodic measurements also use, so only
+// the completion of its own write tells the client that the next
+// write can start.
+// -----------------------------------------------
+static bool write_completed(sl_bt_msg_t *evt, const char *name)
+{
+  if(SL_BT_MSG_ID(evt->header) != sl_bt_evt_gatt_procedure_completed_id){
+      return false;
+  }
+
+  if(evt->data.evt_gatt_procedure_completed.result != SL_STATUS_OK){
+      LOG_ERROR("Failed to write the %s value to GATT server, rc = 0x%x\r\n", \
+                name, (unsigned int)evt->data.evt_gatt_procedure_completed.result);
+  }
+  return true;
+}
+
 /**
- * The state machine that writes GATT characteristic values to the server device
+ * The state machine that writes GATT characteristic values to the server device.
+ * Every write waits for the completion of the previous one.
  * @param evt: the message event pointer
  */
 static void server_update_state_machine(sl_bt_msg_t *evt)
@@ -1067,19 +1470,9 @@ static void server_update_state_machine(sl_bt_msg_t *evt)
 
        LOG_INFO("Current state = state_SEND_TEMP_CONFIRM\r\n");
        next_state = state_SEND_TEMP_CONFIRM;
-       // This event is generated when exactly an indication was received
-       if((SL_BT_MSG_ID(evt->header) == sl_bt_evt_gatt_characteristic_value_id) && \
-           (evt->data.evt_gatt_characteristic_value.att_opcode == sl_bt_gatt_handle_value_indication)){
-
-           if(evt->data.evt_gatt_characteristic_value.characteristic == gattdb_temperature_measurement){
-                // Send confirmation for the indication
-                sc = sl_bt_gatt_send_characteristic_confirmation(bleDataPtr->connectionHandle);
-                if(sc != SL_STATUS_OK){
-                    LOG_ERROR("Failed to send the confirmation for the temperature measurement service\r\n");
-                    break;
-                }
-                next_state = state_WRITE_LIGHT_VALUE;
-            }
+       // the server has taken the value once the write has completed
+       if(write_completed(evt, "temperature")){
+           next_state = state_WRITE_LIGHT_VALUE;
        }
        break;
      }
@@ -1104,19 +1497,9 @@ static void server_update_state_machine(sl_bt_msg_t *evt)
 
        LOG_INFO("Current state = state_SEND_LIGHT_CONFIRM\r\n");
         next_state = state_SEND_LIGHT_CONFIRM;
-        // This event is generated when exactly an indication was received
-        if((SL_BT_MSG_ID(evt->header) == sl_bt_evt_gatt_characteristic_value_id) && \
-            (evt->data.evt_gatt_characteristic_value.att_opcode == sl_bt_gatt_handle_value_indication)){
-
-            if(evt->data.evt_gatt_characteristic_value.characteristic == gattdb_light_measurement){
-                 // Send confirmation for the indication
-                 sc = sl_bt_gatt_send_characteristic_confirmation(bleDataPtr->connectionHandle);
-                 if(sc != SL_STATUS_OK){
-                     LOG_ERROR("Failed to send the confirmation for the light measurement service\r\n");
-                     break;
-                 }
-                 next_state = state_WRITE_SOUND_VALUE;
-             }
+        // the server has taken the value once the write has completed
+        if(write_completed(evt, "light")){
+            next_state = state_WRITE_SOUND_VALUE;
         }
         break;
      }
@@ -1141,19 +1524,9 @@ static void server_update_state_machine(sl_bt_msg_t *evt)
 
        LOG_INFO("Current state = state_SEND_SOUND_CONFIRM\r\n");
        next_state = state_SEND_SOUND_CONFIRM;
-       // This event is generated when exactly an indication was received
-       if((SL_BT_MSG_ID(evt->header) == sl_bt_evt_gatt_characteristic_value_id) && \
-           (evt->data.evt_gatt_characteristic_value.att_opcode == sl_bt_gatt_handle_value_indication)){
-
-           if(evt->data.evt_gatt_characteristic_value.characteristic == gattdb_sound_measurement){
-                // Send confirmation for the indication
-                sc = sl_bt_gatt_send_characteristic_confirmation(bleDataPtr->connectionHandle);
-                if(sc != SL_STATUS_OK){
-                    LOG_ERROR("Failed to send the confirmation for the sound measurement service\r\n");
-                    break;
-                }
-                next_state = state_WRITE_SLEEP_HOURS_VALUE;
-            }
+       // the server has taken the value once the write has completed
+       if(write_completed(evt, "sound")){
+           next_state = state_WRITE_SLEEP_HOURS_VALUE;
        }
        break;
      }
@@ -1179,24 +1552,13 @@ static void server_update_state_machine(sl_bt_msg_t *evt)
 
        LOG_INFO("Current state = state_SEND_SLEEP_HOURS_CONFIRM\r\n");
        next_state = state_SEND_SLEEP_HOURS_CONFIRM;
-       // This event is generated when exactly an indication was received
-       if((SL_BT_MSG_ID(evt->header) == sl_bt_evt_gatt_characteristic_value_id) && \
-           (evt->data.evt_gatt_characteristic_value.att_opcode == sl_bt_gatt_handle_value_indication)){
-
-            if(evt->data.evt_gatt_characteristic_value.characteristic == gattdb_sleep_hours){
-                 // Send confirmation for the indication
-                 sc = sl_bt_gatt_send_characteristic_confirmation(bleDataPtr->connectionHandle);
-                 if(sc != SL_STATUS_OK){
-                     LOG_ERROR("Failed to send the confirmation for the sleep hours service\r\n");
-                     break;
-                 }
-
-                 //reset next_state
-                 next_state = state_WRITE_TEMP_VALUE;
-                 //exit the state machine
-                 return;
-             }
-        }
+       // the server has taken the value once the write has completed
+       if(write_completed(evt, "sleep hours")){
+           //reset next_state
+           next_state = state_WRITE_TEMP_VALUE;
+           //exit the state machine
+           return;
+       }
         break;
      }
    }
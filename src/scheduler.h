@@ -22,34 +22,58 @@
 #include "sl_bt_api.h"
 
 /**
- * Enum type defining the external signal events triggered by BLE stack
+ * Enum type defining the external signal events triggered by BLE stack.
+ * Each event owns one bit so that signals raised by several interrupts
+ * before the stack wakes up are delivered together in one extsignals
+ * bitmask without losing any of them.
  */
 typedef enum {
-  evtI2C0_TRANDONE = 1,//!< evtI2C0_TRANDONE
-  evtI2C0_TRANNACK,    //!< evtI2C0_TRANNACK
-  evtADC0_TRANDONE,    //!< evtADC0_TRANDONE
-  evtLETIMER0_UF,      //!< evtLETIMER0_UF
-  evtLETIMER0_COMP1,   //!< evtLETIMER0_COMP1
-  evtGPIO_PB0,         //!< evtGPIO_PB0
-  evtGPIO_PB1          //!< evtGPIO_PB1
+  evtI2C0_TRANDONE   = (1 << 0),//!< evtI2C0_TRANDONE
+  evtI2C0_TRANNACK   = (1 << 1),//!< evtI2C0_TRANNACK
+  evtADC0_TRANDONE   = (1 << 2),//!< evtADC0_TRANDONE
+  evtMEASURE_TICK    = (1 << 3),//!< evtMEASURE_TICK
+  evtLETIMER0_COMP1  = (1 << 4),//!< evtLETIMER0_COMP1
+  evtGPIO_PB0        = (1 << 5),//!< evtGPIO_PB0
+  evtGPIO_PB1        = (1 << 6),//!< evtGPIO_PB1
+  evtI2C0_RETRY      = (1 << 7),//!< evtI2C0_RETRY
+  evtDISPLAY_DONE    = (1 << 8),//!< evtDISPLAY_DONE
+  evtTEMP_TIMER      = (1 << 9),//!< evtTEMP_TIMER
+  evtSLEEP_HOUR_TICK = (1 << 10) //!< evtSLEEP_HOUR_TICK
 
 }evt_t;
 
 
 /**
- * Activate all services by enabling the temperature service as a starter
+ * Activate the services due on this measurement tick under their
+ * sampling policy by starting their stages of the measurement pipeline.
+ * The sound scan runs on ADC0 while the temperature and light jobs share
+ * I2C0 through the I2C job queue.
  */
 void activate_services();
 
+/**
+ * Abort the measurement cycle in progress and rewind every pipeline
+ * stage to its first state. Called when the connection closes, since
+ * the stage events of a cycle are not dispatched while the link is down
+ * and the cycle would otherwise never finish.
+ */
+void sensor_pipeline_reset();
+
+/**
+ * @brief This function sets the event bit associated
+ * with the periodic measurement tick.
+ */
+void schedulerSetEventMeasureTick();
+
 /**
  * @brief This function sets the event bit associated
- * with LETIMER0 UF interrupts.
+ * with the periodic sleep hours tick.
  */
-void schedulerSetEventLE0_UF();
+void schedulerSetEventSleepHourTick();
 
 /**
  * @brief This function sets the event bit associated
- * with LETIMER0 COMP1 interrupts.
+ * with the end of a timeWaitUs_irq() wait.
  */
 void schedulerSetEventLE0_COMP1();
 
@@ -65,6 +89,12 @@ void schedulerSetEventI2C0TranDone();
  */
 void schedulerSetEventI2C0TranNACK();
 
+/**
+ * @brief This function sets the event bit associated
+ * with the end of an I2C0 job retry backoff.
+ */
+void schedulerSetEventI2C0Retry();
+
 
 /**
  * @brief This function sets the event bit associated
@@ -84,6 +114,18 @@ void schedulerSetEventGPIO_PB0();
  */
 void schedulerSetEventGPIO_PB1();
 
+/**
+ * @brief This function sets the event bit associated
+ * with the end of an asynchronous LCD update.
+ */
+void schedulerSetEventDisplayDone();
+
+/**
+ * @brief This function sets the event bit associated
+ * with the expiry of the temperature stage's software timer.
+ */
+void schedulerSetEventTempTimer();
+
 /**
  * @brief The finite state machine is designed to
  * manipulate the Si7021sensor. The supported service
@@ -108,6 +150,14 @@ void light_state_machine(sl_bt_msg_t *evt);
  */
 void sound_state_machine(sl_bt_msg_t *evt);
 
+/**
+ * @brief Run one step of every active pipeline stage. I2C completions
+ * are first passed through the I2C job queue, whose callbacks mark the
+ * temperature and light jobs as finished.
+ * @param evt: the pointer of the BT event message.
+ */
+void sensor_pipeline_state_machine(sl_bt_msg_t *evt);
+
 /**
  * @brief The finite state machine is designed for the master device to
  * discover primary services on the slave device, and listen for
@@ -158,6 +208,16 @@ uint8_t *get_sleep_hours_service_uuid();
  * @return the address of the sleep_hours_char_UUID
  */
 uint8_t *get_sleep_hours_char_uuid();
+/**
+ * Obtain the UUID of the sensor batch service
+ * @return the address of the sensor_batch_service_UUID
+ */
+uint8_t *get_sensor_batch_service_uuid();
+/**
+ * Obtain the UUID of the sensor batch characteristic
+ * @return the address of the sensor_batch_char_UUID
+ */
+uint8_t *get_sensor_batch_char_uuid();
 /**
  * Get the flag that triggers the BLE stack to handle the sleep hours
  */
@@ -0,0 +1,209 @@
+/**
+ * @file swtimer.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the software timers.
+ * The list is doubly linked, so a timer is stopped in constant time and
+ * only the insertion walks the list. All list changes happen inside a
+ * critical section because the LETIMER0 ISR pops the expired timers.
+ * @version 0.1
+ * @date 2022-04-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stddef.h>
+#include "swtimer.h"
+#include "em_core.h"
+#include "irq.h"
+#include "timers.h"
+
+// head of the running timers, sorted by expiry
+static swtimer_t *timer_list = NULL;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Signed distance between two tick counts, handles the wrap around.
+// ---------------------------------------------------------------------
+static inline int32_t ticks_diff(uint32_t a, uint32_t b)
+{
+  return (int32_t)(a - b);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Compute the next expiry of a timer from its origin, so the rounding
+// of every period does not add up.
+// ---------------------------------------------------------------------
+static void compute_expiry(swtimer_t *timer)
+{
+  uint64_t ms = (uint64_t)timer->timeout_ms + \
+                ((uint64_t)timer->periods * timer->period_ms);
+
+  timer->expiry = timer->origin + \
+                  (uint32_t)((ms * letimerTickFrequency()) / 1000);
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Insert a timer after the timers expiring at the same tick or earlier.
+// Must be called inside a critical section.
+// ---------------------------------------------------------------------
+static void list_insert(swtimer_t *timer)
+{
+  swtimer_t *prev = NULL;
+  swtimer_t *next = timer_list;
+
+  while(next && (ticks_diff(next->expiry, timer->expiry) <= 0)){
+      prev = next;
+      next = next->next;
+  }
+
+  timer->prev = prev;
+  timer->next = next;
+  if(next)
+    next->prev = timer;
+  if(prev)
+    prev->next = timer;
+  else
+    timer_list = timer;
+  timer->running = true;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Unlink a running timer. Must be called inside a critical section.
+// ---------------------------------------------------------------------
+static void list_remove(swtimer_t *timer)
+{
+  if(timer->prev)
+    timer->prev->next = timer->next;
+  else
+    timer_list = timer->next;
+  if(timer->next)
+    timer->next->prev = timer->prev;
+
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->running = false;
+}
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Arm COMP1 for the head of the list. Must be called inside a critical
+// section.
+// ---------------------------------------------------------------------
+static void arm_head()
+{
+  if(timer_list)
+    letimerSetAlarm(timer_list->expiry);
+  else
+    letimerCancelAlarm();
+}
+
+/**
+ * @brief Start a timer, or restart it if it is running.
+ * @param timer: the timer.
+ * @param timeout_ms: the time to the first expiry, in ms.
+ * @param period_ms: the time between later expiries, 0 for a one-shot
+ * timer.
+ * @param callback: called on every expiry in the ISR context.
+ * @param data: passed to the callback.
+ * @return false if a time is above SWTIMER_MAX_MS or the callback is NULL.
+ */
+bool swtimer_start(swtimer_t *timer, uint32_t timeout_ms, uint32_t period_ms, \
+                   swtimer_callback_t callback, void *data)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if(!callback || (timeout_ms > SWTIMER_MAX_MS) || (period_ms > SWTIMER_MAX_MS))
+    return false;
+
+  CORE_ENTER_CRITICAL();
+
+  if(timer->running)
+    list_remove(timer);
+
+  timer->origin = letimerTicks();
+  timer->timeout_ms = timeout_ms;
+  timer->period_ms = period_ms;
+  timer->periods = 0;
+  timer->callback = callback;
+  timer->data = data;
+  compute_expiry(timer);
+
+  list_insert(timer);
+  if(timer_list == timer)
+    arm_head();
+
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/**
+ * @brief Stop a timer. Stopping a timer that is not running does nothing.
+ * @param timer: the timer.
+ */
+void swtimer_stop(swtimer_t *timer)
+{
+  bool was_head;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  if(timer->running){
+      was_head = (timer_list == timer);
+      list_remove(timer);
+      if(was_head)
+        arm_head();
+  }
+
+  CORE_EXIT_CRITICAL();
+}
+
+/**
+ * @brief Check if a timer is running.
+ * @param timer: the timer.
+ * @return true until a one-shot timer expires or any timer is stopped.
+ */
+bool swtimer_is_running(const swtimer_t *timer)
+{
+  return timer->running;
+}
+
+/**
+ * @brief Run the callbacks of all expired timers and arm COMP1 for the
+ * next one. Called by the LETIMER0 ISR on COMP1 and UF.
+ */
+void swtimer_irq_handler()
+{
+  swtimer_t *timer;
+  uint32_t now;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  now = letimerTicks();
+  while(timer_list && (ticks_diff(now, timer_list->expiry) >= 0)){
+      timer = timer_list;
+      list_remove(timer);
+
+      // a periodic timer goes back into the list before its callback, so
+      // the callback may stop it; missed periods are skipped, not queued
+      if(timer->period_ms){
+          do{
+              timer->periods++;
+              compute_expiry(timer);
+          }while(ticks_diff(now, timer->expiry) >= 0);
+          list_insert(timer);
+      }
+
+      timer->callback(timer, timer->data);
+  }
+
+  arm_head();
+
+  CORE_EXIT_CRITICAL();
+}
@@ -0,0 +1,89 @@
+/**
+ * @file swtimer.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the software timers.
+ * Any number of one-shot and periodic timers share LETIMER0: the running
+ * timers are kept in a list sorted by expiry, and COMP1 is only armed for
+ * the head of the list. Timers past the end of the current LETIMER0 period
+ * are re-armed by the UF interrupt, so an idle timer list causes no extra
+ * wakeups.
+ *
+ * Expiry times are kept in LETIMER0 ticks. A periodic timer computes every
+ * expiry from its start tick and the number of periods elapsed, so the
+ * rounding of ms to ticks never accumulates into drift.
+ *
+ * The callback of an expired timer runs in the LETIMER0 ISR context and
+ * is meant to raise a scheduler event, like the sleeptimer callbacks.
+ * @version 0.1
+ * @date 2022-04-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __SWTIMER_H__
+#define __SWTIMER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// the longest timeout or period, half of the tick count range at 8192 Hz
+#define SWTIMER_MAX_MS              (86400000)
+
+struct swtimer;
+
+/**
+ * Callback of an expired timer, runs in the ISR context
+ */
+typedef void (*swtimer_callback_t)(struct swtimer *timer, void *data);
+
+/**
+ * Software timer, owned by the caller. The fields are private to swtimer.c.
+ */
+typedef struct swtimer {
+  struct swtimer *next;
+  struct swtimer *prev;
+  uint32_t expiry;           // tick count of the next expiry
+  uint32_t origin;           // tick count the timeout is counted from
+  uint32_t timeout_ms;
+  uint32_t period_ms;        // 0 for a one-shot timer
+  uint32_t periods;          // periods elapsed since the first expiry
+  swtimer_callback_t callback;
+  void *data;
+  bool running;
+}swtimer_t;
+
+
+/**
+ * @brief Start a timer, or restart it if it is running.
+ * @param timer: the timer.
+ * @param timeout_ms: the time to the first expiry, in ms.
+ * @param period_ms: the time between later expiries, 0 for a one-shot
+ * timer.
+ * @param callback: called on every expiry in the ISR context.
+ * @param data: passed to the callback.
+ * @return false if a time is above SWTIMER_MAX_MS or the callback is NULL.
+ */
+bool swtimer_start(swtimer_t *timer, uint32_t timeout_ms, uint32_t period_ms, \
+                   swtimer_callback_t callback, void *data);
+
+/**
+ * @brief Stop a timer. Stopping a timer that is not running does nothing.
+ * @param timer: the timer.
+ */
+void swtimer_stop(swtimer_t *timer);
+
+/**
+ * @brief Check if a timer is running.
+ * @param timer: the timer.
+ * @return true until a one-shot timer expires or any timer is stopped.
+ */
+bool swtimer_is_running(const swtimer_t *timer);
+
+/**
+ * @brief Run the callbacks of all expired timers and arm COMP1 for the
+ * next one. Called by the LETIMER0 ISR on COMP1 and UF.
+ */
+void swtimer_irq_handler();
+
+#endif // __SWTIMER_H__
@@ -6,6 +6,8 @@
  * energy mode and the LETIMER0 period. Additionally,
  * processor waiting function via polling is also implemented
  * to provide blocking methods for various uses.
+ * COMP1 is the alarm of the software timers in swtimer.c, and the
+ * non-blocking wait is one of those timers.
  * @version 0.1
  * @date 2022-02-01
  *
@@ -15,27 +17,35 @@
 
 #include "em_letimer.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "timers.h"
 #include "oscillators.h"
+#include "irq.h"
+#include "swtimer.h"
+#include "scheduler.h"
 
-#define INCLUDE_LOG_DEBUG 1
+#define LOG_LEVEL LOG_LEVEL_ERROR
 #include "src/log.h"
 
 
 #define PRESCALER_VALUE     4
 #define LFXO_FREQ           32768
 #define ULFRCO_FREQ         1000
-#define LETIMER0_PERIOD_MS   3000
 
 
 static uint32_t ACTUAL_CLK_FREQ = 0;
 static uint32_t LE_TOP_VALUE = 0;
+// the period passed to initLETIMER0(), caps the waits
+static uint32_t LE_PERIOD_MS = 0;
+// the timer behind timeWaitUs_irq()
+static swtimer_t wait_timer;
 
 /**
  * initLETIMER0( ) initializes and configures LETIMER0 according to the
  * desired energy mode, timer period and on-time.
  * @param period: The expected timer period, in MS.
- * @param on_time: The time for LETIMER to turn on LED
+ * @param on_time: The time for LETIMER to turn on LED, must be 0 since
+ * COMP1 is the alarm of the software timers
  * @param energy_mode: The current energy mode the system is in
  * @reference: The implementation body takes void initLETIMER(void)
  * from the demo project 'pulse_width_modulation' provided by SiliconLabs:
@@ -63,8 +73,12 @@ void initLETIMER0(uint32_t period, uint32_t on_time,
 
   //enable the clock
   CMU_ClockEnable(cmuClock_LETIMER0, true);
-  //set the top value according to period
-  uint32_t top_value = (period * ACTUAL_CLK_FREQ) / 1000;
+  //set the top value according to period, the counter runs from TOP
+  //down to 0 so a period is TOP + 1 ticks
+  uint32_t top_value = ((period * ACTUAL_CLK_FREQ) / 1000) - 1;
+  //keep the top value for the wait functions and the timestamp
+  LE_TOP_VALUE = top_value;
+  LE_PERIOD_MS = period;
 
   //set letimer0 run in repeatFree mode
   //set comp0 as the top value each time letimer0 wraps around
@@ -81,16 +95,10 @@ void initLETIMER0(uint32_t period, uint32_t on_time,
   LETIMER_CompareSet(LETIMER0, 0, top_value);
 
   if(on_time){
-      //set the comp1 register with LETIMER_ON_TIME_MS
-      uint32_t ontime_value = (on_time * ACTUAL_CLK_FREQ) / 1000;
-      LETIMER_CompareSet(LETIMER0, 1, ontime_value);
-      //enable LETIMER0 interrupt for COMP1 and UF
-      LETIMER0->IEN |= LETIMER_IEN_COMP1 | LETIMER_IEN_UF;
-  }
-  else{
-      //enable LETIMER0 interrupt for COMP1 and UF
-      LETIMER0->IEN |= LETIMER_IEN_UF;
+      LOG_ERROR("LETIMER0 on-time is not supported, COMP1 is used by the software timers\r\n");
   }
+  //enable LETIMER0 interrupt for UF, COMP1 is enabled by letimerSetAlarm()
+  LETIMER0->IEN |= LETIMER_IEN_UF;
 
   //initialize and enable LETIMER0
   LETIMER_Init(LETIMER0, &letimerInit);
@@ -116,14 +124,13 @@ void timerWaitUs_polled(uint32_t us_wait)
   // convert wait period from us to ms
   uint32_t ms_wait = us_wait / 1000;
 
-  if(ms_wait > LETIMER0_PERIOD_MS ){
+  if(ms_wait > LE_PERIOD_MS ){
       LOG_ERROR("Error: invalid wait value detected, the wait value will set to %u ms\r\n", \
-                LETIMER0_PERIOD_MS);
-      ms_wait = LETIMER0_PERIOD_MS;
+                LE_PERIOD_MS);
+      ms_wait = LE_PERIOD_MS;
   }
 
   const uint32_t TICK_CNT_THRSHOLD = (ms_wait * ACTUAL_CLK_FREQ) / 1000;
-  LE_TOP_VALUE = (LETIMER0_PERIOD_MS * ACTUAL_CLK_FREQ) / 1000;
   uint32_t start_tick_cnt;
   uint32_t curr_tick_cnt;
   uint32_t elasped_tick_cnt = 0;
@@ -138,33 +145,27 @@ void timerWaitUs_polled(uint32_t us_wait)
           elasped_tick_cnt = start_tick_cnt - curr_tick_cnt;
       }
       else{
-          elasped_tick_cnt = LE_TOP_VALUE - curr_tick_cnt + start_tick_cnt;
+          elasped_tick_cnt = (LE_TOP_VALUE + 1) - curr_tick_cnt + start_tick_cnt;
       }
   }while(elasped_tick_cnt < TICK_CNT_THRSHOLD);
 
 }
 
-/**
- * @brief This function enables or disables COMP1 interrupt based on
- * the given flag.
- * @param set: the flag indicating if the COMP1 interrupt should be enabled.
- */
-void set_LETIMER0COMP1_irq(int set)
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Software timer callback ending timeWaitUs_irq(), runs in the ISR context.
+// ---------------------------------------------------------------------
+static void wait_expired(swtimer_t *timer, void *data)
 {
-  if(set){
-     //set LETIMER0 interrupt for COMP1
-     LETIMER0->IEN |= LETIMER_IEN_COMP1;
-  }
-  else{
-      //clear LETIMER0 interrupt for COMP1
-      LETIMER0->IEN &= ~LETIMER_IEN_COMP1;
-  }
+  (void)timer;
+  (void)data;
+  schedulerSetEventLE0_COMP1();
 }
 
 /**
- * @brief This function waits for the specified time by enabling COMP1
- * interrupt for LETIMER0 with the associated COMP1 value. This function
- * does not block the CPU.
+ * @brief This function waits for the specified time on a software timer
+ * and sets the evtLETIMER0_COMP1 event when the time is up. This function
+ * does not block the CPU. A new wait replaces the pending one.
  * @param us_wait: the specified amount of time to wait.
  */
 void timeWaitUs_irq(uint32_t us_wait)
@@ -172,24 +173,72 @@ void timeWaitUs_irq(uint32_t us_wait)
   // convert wait period from us to ms
    uint32_t ms_wait = us_wait / 1000;
 
-   if(ms_wait > LETIMER0_PERIOD_MS ){
+   if(ms_wait > LE_PERIOD_MS ){
        LOG_ERROR("Error: invalid wait value detected, the wait value will set to %u ms\r\n", \
-                 LETIMER0_PERIOD_MS);
-       ms_wait = LETIMER0_PERIOD_MS;
+                 LE_PERIOD_MS);
+       ms_wait = LE_PERIOD_MS;
    }
 
-   uint32_t req_tickmnt = (ms_wait * ACTUAL_CLK_FREQ) / 1000;
-   uint32_t curr_tick_cnt = LETIMER_CounterGet(LETIMER0);
-   uint32_t comp1_val;
-   if(curr_tick_cnt >= req_tickmnt){
-       comp1_val = curr_tick_cnt - req_tickmnt;
-   }
-   else{
-       comp1_val = LE_TOP_VALUE - (req_tickmnt - curr_tick_cnt);
-   }
+   swtimer_start(&wait_timer, ms_wait, 0, wait_expired, NULL);
+}
 
-   LETIMER_CompareSet(LETIMER0, 1, comp1_val);
-   set_LETIMER0COMP1_irq(1);
+/**
+ * @brief This function returns the frequency LETIMER0 counts at.
+ * @return the tick frequency, in Hz.
+ */
+uint32_t letimerTickFrequency()
+{
+  return ACTUAL_CLK_FREQ;
+}
+
+/**
+ * @brief This function raises the COMP1 interrupt when letimerTicks()
+ * reaches the given tick count. An alarm after the end of the current
+ * LETIMER0 period is left to the UF interrupt, which calls the software
+ * timers again. An alarm that is already due raises COMP1 at once.
+ * @param at_tick: the tick count of the alarm.
+ */
+void letimerSetAlarm(uint32_t at_tick)
+{
+  int32_t  delta;
+  uint32_t count;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  delta = (int32_t)(at_tick - letimerTicks());
+  // the counter runs down, it reaches 0 at the end of the period
+  count = LETIMER_CounterGet(LETIMER0);
+
+  //drop a match of the previous alarm
+  LETIMER_IntClear(LETIMER0, LETIMER_IF_COMP1);
+
+  if(delta <= 0){
+      LETIMER_IntSet(LETIMER0, LETIMER_IF_COMP1);
+      LETIMER0->IEN |= LETIMER_IEN_COMP1;
+  }
+  else if((uint32_t)delta > count){
+      LETIMER0->IEN &= ~LETIMER_IEN_COMP1;
+  }
+  else{
+      LETIMER_CompareSet(LETIMER0, 1, count - (uint32_t)delta);
+      LETIMER0->IEN |= LETIMER_IEN_COMP1;
+      //the counter may have passed the compare value while it was written
+      if((int32_t)(at_tick - letimerTicks()) <= 0){
+          LETIMER_IntSet(LETIMER0, LETIMER_IF_COMP1);
+      }
+  }
+
+  CORE_EXIT_CRITICAL();
+}
+
+/**
+ * @brief This function disables the COMP1 interrupt.
+ */
+void letimerCancelAlarm()
+{
+  //clear LETIMER0 interrupt for COMP1
+  LETIMER0->IEN &= ~LETIMER_IEN_COMP1;
 }
 
 /**
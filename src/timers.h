@@ -7,7 +7,8 @@
  * initLETIMER0( ) initializes and configures LETIMER0 according to the
  * desired energy mode, timer period and on-time.
  * @param period: The expected timer period, in MS.
- * @param on_time: The time for LETIMER to turn on LED
+ * @param on_time: The time for LETIMER to turn on LED, must be 0 since
+ * COMP1 is the alarm of the software timers
  * @param energy_mode: The current energy mode the system is in
  * @reference: The implementation body takes void initLETIMER(void)
  * from the demo project 'pulse_width_modulation' provided by SiliconLabs:
@@ -25,19 +26,32 @@ void initLETIMER0(uint32_t period, uint32_t on_time,
 void timerWaitUs_polled(uint32_t us_wait);
 
 /**
- * @brief This function waits for the specified time by enabling COMP1
- * interrupt for LETIMER0 with the associated COMP1 value. This function
- * does not block the CPU.
+ * @brief This function waits for the specified time on a software timer
+ * and sets the evtLETIMER0_COMP1 event when the time is up. This function
+ * does not block the CPU. A new wait replaces the pending one.
  * @param us_wait: the specified amount of time to wait.
  */
 void timeWaitUs_irq(uint32_t us_wait);
 
 /**
- * @brief This function enables or disables COMP1 interrupt based on
- * the given flag.
- * @param set: the flag indicating if the COMP1 interrupt should be enabled.
+ * @brief This function returns the frequency LETIMER0 counts at.
+ * @return the tick frequency, in Hz.
  */
-void set_LETIMER0COMP1_irq(int set);
+uint32_t letimerTickFrequency();
+
+/**
+ * @brief This function raises the COMP1 interrupt when letimerTicks()
+ * reaches the given tick count. An alarm after the end of the current
+ * LETIMER0 period is left to the UF interrupt, which calls the software
+ * timers again. An alarm that is already due raises COMP1 at once.
+ * @param at_tick: the tick count of the alarm.
+ */
+void letimerSetAlarm(uint32_t at_tick);
+
+/**
+ * @brief This function disables the COMP1 interrupt.
+ */
+void letimerCancelAlarm();
 
 /**
  * @brief This function returns the top value configured for LETIMER0.
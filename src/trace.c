@@ -0,0 +1,145 @@
+/**
+ * @file trace.c
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This file contains the implementation of the event-trace recorder.
+ * Records are appended to a linear RAM buffer until it is full,
+ * after which new records are dropped and counted, so the beginning of a
+ * trace (e.g. boot, connection and bonding) is always preserved.
+ * @version 0.1
+ * @date 2022-04-21
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <string.h>
+#include "trace.h"
+
+#if TRACE_ENABLE
+
+#include "em_core.h"
+#include "irq.h"
+
+#define LOG_LEVEL LOG_LEVEL_INFO
+#include "src/log.h"
+
+// size of the record type and the timestamp fields
+#define TRACE_REC_PREFIX_LEN        (5)
+
+static uint8_t  trace_buf[TRACE_BUFFER_SIZE];
+static uint32_t trace_len = 0;
+static uint32_t trace_dropped = 0;
+
+
+// ---------------------------------------------------------------------
+// Private function used only by this .c file.
+// Append one record to the trace buffer. The caller provides the record
+// body that follows the type and timestamp fields.
+// ---------------------------------------------------------------------
+static void trace_append(trace_rec_t type, uint32_t word, \
+                         const uint8_t *payload, uint32_t payload_len)
+{
+  uint32_t timestamp;
+  uint32_t rec_len = TRACE_REC_PREFIX_LEN + sizeof(word) + payload_len;
+  uint8_t  *p;
+
+  CORE_DECLARE_IRQ_STATE;
+  // enter the critical section, signals are recorded from ISRs
+  CORE_ENTER_CRITICAL();
+
+  if((trace_len + rec_len) > TRACE_BUFFER_SIZE){
+      trace_dropped++;
+      CORE_EXIT_CRITICAL();
+      return;
+  }
+
+  timestamp = letimerMilliseconds();
+  p = &trace_buf[trace_len];
+
+  *p++ = (uint8_t)type;
+  memcpy(p, &timestamp, sizeof(timestamp));
+  p += sizeof(timestamp);
+  memcpy(p, &word, sizeof(word));
+  p += sizeof(word);
+  if(payload_len){
+      memcpy(p, payload, payload_len);
+  }
+
+  trace_len += rec_len;
+
+  // exit the critical section
+  CORE_EXIT_CRITICAL();
+}
+
+/**
+ * @brief Discard the current trace and restart recording from
+ * the beginning of the trace buffer.
+ */
+void trace_reset()
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  trace_len = 0;
+  trace_dropped = 0;
+  CORE_EXIT_CRITICAL();
+}
+
+/**
+ * @brief Record a BT message passed to sl_bt_on_event().
+ * @param evt: the pointer of the BT event message.
+ */
+void trace_record_bt_event(sl_bt_msg_t *evt)
+{
+  uint32_t payload_len = SL_BT_MSG_LEN(evt->header);
+
+  if(payload_len > SL_BGAPI_MAX_PAYLOAD_SIZE){
+      payload_len = SL_BGAPI_MAX_PAYLOAD_SIZE;
+  }
+
+  trace_append(TRACE_REC_BT_EVT, evt->header, evt->data.payload, payload_len);
+}
+
+/**
+ * @brief Record the external signal bitmask raised by an interrupt.
+ * This function is safe to call from the ISR context.
+ * @param extsignals: the raised external signals.
+ */
+void trace_record_signal(uint32_t extsignals)
+{
+  trace_append(TRACE_REC_SIGNAL, extsignals, NULL, 0);
+}
+
+/**
+ * @brief Obtain the captured trace.
+ * @param len: the number of valid bytes in the trace buffer.
+ * @return the address of the trace buffer.
+ */
+const uint8_t *trace_get_buffer(uint32_t *len)
+{
+  if(len)
+    *len = trace_len;
+  return &trace_buf[0];
+}
+
+/**
+ * @brief Dump the file header and the captured trace as hex over VCOM.
+ */
+void trace_dump()
+{
+  uint32_t i;
+
+  LOG_INFO("trace: %u bytes, %u records dropped\r\n", trace_len, trace_dropped);
+
+  // file header: magic, version, reserved, length
+  app_log("%s%02X%02X%02X%02X\r\n", TRACE_MAGIC, TRACE_FORMAT_VERSION, 0, \
+          (unsigned int)(trace_len & 0xFF), (unsigned int)((trace_len >> 8) & 0xFF));
+
+  for(i=0;i<trace_len;i++){
+      app_log("%02X", trace_buf[i]);
+      if((i % 32) == 31)
+        app_log("\r\n");
+  }
+  app_log("\r\n");
+}
+
+#endif // TRACE_ENABLE
@@ -0,0 +1,97 @@
+/**
+ * @file trace.h
+ * @author Shuran Xu (shxu6388@colorado.edu)
+ * @brief This header file contains public APIs of the event-trace recorder.
+ * The recorder captures every BT message passed to sl_bt_on_event() and
+ * every external signal raised by the schedulerSetEvent*() functions,
+ * timestamped with letimerMilliseconds(). A captured trace can be dumped
+ * over the VCOM port and replayed on the host with host_sim -r, see
+ * host/sim/host_replay.h.
+ *
+ * Trace format (little-endian, records are packed back-to-back):
+ *
+ *   TRACE_REC_BT_EVT : [type:1][timestamp_ms:4][header:4][payload:SL_BT_MSG_LEN(header)]
+ *   TRACE_REC_SIGNAL : [type:1][timestamp_ms:4][extsignals:4]
+ *
+ * The dump is prefixed with a 8-byte file header:
+ *
+ *   [magic:4 = "BTTR"][version:1][reserved:1][length:2]
+ *
+ * @version 0.1
+ * @date 2022-04-21
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include "sl_bt_api.h"
+
+/**
+ * Set to 1 to compile in the event-trace recorder.
+ */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE                (0)
+#endif
+
+#define TRACE_BUFFER_SIZE           (4096)
+#define TRACE_FORMAT_VERSION        (1)
+#define TRACE_MAGIC                 "BTTR"
+
+/**
+ * Record types stored in the trace buffer
+ */
+typedef enum {
+  TRACE_REC_BT_EVT = 1,  //!< TRACE_REC_BT_EVT
+  TRACE_REC_SIGNAL       //!< TRACE_REC_SIGNAL
+}trace_rec_t;
+
+
+#if TRACE_ENABLE
+
+/**
+ * @brief Discard the current trace and restart recording from
+ * the beginning of the trace buffer.
+ */
+void trace_reset();
+
+/**
+ * @brief Record a BT message passed to sl_bt_on_event().
+ * @param evt: the pointer of the BT event message.
+ */
+void trace_record_bt_event(sl_bt_msg_t *evt);
+
+/**
+ * @brief Record the external signal bitmask raised by an interrupt.
+ * This function is safe to call from the ISR context.
+ * @param extsignals: the raised external signals.
+ */
+void trace_record_signal(uint32_t extsignals);
+
+/**
+ * @brief Obtain the captured trace.
+ * @param len: the number of valid bytes in the trace buffer.
+ * @return the address of the trace buffer.
+ */
+const uint8_t *trace_get_buffer(uint32_t *len);
+
+/**
+ * @brief Dump the file header and the captured trace as hex over VCOM.
+ */
+void trace_dump();
+
+#else
+
+/*
+ * Remove all trace related code where tracing is not enabled
+ */
+static inline void trace_reset() {}
+static inline void trace_record_bt_event(sl_bt_msg_t *evt) { (void)evt; }
+static inline void trace_record_signal(uint32_t extsignals) { (void)extsignals; }
+
+#endif // TRACE_ENABLE
+
+#endif // __TRACE_H__
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Generate a GLIB PackedFont from one of the GLIB bitmap fonts.
+
+The GLIB fonts store one row of every glyph after the other, so drawing a
+glyph walks the whole table fontRowOffset elements at a time, and every row
+takes a full 8, 16 or 32 bit element. The packed font stores each glyph as
+fontHeight rows of fontWidth bits, LSB leftmost, which is the bit order of a
+memory LCD row, plus a table of ink widths so that blank glyphs are skipped.
+
+Usage:
+    gen_packed_font.py <glib_font.c> <font name> <output base path>
+
+e.g.
+    tools/gen_packed_font.py \\
+        gecko_sdk_3.2.3/platform/middleware/glib/glib/glib_font_narrow_6x8.c \\
+        GLIB_FontNarrow6x8Packed src/font_narrow_6x8_packed
+
+Only FullFont fonts (characters ' ' to '~') are supported.
+"""
+
+import os
+import re
+import sys
+
+FIRST_CHAR = ' '
+LAST_CHAR = '~'
+# read ahead of the last glyph by packedGlyphRow() in glib_string.c
+PADDING_BYTES = 2
+
+
+def parse_font(path):
+    with open(path) as f:
+        src = re.sub(r'/\*.*?\*/', '', f.read(), flags=re.S)
+
+    m = re.search(r'static\s+const\s+uint(8|16|32)_t\s+(\w+)\s*\[\s*\]\s*=\s*\{(.*?)\};',
+                  src, re.S)
+    if not m:
+        sys.exit('%s: no pixel map found' % path)
+    pixmap = [int(v, 0) for v in m.group(3).replace('\n', ' ').split(',') if v.strip()]
+
+    m = re.search(r'const\s+GLIB_Font_t\s+\w+\s*=\s*\{(.*?)\};', src, re.S)
+    if not m:
+        sys.exit('%s: no GLIB_Font_t found' % path)
+    fields = [v.strip() for v in m.group(1).split(',')]
+    row_offset, width, height, line_spacing, char_spacing = \
+        [int(v, 0) for v in fields[3:8]]
+    font_class = fields[8]
+    if font_class != 'FullFont':
+        sys.exit('%s: %s is not supported' % (path, font_class))
+
+    return pixmap, row_offset, width, height, line_spacing, char_spacing
+
+
+def pack(pixmap, row_offset, width, height):
+    glyph_bytes = (width * height + 7) // 8
+    count = ord(LAST_CHAR) - ord(FIRST_CHAR) + 1
+    glyphs = []
+    widths = []
+
+    for idx in range(count):
+        bits = 0
+        ink = 0
+        for row in range(height):
+            row_bits = pixmap[idx + row * row_offset] & ((1 << width) - 1)
+            bits |= row_bits << (row * width)
+            ink = max(ink, row_bits.bit_length())
+        glyphs.append(bits.to_bytes(glyph_bytes, 'little'))
+        widths.append(ink)
+
+    return glyph_bytes, glyphs, widths
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+
+    src_path, name, out_base = sys.argv[1:]
+    pixmap, row_offset, width, height, line_spacing, char_spacing = parse_font(src_path)
+    if width > 16:
+        sys.exit('%s: glyphs wider than 16 pixels are not supported' % src_path)
+
+    glyph_bytes, glyphs, widths = pack(pixmap, row_offset, width, height)
+    src_name = os.path.basename(src_path)
+    base_name = os.path.basename(out_base)
+    guard = '__%s_H__' % base_name.upper()
+
+    header = ('/**\n'
+              ' * @file %s\n'
+              ' * @brief Generated by tools/gen_packed_font.py from %s, do not edit.\n'
+              ' */\n') % ('%s', src_name)
+
+    with open(out_base + '.h', 'w') as f:
+        f.write(header % (base_name + '.h'))
+        f.write('\n#ifndef %s\n#define %s\n\n' % (guard, guard))
+        f.write('#include "glib.h"\n\n')
+        f.write('extern const GLIB_Font_t %s;\n\n' % name)
+        f.write('#endif // %s\n' % guard)
+
+    with open(out_base + '.c', 'w') as f:
+        f.write(header % (base_name + '.c'))
+        f.write('\n#include <stdint.h>\n#include "%s.h"\n\n' % base_name)
+
+        f.write('static const uint8_t %sGlyphs[] = {\n' % name)
+        for idx, glyph in enumerate(glyphs):
+            ch = chr(ord(FIRST_CHAR) + idx)
+            f.write('  %s, // %s\n' % (', '.join('0x%02x' % b for b in glyph),
+                                       repr(ch)))
+        f.write('  %s\n};\n\n' % ', '.join(['0x00'] * PADDING_BYTES))
+
+        f.write('static const uint8_t %sWidths[] = {\n' % name)
+        for i in range(0, len(widths), 16):
+            f.write('  %s,\n' % ', '.join('%d' % w for w in widths[i:i + 16]))
+        f.write('};\n\n')
+
+        f.write('static const GLIB_PackedFont_t %sData = {\n' % name)
+        f.write('  %sGlyphs, %sWidths, %d, \'%s\'\n};\n\n'
+                % (name, name, glyph_bytes, FIRST_CHAR))
+
+        f.write('const GLIB_Font_t %s = { (void *)&%sData,\n' % (name, name))
+        f.write('  %d, %d, 0, %d, %d, %d, %d, PackedFont };\n'
+                % (len(glyphs), glyph_bytes, width, height, line_spacing, char_spacing))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Decode the binary log written by logDrain() in src/log.c back into text.
+
+Every record is the sync byte 0xB1, a header word and the argument words,
+all little endian. The header holds the flash address of the format string
+in bits 0..23 and the number of arguments in bits 24..31. The format strings,
+and the %s arguments that point into flash, are read from the .axf file of
+the firmware that produced the log. A format address of 0 reports the number
+of log lines dropped because the RAM ring was full.
+
+Bytes that do not form a valid record, e.g. the text of trace_dump(), are
+passed through as they are.
+
+Usage:
+    log_decode.py <firmware.axf> [capture.bin]
+
+The capture is the raw VCOM output, e.g. from
+    stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > capture.bin
+and is read from stdin if no file is given.
+"""
+
+import re
+import struct
+import sys
+
+SYNC_BYTE = 0xB1
+# LOG_MAX_ARGS in src/log.c
+MAX_ARGS = 15
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+CONVERSION = re.compile(r'%([-0]*)(\d*)[lhz]*([diuxXcs%])')
+
+
+class Elf32:
+    """The allocated sections of a little endian ELF32 file."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1 or self.data[5] != 1:
+            sys.exit('%s: not a little endian ELF32 file' % path)
+
+        shoff, = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, flags, addr, offset, size) = \
+                struct.unpack_from('<IIIIII', self.data, shoff + i * shentsize)
+            if (flags & SHF_ALLOC) and sh_type != SHT_NOBITS and size:
+                self.sections.append((addr, offset, size))
+
+    def string_at(self, addr):
+        """The null terminated string at addr, None if addr is not in the file."""
+        for (start, offset, size) in self.sections:
+            if start <= addr < start + size:
+                pos = offset + addr - start
+                end = self.data.find(b'\0', pos, offset + size)
+                if end < 0:
+                    return None
+                return self.data[pos:end].decode('latin-1')
+        return None
+
+
+def render(elf, fmt, args):
+    """Format a record like the C formatter in src/fmt.c."""
+    args = list(args)
+
+    def convert(m):
+        flags, width, conv = m.groups()
+        if conv == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        spec = '%' + flags + width
+        if conv in 'di':
+            return (spec + 'd') % (value - (1 << 32) if value & 0x80000000 else value)
+        if conv == 'c':
+            return (spec + 's') % chr(value & 0xFF)
+        if conv == 's':
+            text = elf.string_at(value)
+            return (spec + 's') % (text if text is not None else '<0x%08x>' % value)
+        return (spec + conv) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode(elf, data, out):
+    pos = 0
+    text_start = 0
+    while pos < len(data):
+        if data[pos] != SYNC_BYTE or pos + 5 > len(data):
+            pos += 1
+            continue
+
+        header, = struct.unpack_from('<I', data, pos + 1)
+        nargs = header >> 24
+        addr = header & 0xFFFFFF
+        end = pos + 5 + 4 * nargs
+        if nargs > MAX_ARGS or end > len(data):
+            pos += 1
+            continue
+
+        args = struct.unpack_from('<%dI' % nargs, data, pos + 5)
+        if addr == 0 and nargs == 1:
+            line = '<%u log lines dropped>\n' % args[0]
+        else:
+            fmt = elf.string_at(addr)
+            if fmt is None:
+                pos += 1
+                continue
+            line = render(elf, fmt, args)
+
+        out.write(data[text_start:pos].decode('latin-1'))
+        out.write(line)
+        pos = end
+        text_start = pos
+
+    out.write(data[text_start:].decode('latin-1'))
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+
+    elf = Elf32(sys.argv[1])
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    decode(elf, data, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Print the event-loop profile written by profiler_dump() in src/profiler.c.
+
+The dump is one hex line with the header of the profile blob followed by one
+hex line per entry, see src/profiler.h for the layout. The raw blob returned
+by profiler_get_blob() can be decoded with --binary.
+
+Usage:
+    profile_decode.py [--binary] [capture]
+
+The capture is the VCOM output, e.g. from
+    stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > capture.bin
+and is read from stdin if no file is given. Every profile in the capture is
+printed.
+"""
+
+import re
+import struct
+import sys
+
+MAGIC = b'PROF'
+HEADER = struct.Struct('<4sBBBBIII')
+ENTRY = struct.Struct('<BIIIIQ')
+
+KINDS = {
+    1: 'bt_event',
+    2: 'ble_handler',
+    3: 'temp_state',
+    4: 'light_state',
+    5: 'sound_state',
+    6: 'wakeup',
+}
+
+# state enums in src/scheduler.c
+STATES = {
+    3: ['IDLE', 'TIMEVT_1', 'I2C_WRITE_COMP', 'TIMEVT_2', 'I2C_READ_COMP'],
+    4: ['READ_RGB', 'COMP_LUX', 'SLEEP'],
+    5: ['SINGLE_SCAN', 'READ_SOUND_LVL'],
+}
+
+HEX_LINE = re.compile(rb'^[0-9A-F]+$')
+
+
+def id_name(kind, ident):
+    if kind in STATES and ident < len(STATES[kind]):
+        return STATES[kind][ident]
+    if kind == 6:
+        return 'EM%d' % ident
+    return '0x%08x' % ident
+
+
+def print_profile(blob, out):
+    (magic, version, entries, buckets, shift, cycle_hz, wakeups, dropped) = \
+        HEADER.unpack_from(blob, 0)
+    if magic != MAGIC or version != 1:
+        sys.exit('not a version 1 profile')
+
+    us = 1e6 / cycle_hz
+    out.write('%u entries, %u wakeups, %u entries dropped, %.1f MHz\n'
+              % (entries, wakeups, dropped, cycle_hz / 1e6))
+    out.write('%-12s %-16s %8s %10s %10s %10s  histogram (bucket 0 < %u cycles)\n'
+              % ('kind', 'id', 'count', 'min us', 'avg us', 'max us', 1 << shift))
+
+    pos = HEADER.size
+    entry_len = ENTRY.size + 2 * buckets
+    for _ in range(entries):
+        if pos + entry_len > len(blob):
+            out.write('<truncated>\n')
+            return
+        (kind, ident, count, cmin, cmax, csum) = ENTRY.unpack_from(blob, pos)
+        histogram = struct.unpack_from('<%dH' % buckets, blob, pos + ENTRY.size)
+        pos += entry_len
+
+        avg = csum / count if count else 0
+        out.write('%-12s %-16s %8u %10.1f %10.1f %10.1f  %s\n'
+                  % (KINDS.get(kind, str(kind)), id_name(kind, ident), count,
+                     cmin * us, avg * us, cmax * us,
+                     ' '.join(str(n) for n in histogram)))
+
+
+def main():
+    args = sys.argv[1:]
+    binary = '--binary' in args
+    if binary:
+        args.remove('--binary')
+    if len(args) > 1:
+        sys.exit(__doc__)
+
+    if args:
+        with open(args[0], 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    if binary:
+        print_profile(data, sys.stdout)
+        return
+
+    # rebuild every blob from its header line and the entry lines after it
+    lines = [l.strip() for l in data.split(b'\n')]
+    i = 0
+    while i < len(lines):
+        line = lines[i]
+        i += 1
+        if not line.startswith(MAGIC.hex().upper().encode()) or \
+                not HEX_LINE.match(line):
+            continue
+        blob = bytes.fromhex(line.decode())
+        while i < len(lines) and lines[i] and HEX_LINE.match(lines[i]):
+            blob += bytes.fromhex(lines[i].decode())
+            i += 1
+        print_profile(blob, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()